@@ -55,6 +55,7 @@
   #if ARCH_ARM64
     #define cpu_yield()   __yield()
     #define store_fence() __dmb(0x0A) // 0x0A: ishst
+    #define load_fence()  __dmb(0x09) // 0x09: ishld
   #endif
 
   #define atomic_add_u32(ptr, n)         _InterlockedExchangeAdd((volatile u32 *)(ptr), (n))
@@ -81,6 +82,8 @@
   #define exp_f64(a)      exp(a)
   #define sqrt_f64(a)     sqrt(a)
 
+  #define target_feature(s)
+
 #else
   #define alignas(n)       __attribute__((aligned(n)))
   #define pack_struct(s) s __attribute__((packed))
@@ -109,6 +112,7 @@
     #define debugbreak()   asm volatile ("brk 0xf000")
     #define cpu_yield()    asm volatile ("isb")
     #define store_fence()  asm volatile ("dmb ishst" ::: "memory")
+    #define load_fence()   asm volatile ("dmb ishld" ::: "memory")
   #else
     #define debugbreak()   asm volatile ("int3; nop")
   #endif
@@ -137,6 +141,10 @@
   #define exp_f64(a)      __builtin_exp(a)
   #define sqrt_f64(a)     __builtin_sqrt(a)
 
+  /* NOTE(rnp): allows instructions beyond the -march baseline in a single function. the
+   * caller is responsible for checking that the CPU supports them (see CPUFeatureFlags) */
+  #define target_feature(s) __attribute__((target(s)))
+
   #define popcount_u64(a) (u64)__builtin_popcountll(a)
 #endif
 
@@ -152,7 +160,7 @@ clz_u64(u64 a)
 	u64 result = 64, index;
 	if (a) {
 		_BitScanReverse64(&index, a);
-		result = index;
+		result = 63 - index;
 	}
 	return result;
 }
@@ -171,7 +179,7 @@ ctz_u64(u64 a)
 #else /* !COMPILER_MSVC */
 
 function force_inline u64
-clz_u64(u32 a)
+clz_u64(u64 a)
 {
 	u64 result = 64;
 	if (a) result = (u64)__builtin_clzll(a);
@@ -242,7 +250,57 @@ typedef __m128i u32x4;
 
 #define cpu_yield             _mm_pause
 #define store_fence           _mm_sfence
+#define load_fence            _mm_lfence
+
+#if COMPILER_MSVC
+  #include <intrin.h>
+  #define cpuid(leaf, subleaf, r) __cpuidex((i32 *)(r), (i32)(leaf), (i32)(subleaf))
+  #define xgetbv(n)               _xgetbv(n)
+#else
+  #include <cpuid.h>
+  #define cpuid(leaf, subleaf, r) __cpuid_count(leaf, subleaf, (r)[0], (r)[1], (r)[2], (r)[3])
+
+function force_inline u64
+xgetbv(u32 n)
+{
+	u32 lo, hi;
+	asm volatile ("xgetbv" : "=a"(lo), "=d"(hi) : "c"(n));
+	return (u64)hi << 32 | lo;
+}
+#endif
+
+#endif
 
+/* NOTE(rnp): instruction set extensions which are selected at runtime. NEON is part of the
+ * ARM64 baseline and SSE2 part of the x86_64 baseline so they are not listed */
+typedef enum {
+	CPUFeature_AVX2     = 1 << 0,
+	CPUFeature_AVX512BW = 1 << 1,
+	CPUFeature_SVE      = 1 << 2,
+} CPUFeatureFlags;
+
+#if ARCH_X64
+/* NOTE(rnp): the OS must also have enabled the YMM/ZMM state (XCR0) for AVX to be usable */
+function u32
+x64_cpu_features(void)
+{
+	u32 result = 0, r[4];
+	cpuid(0, 0, r);
+	u32 maximum_leaf = r[0];
+	cpuid(1, 0, r);
+	b32 osxsave = (r[2] >> 27) & 1;
+	b32 avx     = (r[2] >> 28) & 1;
+	if (maximum_leaf >= 7 && osxsave && avx) {
+		u64 xcr0 = xgetbv(0);
+		cpuid(7, 0, r);
+		b32 avx2      = (r[1] >>  5) & 1;
+		b32 avx512f   = (r[1] >> 16) & 1;
+		b32 avx512bw  = (r[1] >> 30) & 1;
+		if ((xcr0 & 0x06) == 0x06 && avx2)                  result |= CPUFeature_AVX2;
+		if ((xcr0 & 0xE6) == 0xE6 && avx512f && avx512bw)   result |= CPUFeature_AVX512BW;
+	}
+	return result;
+}
 #endif
 
 function force_inline f32
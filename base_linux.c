@@ -72,12 +72,28 @@ os_number_of_processors(void)
 	return result > 0 ? result : 1;
 }
 
+function u32
+os_cpu_features(void)
+{
+	u32 result = 0;
+	#if ARCH_X64
+	result = x64_cpu_features();
+	#elif ARCH_ARM64
+	#ifndef HWCAP_SVE
+	#define HWCAP_SVE (1 << 22)
+	#endif
+	if (getauxval(AT_HWCAP) & HWCAP_SVE) result |= CPUFeature_SVE;
+	#endif
+	return result;
+}
+
 function void
 os_system_info_init(void)
 {
 	linux_system_info.timer_frequency         = os_timer_frequency();
 	linux_system_info.logical_processor_count = os_number_of_processors();
 	linux_system_info.page_size               = ARCH_X64? KB(4) : getauxval(AT_PAGESZ);
+	linux_system_info.cpu_features            = os_cpu_features();
 	linux_system_info.path_separator_byte     = '/';
 }
 
@@ -216,6 +232,145 @@ os_wake_all_waiters(i32 *sync)
 	}
 }
 
+/* NOTE(rnp): bitmask of logical processors in the kernel's cpu_set_t/nodemask layout */
+typedef struct { u64 bits[16]; } OSLinuxCPUSet;
+
+function void
+os_linux_cpu_set_add(OSLinuxCPUSet *set, u32 cpu)
+{
+	if (cpu < countof(set->bits) * 64)
+		set->bits[cpu / 64] |= 1ull << (cpu % 64);
+}
+
+function b32
+os_linux_cpu_set_has(OSLinuxCPUSet *set, u32 cpu)
+{
+	b32 result = cpu < countof(set->bits) * 64 && (set->bits[cpu / 64] >> (cpu % 64)) & 1;
+	return result;
+}
+
+function u32
+os_linux_cpu_set_count(OSLinuxCPUSet *set)
+{
+	u32 result = 0;
+	for EachElement(set->bits, it)
+		result += popcount_u64(set->bits[it]);
+	return result;
+}
+
+/* NOTE(rnp): parses the sysfs cpulist format (e.g. "0-7,16-23") */
+function OSLinuxCPUSet
+os_linux_cpu_set_from_list(str8 list)
+{
+	OSLinuxCPUSet result = {0};
+	u32 first = 0, value = 0;
+	b32 have_value = 0, in_range = 0;
+	for (i64 i = 0; i <= list.length; i++) {
+		u8 c = i < list.length ? list.data[i] : ',';
+		if (Between(c, '0', '9')) {
+			value      = value * 10 + (u32)(c - '0');
+			have_value = 1;
+		} else if (c == '-') {
+			first    = value;
+			value    = 0;
+			in_range = 1;
+		} else if (have_value) {
+			if (!in_range) first = value;
+			for (u32 cpu = first; cpu <= value && cpu < countof(result.bits) * 64; cpu++)
+				os_linux_cpu_set_add(&result, cpu);
+			value = 0;
+			have_value = in_range = 0;
+		}
+	}
+	return result;
+}
+
+function OSLinuxCPUSet
+os_linux_process_cpu_set(void)
+{
+	OSLinuxCPUSet result = {0};
+	syscall(SYS_sched_getaffinity, 0, sizeof(result.bits), result.bits);
+	return result;
+}
+
+/* NOTE(rnp): sysfs files report a size of a full page so os_read_entire_file() can't be used */
+function str8
+os_linux_read_sysfs_file(u8 *buffer, i64 capacity, char *path)
+{
+	str8 result = {.data = buffer};
+	i32 fd = open(path, O_RDONLY);
+	if (fd >= 0) {
+		i64 rlen = read(fd, buffer, (u64)capacity);
+		if (rlen > 0) result.length = rlen;
+		close(fd);
+	}
+	while (result.length > 0 && (result.data[result.length - 1] == '\n' || result.data[result.length - 1] == 0))
+		result.length--;
+	return result;
+}
+
+/* NOTE(rnp): returns the NUMA node of a PCI device (-1 when the system doesn't report one)
+ * and the logical processors attached to that node */
+function i32
+os_linux_pci_device_locality(u32 domain, u32 bus, u32 device, u32 function_, OSLinuxCPUSet *cpus)
+{
+	u8  path[128], buffer[512];
+	i32 result = -1;
+
+	Stream sb = {.data = path, .cap = countof(path)};
+	stream_append_str8(&sb, str8("/sys/bus/pci/devices/"));
+	stream_append_hex_u64_width(&sb, domain, 4);
+	stream_append_byte(&sb, ':');
+	stream_append_hex_u64_width(&sb, bus, 2);
+	stream_append_byte(&sb, ':');
+	stream_append_hex_u64_width(&sb, device, 2);
+	stream_append_byte(&sb, '.');
+	stream_append_hex_u64_width(&sb, function_, 1);
+	i32 base = sb.widx;
+
+	stream_append_str8(&sb, str8("/numa_node"));
+	stream_append_byte(&sb, 0);
+	str8 node = os_linux_read_sysfs_file(buffer, countof(buffer), (char *)path);
+	if (node.length > 0 && !sb.errors) result = (i32)integer_from_str8(node).S64;
+
+	stream_reset(&sb, base);
+	stream_append_str8(&sb, str8("/local_cpulist"));
+	stream_append_byte(&sb, 0);
+	str8 list = os_linux_read_sysfs_file(buffer, countof(buffer), (char *)path);
+	if (list.length > 0 && !sb.errors) *cpus = os_linux_cpu_set_from_list(list);
+
+	return result;
+}
+
+function b32
+os_linux_thread_set_affinity(u64 thread, OSLinuxCPUSet *cpus)
+{
+	b32 result = pthread_setaffinity_np((pthread_t)thread, sizeof(cpus->bits), (cpu_set_t *)cpus->bits) == 0;
+	return result;
+}
+
+/* NOTE(rnp): requires CAP_SYS_NICE or a sufficient RLIMIT_RTPRIO */
+function b32
+os_linux_thread_set_realtime(u64 thread, i32 priority)
+{
+	struct sched_param param = {.sched_priority = priority};
+	b32 result = pthread_setschedparam((pthread_t)thread, SCHED_FIFO, &param) == 0;
+	return result;
+}
+
+/* NOTE(rnp): prefer placing (and move already faulted) pages of [base, base + size) on node */
+function b32
+os_linux_memory_bind_node(void *base, u64 size, i32 node)
+{
+	#define OS_LINUX_MPOL_PREFERRED (1)
+	#define OS_LINUX_MPOL_MF_MOVE   (1 << 1)
+	OSLinuxCPUSet nodes = {0};
+	os_linux_cpu_set_add(&nodes, (u32)node);
+	b32 result = node >= 0 && syscall(SYS_mbind, base, size, OS_LINUX_MPOL_PREFERRED, nodes.bits,
+	                                  countof(nodes.bits) * 64 + 1, OS_LINUX_MPOL_MF_MOVE) == 0;
+	return result;
+}
+
 #if !BASE_PLATFORM_NO_MAIN
 BASE_IMPORT void entry_point(i32 argc, char *argv[]);
 
@@ -32,6 +32,7 @@ typedef struct {
 
 	u32 logical_processor_count;
 	u32 page_size;
+	u32 cpu_features;
 
 	u8  path_separator_byte;
 } OSSystemInfo;
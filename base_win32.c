@@ -172,6 +172,9 @@ os_system_info_init(void)
 	win32_system_info.timer_frequency         = os_timer_frequency();
 	win32_system_info.logical_processor_count = info.number_of_processors;
 	win32_system_info.page_size               = info.page_size;
+	#if ARCH_X64
+	win32_system_info.cpu_features            = x64_cpu_features();
+	#endif
 	win32_system_info.path_separator_byte     = '\\';
 }
 
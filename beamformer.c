@@ -55,6 +55,10 @@ fatal(str8 message)
 
 #include "vulkan.c"
 
+#if BEAMFORMER_TRACING
+#include "trace.c"
+#endif
+
 // TODO(rnp): this doesn't belong here, but will be removed
 // once vulkan migration is complete
 void * glfwGetProcAddress(char *);
@@ -137,6 +141,7 @@ function OS_THREAD_ENTRY_POINT_FN(compute_worker_thread_entry_point)
 
 	BeamformerCtx *beamformer = (BeamformerCtx *)ctx->user_context;
 
+	trace_thread_name(str8("[compute]"));
 	for (;;) {
 		worker_thread_sleep(ctx, beamformer->shared_memory);
 		beamformer_complete_compute(beamformer, ctx->arena);
@@ -152,6 +157,7 @@ function OS_THREAD_ENTRY_POINT_FN(beamformer_upload_entry_point)
 	GLWorkerThreadContext         *ctx = user_context;
 	BeamformerUploadThreadContext *up  = (typeof(up))ctx->user_context;
 
+	trace_thread_name(str8("[upload]"));
 	for (;;) {
 		worker_thread_sleep(ctx, up->shared_memory);
 		beamformer_rf_upload(up);
@@ -162,6 +168,168 @@ function OS_THREAD_ENTRY_POINT_FN(beamformer_upload_entry_point)
 	return 0;
 }
 
+/* NOTE(rnp): each lane copies a contiguous run of pages so that lanes never share a cache
+ * line or a non-coherent atom */
+function void
+beamformer_upload_copy_lane(BeamformerUploadCopyJob *job)
+{
+	if (lane_index() < job->lane_count) {
+		u64      page_count = (job->size + KB(4) - 1) / KB(4);
+		RangeU64 pages      = subrange_n_from_n_m_count(lane_index(), job->lane_count, page_count);
+		u64      start      = pages.start * KB(4);
+		u64      stop       = Min(pages.stop * KB(4), job->size);
+		if (stop > start)
+			gpu_buffer_range_upload(job->buffer, job->data + start, job->offset + start, stop - start, 1);
+	}
+}
+
+function OS_THREAD_ENTRY_POINT_FN(beamformer_upload_copy_entry_point)
+{
+	BeamformerUploadCopyLane *lane = user_context;
+
+	lane_context(&lane->thread);
+	trace_thread_name(str8("[upload copy]"));
+	for (;;) {
+		lane_sync();
+		TraceZone("upload_copy_lane") beamformer_upload_copy_lane(&lane->lanes->job);
+		lane_sync();
+	}
+
+	unreachable();
+
+	return 0;
+}
+
+DEBUG_IMPORT void
+beamformer_upload_copy(BeamformerUploadCopyLanes *cl, GPUBuffer *buffer, void *data, u64 offset, u64 size, u32 lane_count)
+{
+	lane_count = Clamp(lane_count, 1, cl->lane_count);
+	if (lane_count == 1) {
+		gpu_buffer_range_upload(buffer, data, offset, size, 1);
+	} else {
+		cl->job = (BeamformerUploadCopyJob){
+			.buffer     = buffer,
+			.data       = data,
+			.offset     = offset,
+			.size       = size,
+			.lane_count = lane_count,
+		};
+		lane_context(&cl->lanes[0].thread);
+		lane_sync();
+		TraceZone("upload_copy_lane") beamformer_upload_copy_lane(&cl->job);
+		lane_sync();
+	}
+}
+
+global BeamformerThreadPlacementLayout beamformer_thread_placement_layout;
+
+DEBUG_IMPORT BeamformerThreadPlacementLayout *
+beamformer_thread_placement(void)
+{
+	return &beamformer_thread_placement_layout;
+}
+
+function BeamformerUploadCopyLanes *
+beamformer_upload_copy_lanes_create(Arena *arena, u32 lane_count)
+{
+	BeamformerUploadCopyLanes *result = push_struct(arena, BeamformerUploadCopyLanes);
+	result->lane_count = Clamp(lane_count, 1, BeamformerUploadMaxCopyLanes);
+
+	OSBarrier barrier = os_barrier_alloc(result->lane_count);
+	u64 *broadcast    = push_array(arena, u64, 8);
+	for (u32 i = 0; i < result->lane_count; i++) {
+		LaneContext *lc = &result->lanes[i].thread.lane_context;
+		lc->index            = i;
+		lc->count            = result->lane_count;
+		lc->barrier          = barrier;
+		lc->broadcast_memory = broadcast;
+		result->lanes[i].lanes = result;
+	}
+
+	for (u32 i = 1; i < result->lane_count; i++)
+		os_create_thread("[upload copy]", result->lanes + i, beamformer_upload_copy_entry_point);
+
+	return result;
+}
+
+/* NOTE(rnp): the backlog keeps whatever the trial allocation got. the rest of the heap, less
+ * a reserve for the driver and everything that isn't budgeted, is split between the raw
+ * data history and the kinds of per plan memory. the RF history gets the largest share
+ * since it scales with the raw data size times the frames in flight. recently used plans
+ * which are not active are kept in a quarter of the plan share */
+function void
+beamformer_memory_budget_init(BeamformerMemoryBudgetTable *mb, u64 heap_size, u64 backlog_size)
+{
+	mb->heap_size = heap_size;
+	mb->reserved  = Min(Max(heap_size / 16, MB(256)), heap_size / 4);
+
+	u64 remaining = heap_size - Min(heap_size, mb->reserved + backlog_size);
+	mb->budget[BeamformerMemoryBudget_Backlog]   = backlog_size;
+	mb->budget[BeamformerMemoryBudget_RFHistory] = remaining / 2;
+	mb->budget[BeamformerMemoryBudget_PingPong]  = remaining / 4;
+	mb->budget[BeamformerMemoryBudget_PlanTemp]  = remaining / 4 - remaining / 16;
+	mb->budget[BeamformerMemoryBudget_PlanCache] = remaining / 16;
+	mb->used[BeamformerMemoryBudget_Backlog]     = backlog_size;
+
+	mb->rf_frames_in_flight = BeamformerMaxRawDataFramesInFlight;
+	mb->ping_pong_slots     = PING_PONG_BUFFER_SLOTS;
+}
+
+#define COPY_BANDWIDTH_BUFFER_SIZE MB(64)
+#define COPY_BANDWIDTH_REPEATS     8
+
+/* NOTE(rnp): device to device copy bandwidth in [B/s]. this is the practical peak that the
+ * per stage bandwidth estimates are compared against. the fastest of a few repeats is taken
+ * so that clock ramp up on the first copy doesn't count. returns 0 on failure */
+function f32
+beamformer_measure_copy_bandwidth(Arena *arena)
+{
+	f32 result = 0;
+
+	GPUBuffer buffers[2] = {0};
+	for EachElement(buffers, it) {
+		gpu_buffer_allocate(buffers + it, (GPUBufferAllocateInfo){
+			.size  = COPY_BANDWIDTH_BUFFER_SIZE,
+			.flags = VulkanUsageFlag_TransferSource|VulkanUsageFlag_TransferDestination,
+			.label = str8("CopyBandwidth"),
+		});
+	}
+
+	if (buffers[0].size > 0 && buffers[1].size > 0) {
+		GPUCommandList cmd = gpu_command_list_begin(GPUTimeline_Compute);
+		for (u32 it = 0; it < COPY_BANDWIDTH_REPEATS; it++) {
+			/* NOTE(rnp): each copy reads the previous copy's destination; without the barrier
+			 * copies overlap and a zone can be shorter than one whole copy */
+			if (it != 0) gpu_command_pipeline_barrier(cmd);
+			gpu_profile_zone_begin(cmd, str8("Copy Bandwidth"), 0);
+			gpu_command_copy_buffer(cmd, buffers + (it % 2), buffers + ((it + 1) % 2), 0, COPY_BANDWIDTH_BUFFER_SIZE);
+			gpu_profile_zone_end(cmd);
+		}
+		gpu_command_list_end(cmd, (VulkanHandle){0}, (VulkanHandle){0});
+
+		Temp scratch = temp_begin(arena);
+		u32 zone_count = 0;
+		GPUProfileZone *zones = gpu_read_profile_zones(GPUTimeline_Compute, &zone_count, scratch.arena);
+
+		u64 best = U64_MAX;
+		for (u32 it = 0; it < zone_count; it++)
+			if (zones[it].end > zones[it].begin)
+				best = Min(best, zones[it].end - zones[it].begin);
+		temp_end(scratch);
+
+		if (best != U64_MAX) {
+			f64 seconds = (f64)best * 1.0e-9 * gpu_info()->timestamp_period_ns;
+			/* NOTE(rnp): every byte is read once and written once */
+			result = (f32)(2.0 * COPY_BANDWIDTH_BUFFER_SIZE / seconds);
+		}
+	}
+
+	for EachElement(buffers, it)
+		gpu_buffer_release(buffers + it);
+
+	return result;
+}
+
 BEAMFORMER_EXPORT void *
 beamformer_init(BeamformerInput *input)
 {
@@ -250,17 +418,20 @@ beamformer_init(BeamformerInput *input)
 
 	ctx->shared_memory->version = BEAMFORMER_SHARED_MEMORY_VERSION;
 	ctx->shared_memory->reserved_parameter_blocks = 1;
+	ctx->shared_memory->telemetry.timer_frequency = os_system_info()->timer_frequency;
 
 	ctx->shared_memory->beamformed_frame_buffer_size = cs->backlog.buffer->size;
 
-	// TODO(rnp): dynamic rf data buffer slot usage
-	// NOTE(rnp): will be same as the max size we were able to get for the frame buffer
-	ctx->shared_memory->capabilities.max_rf_data_size = cs->backlog.buffer->size
-	                                                    / BeamformerMaxRawDataFramesInFlight;
+	beamformer_memory_budget_init(&cs->memory_budget, gpu_info()->gpu_heap_size, (u64)cs->backlog.buffer->size);
+	cs->peak_bandwidth = beamformer_measure_copy_bandwidth(scratch);
+
+	/* NOTE(rnp): a single frame may use the whole RF history budget; it is then uploaded
+	 * without any other frames in flight. the upload size is tracked in 32 bits */
+	ctx->shared_memory->capabilities.max_rf_data_size = Min(cs->memory_budget.budget[BeamformerMemoryBudget_RFHistory],
+	                                                        U32_MAX);
 
 	ctx->shared_memory->capabilities.cuda    = cuda_supported();
-	// TODO(rnp): re-enable hilbert support, with and without cuda
-	ctx->shared_memory->capabilities.hilbert = 0;
+	ctx->shared_memory->capabilities.hilbert = 1;
 
 	/* TODO(rnp): I'm not sure if its a good idea to pre-reserve a bunch of semaphores
 	 * on w32 but thats what we are doing for now */
@@ -288,6 +459,13 @@ beamformer_init(BeamformerInput *input)
 	}
 	#endif
 
+	/* NOTE(rnp): leave room for the main, compute and upload threads */
+	ctx->job_system = job_system_create(memory, Max(os_system_info()->logical_processor_count, 4) - 3);
+
+	/* NOTE(rnp): only used when a plan can't run on the GPU; the compute thread is lane 0 */
+	cs->cpu_beamformer = beamformer_cpu_context_create(arena_create(.name = "CPU Beamformer"),
+	                                                   Max(os_system_info()->logical_processor_count, 3) - 2);
+
 	GLWorkerThreadContext *worker = &ctx->compute_worker;
 	/* TODO(rnp): we should lock this down after we have something working */
 	worker->user_context = (iptr)ctx;
@@ -301,6 +479,10 @@ beamformer_init(BeamformerInput *input)
 	upctx->shared_memory_size   = ctx->shared_memory_size;
 	upctx->compute_timing_table = ctx->compute_timing_table;
 	upctx->compute_worker_sync  = &ctx->compute_worker.sync_variable;
+	upctx->memory_budget        = &cs->memory_budget;
+	/* NOTE(rnp): a few lanes are enough to saturate memory or BAR bandwidth; the upload
+	 * tuner decides how many of them are actually used */
+	upctx->copy_lanes = beamformer_upload_copy_lanes_create(memory, os_system_info()->logical_processor_count / 4);
 	upload->handle = os_create_thread("[upload]", upload, beamformer_upload_entry_point);
 
 	/* NOTE: set up OpenGL debug logging */
@@ -38,6 +38,11 @@
  *   if loaded normally. It must be loaded using platform module loading APIs. For example
  *   GetModuleHandle or dlopen with the RTLD_NOLOAD flag set.
  *
+ * BEAMFORMER_NO_TRACING
+ *   Compile out the trace zones (see trace.c). By default the beamformer records scoped
+ *   CPU zones and GPU shader timings which the platform can write out as a Chrome/Perfetto
+ *   trace. Each zone costs roughly two timer reads.
+ *
  */
 
 #ifndef BEAMFORMER_IMPORT
@@ -62,6 +67,12 @@
   #define BEAMFORMER_RENDERDOC_HOOKS (0)
 #endif
 
+#ifdef BEAMFORMER_NO_TRACING
+  #define BEAMFORMER_TRACING (0)
+#else
+  #define BEAMFORMER_TRACING (1)
+#endif
+
 ///////////////////
 // REQUIRED OS API
 //
@@ -92,6 +103,10 @@ BEAMFORMER_IMPORT void           os_fatal(uint8_t *data, int64_t length);
 // NOTE(rnp): for vulkan cross API export on win32 (will be removed eventually)
 BEAMFORMER_IMPORT void           os_release_handle(OSHandle handle);
 
+// NOTE(rnp): used for writing out traces; files are closed with os_release_handle()
+BEAMFORMER_IMPORT OSHandle       os_create_file(const char *path);
+BEAMFORMER_IMPORT b32            os_append_file(OSHandle file, uint8_t *data, int64_t length);
+
 //////////////////////////////
 // BEAMFORMER APPLICATION API
 
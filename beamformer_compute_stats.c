@@ -1,5 +1,146 @@
 /* See LICENSE for license details. */
 
+/* NOTE(rnp): partitions of the GPU heap. Backlog holds beamformed frames, RFHistory the raw
+ * data frames in flight, PingPong the intermediates of the channel chunk stages and PlanTemp
+ * the per parameter block temporary arenas (filters, incoherent sums, ...) */
+#define BEAMFORMER_MEMORY_BUDGET_LIST \
+	X(Backlog,   "Backlog")    \
+	X(RFHistory, "RF History") \
+	X(PingPong,  "Ping Pong")  \
+	X(PlanTemp,  "Plan Temp")  \
+	X(PlanCache, "Plan Cache") \
+
+typedef enum {
+	#define X(k, ...) BeamformerMemoryBudget_##k,
+	BEAMFORMER_MEMORY_BUDGET_LIST
+	#undef X
+	BeamformerMemoryBudget_Count,
+} BeamformerMemoryBudgetKind;
+
+/* NOTE(rnp): Downgraded plans run with less memory than they would like (fewer raw data
+ * frames in flight, no overlap slot for DAS). Rejected plans are not dispatched */
+#define BEAMFORMER_PLAN_ADMISSION_LIST \
+	X(None,       "none")       \
+	X(Admitted,   "admitted")   \
+	X(Downgraded, "downgraded") \
+	X(Rejected,   "rejected")   \
+
+typedef enum {
+	#define X(k, ...) BeamformerPlanAdmission_##k,
+	BEAMFORMER_PLAN_ADMISSION_LIST
+	#undef X
+	BeamformerPlanAdmission_Count,
+} BeamformerPlanAdmission;
+
+typedef struct {
+	u64 heap_size;
+	/* NOTE(rnp): held back for the driver, presentation and small buffers */
+	u64 reserved;
+	u64 budget[BeamformerMemoryBudget_Count];
+	u64 used[BeamformerMemoryBudget_Count];
+
+	/* NOTE(rnp): admission of each parameter block's plan and a mask of the budgets which
+	 * caused it to be downgraded or rejected */
+	u8  plan_admission[BeamformerMaxParameterBlocks];
+	u8  plan_budget_mask[BeamformerMaxParameterBlocks];
+	static_assert(BeamformerMemoryBudget_Count <= 8, "");
+
+	u32 rf_frames_in_flight;
+	u32 ping_pong_slots;
+
+	/* NOTE(rnp): plan changes served from the plan cache instead of being planned again */
+	u32 plan_cache_count;
+	u64 plan_cache_hits;
+	u64 plan_cache_misses;
+} BeamformerMemoryBudgetTable;
+
+/* NOTE(rnp): log bucketed (HDR style) latency histograms. each power of two range of
+ * nanoseconds is split into BeamformerLatencySubBuckets linear buckets so a recorded value
+ * is never off by more than 1/BeamformerLatencySubBuckets (~3%). values up to ~68 s are
+ * resolved; anything longer lands in the last bucket. stage histograms are indexed by
+ * shader slot starting at BeamformerLatencyHistogram_FirstStage */
+#define BeamformerLatencySubBucketBits (5u)
+#define BeamformerLatencySubBuckets    (1u << BeamformerLatencySubBucketBits)
+#define BeamformerLatencyBuckets       (1024u)
+
+#define BEAMFORMER_LATENCY_HISTOGRAM_LIST \
+	X(FrameTime, "Frame Time") \
+	X(Upload,    "RF Upload")  \
+	X(EndToEnd,  "End to End") \
+
+typedef enum {
+	#define X(k, ...) BeamformerLatencyHistogram_##k,
+	BEAMFORMER_LATENCY_HISTOGRAM_LIST
+	#undef X
+	BeamformerLatencyHistogram_FirstStage,
+	BeamformerLatencyHistogram_Count = BeamformerLatencyHistogram_FirstStage + BeamformerMaxComputeShaderStages,
+} BeamformerLatencyHistogramKind;
+
+/* NOTE(rnp): quantiles are in units of 1/10000 */
+#define BEAMFORMER_LATENCY_PERCENTILE_LIST \
+	X(P50,  5000, "p50")   \
+	X(P90,  9000, "p90")   \
+	X(P99,  9900, "p99")   \
+	X(P999, 9990, "p99.9") \
+
+typedef enum {
+	#define X(k, ...) BeamformerLatencyPercentile_##k,
+	BEAMFORMER_LATENCY_PERCENTILE_LIST
+	#undef X
+	BeamformerLatencyPercentile_Count,
+} BeamformerLatencyPercentile;
+
+#define BeamformerLatencyWindowDefaultSamples (1024u)
+#define BeamformerLatencyWindowMaxSamples     (4096u)
+
+/* NOTE(rnp): Window covers the last BeamformerComputeStatsTable.latency_window samples of
+ * each histogram, Total every sample since the beamformer started */
+#define BEAMFORMER_LATENCY_WINDOW_LIST \
+	X(Window, "Window") \
+	X(Total,  "Total")  \
+
+typedef enum {
+	#define X(k, ...) BeamformerLatencyWindow_##k,
+	BEAMFORMER_LATENCY_WINDOW_LIST
+	#undef X
+	BeamformerLatencyWindow_Count,
+} BeamformerLatencyWindow;
+
+typedef struct {
+	u64 count;
+	/* NOTE(rnp): [s]; the upper bound of the bucket holding each value */
+	f32 percentiles[BeamformerLatencyPercentile_Count];
+	f32 max;
+} BeamformerLatencySummary;
+
+/* NOTE(rnp): points each frame passes on its way from beamformer_push_data_with_compute()
+ * to being ready for export. the second name is the interval which ends at that point */
+#define BEAMFORMER_FRAME_TIMESTAMP_LIST \
+	X(PushBegin,     "Push Begin",     "")               \
+	X(PushEnd,       "Push End",       "Client Push")    \
+	X(UploadStart,   "Upload Start",   "Upload Wait")    \
+	X(UploadEnd,     "Upload End",     "RF Upload")      \
+	X(ComputeSubmit, "Compute Submit", "Compute Record") \
+	X(GPUStart,      "GPU Start",      "GPU Queue")      \
+	X(GPUEnd,        "GPU End",        "GPU Compute")    \
+	X(FrameReady,    "Frame Ready",    "Readback")       \
+
+typedef enum {
+	#define X(k, ...) BeamformerFrameTimestamp_##k,
+	BEAMFORMER_FRAME_TIMESTAMP_LIST
+	#undef X
+	BeamformerFrameTimestamp_Count,
+} BeamformerFrameTimestamp;
+
+typedef struct {
+	u32 frame_id;
+	u32 parameter_block;
+	/* NOTE(rnp): os timer counts (BeamformerComputeStatsTable.timer_frequency). 0 when the
+	 * frame did not pass that point; frames computed from the previous upload have no push
+	 * or upload times */
+	u64 timestamps[BeamformerFrameTimestamp_Count];
+} BeamformerFrameTiming;
+
 typedef struct {
 	u64 shader_count;
 	u32 shader_ids[BeamformerMaxComputeShaderStages];
@@ -7,4 +148,22 @@ typedef struct {
 	 * visualization method you want to use. the coalescing function wants both directions */
 	f32 times[32][BeamformerMaxComputeShaderStages];
 	f32 rf_time_deltas[32];
+
+	/* NOTE(rnp): planner estimate of the bytes each stage moves and the floating point
+	 * operations it performs in a frame. divided by the stage times they give the achieved
+	 * bandwidth and throughput */
+	u64 stage_bytes[BeamformerMaxComputeShaderStages];
+	u64 stage_flops[BeamformerMaxComputeShaderStages];
+	/* NOTE(rnp): [B/s]; device to device copy bandwidth measured at startup */
+	f32 peak_bandwidth;
+
+	BeamformerMemoryBudgetTable memory;
+
+	u32 latency_window;
+	BeamformerLatencySummary latency[BeamformerLatencyWindow_Count][BeamformerLatencyHistogram_Count];
+
+	/* NOTE(rnp): the last frame_timing_count frames ordered from oldest to newest */
+	u64 timer_frequency;
+	u32 frame_timing_count;
+	BeamformerFrameTiming frame_timings[32];
 } BeamformerComputeStatsTable;
@@ -75,6 +75,28 @@
 
 #include "beamformer_internal.h"
 
+/* NOTE(rnp): a layout which a stage can consume and produce natively. the same don't care
+ * rules as BeamformerComputeGraphNode apply. cost is the number of bytes the stage is expected
+ * to move per channel chunk with this layout and variant tells the stage which one was picked */
+typedef struct {
+	BeamformerDataKind input_data_kind;
+	iv3                input_stride;
+
+	BeamformerDataKind output_data_kind;
+	iv3                output_stride;
+
+	u64                cost;
+	u32                variant;
+} BeamformerComputeGraphLayout;
+
+typedef enum {
+	BeamformerDecodeLayoutVariant_Packed,
+	BeamformerDecodeLayoutVariant_Strided,
+	BeamformerDecodeLayoutVariant_CooperativeMatrix,
+} BeamformerDecodeLayoutVariant;
+
+#define BEAMFORMER_COMPUTE_GRAPH_MAX_LAYOUTS 4
+
 typedef struct BeamformerComputeGraphNode BeamformerComputeGraphNode;
 struct BeamformerComputeGraphNode {
 	// NOTE(rnp): will be BeamformerShaderKind_Count for root node
@@ -90,6 +112,16 @@ struct BeamformerComputeGraphNode {
 	BeamformerDataKind output_data_kind;
 	iv3                output_stride;
 
+	// NOTE(rnp): stages which can run with more than one layout list them here and the
+	// negotiation pass copies the cheapest into the fields above before layouts are resolved
+	BeamformerComputeGraphLayout layouts[BEAMFORMER_COMPUTE_GRAPH_MAX_LAYOUTS];
+	u32                          layout_count;
+	u32                          layout_variant;
+
+	// NOTE(rnp): elements per channel chunk entering and leaving the stage (for costing)
+	u64                input_element_count;
+	u64                output_element_count;
+
 	i32                user_pipeline_index;
 
 	BeamformerComputeGraphNode *prev;
@@ -228,19 +260,6 @@ beamformer_frame_valid(u64 index)
 	return result;
 }
 
-function void
-beamformer_compute_plan_release(BeamformerComputeContext *cc, u32 block)
-{
-	assert(block < countof(cc->compute_plans));
-	BeamformerComputePlan *cp = cc->compute_plans[block];
-	if (cp) {
-		gpu_buffer_release(&cp->array_parameters);
-		gpu_buffer_release(&cp->gpu_temp_arena);
-		cc->compute_plans[block] = 0;
-		SLLPushFreelist(cp, cc->compute_plan_freelist);
-	}
-}
-
 function GPUResource *
 gpu_resource_from_hash(GPUResourceBuilder *rb, u64 hash)
 {
@@ -301,6 +320,17 @@ gpu_resource_push_(GPUResourceBuilder *rb, GPUResourcePushInfo info)
 	rb->position = r->offset + r->size;
 }
 
+/* NOTE(rnp): replaces old_size of the budget's usage with new_size if the result fits */
+function b32
+beamformer_memory_budget_reserve(BeamformerMemoryBudgetTable *mb, BeamformerMemoryBudgetKind kind,
+                                 u64 old_size, u64 new_size)
+{
+	u64 used   = mb->used[kind] - old_size + new_size;
+	b32 result = used <= mb->budget[kind];
+	if (result) mb->used[kind] = used;
+	return result;
+}
+
 function GPUResourceBuilder *
 gpu_resource_build_begin(Arena *arena)
 {
@@ -363,18 +393,50 @@ beamformer_compute_plan_for_block(BeamformerComputeContext *cc, u32 block, Arena
 	return result;
 }
 
+function v2 *
+complex_from_real_filter(Arena *arena, f32 *filter, i32 length)
+{
+	v2 *result = push_array(arena, v2, length);
+	for (i32 i = 0; i < length; i++)
+		result[i].x = filter[i];
+	return result;
+}
+
 function BeamformerFilter *
 beamformer_filter_create(Arena *arena, BeamformerFilterParameters fp)
 {
 	BeamformerFilter *result = push_struct(arena, BeamformerFilter);
+	result->interpolation_factor = 1;
 	switch (fp.kind) {
 	case BeamformerFilterKind_Kaiser:{
-		/* TODO(rnp): this should also support complex */
-		/* TODO(rnp): implement this as an IFIR filter instead to reduce computation */
-		result->data = kaiser_low_pass_filter(arena, fp.kaiser.cutoff_frequency, fp.sampling_frequency,
-		                                      fp.kaiser.beta, (i32)fp.kaiser.length);
-		result->length     = (i32)fp.kaiser.length;
-		result->time_delay = (f32)result->length / 2.0f / fp.sampling_frequency;
+		typeof(fp.kaiser) *k = &fp.kaiser;
+		f32 fs = fp.sampling_frequency;
+		i32 interpolation_factor = kaiser_ifir_interpolation_factor(k->cutoff_frequency, fs,
+		                                                            Max(1, (i32)k->interpolation_factor));
+		if (interpolation_factor > 1) {
+			result->interpolation_factor = interpolation_factor;
+			result->length       = (i32)ceil_f32((f32)k->length / (f32)interpolation_factor);
+			result->image_length = kaiser_ifir_image_filter_length(k->cutoff_frequency, fs, k->beta,
+			                                                       interpolation_factor);
+			result->data       = kaiser_ifir_model_filter(arena, k->cutoff_frequency, fs, k->beta,
+			                                              result->length, interpolation_factor);
+			result->image_data = kaiser_ifir_image_filter(arena, fs, k->beta, result->image_length,
+			                                              interpolation_factor);
+			result->time_delay = ((f32)(result->length * interpolation_factor) / 2.0f +
+			                      (f32)result->image_length / 2.0f) / fs;
+		} else {
+			result->length     = (i32)k->length;
+			result->data       = kaiser_low_pass_filter(arena, k->cutoff_frequency, fs, k->beta, result->length);
+			result->time_delay = (f32)result->length / 2.0f / fs;
+		}
+		result->symmetric = 1;
+
+		// NOTE(rnp): complex Kaiser is the same low pass applied to I and Q
+		if (fp.complex) {
+			result->data = complex_from_real_filter(arena, result->data, result->length);
+			if (result->image_data)
+				result->image_data = complex_from_real_filter(arena, result->image_data, result->image_length);
+		}
 	}break;
 
 	case BeamformerFilterKind_MatchedChirp:{
@@ -397,6 +459,114 @@ beamformer_filter_create(Arena *arena, BeamformerFilterParameters fp)
 	return result;
 }
 
+/* NOTE(rnp): Hilbert FIR approximation used when a line doesn't fit in shared memory */
+#define HILBERT_FIR_DEFAULT_LENGTH 63
+#define HILBERT_FIR_KAISER_BETA    5.65f
+
+/* NOTE(rnp): overlap-save fast convolution. returns the FFT size when it is expected to
+ * beat the direct form for a filter of this length and 0 otherwise. costs are complex
+ * multiplies per input sample; the direct form only evaluates the decimated outputs while
+ * the FFT form pays for a forward and inverse transform plus the spectrum product on every
+ * block. below FILTER_FFT_MINIMUM_LENGTH the extra barriers dominate regardless */
+#define FILTER_FFT_MINIMUM_LENGTH 64
+function u32
+filter_fast_convolution_size(i32 filter_length, u32 decimation_rate)
+{
+	u32 result = 0;
+	if (filter_length >= FILTER_FFT_MINIMUM_LENGTH) {
+		u64 max_size = round_down_power_of_two(gpu_info()->max_compute_shared_memory_size / sizeof(v2));
+		u64 fft_size = Min(round_up_power_of_two(4 * (u64)filter_length), max_size);
+		if (fft_size >= 2 * (u64)filter_length) {
+			f32 valid_count = (f32)(fft_size - (u64)filter_length + 1);
+			f32 fft_cost    = (f32)fft_size * ((f32)ctz_u64(fft_size) + 1) / valid_count;
+			f32 direct_cost = (f32)filter_length / (f32)decimation_rate;
+			if (fft_cost < direct_cost)
+				result = (u32)fft_size;
+		}
+	}
+	return result;
+}
+
+/* NOTE(rnp): result must be zeroed */
+function void
+filter_fast_convolution_spectrum(v2 *result, BeamformerFilter *f, u32 fft_size)
+{
+	// NOTE(rnp): the direct form correlates against the taps; reverse them so that
+	// the circular convolution produces identical output
+	for (i32 i = 0; i < f->length; i++) {
+		i32 index = f->length - 1 - i;
+		if (f->parameters.complex) result[index]   = ((v2 *)f->data)[i];
+		else                       result[index].x = ((f32 *)f->data)[i];
+	}
+	fft_complex(result, (i32)fft_size, 0);
+
+	// NOTE(rnp): fold in the inverse transform scaling
+	for (u32 i = 0; i < fft_size; i++)
+		result[i] = v2_scale(result[i], 1.0f / (f32)fft_size);
+}
+
+/* NOTE(rnp): filter design for one Demodulate/Filter stage of a plan. the design job only
+ * sizes the fast convolution spectrum; it is filled by the spectrum job (which depends on the
+ * design job) so that the planner can place it in the resource builder before it exists.
+ * everything lives in the stage's arena until the next plan */
+typedef struct {
+	Job                        design_job;
+	Job                        spectrum_job;
+	Arena                     *arena;
+	BeamformerFilterParameters parameters;
+	u32                        decimation_rate;
+
+	BeamformerFilter          *filter;
+	v2                        *spectrum;
+	u32                        fft_size;
+} BeamformerFilterDesignJob;
+
+function JOB_FUNCTION(beamformer_filter_design_job)
+{
+	BeamformerFilterDesignJob *job = user_context;
+	trace_zone_begin(str8("filter design"));
+	arena_clear(job->arena);
+	job->filter = beamformer_filter_create(job->arena, job->parameters);
+	if (job->filter->interpolation_factor == 1)
+		job->fft_size = filter_fast_convolution_size(job->filter->length, job->decimation_rate);
+	if (job->fft_size)
+		job->spectrum = push_array(job->arena, v2, job->fft_size);
+	trace_zone_end();
+}
+
+function JOB_FUNCTION(beamformer_filter_spectrum_job)
+{
+	BeamformerFilterDesignJob *job = user_context;
+	if (job->spectrum) {
+		trace_zone_begin(str8("filter spectrum"));
+		filter_fast_convolution_spectrum(job->spectrum, job->filter, job->fft_size);
+		trace_zone_end();
+	}
+}
+
+/* NOTE(rnp): fused Decode + Demodulate/Filter. x is the tile of output samples and y the
+ * number of transmits filtered concurrently. the filtered tile for every transmit must stay
+ * resident for the decode so wide tiles are traded for rows until it fits in half of shared
+ * memory. returns a zero layout when even the narrowest tile doesn't fit */
+#define DECODE_DEMODULATE_MINIMUM_WIDTH 4
+function uv3
+decode_demodulate_layout(u32 transmit_count, i32 filter_length, u32 decimation_rate)
+{
+	uv3 result        = {0};
+	u32 subgroup_size = gpu_info()->subgroup_size;
+	u64 shared_size   = gpu_info()->max_compute_shared_memory_size / 2;
+	for (u32 width = subgroup_size; width >= DECODE_DEMODULATE_MINIMUM_WIDTH; width /= 2) {
+		u32 rows = Clamp(4 * subgroup_size / width, 1, transmit_count);
+		u64 filtered_size = (u64)transmit_count * width * sizeof(v2);
+		u64 rf_size       = (u64)rows * (decimation_rate * width + (u32)filter_length - 1) * sizeof(v2);
+		if (filtered_size + rf_size <= shared_size) {
+			result = (uv3){{width, rows, 1}};
+			break;
+		}
+	}
+	return result;
+}
+
 function iv3
 das_valid_points(iv3 points)
 {
@@ -459,12 +629,87 @@ beamformer_frame_next(BeamformerComputeContext *cc, iv3 output_points, b32 compl
 	result->gpu_pointer   = bl->buffer->gpu_pointer + bl->next_offset;
 	result->points        = output_points;
 	result->data_kind     = kind;
+	memory_clear(result->timestamps, 0, sizeof(result->timestamps));
 
 	bl->next_offset += frame_size;
 
 	return result;
 }
 
+function u32
+latency_bucket_index(u64 ns)
+{
+	u32 msb    = (u32)(63 - clz_u64(ns | 1));
+	u32 shift  = msb > BeamformerLatencySubBucketBits ? msb - BeamformerLatencySubBucketBits : 0;
+	u64 result = (u64)shift * BeamformerLatencySubBuckets + (ns >> shift);
+	return (u32)Min(result, BeamformerLatencyBuckets - 1);
+}
+
+/* NOTE(rnp): largest value which maps to bucket */
+function u64
+latency_bucket_value(u32 bucket)
+{
+	u32 shift  = bucket < 2 * BeamformerLatencySubBuckets ? 0 : bucket / BeamformerLatencySubBuckets - 1;
+	u64 result = ((u64)(bucket - shift * BeamformerLatencySubBuckets) << shift) + (1ull << shift) - 1;
+	return result;
+}
+
+function void
+latency_histogram_push(LatencyHistogram *h, u32 window, u64 ns)
+{
+	u32 bucket = latency_bucket_index(ns);
+	/* NOTE(rnp): retire the sample leaving the window before its history slot is reused */
+	if (h->count >= window)
+		h->window[h->history[(h->count - window) % countof(h->history)]]--;
+	h->history[h->count % countof(h->history)] = (u16)bucket;
+	h->window[bucket]++;
+	h->total[bucket]++;
+	h->max_ns = Max(h->max_ns, ns);
+	h->count++;
+}
+
+function void
+latency_histogram_set_window(LatencyHistogram *h, u32 window)
+{
+	memory_clear(h->window, 0, sizeof(h->window));
+	for (u64 it = h->count - Min(h->count, window); it < h->count; it++)
+		h->window[h->history[it % countof(h->history)]]++;
+}
+
+function BeamformerLatencySummary
+latency_histogram_summary(LatencyHistogram *h, u32 window, BeamformerLatencyWindow kind)
+{
+	read_only local_persist u64 quantiles[BeamformerLatencyPercentile_Count] = {
+		#define X(_k, q, ...) q,
+		BEAMFORMER_LATENCY_PERCENTILE_LIST
+		#undef X
+	};
+
+	u64 *buckets = kind == BeamformerLatencyWindow_Window ? h->window : h->total;
+	BeamformerLatencySummary result = {0};
+	result.count = kind == BeamformerLatencyWindow_Window ? Min(h->count, window) : h->count;
+
+	if (result.count) {
+		u64 targets[BeamformerLatencyPercentile_Count];
+		for EachElement(quantiles, it)
+			targets[it] = Max(1, (result.count * quantiles[it] + 9999) / 10000);
+
+		u32 percentile = 0, top = 0;
+		u64 seen = 0;
+		for (u32 bucket = 0; bucket < BeamformerLatencyBuckets; bucket++) {
+			if (buckets[bucket] == 0) continue;
+			seen += buckets[bucket];
+			top   = bucket;
+			/* NOTE(rnp): every sample is <= max_ns so it bounds the bucket upper limit */
+			f32 value = (f32)Min(latency_bucket_value(bucket), h->max_ns) * 1e-9f;
+			for (; percentile < BeamformerLatencyPercentile_Count && seen >= targets[percentile]; percentile++)
+				result.percentiles[percentile] = value;
+		}
+		result.max = (f32)Min(latency_bucket_value(top), h->max_ns) * 1e-9f;
+	}
+	return result;
+}
+
 function void
 push_compute_timing_info(ComputeTimingTable *t, ComputeTimingInfo info)
 {
@@ -551,7 +796,253 @@ push_compute_graph_node(BeamformerComputeGraph *graph, BeamformerShaderKind kind
 }
 
 function void
-plan_compute_pipeline(BeamformerComputePlan *cp, BeamformerParameterBlock *pb, Arena *scratch)
+compute_graph_node_push_layout(BeamformerComputeGraphNode *node, BeamformerComputeGraphLayout layout)
+{
+	assert(node->layout_count < countof(node->layouts));
+	node->layouts[node->layout_count++] = layout;
+}
+
+function u64
+compute_graph_bytes(u64 element_count, BeamformerDataKind kind, BeamformerDataKind fallback_kind)
+{
+	if (kind == BeamformerDataKind_Count) kind = fallback_kind;
+	u64 result = element_count * beamformer_data_kind_byte_size[kind];
+	return result;
+}
+
+#define DECODE_REGISTER_PATH_MAX_TRANSMITS 40
+// NOTE(rnp): cost of an uncoalesced load; one sector per element
+#define GPU_MEMORY_TRANSACTION_BYTES       32
+
+/* NOTE(rnp): nodes which didn't list any layouts have only their fixed one. image stages
+ * cost the same regardless of the layout chosen upstream so they are left out */
+function BeamformerComputeGraphLayout
+compute_graph_node_layout(BeamformerComputeGraphNode *node, u32 index, BeamformerDataKind fallback_kind)
+{
+	BeamformerComputeGraphLayout result;
+	if (index < node->layout_count) {
+		result = node->layouts[index];
+	} else {
+		result = (BeamformerComputeGraphLayout){
+			.input_data_kind  = node->input_data_kind,
+			.input_stride     = node->input_stride,
+			.output_data_kind = node->output_data_kind,
+			.output_stride    = node->output_stride,
+		};
+		switch (node->kind) {
+		case BeamformerShaderKind_Count:
+		case BeamformerShaderKind_DAS:
+		case BeamformerShaderKind_CoherencyWeighting:
+		{}break;
+		default:{
+			result.cost = compute_graph_bytes(node->input_element_count,  node->input_data_kind,  fallback_kind) +
+			              compute_graph_bytes(node->output_element_count, node->output_data_kind, fallback_kind);
+		}break;
+		}
+	}
+	return result;
+}
+
+/* NOTE(rnp): bytes moved by the Reshape which would be needed to connect two layouts */
+function u64
+compute_graph_reshape_cost(BeamformerComputeGraphLayout *producer, BeamformerComputeGraphLayout *consumer,
+                           u64 element_count, BeamformerDataKind fallback_kind)
+{
+	b32 stride_mismatch = !bv3_any(iv3_equal(producer->output_stride, (iv3){0})) &&
+	                      !bv3_any(iv3_equal(consumer->input_stride,  (iv3){0})) &&
+	                      !bv3_all(iv3_equal(producer->output_stride, consumer->input_stride));
+	b32 kind_mismatch   = producer->output_data_kind != BeamformerDataKind_Count &&
+	                      consumer->input_data_kind  != BeamformerDataKind_Count &&
+	                      producer->output_data_kind != consumer->input_data_kind;
+	u64 result = 0;
+	if (stride_mismatch || kind_mismatch) {
+		result = compute_graph_bytes(element_count, producer->output_data_kind, fallback_kind) +
+		         compute_graph_bytes(element_count, consumer->input_data_kind,  fallback_kind);
+	}
+	return result;
+}
+
+/* NOTE(rnp): picks a layout for every node which listed alternatives such that the total
+ * bytes moved, including any Reshape needed between neighbours, is minimized. the graph is
+ * a chain and only neighbours interact so this is exact. returns the minimized cost and
+ * writes the cost of always taking each node's first (default) layout to default_cost */
+function u64
+compute_graph_negotiate_layouts(BeamformerComputeGraph *graph, BeamformerDataKind fallback_kind,
+                                u64 *default_cost, Arena scratch)
+{
+	u32 max_layouts = BEAMFORMER_COMPUTE_GRAPH_MAX_LAYOUTS;
+	u64 node_count  = graph->count;
+	u64 *costs      = push_array(&scratch, u64, node_count * max_layouts);
+	u32 *choices    = push_array(&scratch, u32, node_count * max_layouts);
+	BeamformerComputeGraphNode **nodes = push_array(&scratch, BeamformerComputeGraphNode *, node_count);
+
+	u64 node_index = 0;
+	*default_cost  = 0;
+	for (BeamformerComputeGraphNode *node = graph->first; node; node = node->next, node_index++) {
+		nodes[node_index] = node;
+		u32 layout_count  = Max(1, node->layout_count);
+		for (u32 layout = 0; layout < layout_count; layout++) {
+			BeamformerComputeGraphLayout consumer = compute_graph_node_layout(node, layout, fallback_kind);
+			u64 best_cost = node_index == 0 ? 0 : U64_MAX;
+			u32 best      = 0;
+			if (node_index > 0) {
+				for (u32 it = 0; it < Max(1, node->prev->layout_count); it++) {
+					BeamformerComputeGraphLayout producer = compute_graph_node_layout(node->prev, it, fallback_kind);
+					u64 cost = costs[(node_index - 1) * max_layouts + it] +
+					           compute_graph_reshape_cost(&producer, &consumer, node->input_element_count, fallback_kind);
+					if (cost < best_cost) {
+						best_cost = cost;
+						best      = it;
+					}
+				}
+			}
+			costs[node_index * max_layouts + layout]   = best_cost + consumer.cost;
+			choices[node_index * max_layouts + layout] = best;
+		}
+
+		BeamformerComputeGraphLayout consumer = compute_graph_node_layout(node, 0, fallback_kind);
+		*default_cost += consumer.cost;
+		if (node_index > 0) {
+			BeamformerComputeGraphLayout producer = compute_graph_node_layout(node->prev, 0, fallback_kind);
+			*default_cost += compute_graph_reshape_cost(&producer, &consumer, node->input_element_count, fallback_kind);
+		}
+	}
+
+	u64 last   = node_count - 1;
+	u32 choice = 0;
+	for (u32 it = 1; it < Max(1, nodes[last]->layout_count); it++)
+		if (costs[last * max_layouts + it] < costs[last * max_layouts + choice])
+			choice = it;
+	u64 result = costs[last * max_layouts + choice];
+
+	for (u64 it = node_count; it > 0; it--) {
+		BeamformerComputeGraphNode *node = nodes[it - 1];
+		if (node->layout_count) {
+			BeamformerComputeGraphLayout *layout = node->layouts + choice;
+			node->input_data_kind  = layout->input_data_kind;
+			node->input_stride     = layout->input_stride;
+			node->output_data_kind = layout->output_data_kind;
+			node->output_stride    = layout->output_stride;
+			node->layout_variant   = layout->variant;
+		}
+		choice = choices[(it - 1) * max_layouts + choice];
+	}
+
+	return result;
+}
+
+// NOTE(rnp): delay calculation, apodization, interpolation, and accumulation per sample
+#define DAS_FLOPS_PER_SAMPLE 32
+
+function u64
+fft_flops(u64 fft_size)
+{
+	// NOTE(rnp): standard radix-2 estimate for a complex transform
+	u64 result = 5 * fft_size * ctz_u64(round_up_power_of_two(fft_size));
+	return result;
+}
+
+/* NOTE(rnp): estimate of the memory traffic and arithmetic of one dispatch of a stage. these
+ * are the minimums the algorithm needs; caches are assumed to absorb any reuse. they only
+ * need to be good enough to tell whether a stage is bandwidth or compute bound */
+function BeamformerStageCost
+compute_plan_stage_cost(BeamformerComputeGraphNode *node, BeamformerShaderDescriptor *sd)
+{
+	BeamformerStageCost result = {0};
+
+	u64 input_components  = beamformer_data_kind_element_count[sd->input_data_kind];
+	u64 output_components = beamformer_data_kind_element_count[sd->output_data_kind];
+
+	result.bytes_read    = compute_graph_bytes(node->input_element_count,  sd->input_data_kind,  sd->input_data_kind);
+	result.bytes_written = compute_graph_bytes(node->output_element_count, sd->output_data_kind, sd->output_data_kind);
+
+	u64 output_components_total = node->output_element_count * output_components;
+
+	switch (node->kind) {
+	case BeamformerShaderKind_Decode:{
+		BeamformerDecodeBakeParameters *db = &sd->bake.Decode;
+		result.flops = 2 * (u64)db->TransmitCount * output_components_total;
+		if (node->layout_variant == BeamformerDecodeLayoutVariant_Strided &&
+		    db->TransmitCount > DECODE_REGISTER_PATH_MAX_TRANSMITS)
+		{
+			result.bytes_read = node->input_element_count * GPU_MEMORY_TRANSACTION_BYTES;
+		}
+	}break;
+
+	case BeamformerShaderKind_Demodulate:
+	case BeamformerShaderKind_Filter:
+	{
+		BeamformerFilterBakeParameters *fb = &sd->bake.Filter;
+		if (fb->FFTSize) {
+			// NOTE(rnp): forward and inverse transforms plus the spectrum multiply per block
+			u64 blocks = (u64)sd->dispatch.x * sd->dispatch.y * sd->dispatch.z;
+			result.flops = blocks * (2 * fft_flops(fb->FFTSize) + 6 * (u64)fb->FFTSize);
+		} else {
+			u64 taps = (sd->compile_flags & BeamformerFilterCompileFlags_ComplexFilter) ? 2 : 1;
+			result.flops = 2 * (u64)fb->FilterLength * taps * output_components_total;
+		}
+		if (node->kind == BeamformerShaderKind_Demodulate)
+			result.flops += 2 * node->input_element_count * input_components;
+	}break;
+
+	case BeamformerShaderKind_DecodeDemodulate:{
+		BeamformerDecodeDemodulateBakeParameters *db = &sd->bake.DecodeDemodulate;
+		u64 taps = (sd->compile_flags & BeamformerDecodeDemodulateCompileFlags_ComplexFilter) ? 2 : 1;
+		result.flops  = 2 * (u64)db->TransmitCount * node->input_element_count * input_components;
+		result.flops += 2 * (u64)db->FilterLength * taps * output_components_total;
+		if (sd->compile_flags & BeamformerDecodeDemodulateCompileFlags_Demodulate)
+			result.flops += 2 * node->input_element_count * input_components;
+	}break;
+
+	case BeamformerShaderKind_Hilbert:{
+		BeamformerHilbertBakeParameters *hb = &sd->bake.Hilbert;
+		if (hb->FIRLength) {
+			result.flops = 2 * (u64)hb->FIRLength * node->output_element_count;
+		} else {
+			u64 lines = (u64)sd->dispatch.y * sd->dispatch.z;
+			result.flops = lines * (2 * fft_flops(hb->FFTSize) + 2 * (u64)hb->FFTSize);
+		}
+	}break;
+
+	case BeamformerShaderKind_DAS:{
+		BeamformerDASBakeParameters *db = &sd->bake.DAS;
+		u64 voxels      = (u64)db->OutputSizeX * db->OutputSizeY * db->OutputSizeZ;
+		u64 voxel_bytes = beamformer_data_kind_byte_size[sd->output_data_kind];
+
+		/* NOTE(rnp): every chunk reads back and accumulates into the whole frame */
+		result.flops          = voxels * db->ChunkChannelCount * db->AcquisitionCount * DAS_FLOPS_PER_SAMPLE;
+		result.bytes_read    += voxels * voxel_bytes;
+		result.bytes_written  = voxels * voxel_bytes;
+		if (sd->compile_flags & BeamformerDASCompileFlags_CoherencyWeighting) {
+			result.bytes_read    += voxels * sizeof(f32);
+			result.bytes_written += voxels * sizeof(f32);
+		}
+	}break;
+
+	case BeamformerShaderKind_CoherencyWeighting:{
+		u64 voxels      = sd->bake.CoherencyWeighting.OutputVoxels;
+		u64 voxel_bytes = beamformer_data_kind_byte_size[sd->output_data_kind];
+		result.flops         = voxels * 6;
+		result.bytes_read    = voxels * (voxel_bytes + sizeof(f32));
+		result.bytes_written = voxels * voxel_bytes;
+	}break;
+
+	case BeamformerShaderKind_Reshape:{
+		BeamformerReshapeBakeParameters *rb = &sd->bake.Reshape;
+		u64 elements = (u64)rb->SizeX * rb->SizeY * rb->SizeZ;
+		result.bytes_read    = compute_graph_bytes(elements, sd->input_data_kind,  sd->input_data_kind);
+		result.bytes_written = compute_graph_bytes(elements, sd->output_data_kind, sd->output_data_kind);
+	}break;
+
+	default:{}break;
+	}
+
+	return result;
+}
+
+function void
+plan_compute_pipeline(BeamformerComputeContext *cc, JobSystem *js, BeamformerComputePlan *cp,
+                      BeamformerParameterBlock *pb, Arena *scratch)
 {
 	b32 run_hilbert = 0;
 	b32 demodulate  = 0;
@@ -564,7 +1055,37 @@ plan_compute_pipeline(BeamformerComputePlan *cp, BeamformerParameterBlock *pb, A
 		}
 	}
 
-	if (demodulate) run_hilbert = 0;
+	/* NOTE(rnp): filters are designed by jobs. the designs are waited on before the fusion
+	 * check and the spectra (the expensive part) are built while the graph is planned; they
+	 * are waited on before the temp arena upload */
+	Job filter_design_root, filter_spectrum_root;
+	job_init(&filter_design_root,   0, 0, str8("filter design"));
+	job_init(&filter_spectrum_root, 0, 0, str8("filter spectrum"));
+	BeamformerFilterDesignJob *filter_jobs = push_array(scratch, BeamformerFilterDesignJob, pb->pipeline.shader_count);
+	for (u32 i = 0; i < pb->pipeline.shader_count; i++) {
+		BeamformerShaderKind kind = pb->pipeline.shaders[i];
+		if (kind == BeamformerShaderKind_Demodulate || kind == BeamformerShaderKind_Filter) {
+			BeamformerFilterDesignJob *fj = filter_jobs + i;
+			if (!cc->filter_design_arenas[i])
+				cc->filter_design_arenas[i] = arena_create(.name = "Filter Design");
+			fj->arena           = cc->filter_design_arenas[i];
+			fj->parameters      = cp->filter_parameters[pb->pipeline.parameters[i].filter_slot];
+			fj->decimation_rate = kind == BeamformerShaderKind_Demodulate ? Max(pb->parameters.decimation_rate, 1) : 1;
+
+			job_init(&fj->design_job,   beamformer_filter_design_job,   fj, str8("filter design"));
+			job_init(&fj->spectrum_job, beamformer_filter_spectrum_job, fj, str8("filter spectrum"));
+			job_depends_on(&fj->spectrum_job, &fj->design_job);
+			job_add_child(&filter_design_root,   &fj->design_job);
+			job_add_child(&filter_spectrum_root, &fj->spectrum_job);
+			job_submit(js, &fj->spectrum_job);
+			job_submit(js, &fj->design_job);
+		}
+	}
+	job_submit(js, &filter_design_root);
+	job_submit(js, &filter_spectrum_root);
+
+	// NOTE(rnp): data is already analytic
+	if (demodulate || beamformer_data_kind_complex[pb->pipeline.data_kind]) run_hilbert = 0;
 
 	f32 sampling_frequency = pb->parameters.sampling_frequency;
 	u32 input_sample_count = pb->parameters.sample_count;
@@ -591,11 +1112,24 @@ plan_compute_pipeline(BeamformerComputePlan *cp, BeamformerParameterBlock *pb, A
 	BeamformerDataKind das_data_kind = cp->iq_pipeline ? BeamformerDataKind_Float32Complex
 	                                                   : BeamformerDataKind_Float32;
 
+	BeamformerMemoryBudgetTable *mb = &cc->memory_budget;
+
+	/* NOTE(rnp): chunk size downgrade. the intermediates of a channel chunk live in the ping
+	 * pong buffer so the channels per chunk are halved until the minimum (2) slots fit in the
+	 * PingPong budget. the plan is only rejected when even single channel chunks don't fit
+	 * (see beamformer_compute_plan_admit()) */
 	cp->channel_count = pb->parameters.channel_count;
 	u32 chunk_channel_count = Min(cp->channel_count, BeamformerChunkChannelCount);
+	u64 chunk_channel_size  = (u64)input_sample_count * pb->parameters.acquisition_count
+	                          * beamformer_data_kind_byte_size[das_data_kind];
+	while (chunk_channel_count > 1 &&
+	       2 * (u64)round_up_to(chunk_channel_size * chunk_channel_count, 64) > mb->budget[BeamformerMemoryBudget_PingPong])
+	{
+		chunk_channel_count /= 2;
+	}
+	cp->chunk_channel_count = chunk_channel_count;
 
-	cp->rf_size = input_sample_count * pb->parameters.acquisition_count * chunk_channel_count
-	              * beamformer_data_kind_byte_size[das_data_kind];
+	cp->rf_size = (u32)(chunk_channel_size * chunk_channel_count);
 
 	read_only local_persist BeamformerDataKind data_kind_to_element_kind[] = {
 		[BeamformerDataKind_Int16]          = BeamformerDataKind_Float16,
@@ -606,6 +1140,39 @@ plan_compute_pipeline(BeamformerComputePlan *cp, BeamformerParameterBlock *pb, A
 		[BeamformerDataKind_Float32Complex] = BeamformerDataKind_Float32,
 	};
 
+	/* NOTE(rnp): Decode acts across transmits while Demodulate/Filter act along samples; both
+	 * are linear so adjacent stages commute and can run as a single DecodeDemodulate stage.
+	 * this saves a full write and read of the channel chunk (plus the Reshape Decode would
+	 * otherwise need). only direct form filters are fused; the FFT and IFIR paths need the
+	 * shared memory which the fused stage uses for holding every transmit */
+	TraceZone("filter_design_wait") job_wait(js, &filter_design_root, scratch);
+
+	i32 fused_decode_index = -1;
+	i32 fused_filter_index = -1;
+	if (pb->parameters.decode_mode != BeamformerDecodeMode_None) {
+		for (u32 i = 0; fused_decode_index < 0 && i + 1 < pb->pipeline.shader_count; i++) {
+			u32 decode_index = i, filter_index = i + 1;
+			if (pb->pipeline.shaders[decode_index] != BeamformerShaderKind_Decode)
+				swap(decode_index, filter_index);
+
+			BeamformerShaderKind filter_kind = pb->pipeline.shaders[filter_index];
+			if (pb->pipeline.shaders[decode_index] != BeamformerShaderKind_Decode ||
+			    (filter_kind != BeamformerShaderKind_Demodulate && filter_kind != BeamformerShaderKind_Filter) ||
+			    pb->pipeline.parameters[decode_index].decode_unfused)
+			{
+				continue;
+			}
+
+			u32 rate          = filter_kind == BeamformerShaderKind_Demodulate ? decimation_rate : 1;
+			BeamformerFilter *f = filter_jobs[filter_index].filter;
+			b32 direct_form   = f->length > 0 && f->interpolation_factor == 1 && filter_jobs[filter_index].fft_size == 0;
+			if (direct_form && decode_demodulate_layout(acquisition_count, f->length, rate).x) {
+				fused_decode_index = (i32)decode_index;
+				fused_filter_index = (i32)filter_index;
+			}
+		}
+	}
+
 	//////////////////////////////////////
 	// NOTE(rnp): First Pass: build initial graph and insert hard layout constraints
 	BeamformerComputeGraph graph = {0};
@@ -619,9 +1186,21 @@ plan_compute_pipeline(BeamformerComputePlan *cp, BeamformerParameterBlock *pb, A
 	root_node->output_stride.y  = pb->parameters.sample_count * acquisition_count; // Channel Stride
 	root_node->output_stride.z  = pb->parameters.sample_count;                     // Receive Event Stride
 
+	// NOTE(rnp): when demodulating the raw samples are consumed as (I, Q) pairs
+	u64 element_count = (u64)pb->parameters.sample_count / (demodulate ? 2 : 1) * acquisition_count * chunk_channel_count;
+	u64 das_element_count = (u64)input_sample_count * acquisition_count * chunk_channel_count;
+	root_node->input_element_count  = element_count;
+	root_node->output_element_count = element_count;
+
 	for EachIndex(pb->pipeline.shader_count, it) {
+		BeamformerShaderKind kind = pb->pipeline.shaders[it];
+
+		// NOTE(rnp): the fused stage takes the place of the filter and keeps its parameters
+		if ((i32)it == fused_decode_index) continue;
+		if ((i32)it == fused_filter_index) kind = BeamformerShaderKind_DecodeDemodulate;
+
 		// NOTE(rnp): skip unnecessary shaders
-		switch (pb->pipeline.shaders[it]) {
+		switch (kind) {
 		case BeamformerShaderKind_Hilbert:{if (!run_hilbert) continue;}break;
 
 		case BeamformerShaderKind_Decode:{
@@ -639,9 +1218,17 @@ plan_compute_pipeline(BeamformerComputePlan *cp, BeamformerParameterBlock *pb, A
 		default:{}break;
 		}
 
-		BeamformerComputeGraphNode *node = push_compute_graph_node(&graph, pb->pipeline.shaders[it], scratch);
+		BeamformerComputeGraphNode *node = push_compute_graph_node(&graph, kind, scratch);
 		node->user_pipeline_index = (i32)it;
-		switch (pb->pipeline.shaders[it]) {
+		node->input_element_count = element_count;
+		if (kind == BeamformerShaderKind_Demodulate ||
+		    (kind == BeamformerShaderKind_DecodeDemodulate && pb->pipeline.shaders[it] == BeamformerShaderKind_Demodulate))
+		{
+			element_count = das_element_count;
+		}
+		node->output_element_count = element_count;
+
+		switch (kind) {
 		case BeamformerShaderKind_Decode:{
 			b32 low_precision   = beamformer_data_kind_element_size[input_data_kind] < 4;
 			b32 use_coop_matrix = gpu_info()->cooperative_matrix &&
@@ -649,20 +1236,56 @@ plan_compute_pipeline(BeamformerComputePlan *cp, BeamformerParameterBlock *pb, A
 			                      (acquisition_count   % 16 == 0) &&
 			                      (chunk_channel_count % 16 == 0);
 
-			// NOTE(rnp): fixed input layout required for reasonable performance
+			/* NOTE(rnp): the packed (transmit major) input layout is always coalesced and is the
+			 * only one cooperative matrices can load. the strided layout reads whatever the
+			 * producer wrote, avoiding the Reshape, but when the shared memory path is taken
+			 * neighbouring threads read different transmits so every load costs a full memory
+			 * transaction. register path threads walk samples so it stays coalesced */
+			BeamformerComputeGraphLayout packed = {
+				.input_stride = {{(i32)(chunk_channel_count * acquisition_count), (i32)acquisition_count, 1}},
+				.input_data_kind  = BeamformerDataKind_Count,
+				.output_data_kind = BeamformerDataKind_Count,
+				.variant          = BeamformerDecodeLayoutVariant_Packed,
+			};
 			if (low_precision && beamformer_data_kind_complex[input_data_kind])
-				node->input_data_kind = BeamformerDataKind_Float16Complex;
-			node->input_stride.x = chunk_channel_count * acquisition_count;
-			node->input_stride.y = acquisition_count;
-			node->input_stride.z = 1;
+				packed.input_data_kind = BeamformerDataKind_Float16Complex;
 
 			if (use_coop_matrix) {
-				node->input_data_kind  = BeamformerDataKind_Float16;
-				node->output_data_kind = data_kind_to_element_kind[das_data_kind];
-				node->output_stride    = node->input_stride;
+				packed.input_data_kind  = BeamformerDataKind_Float16;
+				packed.output_data_kind = data_kind_to_element_kind[das_data_kind];
+				packed.output_stride    = packed.input_stride;
+				packed.variant          = BeamformerDecodeLayoutVariant_CooperativeMatrix;
+			}
+
+			u64 output_bytes = compute_graph_bytes(element_count, packed.output_data_kind, das_data_kind);
+			packed.cost = output_bytes + compute_graph_bytes(element_count, packed.input_data_kind, input_data_kind);
+			compute_graph_node_push_layout(node, packed);
+
+			// NOTE(rnp): only offered for reading the raw data directly. raw (I, Q) pairs are
+			// addressed in units of single samples which the decode shader doesn't handle
+			if (node->prev == root_node && !demodulate) {
+				BeamformerComputeGraphLayout strided = {
+					.input_data_kind  = BeamformerDataKind_Count,
+					.output_data_kind = BeamformerDataKind_Count,
+					.variant          = BeamformerDecodeLayoutVariant_Strided,
+				};
+				// NOTE(rnp): never decode into an integer type
+				if (low_precision && beamformer_data_kind_complex[input_data_kind])
+					strided.output_data_kind = BeamformerDataKind_Float16Complex;
+
+				strided.cost = output_bytes + compute_graph_bytes(element_count, strided.input_data_kind, input_data_kind);
+				if (acquisition_count > DECODE_REGISTER_PATH_MAX_TRANSMITS)
+					strided.cost = output_bytes + element_count * GPU_MEMORY_TRANSACTION_BYTES;
+				compute_graph_node_push_layout(node, strided);
 			}
 		}break;
 
+		case BeamformerShaderKind_Hilbert:{
+			// NOTE(rnp): strides are free but data must arrive as real f32
+			node->input_data_kind  = BeamformerDataKind_Float32;
+			node->output_data_kind = das_data_kind;
+		}break;
+
 		case BeamformerShaderKind_DAS:{
 			node->input_data_kind  = das_data_kind;
 			node->input_stride.x   = 1;                                      // Sample Stride
@@ -682,6 +1305,13 @@ plan_compute_pipeline(BeamformerComputePlan *cp, BeamformerParameterBlock *pb, A
 		}
 	}
 
+	//////////////////////////////////////
+	// NOTE(rnp): Layout Negotiation: stages which listed more than one native layout get the
+	// one that minimizes bytes moved; Reshape is only inserted below when it is unavoidable
+	cp->reshape_count     = 0;
+	cp->chunk_bytes_moved = compute_graph_negotiate_layouts(&graph, das_data_kind,
+	                                                        &cp->chunk_bytes_moved_default, *scratch);
+
 	//////////////////////////////////////
 	// NOTE(rnp): Second Pass: resolve layout constraints
 	for (BeamformerComputeGraphNode *node = root_node->next; node; node = node->next) {
@@ -722,6 +1352,7 @@ plan_compute_pipeline(BeamformerComputePlan *cp, BeamformerParameterBlock *pb, A
 		}
 
 		// NOTE(rnp): insert reshape if needed
+		cp->reshape_count += needs_reshape;
 		if (needs_reshape) {
 			BeamformerComputeGraphNode *new = push_compute_graph_node(0, BeamformerShaderKind_Reshape, scratch);
 			BeamformerComputeGraphNode *last  = node->prev;
@@ -737,6 +1368,8 @@ plan_compute_pipeline(BeamformerComputePlan *cp, BeamformerParameterBlock *pb, A
 	// NOTE(rnp): ensure last node descriptor gets proper values for output data kind
 	if (graph.last->output_data_kind == BeamformerDataKind_Count)
 		graph.last->output_data_kind = graph.last->input_data_kind;
+	if (bv3_any(iv3_equal(graph.last->output_stride, (iv3){0})))
+		graph.last->output_stride = graph.last->input_stride;
 
 	f32 time_offset   = pb->parameters.time_offset;
 	u32 subgroup_size = gpu_info()->subgroup_size;
@@ -770,12 +1403,13 @@ plan_compute_pipeline(BeamformerComputePlan *cp, BeamformerParameterBlock *pb, A
 				db->OutputChannelStride  = node->output_stride.y;
 				db->OutputTransmitStride = node->output_stride.z;
 
+				db->InputSampleStride    = node->input_stride.x;
+				db->InputChannelStride   = node->input_stride.y;
+				db->InputTransmitStride  = node->input_stride.z;
+
 				db->ToProcess = 1;
 
-				b32 use_coop_matrix = gpu_info()->cooperative_matrix &&
-				                      node->input_data_kind == BeamformerDataKind_Float16 &&
-				                      (db->TransmitCount % 16 == 0) &&
-				                      (chunk_channel_count % 16 == 0);
+				b32 use_coop_matrix = node->layout_variant == BeamformerDecodeLayoutVariant_CooperativeMatrix;
 				if (use_coop_matrix) {
 					// TODO(rnp): shared memory for larger sizes
 					sd->layout = (uv3){{subgroup_size, 1, 1}};
@@ -791,7 +1425,7 @@ plan_compute_pipeline(BeamformerComputePlan *cp, BeamformerParameterBlock *pb, A
 					sd->dispatch.x = db->TransmitCount   / db->CooperativeMatrixN;
 					sd->dispatch.y = chunk_channel_count / db->CooperativeMatrixM;
 					sd->dispatch.z = decode_sample_count;
-				} else if (db->TransmitCount > 40) {
+				} else if (db->TransmitCount > DECODE_REGISTER_PATH_MAX_TRANSMITS) {
 					sd->compile_flags |= BeamformerDecodeCompileFlags_UseSharedMemory;
 
 					if (db->TransmitCount == 48)
@@ -827,7 +1461,8 @@ plan_compute_pipeline(BeamformerComputePlan *cp, BeamformerParameterBlock *pb, A
 			case BeamformerShaderKind_Filter:
 			{
 				b32 demod = node->kind == BeamformerShaderKind_Demodulate;
-				BeamformerFilter *f = beamformer_filter_create(scratch, cp->filter_parameters[sp->filter_slot]);
+				BeamformerFilterDesignJob *fj = filter_jobs + node->user_pipeline_index;
+				BeamformerFilter *f = fj->filter;
 
 				sd->compile_flags |= BeamformerFilterCompileFlags_Demodulate * demod;
 				sd->compile_flags |= BeamformerFilterCompileFlags_ComplexFilter * f->parameters.complex;
@@ -836,15 +1471,38 @@ plan_compute_pipeline(BeamformerComputePlan *cp, BeamformerParameterBlock *pb, A
 
 				BeamformerFilterBakeParameters *fb = &sd->bake.Filter;
 
-				fb->FilterLength = (u32)f->length;
-				gpu_resource_push(resource_builder, f32, f->length * (f->parameters.complex ? 2 : 1),
-				                  .data  = f->data,
-				                  .name  = push_str8_f(scratch, "filter_%u", sp->filter_slot),
-				                  .store = &fb->FilterCoefficients);
-
 				fb->SampleCount    = input_sample_count;
 				fb->DecimationRate = demod ? decimation_rate : 1;
 
+				fb->FilterLength        = (u32)f->length;
+				fb->InterpolationFactor = (u32)f->interpolation_factor;
+
+				sd->compile_flags |= BeamformerFilterCompileFlags_SymmetricFilter * f->symmetric;
+
+				fb->FFTSize = fj->fft_size;
+
+				if (f->interpolation_factor > 1) {
+					sd->compile_flags |= BeamformerFilterCompileFlags_InterpolatedFilter;
+					fb->ImageFilterLength = (u32)f->image_length;
+					gpu_resource_push(resource_builder, f32, f->image_length * (f->parameters.complex ? 2 : 1),
+					                  .data  = f->image_data,
+					                  .name  = push_str8_f(scratch, "filter_image_%u", sp->filter_slot),
+					                  .store = &fb->ImageFilterCoefficients);
+				}
+
+				if (fb->FFTSize) {
+					sd->compile_flags |= BeamformerFilterCompileFlags_FastConvolution;
+					gpu_resource_push(resource_builder, v2, fb->FFTSize,
+					                  .data  = fj->spectrum,
+					                  .name  = push_str8_f(scratch, "filter_spectrum_%u", sp->filter_slot),
+					                  .store = &fb->FilterCoefficients);
+				} else {
+					gpu_resource_push(resource_builder, f32, f->length * (f->parameters.complex ? 2 : 1),
+					                  .data  = f->data,
+					                  .name  = push_str8_f(scratch, "filter_%u", sp->filter_slot),
+					                  .store = &fb->FilterCoefficients);
+				}
+
 				b32 deinterleave =  beamformer_data_kind_complex[node->input_data_kind] &&
 				                   !beamformer_data_kind_complex[node->output_data_kind];
 				if (deinterleave)
@@ -872,10 +1530,101 @@ plan_compute_pipeline(BeamformerComputePlan *cp, BeamformerParameterBlock *pb, A
 					fb->SamplingFrequency     = pb->parameters.sampling_frequency / 2;
 				}
 
-				sd->layout     = (uv3){{subgroup_size, 1, 1}};
-				sd->dispatch.x = (u32)ceil_f32((f32)input_sample_count               / (f32)sd->layout.x);
-				sd->dispatch.y = (u32)ceil_f32((f32)chunk_channel_count              / (f32)sd->layout.y);
-				sd->dispatch.z = (u32)ceil_f32((f32)pb->parameters.acquisition_count / (f32)sd->layout.z);
+				if (fb->FFTSize) {
+					// NOTE(rnp): one workgroup per overlap-save block
+					u32 valid_count = fb->FFTSize - fb->FilterLength + 1;
+					u32 block_count = (u32)ceil_f32((f32)input_sample_count / (f32)valid_count);
+					sd->layout     = (uv3){{Min(fb->FFTSize / 2, 4 * subgroup_size), 1, 1}};
+					sd->dispatch.x = block_count;
+					sd->dispatch.y = chunk_channel_count;
+					sd->dispatch.z = pb->parameters.acquisition_count;
+				} else {
+					sd->layout     = (uv3){{subgroup_size, 1, 1}};
+					sd->dispatch.x = (u32)ceil_f32((f32)input_sample_count               / (f32)sd->layout.x);
+					sd->dispatch.y = (u32)ceil_f32((f32)chunk_channel_count              / (f32)sd->layout.y);
+					sd->dispatch.z = (u32)ceil_f32((f32)pb->parameters.acquisition_count / (f32)sd->layout.z);
+				}
+			}break;
+
+			case BeamformerShaderKind_DecodeDemodulate:{
+				b32 demod = pb->pipeline.shaders[node->user_pipeline_index] == BeamformerShaderKind_Demodulate;
+				BeamformerFilter *f = filter_jobs[node->user_pipeline_index].filter;
+
+				sd->compile_flags |= BeamformerDecodeDemodulateCompileFlags_Demodulate      * demod;
+				sd->compile_flags |= BeamformerDecodeDemodulateCompileFlags_ComplexFilter   * f->parameters.complex;
+				sd->compile_flags |= BeamformerDecodeDemodulateCompileFlags_SymmetricFilter * f->symmetric;
+
+				time_offset += f->time_delay;
+
+				BeamformerDecodeDemodulateBakeParameters *db = &sd->bake.DecodeDemodulate;
+				db->TransmitCount  = acquisition_count;
+				db->SampleCount    = input_sample_count;
+				db->DecimationRate = demod ? decimation_rate : 1;
+				db->FilterLength   = (u32)f->length;
+
+				db->OutputSampleStride   = node->output_stride.x;
+				db->OutputChannelStride  = node->output_stride.y;
+				db->OutputTransmitStride = node->output_stride.z;
+
+				db->InputSampleStride    = node->input_stride.x;
+				db->InputChannelStride   = node->input_stride.y;
+				db->InputTransmitStride  = node->input_stride.z;
+
+				// NOTE(rnp): see Demodulate above
+				if (demod) {
+					db->DemodulationFrequency = pb->parameters.demodulation_frequency;
+					db->SamplingFrequency     = pb->parameters.sampling_frequency / 2;
+				}
+
+				gpu_resource_push(resource_builder, f16, acquisition_count * acquisition_count,
+				                  .data  = make_hadamard_transpose(scratch, acquisition_count, 0),
+				                  .name  = str8("hadamard"),
+				                  .store = &db->Hadamard);
+				gpu_resource_push(resource_builder, f32, f->length * (f->parameters.complex ? 2 : 1),
+				                  .data  = f->data,
+				                  .name  = push_str8_f(scratch, "filter_%u", sp->filter_slot),
+				                  .store = &db->FilterCoefficients);
+
+				sd->layout     = decode_demodulate_layout(acquisition_count, f->length, db->DecimationRate);
+				sd->dispatch.x = (u32)ceil_f32((f32)input_sample_count / (f32)sd->layout.x);
+				sd->dispatch.y = 1;
+				sd->dispatch.z = chunk_channel_count;
+			}break;
+
+			case BeamformerShaderKind_Hilbert:{
+				BeamformerHilbertBakeParameters *hb = &sd->bake.Hilbert;
+				hb->SampleCount          = input_sample_count;
+				hb->InputSampleStride    = node->input_stride.x;
+				hb->InputChannelStride   = node->input_stride.y;
+				hb->InputTransmitStride  = node->input_stride.z;
+				hb->OutputSampleStride   = node->output_stride.x;
+				hb->OutputChannelStride  = node->output_stride.y;
+				hb->OutputTransmitStride = node->output_stride.z;
+
+				u64 fft_size    = round_up_power_of_two(input_sample_count);
+				b32 fft_fits    = fft_size * sizeof(v2) <= gpu_info()->max_compute_shared_memory_size;
+				u32 fir_length  = sp ? sp->hilbert_fir_length : 0;
+				if (fir_length == 0 && !fft_fits)
+					fir_length = HILBERT_FIR_DEFAULT_LENGTH;
+
+				if (fir_length) {
+					hb->FIRLength = fir_length | 1;
+					gpu_resource_push(resource_builder, f32, hb->FIRLength,
+					                  .data  = hilbert_fir_filter(scratch, (i32)hb->FIRLength, HILBERT_FIR_KAISER_BETA),
+					                  .name  = push_str8_f(scratch, "hilbert_fir_%u", hb->FIRLength),
+					                  .store = &hb->FIRCoefficients);
+
+					sd->compile_flags |= BeamformerHilbertCompileFlags_FIRApproximation;
+					sd->layout     = (uv3){{subgroup_size, 1, 1}};
+					sd->dispatch.x = (u32)ceil_f32((f32)input_sample_count / (f32)sd->layout.x);
+				} else {
+					// NOTE(rnp): one workgroup per line
+					hb->FFTSize    = (u32)fft_size;
+					sd->layout     = (uv3){{Min(hb->FFTSize / 2, 4 * subgroup_size), 1, 1}};
+					sd->dispatch.x = 1;
+				}
+				sd->dispatch.y = chunk_channel_count;
+				sd->dispatch.z = pb->parameters.acquisition_count;
 			}break;
 
 			case BeamformerShaderKind_DAS:{
@@ -902,6 +1651,21 @@ plan_compute_pipeline(BeamformerComputePlan *cp, BeamformerParameterBlock *pb, A
 				db->OutputSizeZ           = cp->output_points.z;
 				db->TransmitReceiveOrientation = pb->parameters.transmit_receive_orientation;
 
+				cp->speed_of_sound     = db->SpeedOfSound;
+				cp->time_offset        = db->TimeOffset;
+				cp->f_number           = db->FNumber;
+				cp->interpolation_mode = db->InterpolationMode;
+				cp->stage_time_delay   = time_offset - pb->parameters.time_offset;
+				if (cp->interactive) {
+					/* NOTE(rnp): runtime parameters come from the push constants; clearing
+					 * them here keeps the descriptor hash the same as they change */
+					sd->compile_flags    |= BeamformerDASCompileFlags_Interactive;
+					db->SpeedOfSound      = 0;
+					db->TimeOffset        = 0;
+					db->FNumber           = 0;
+					db->InterpolationMode = 0;
+				}
+
 				// NOTE(rnp): old gcc will miscompile an assignment
 				memory_copy(cp->xdc_transform.E, pb->parameters.xdc_transform.E, sizeof(cp->xdc_transform));
 
@@ -1001,6 +1765,8 @@ plan_compute_pipeline(BeamformerComputePlan *cp, BeamformerParameterBlock *pb, A
 			#endif
 
 			}
+
+			cp->stage_costs[cp->pipeline.shader_count - 1] = compute_plan_stage_cost(node, sd);
 		}
 	}
 
@@ -1009,10 +1775,21 @@ plan_compute_pipeline(BeamformerComputePlan *cp, BeamformerParameterBlock *pb, A
 	if (cp->first_image_shader_index == 0)
 		cp->first_image_shader_index = cp->pipeline.shader_count;
 
-	gpu_resource_build_end(resource_builder, &cp->gpu_temp_arena);
-}
+	TraceZone("filter_spectrum_wait") job_wait(js, &filter_spectrum_root, scratch);
 
-function void
+	/* NOTE(rnp): the temp arena is only (re)allocated if it fits in the PlanTemp budget. the
+	 * rest of the admission happens in beamformer_compute_plan_admit() */
+	u64 temp_size = gpu_round_up_to_sync_size(resource_builder->position, 64);
+	if (beamformer_memory_budget_reserve(mb, BeamformerMemoryBudget_PlanTemp, (u64)cp->gpu_temp_arena.size, temp_size)) {
+		gpu_resource_build_end(resource_builder, &cp->gpu_temp_arena);
+	} else {
+		mb->used[BeamformerMemoryBudget_PlanTemp] -= (u64)cp->gpu_temp_arena.size;
+		gpu_buffer_release(&cp->gpu_temp_arena);
+		cp->admission_budget_mask |= 1u << BeamformerMemoryBudget_PlanTemp;
+	}
+}
+
+function void
 stream_append_shader_header(Stream *s, i32 reloadable_index, BeamformerShaderDescriptor *sd, uv3 layout)
 {
 	stream_append_str8(s, str8("#version 460 core\n\n"
@@ -1147,7 +1924,7 @@ beamformer_reload_pipeline(VulkanHandle *pipeline, BeamformerShaderReloadInfo *s
 	}
 
 	vk_pipeline_release(*pipeline);
-	*pipeline = vk_pipeline(infos, count, push_constants_size);
+	*pipeline = vk_pipeline(scratch, infos, count, push_constants_size);
 }
 
 function void
@@ -1188,6 +1965,459 @@ beamformer_reload_compute_pipeline(VulkanHandle *pipeline, BeamformerShaderKind
 	beamformer_reload_pipeline(pipeline, &info, 1, scratch);
 }
 
+typedef struct {
+	VulkanHandle               *pipeline;
+	BeamformerShaderKind        shader;
+	BeamformerShaderDescriptor *shader_descriptor;
+} BeamformerShaderCompileJob;
+
+function JOB_FUNCTION(beamformer_compile_compute_shader_job)
+{
+	BeamformerShaderCompileJob *job = user_context;
+	trace_zone_begin(beamformer_shader_names[job->shader]);
+	beamformer_reload_compute_pipeline(job->pipeline, job->shader, job->shader_descriptor, scratch);
+	trace_zone_end();
+}
+
+function JOB_FUNCTION(beamformer_specialize_job)
+{
+	BeamformerSpecializeJob *job = user_context;
+	trace_zone_begin(str8("specialize DAS"));
+	beamformer_reload_compute_pipeline(&job->pipeline, BeamformerShaderKind_DAS, &job->descriptor, scratch);
+	trace_zone_end();
+}
+
+/* NOTE(rnp): the descriptor plan_compute_pipeline() would produce for the DAS stage of an
+ * interactive plan if it wasn't interactive */
+function BeamformerShaderDescriptor
+beamformer_das_specialized_descriptor(BeamformerComputePlan *cp, u32 das_slot)
+{
+	BeamformerShaderDescriptor result = cp->shader_descriptors[das_slot];
+	result.compile_flags &= ~(u32)BeamformerDASCompileFlags_Interactive;
+	result.bake.DAS.SpeedOfSound      = cp->speed_of_sound;
+	result.bake.DAS.TimeOffset        = cp->time_offset;
+	result.bake.DAS.FNumber           = cp->f_number;
+	result.bake.DAS.InterpolationMode = cp->interpolation_mode;
+	return result;
+}
+
+/* NOTE(rnp): moves an interactive plan back to a fully specialized DAS pipeline once its
+ * runtime parameters have settled (or interactive tuning was disabled). the pipeline is
+ * compiled by a background job and swapped in by the first frame after the job is done;
+ * frames keep using the interactive pipeline in the meantime. a result which no longer
+ * matches the plan is thrown away */
+function void
+beamformer_interactive_tuning_update(BeamformerCtx *ctx, BeamformerComputePlan *cp, u32 block)
+{
+	BeamformerComputeContext    *cc = &ctx->compute_context;
+	BeamformerSpecializeJob     *sj = cc->specialize_jobs + block;
+	BeamformerInteractiveTuning *it = ctx->shared_memory->interactive_tuning + block;
+
+	i32 das_slot = -1;
+	for (u32 slot = 0; slot < cp->pipeline.shader_count; slot++)
+		if (cp->pipeline.shaders[slot] == BeamformerShaderKind_DAS)
+			das_slot = (i32)slot;
+
+	b32 ready = cp->interactive && das_slot >= 0 && (cp->dirty_programs & (1u << das_slot)) == 0;
+
+	if (sj->running && job_finished(&sj->job)) {
+		sj->running = 0;
+		cc->background_compiles[block]++;
+
+		BeamformerShaderDescriptor sd = ready ? beamformer_das_specialized_descriptor(cp, (u32)das_slot)
+		                                      : (BeamformerShaderDescriptor){0};
+		if (ready && u128_equal(sj->hash, u128_hash_from_data(&sd, sizeof(sd)))) {
+			vk_pipeline_release(cp->interactive_pipeline);
+			cp->interactive_pipeline = cp->vulkan_pipelines[das_slot];
+			cp->interactive_hash     = cp->shader_hashes[das_slot];
+
+			cp->shader_descriptors[das_slot] = sd;
+			cp->vulkan_pipelines[das_slot]   = sj->pipeline;
+			cp->shader_hashes[das_slot]      = sj->hash;
+			cp->interactive = 0;
+			ready           = 0;
+		} else {
+			vk_pipeline_release(sj->pipeline);
+		}
+		sj->pipeline = (VulkanHandle){0};
+	}
+
+	if (ready && !sj->running) {
+		f32 settle_time = it->settle_time;
+		if (settle_time <= 0) settle_time = BeamformerInteractiveSettleTimeDefault;
+		u64 settle_ticks = (u64)((f64)settle_time * (f64)os_system_info()->timer_frequency);
+
+		if (atomic_load_u32(&it->disabled) || os_timer_count() - cp->interactive_last_edit >= settle_ticks) {
+			sj->descriptor = beamformer_das_specialized_descriptor(cp, (u32)das_slot);
+			sj->hash       = u128_hash_from_data(&sj->descriptor, sizeof(sj->descriptor));
+			sj->running    = 1;
+			job_init(&sj->job, beamformer_specialize_job, sj, str8("specialize DAS"));
+			job_submit(ctx->job_system, &sj->job);
+		}
+	}
+}
+
+#if defined(BEAMFORMER_DEBUG)
+function void
+beamformer_compute_plan_log(BeamformerComputePlan *cp, u32 block, Arena arena)
+{
+	Stream sb = arena_stream(&arena);
+	stream_appendf(&sb, "[plan %u] ", block);
+	for (u32 i = 0; i < cp->pipeline.shader_count; i++) {
+		if (i != 0) stream_append_str8(&sb, str8(" -> "));
+		stream_append_str8(&sb, beamformer_shader_names[cp->pipeline.shaders[i]]);
+	}
+
+	f64 saved = (f64)cp->chunk_bytes_moved_default - (f64)cp->chunk_bytes_moved;
+	stream_appendf(&sb, " | reshapes: %u | bytes/chunk: %0.2f MB (naive: %0.2f MB, saved %0.2f MB)\n",
+	               cp->reshape_count, (f64)cp->chunk_bytes_moved / MB(1),
+	               (f64)cp->chunk_bytes_moved_default / MB(1), saved / MB(1));
+	os_console_log(sb.data, sb.widx);
+}
+#else
+#define beamformer_compute_plan_log(...)
+#endif
+
+/* NOTE(rnp): checks a freshly planned pipeline against the memory budgets. a plan that
+ * doesn't fit is downgraded when there is a cheaper way to run it and is otherwise rejected
+ * with a message instead of failing an allocation in the middle of a frame */
+function void
+beamformer_compute_plan_admit(BeamformerCtx *ctx, BeamformerComputePlan *cp, u32 block, Arena arena)
+{
+	BeamformerComputeContext    *cc = &ctx->compute_context;
+	BeamformerMemoryBudgetTable *mb = &cc->memory_budget;
+
+	/* NOTE(rnp): PlanTemp was already checked and the chunk size already downgraded by
+	 * plan_compute_pipeline() */
+	u32 rejected   = cp->admission_budget_mask;
+	u32 downgraded = 0;
+	if (cp->chunk_channel_count < Min(cp->channel_count, BeamformerChunkChannelCount))
+		downgraded |= 1u << BeamformerMemoryBudget_PingPong;
+
+	BeamformerDataKind frame_kind = cp->iq_pipeline ? BeamformerDataKind_Float32Complex
+	                                                : BeamformerDataKind_Float32;
+	if (beamformer_frame_byte_size(cp->output_points, frame_kind) > mb->budget[BeamformerMemoryBudget_Backlog])
+		rejected |= 1u << BeamformerMemoryBudget_Backlog;
+
+	/* NOTE(rnp): the RF history itself is sized by the upload thread; here it only matters
+	 * whether a frame fits and if it fits as many times as there can be frames in flight */
+	u64 rf_budget = mb->budget[BeamformerMemoryBudget_RFHistory];
+	u64 raw_size  = (u64)cp->raw_channel_byte_stride * cp->channel_count;
+	if (raw_size > Min(rf_budget, U32_MAX))
+		rejected |= 1u << BeamformerMemoryBudget_RFHistory;
+	else if (raw_size * BeamformerMaxRawDataFramesInFlight > rf_budget)
+		downgraded |= 1u << BeamformerMemoryBudget_RFHistory;
+
+	/* NOTE(rnp): the ping pong buffer is shared by every plan so it only grows. when the DAS
+	 * slot doesn't fit the stage feeding DAS writes to the regular output slot instead */
+	if (!rejected) {
+		u64 budget     = mb->budget[BeamformerMemoryBudget_PingPong];
+		u64 slot_size  = Max(cc->ping_pong_slot_size, (u64)round_up_to(cp->rf_size, 64));
+		u32 slot_count = PING_PONG_BUFFER_SLOTS;
+		while (slot_count > 2 && slot_count * slot_size > budget)
+			slot_count--;
+
+		if (slot_count * slot_size > budget) {
+			rejected |= 1u << BeamformerMemoryBudget_PingPong;
+		} else {
+			if (slot_count < PING_PONG_BUFFER_SLOTS)
+				downgraded |= 1u << BeamformerMemoryBudget_PingPong;
+
+			if ((u64)cc->ping_pong_buffer.size < slot_count * slot_size) {
+				b32 cuda = cuda_supported();
+				GPUBufferAllocateInfo allocate_info = {
+					.size   = slot_count * slot_size,
+					.export = cuda ? &cc->ping_pong_export_handle : 0,
+					.label  = str8("PingPongBuffer"),
+				};
+				gpu_buffer_allocate(&cc->ping_pong_buffer, allocate_info);
+				mb->used[BeamformerMemoryBudget_PingPong] = (u64)cc->ping_pong_buffer.size;
+
+				BeamformerShaderResourceInfo shader_resource_infos[] = {
+					{
+						.kind   = BeamformerShaderResourceKind_Buffer,
+						.handle = cc->ping_pong_buffer.handle,
+						.slot   = BeamformerShaderBufferSlot_PingPong,
+					},
+				};
+				vk_bind_shader_resources(shader_resource_infos, countof(shader_resource_infos));
+
+				// TODO(rnp): figure out how to share with CUDA
+				// IMPORTANT: on linux the handle is returned to os and should be cleared after import
+				// see usage of glImportMemoryFdEXT and surrounding code in ui.c for examples
+				if (cuda) {
+				}
+			}
+
+			if (cc->ping_pong_buffer.size == 0) {
+				rejected |= 1u << BeamformerMemoryBudget_PingPong;
+			} else {
+				cc->ping_pong_slot_size  = slot_size;
+				cc->ping_pong_slot_count = slot_count;
+				mb->ping_pong_slots      = slot_count;
+			}
+		}
+	}
+
+	/* NOTE(rnp): a rejected plan gives back its temp arena so that it doesn't crowd out the
+	 * plans that can run */
+	if (rejected) {
+		mb->used[BeamformerMemoryBudget_PlanTemp] -= (u64)cp->gpu_temp_arena.size;
+		gpu_buffer_release(&cp->gpu_temp_arena);
+	}
+
+	cp->admission_budget_mask = rejected ? rejected : downgraded;
+	if      (rejected)   cp->admission = BeamformerPlanAdmission_Rejected;
+	else if (downgraded) cp->admission = BeamformerPlanAdmission_Downgraded;
+	else                 cp->admission = BeamformerPlanAdmission_Admitted;
+
+	mb->plan_admission[block]   = (u8)cp->admission;
+	mb->plan_budget_mask[block] = (u8)cp->admission_budget_mask;
+
+	if (cp->admission != BeamformerPlanAdmission_Admitted) {
+		Stream sb   = arena_stream(&arena);
+		str8   kind = beamformer_plan_admission_names[cp->admission];
+		stream_appendf(&sb, "[%s] parameter block %u %.*s by memory budget:", rejected ? "error" : "info",
+		               block, (i32)kind.length, kind.data);
+		for EachBit(cp->admission_budget_mask, it) {
+			str8 name = beamformer_memory_budget_names[it];
+			stream_appendf(&sb, " %.*s (%0.1f MiB)", (i32)name.length, name.data, (f64)mb->budget[it] / MB(1));
+		}
+		stream_append_byte(&sb, '\n');
+		os_console_log(sb.data, sb.widx);
+	}
+}
+
+/* NOTE(rnp): hash of everything plan_compute_pipeline() reads */
+function u128
+beamformer_compute_plan_key(BeamformerComputePlan *cp, BeamformerParameterBlock *pb)
+{
+	struct {
+		BeamformerParameters       parameters;
+		BeamformerComputePipeline  pipeline;
+		BeamformerFilterParameters filter_parameters[BeamformerFilterSlots];
+		m4                         ui_voxel_transform;
+	} inputs;
+	zero_struct(&inputs);
+
+	inputs.parameters = pb->parameters;
+	inputs.pipeline   = pb->pipeline;
+	memory_copy(inputs.filter_parameters, cp->filter_parameters, sizeof(inputs.filter_parameters));
+	memory_copy(inputs.ui_voxel_transform.E, cp->ui_voxel_transform.E, sizeof(inputs.ui_voxel_transform));
+
+	/* NOTE(rnp): DAS runtime parameters are tracked by beamformer_compute_plan_runtime_key() */
+	inputs.parameters.speed_of_sound     = 0;
+	inputs.parameters.time_offset        = 0;
+	inputs.parameters.f_number           = 0;
+	inputs.parameters.interpolation_mode = 0;
+
+	u128 result = u128_hash_from_data(&inputs, sizeof(inputs));
+	return result;
+}
+
+function u128
+beamformer_compute_plan_runtime_key(BeamformerParameterBlock *pb)
+{
+	struct {
+		f32 speed_of_sound;
+		f32 time_offset;
+		f32 f_number;
+		u32 interpolation_mode;
+	} inputs = {
+		.speed_of_sound     = pb->parameters.speed_of_sound,
+		.time_offset        = pb->parameters.time_offset,
+		.f_number           = pb->parameters.f_number,
+		.interpolation_mode = pb->parameters.interpolation_mode,
+	};
+	u128 result = u128_hash_from_data(&inputs, sizeof(inputs));
+	return result;
+}
+
+function void
+beamformer_compute_plan_release_resources(BeamformerComputePlan *cp)
+{
+	gpu_buffer_release(&cp->gpu_temp_arena);
+	for EachElement(cp->vulkan_pipelines, it) {
+		vk_pipeline_release(cp->vulkan_pipelines[it]);
+		cp->vulkan_pipelines[it] = (VulkanHandle){0};
+	}
+	vk_pipeline_release(cp->interactive_pipeline);
+	cp->interactive_pipeline = (VulkanHandle){0};
+}
+
+function b32
+beamformer_compute_plan_uses_array_parameters(BeamformerComputePlan *cp, u64 gpu_pointer)
+{
+	b32 result = 0;
+	for (u32 slot = 0; !result && slot < cp->pipeline.shader_count; slot++) {
+		result = cp->pipeline.shaders[slot] == BeamformerShaderKind_DAS &&
+		         cp->shader_descriptors[slot].bake.DAS.ArrayParameters == gpu_pointer;
+	}
+	return result;
+}
+
+/* NOTE(rnp): removes a plan without releasing it; the last plan takes its place */
+function void
+beamformer_plan_cache_remove(BeamformerComputeContext *cc, u32 index)
+{
+	BeamformerPlanCache *pc = &cc->plan_cache;
+	assert(index < pc->count);
+	cc->memory_budget.used[BeamformerMemoryBudget_PlanCache] -= (u64)pc->plans[index].gpu_temp_arena.size;
+
+	pc->count--;
+	if (index != pc->count) {
+		pc->plans[index]     = pc->plans[pc->count];
+		pc->last_used[index] = pc->last_used[pc->count];
+	}
+	cc->memory_budget.plan_cache_count = pc->count;
+}
+
+function void
+beamformer_plan_cache_evict_lru(BeamformerComputeContext *cc)
+{
+	BeamformerPlanCache *pc = &cc->plan_cache;
+	u32 lru = 0;
+	for (u32 it = 1; it < pc->count; it++)
+		if (pc->last_used[it] < pc->last_used[lru]) lru = it;
+	beamformer_compute_plan_release_resources(pc->plans + lru);
+	beamformer_plan_cache_remove(cc, lru);
+}
+
+/* NOTE(rnp): moves the built state of cp (temp arena, pipelines, descriptors) into the
+ * cache. cp is left without a temp arena or pipelines and must be planned again */
+function void
+beamformer_plan_cache_store(BeamformerComputeContext *cc, BeamformerComputePlan *cp)
+{
+	BeamformerPlanCache         *pc = &cc->plan_cache;
+	BeamformerMemoryBudgetTable *mb = &cc->memory_budget;
+
+	u64 size = (u64)cp->gpu_temp_arena.size;
+	mb->used[BeamformerMemoryBudget_PlanTemp] -= size;
+
+	while (pc->count > 0 && (pc->count == countof(pc->plans) ||
+	                         mb->used[BeamformerMemoryBudget_PlanCache] + size > mb->budget[BeamformerMemoryBudget_PlanCache]))
+	{
+		beamformer_plan_cache_evict_lru(cc);
+	}
+
+	BeamformerComputePlan entry = *cp;
+	zero_struct(&entry.array_parameters);
+	entry.next = 0;
+
+	/* NOTE(rnp): pipelines still waiting to be compiled don't match their hash */
+	for EachBit(atomic_swap_u32(&cp->dirty_programs, 0), slot)
+		entry.shader_hashes[slot] = (u128){0};
+	entry.dirty_programs = 0;
+
+	zero_struct(&cp->gpu_temp_arena);
+	zero_struct(&cp->vulkan_pipelines);
+	zero_struct(&cp->shader_hashes);
+	zero_struct(&cp->interactive_pipeline);
+	zero_struct(&cp->interactive_hash);
+
+	if (cp->admission != BeamformerPlanAdmission_Rejected &&
+	    mb->used[BeamformerMemoryBudget_PlanCache] + size <= mb->budget[BeamformerMemoryBudget_PlanCache])
+	{
+		pc->plans[pc->count]     = entry;
+		pc->last_used[pc->count] = pc->use_counter++;
+		pc->count++;
+		mb->used[BeamformerMemoryBudget_PlanCache] += size;
+		mb->plan_cache_count = pc->count;
+	} else {
+		beamformer_compute_plan_release_resources(&entry);
+	}
+}
+
+/* NOTE(rnp): moves a cached plan into cp after cp has been stored. the block's own array
+ * parameters and UI transform stay with it */
+function void
+beamformer_compute_plan_restore(BeamformerComputeContext *cc, BeamformerComputePlan *cp,
+                                BeamformerComputePlan *cached)
+{
+	BeamformerMemoryBudgetTable *mb = &cc->memory_budget;
+
+	GPUBuffer array_parameters   = cp->array_parameters;
+	m4        ui_voxel_transform = cp->ui_voxel_transform;
+	*cp = *cached;
+	cp->array_parameters = array_parameters;
+	memory_copy(cp->ui_voxel_transform.E, ui_voxel_transform.E, sizeof(ui_voxel_transform));
+	cp->next = 0;
+
+	/* NOTE(rnp): the cache is shared by all blocks and the plan may have been built by
+	 * another one. its DAS stage must read this block's array parameters; the changed
+	 * descriptor no longer matches its hash so the stage is compiled again on commit */
+	for (u32 slot = 0; slot < cp->pipeline.shader_count; slot++) {
+		BeamformerDASBakeParameters *db = &cp->shader_descriptors[slot].bake.DAS;
+		if (cp->pipeline.shaders[slot] == BeamformerShaderKind_DAS &&
+		    db->ArrayParameters != array_parameters.gpu_pointer)
+		{
+			db->ArrayParameters = array_parameters.gpu_pointer;
+			vk_pipeline_release(cp->interactive_pipeline);
+			cp->interactive_pipeline = (VulkanHandle){0};
+			cp->interactive_hash     = (u128){0};
+		}
+	}
+
+	cp->admission             = BeamformerPlanAdmission_None;
+	cp->admission_budget_mask = 0;
+	if (!beamformer_memory_budget_reserve(mb, BeamformerMemoryBudget_PlanTemp, 0, (u64)cp->gpu_temp_arena.size)) {
+		gpu_buffer_release(&cp->gpu_temp_arena);
+		cp->admission_budget_mask |= 1u << BeamformerMemoryBudget_PlanTemp;
+	}
+}
+
+function void
+beamformer_compute_plan_release(BeamformerComputeContext *cc, u32 block)
+{
+	assert(block < countof(cc->compute_plans));
+	BeamformerComputePlan *cp = cc->compute_plans[block];
+	if (cp) {
+		cc->memory_budget.used[BeamformerMemoryBudget_PlanTemp] -= (u64)cp->gpu_temp_arena.size;
+		cc->memory_budget.plan_admission[block]   = BeamformerPlanAdmission_None;
+		cc->memory_budget.plan_budget_mask[block] = 0;
+
+		/* NOTE(rnp): cached plans left by this block have its array parameters baked into
+		 * their DAS pipelines; they must not outlive the buffer */
+		BeamformerPlanCache *pc = &cc->plan_cache;
+		for (u32 it = 0; it < pc->count;) {
+			if (beamformer_compute_plan_uses_array_parameters(pc->plans + it, cp->array_parameters.gpu_pointer)) {
+				beamformer_compute_plan_release_resources(pc->plans + it);
+				beamformer_plan_cache_remove(cc, it);
+			} else {
+				it++;
+			}
+		}
+
+		gpu_buffer_release(&cp->array_parameters);
+		gpu_buffer_release(&cp->gpu_temp_arena);
+		cc->compute_plans[block] = 0;
+		SLLPushFreelist(cp, cc->compute_plan_freelist);
+	}
+}
+
+/* NOTE(rnp): compiled pipelines are matched by shader and descriptor hash so a plan which
+ * shares stages with a cached plan doesn't compile them again. the cached plan will compile
+ * that stage if it is ever restored */
+function b32
+beamformer_plan_cache_take_pipeline(BeamformerPlanCache *pc, BeamformerShaderKind shader, u128 hash,
+                                    VulkanHandle *pipeline)
+{
+	b32 result = 0;
+	for (u32 it = 0; !result && it < pc->count; it++) {
+		BeamformerComputePlan *cached = pc->plans + it;
+		for (u32 slot = 0; !result && slot < cached->pipeline.shader_count; slot++) {
+			if (cached->pipeline.shaders[slot] == shader && u128_equal(hash, cached->shader_hashes[slot])) {
+				vk_pipeline_release(*pipeline);
+				*pipeline = cached->vulkan_pipelines[slot];
+				cached->vulkan_pipelines[slot] = (VulkanHandle){0};
+				cached->shader_hashes[slot]    = (u128){0};
+				result = 1;
+			}
+		}
+	}
+	return result;
+}
+
 function void
 beamformer_commit_parameter_block(BeamformerCtx *ctx, BeamformerComputePlan *cp, u32 block, Arena *scratch)
 {
@@ -1205,10 +2435,89 @@ beamformer_commit_parameter_block(BeamformerCtx *ctx, BeamformerComputePlan *cp,
 		case BeamformerParameterRegionFlag_ComputePipeline:
 		case BeamformerParameterRegionFlag_Parameters:
 		{
-			cp->output_points  = das_valid_points(pb->parameters.output_points.xyz);
-			cp->average_frames = pb->parameters.output_points.E[3];
+			BeamformerComputeContext *cc = &ctx->compute_context;
+			BeamformerPlanCache      *pc = &cc->plan_cache;
+			if (atomic_swap_u32(&pc->invalid, 0)) {
+				while (pc->count) beamformer_plan_cache_evict_lru(cc);
+			}
 
-			plan_compute_pipeline(cp, pb, scratch);
+			/* NOTE(rnp): when the inputs change the current plan is cached and a cached plan
+			 * for the new inputs is restored if there is one. unchanged inputs are planned
+			 * again in place */
+			b32  restored    = 0;
+			b32  interactive = cp->interactive;
+			u128 key         = beamformer_compute_plan_key(cp, pb);
+			u128 runtime_key = beamformer_compute_plan_runtime_key(pb);
+
+			/* NOTE(rnp): a change to only the DAS runtime parameters makes the plan interactive
+			 * (see BeamformerInteractiveTuning) */
+			BeamformerInteractiveTuning *tuning = ctx->shared_memory->interactive_tuning + block;
+			if (atomic_load_u32(&tuning->disabled)) {
+				cp->interactive = 0;
+			} else if (u128_equal(key, cp->plan_key) && !u128_equal(runtime_key, cp->runtime_key)) {
+				cp->interactive           = 1;
+				cp->interactive_last_edit = os_timer_count();
+			}
+
+			/* NOTE(rnp): an interactive plan reads the runtime parameters from the push
+			 * constants so a runtime only edit doesn't need to be planned again */
+			if (interactive && cp->interactive && u128_equal(key, cp->plan_key)) {
+				cp->speed_of_sound     = pb->parameters.speed_of_sound;
+				cp->time_offset        = pb->parameters.time_offset + cp->stage_time_delay;
+				cp->f_number           = pb->parameters.f_number;
+				cp->interpolation_mode = pb->parameters.interpolation_mode;
+				cp->runtime_key        = runtime_key;
+
+				pb->region_update_flags &= ~(1u << BeamformerParameterBlockRegion_ComputePipeline |
+				                             1u << BeamformerParameterBlockRegion_Parameters);
+				break;
+			}
+
+			if (!u128_equal(key, cp->plan_key)) {
+				BeamformerComputePlan cached;
+				for (u32 it = 0; !restored && it < pc->count; it++) {
+					if (u128_equal(key, pc->plans[it].plan_key)) {
+						cached = pc->plans[it];
+						beamformer_plan_cache_remove(cc, it);
+						restored = 1;
+					}
+				}
+
+				if (!u128_equal(cp->plan_key, (u128){0}))
+					beamformer_plan_cache_store(cc, cp);
+
+				if (restored) {
+					beamformer_compute_plan_restore(cc, cp, &cached);
+					cc->memory_budget.plan_cache_hits++;
+				} else {
+					cc->memory_budget.plan_cache_misses++;
+				}
+
+				/* NOTE(rnp): a cached plan built for other runtime parameters still provides
+				 * its pipelines and temp arena but must be planned again */
+				if (restored && !u128_equal(runtime_key, cp->runtime_key)) {
+					if (atomic_load_u32(&tuning->disabled)) {
+						cp->interactive = 0;
+					} else {
+						cp->interactive           = 1;
+						cp->interactive_last_edit = os_timer_count();
+					}
+					restored = 0;
+				}
+			}
+
+			if (!restored) {
+				cp->output_points  = das_valid_points(pb->parameters.output_points.xyz);
+				cp->average_frames = pb->parameters.output_points.E[3];
+
+				cp->admission             = BeamformerPlanAdmission_None;
+				cp->admission_budget_mask = 0;
+
+				plan_compute_pipeline(cc, ctx->job_system, cp, pb, scratch);
+				beamformer_compute_plan_log(cp, block, *scratch);
+			}
+			cp->plan_key    = key;
+			cp->runtime_key = runtime_key;
 
 			/* NOTE(rnp): these are both handled by plan_compute_pipeline() */
 			u32 mask = 1 << BeamformerParameterBlockRegion_ComputePipeline |
@@ -1217,8 +2526,17 @@ beamformer_commit_parameter_block(BeamformerCtx *ctx, BeamformerComputePlan *cp,
 
 			for (u32 shader_slot = 0; shader_slot < cp->pipeline.shader_count; shader_slot++) {
 				u128 hash = u128_hash_from_data(cp->shader_descriptors + shader_slot, sizeof(BeamformerShaderDescriptor));
-				if (!u128_equal(hash, cp->shader_hashes[shader_slot]))
-					cp->dirty_programs |= 1 << shader_slot;
+				if (!u128_equal(hash, cp->shader_hashes[shader_slot])) {
+					VulkanHandle *pipeline = cp->vulkan_pipelines + shader_slot;
+					if (vk_pipeline_valid(cp->interactive_pipeline) && u128_equal(hash, cp->interactive_hash)) {
+						/* NOTE(rnp): the specialized pipeline was built for the old runtime parameters */
+						vk_pipeline_release(*pipeline);
+						*pipeline = cp->interactive_pipeline;
+						cp->interactive_pipeline = (VulkanHandle){0};
+					} else if (!beamformer_plan_cache_take_pipeline(pc, cp->pipeline.shaders[shader_slot], hash, pipeline)) {
+						cp->dirty_programs |= 1 << shader_slot;
+					}
+				}
 				cp->shader_hashes[shader_slot] = hash;
 			}
 
@@ -1226,31 +2544,7 @@ beamformer_commit_parameter_block(BeamformerCtx *ctx, BeamformerComputePlan *cp,
 			cp->acquisition_kind  = pb->parameters.acquisition_kind;
 			cp->contrast_mode     = pb->parameters.contrast_mode;
 
-			i64 buffer_size = PING_PONG_BUFFER_SLOTS * round_up_to(cp->rf_size, 64);
-			if (ctx->compute_context.ping_pong_buffer.size < buffer_size) {
-				b32 cuda = cuda_supported();
-				GPUBufferAllocateInfo allocate_info = {
-					.size   = buffer_size,
-					.export = cuda ? &ctx->compute_context.ping_pong_export_handle : 0,
-					.label  = str8("PingPongBuffer"),
-				};
-				gpu_buffer_allocate(&ctx->compute_context.ping_pong_buffer, allocate_info);
-
-				BeamformerShaderResourceInfo shader_resource_infos[] = {
-					{
-						.kind   = BeamformerShaderResourceKind_Buffer,
-						.handle = ctx->compute_context.ping_pong_buffer.handle,
-						.slot   = BeamformerShaderBufferSlot_PingPong,
-					},
-				};
-				vk_bind_shader_resources(shader_resource_infos, countof(shader_resource_infos));
-
-				// TODO(rnp): figure out how to share with CUDA
-				// IMPORTANT: on linux the handle is returned to os and should be cleared after import
-				// see usage of glImportMemoryFdEXT and surrounding code in ui.c for examples
-				if (cuda) {
-				}
-			}
+			beamformer_compute_plan_admit(ctx, cp, block, *scratch);
 		}break;
 
 		case BeamformerParameterBlockRegion_ChannelMapping:{
@@ -1294,9 +2588,10 @@ do_compute_shader(BeamformerCtx *ctx, GPUCommandList cmd, BeamformerComputePlan
 
 	u32 output_index     = !cc->ping_pong_input_index;
 	u32 input_index      =  cc->ping_pong_input_index;
-	u32 das_output_index =  PING_PONG_BUFFER_SLOTS - 1;
+	u32 das_output_index =  cc->ping_pong_slot_count == PING_PONG_BUFFER_SLOTS ? PING_PONG_BUFFER_SLOTS - 1
+	                                                                           : output_index;
 
-	u64 pp_size           = cc->ping_pong_buffer.size / PING_PONG_BUFFER_SLOTS;
+	u64 pp_size           = cc->ping_pong_slot_size;
 	u64 pp_input_pointer  = cc->ping_pong_buffer.gpu_pointer + input_index      * pp_size;
 	u64 pp_output_pointer = cc->ping_pong_buffer.gpu_pointer + output_index     * pp_size;
 	u64 pp_das_pointer    = cc->ping_pong_buffer.gpu_pointer + das_output_index * pp_size;
@@ -1310,12 +2605,13 @@ do_compute_shader(BeamformerCtx *ctx, GPUCommandList cmd, BeamformerComputePlan
 	switch (cp->pipeline.shaders[shader_slot]) {
 
 	case BeamformerShaderKind_Decode:{
-		BeamformerDecodePushConstants pc = {.rf_buffer = pp_input_pointer};
+		BeamformerDecodePushConstants pc = {.rf_buffer = shader_slot == 0 ? rf_pointer : pp_input_pointer};
 
 		if ((shader_slot + 1) == das_index) pc.output_buffer = pp_das_pointer;
 		else                                pc.output_buffer = pp_output_pointer;
 
-		gpu_command_pipeline_barrier(cmd);
+		if (shader_slot != 0 || (shader_slot + 1) == das_index)
+			gpu_command_pipeline_barrier(cmd);
 		gpu_command_push_constants(cmd, 0, sizeof(pc), &pc);
 		gpu_command_dispatch_compute(cmd, dispatch);
 
@@ -1323,15 +2619,33 @@ do_compute_shader(BeamformerCtx *ctx, GPUCommandList cmd, BeamformerComputePlan
 	}break;
 
 	case BeamformerShaderKind_Hilbert:{
-		cuda_hilbert(input_index, output_index);
+		BeamformerDataKind output_data_kind = cp->shader_descriptors[shader_slot].output_data_kind;
+
+		u64 element_size = beamformer_data_kind_byte_size[output_data_kind];
+		BeamformerHilbertPushConstants pc = {
+			.input_data            = pp_input_pointer,
+			.output_element_offset = output_index * pp_size / element_size,
+		};
+
+		if ((shader_slot + 1) == das_index)
+			pc.output_element_offset = das_output_index * pp_size / element_size;
+
+		gpu_command_pipeline_barrier(cmd);
+		gpu_command_push_constants(cmd, 0, sizeof(pc), &pc);
+		gpu_command_dispatch_compute(cmd, dispatch);
+
 		cc->ping_pong_input_index = !cc->ping_pong_input_index;
 	}break;
 
 	case BeamformerShaderKind_Filter:
 	case BeamformerShaderKind_Demodulate:
+	case BeamformerShaderKind_DecodeDemodulate:
 	{
 		BeamformerDataKind output_data_kind = cp->shader_descriptors[shader_slot].output_data_kind;
 
+		static_assert(sizeof(BeamformerFilterPushConstants) == sizeof(BeamformerDecodeDemodulatePushConstants),
+		              "Filter and DecodeDemodulate must share push constant layout");
+
 		u64 element_size = beamformer_data_kind_byte_size[output_data_kind];
 		BeamformerFilterPushConstants pc = {
 			.input_data            = shader_slot == 0 ? rf_pointer : pp_input_pointer,
@@ -1354,11 +2668,15 @@ do_compute_shader(BeamformerCtx *ctx, GPUCommandList cmd, BeamformerComputePlan
 		u64 element_size = beamformer_data_kind_byte_size[cp->shader_descriptors[shader_slot].input_data_kind];
 
 		BeamformerDASPushConstants pc = {
-			.xdc_element_pitch = cp->xdc_element_pitch,
-			.rf_element_offset = das_output_index * pp_size / element_size,
-			.output_frame      = frame->gpu_pointer,
-			.channel_offset    = channel_offset,
-			.readi_group       = cp->readi_group,
+			.xdc_element_pitch  = cp->xdc_element_pitch,
+			.rf_element_offset  = das_output_index * pp_size / element_size,
+			.output_frame       = frame->gpu_pointer,
+			.channel_offset     = channel_offset,
+			.readi_group        = cp->readi_group,
+			.speed_of_sound     = cp->speed_of_sound,
+			.time_offset        = cp->time_offset,
+			.f_number           = cp->f_number,
+			.interpolation_mode = cp->interpolation_mode,
 		};
 		memory_copy(pc.voxel_transform.E, cp->das_voxel_transform.E, sizeof(pc.voxel_transform));
 		memory_copy(pc.xdc_transform.E,   cp->xdc_transform.E,       sizeof(pc.xdc_transform));
@@ -1453,19 +2771,689 @@ do_compute_shader(BeamformerCtx *ctx, GPUCommandList cmd, BeamformerComputePlan
 	#endif
 }
 
+/* NOTE(rnp): places device timestamps from gpu_read_profile_zones() on the os_timer_count()
+ * timeline. with VK_EXT_calibrated_timestamps both clocks are sampled together. otherwise
+ * gpu_end is taken to be readback_time; the work finished some time before it was read
+ * back so mapped times are late by at most the readback latency */
+typedef struct {
+	u64 gpu_reference;
+	u64 host_reference;
+	f64 gpu_to_host;
+} GPUHostTimeMap;
+
+function GPUHostTimeMap
+gpu_host_time_map(u64 gpu_end, u64 readback_time)
+{
+	GPUHostTimeMap result = {0};
+	if (!gpu_timestamp_calibration(&result.gpu_reference, &result.host_reference)) {
+		result.gpu_reference  = gpu_end;
+		result.host_reference = readback_time;
+	}
+	result.gpu_to_host = (f64)gpu_info()->timestamp_period_ns * (f64)os_system_info()->timer_frequency * 1e-9;
+	return result;
+}
+
+function u64
+gpu_host_time(GPUHostTimeMap *map, u64 gpu_ticks)
+{
+	u64 result = map->host_reference + (u64)(i64)((f64)(i64)(gpu_ticks - map->gpu_reference) * map->gpu_to_host);
+	return result;
+}
+
+function void
+beamformer_trace_gpu_zones(GPUHostTimeMap *map, GPUProfileZone *zones, u32 count)
+{
+	#if BEAMFORMER_TRACING
+	u32 track = trace_track(str8("[gpu compute]"));
+	for (u32 it = 0; it < count; it++) {
+		trace_track_zone(track, zones[it].label, gpu_host_time(map, zones[it].begin),
+		                 gpu_host_time(map, zones[it].end));
+	}
+	#endif
+}
+
+/* NOTE(rnp): GPU time of each pipeline slot, summed over the channel chunks */
+typedef struct {
+	u32 count;
+	u32 shaders[BeamformerMaxComputeShaderStages];
+	f32 times[BeamformerMaxComputeShaderStages];
+	u64 invocations[BeamformerMaxComputeShaderStages];
+} BeamformerStageTimings;
+
+/* NOTE(rnp): stages before the first image stage run once per channel chunk */
+function BeamformerStageCost
+beamformer_compute_plan_frame_cost(BeamformerComputePlan *cp, u32 shader_slot)
+{
+	u32 chunk_size  = Max(cp->chunk_channel_count, 1);
+	u64 chunk_count = (cp->channel_count + chunk_size - 1) / chunk_size;
+	u64 dispatches  = shader_slot < cp->first_image_shader_index ? chunk_count : 1;
+
+	BeamformerStageCost result = {
+		.bytes_read    = dispatches * cp->stage_costs[shader_slot].bytes_read,
+		.bytes_written = dispatches * cp->stage_costs[shader_slot].bytes_written,
+		.flops         = dispatches * cp->stage_costs[shader_slot].flops,
+	};
+	return result;
+}
+
+function u32
+beamformer_scheduler_block_count(BeamformerSchedulerBlock *b)
+{
+	u32 result = b->write_index - b->read_index;
+	return result;
+}
+
+/* NOTE(rnp): only called by the compute thread; the upload thread only reads compute_index */
+function void
+beamformer_rf_consume(BeamformerRFBuffer *rf, u64 rf_index)
+{
+	rf->consumed_mask       |= 1ULL << (rf_index % 64);
+	rf->last_consumed_index  = Max(rf->last_consumed_index, rf_index);
+
+	u64 compute_index = rf->compute_index;
+	while (rf->consumed_mask & (1ULL << (compute_index % 64))) {
+		rf->consumed_mask &= ~(1ULL << (compute_index % 64));
+		compute_index++;
+	}
+	atomic_store_u64(&rf->compute_index, compute_index);
+}
+
+function void
+beamformer_publish_compute_telemetry(BeamformerSharedMemory *sm, BeamformerComputeContext *cs,
+                                     BeamformerScheduledWork *sw, u64 start_time,
+                                     BeamformerFrame *frame, BeamformerStageTimings *stages)
+{
+	BeamformerComputeTelemetry *ct = &sm->telemetry.compute;
+	BeamformerRFBuffer         *rf = &cs->rf_buffer;
+	u32                      block = sw->work.compute_context.parameter_block;
+	BeamformerBlockTelemetry   *bt = ct->blocks + block;
+
+	u64 frame_ready = frame->timestamps[BeamformerFrameTimestamp_FrameReady];
+	u64 frame_start = frame->timestamps[BeamformerFrameTimestamp_PushBegin];
+	if (!frame_start) frame_start = frame->timestamps[BeamformerFrameTimestamp_UploadStart];
+	if (!frame_start) frame_start = sw->enqueue_time;
+
+	f64 timer_frequency = (f64)os_system_info()->timer_frequency;
+	f32 latency    = (f32)((f64)(frame_ready - frame_start) / timer_frequency);
+	f32 queue_wait = (f32)((f64)(start_time - sw->enqueue_time) / timer_frequency);
+
+	beamformer_telemetry_write_begin(&ct->sequence);
+
+	ct->frames_completed++;
+	ct->last_frame_id        = frame->id;
+	ct->last_parameter_block = frame->parameter_block;
+	ct->work_queue_depth     = beamform_work_queue_depth(&sm->external_work_queue) + cs->scheduler.pending;
+	ct->rf_frames_pending    = (u32)(atomic_load_u64(&rf->insertion_index) - atomic_load_u64(&rf->compute_index));
+
+	ct->shader_count = stages->count;
+	for (u32 it = 0; it < stages->count; it++) {
+		ct->shader_ids[it]        = stages->shaders[it];
+		ct->stage_times[it]       = stages->times[it];
+		ct->stage_invocations[it] = stages->invocations[it];
+	}
+
+	ct->last_frame.frame_id        = frame->id;
+	ct->last_frame.parameter_block = frame->parameter_block;
+	memory_copy(ct->last_frame.timestamps, frame->timestamps, sizeof(frame->timestamps));
+	ct->memory = cs->memory_budget;
+
+	bt->average_latency = bt->frames_completed ? bt->average_latency + (latency - bt->average_latency) / 16.0f : latency;
+	bt->frames_completed++;
+	bt->last_latency    = latency;
+	bt->last_queue_wait = queue_wait;
+	bt->queued          = beamformer_scheduler_block_count(cs->scheduler.blocks + block);
+
+	BeamformerComputePlan *cp = cs->compute_plans[block];
+	bt->interactive         = cp && cp->interactive;
+	bt->foreground_compiles = cs->foreground_compiles[block];
+	bt->background_compiles = cs->background_compiles[block];
+
+	beamformer_telemetry_write_end(&ct->sequence);
+}
+
+/* NOTE(rnp): CPU plan for the block's current parameters with the output of the GPU plan */
+function BeamformerCPUPlan *
+beamformer_cpu_plan_for_block(BeamformerSharedMemory *sm, BeamformerComputePlan *cp, u32 block, Arena *arena)
+{
+	BeamformerCPUPlanInfo info = {0};
+
+	BeamformerParameterBlock *pb;
+	DeferLoop(pb = beamformer_parameter_block_lock(sm, block, -1), beamformer_parameter_block_unlock(sm, block))
+	{
+		info.parameters  = pb->parameters;
+		info.data_kind   = pb->pipeline.data_kind;
+		info.stage_count = pb->pipeline.shader_count;
+		for (u32 i = 0; i < info.stage_count; i++) {
+			BeamformerShaderParameters *sp = pb->pipeline.parameters + i;
+			info.stages[i] = pb->pipeline.shaders[i];
+			switch (info.stages[i]) {
+			case BeamformerShaderKind_Demodulate:
+			case BeamformerShaderKind_Filter:
+			{
+				// NOTE(rnp): only the direct form is implemented on the CPU
+				BeamformerFilterParameters fp = cp->filter_parameters[sp->filter_slot];
+				if (fp.kind == BeamformerFilterKind_Kaiser)
+					fp.kaiser.interpolation_factor = 1;
+				BeamformerFilter *f = beamformer_filter_create(arena, fp);
+				info.filters[i] = (BeamformerCPUFilter){
+					.data       = f->data,
+					.length     = f->length,
+					.complex    = fp.complex,
+					.time_delay = f->time_delay,
+				};
+			}break;
+			case BeamformerShaderKind_Hilbert:{
+				if (sp->hilbert_fir_length) {
+					i32 length = sp->hilbert_fir_length | 1;
+					info.filters[i].data   = hilbert_fir_filter(arena, length, HILBERT_FIR_KAISER_BETA);
+					info.filters[i].length = length;
+				}
+			}break;
+			default:{}break;
+			}
+		}
+	}
+
+	BeamformerComputeArrayParameters *ap = push_struct(arena, BeamformerComputeArrayParameters);
+	gpu_buffer_range_download(ap, &cp->array_parameters, 0, sizeof(*ap), 0);
+	info.array_parameters = ap;
+
+	/* NOTE(rnp): see the DAS case in plan_compute_pipeline() */
+	info.parameters.output_points.xyz = cp->output_points;
+	memory_copy(info.parameters.das_voxel_transform.E, cp->voxel_transform.E, sizeof(cp->voxel_transform));
+
+	BeamformerCPUPlan *result = beamformer_cpu_plan(arena, &info);
+	return result;
+}
+
+/* NOTE(rnp): for frames whose plan can't run on the GPU, either rejected by admission or
+ * left without a pipeline by a failed compile. the frame is beamformed by the CPU when it
+ * can run the plan and is dropped otherwise. either way uploaded raw data must be consumed
+ * or the upload thread will stall */
+function void
+beamformer_compute_frame_fallback(BeamformerCtx *ctx, BeamformerComputePlan *cp,
+                                  BeamformerScheduledWork *sw, u64 start_time, Arena *arena)
+{
+	BeamformerComputeContext   *cs   = &ctx->compute_context;
+	BeamformerSharedMemory     *sm   = ctx->shared_memory;
+	BeamformerComputeTelemetry *ct   = &sm->telemetry.compute;
+	BeamformerRFBuffer         *rf   = &cs->rf_buffer;
+	BeamformWork               *work = &sw->work;
+	GPUBuffer                  *backlog = cs->backlog.buffer;
+
+	u32 block = work->compute_context.parameter_block;
+
+	BeamformerCPUPlan *plan;
+	TraceZone("cpu_plan") plan = beamformer_cpu_plan_for_block(sm, cp, block, arena);
+
+	BeamformerParameters *bp = &plan->parameters;
+	BeamformerDataKind frame_kind = plan->iq ? BeamformerDataKind_Float32Complex : BeamformerDataKind_Float32;
+	u64 frame_size = beamformer_frame_byte_size(cp->output_points, frame_kind);
+	u64 raw_size   = (u64)bp->sample_count * bp->acquisition_count * bp->channel_count
+	                 * beamformer_data_kind_byte_size[plan->data_kind];
+
+	b32 run_cpu = plan->error.length == 0 && frame_size <= (u64)backlog->size && raw_size <= rf->active_rf_size;
+	if (run_cpu) {
+		u32 slot_count = Max(rf->slot_count, 1);
+		u32 slot       = (u32)(sw->rf_index % slot_count);
+		if (work->kind == BeamformerWorkKind_ComputeIndirect) {
+			TraceZone("wait_rf_upload") spin_wait(atomic_load_u64(&rf->insertion_index) <= sw->rf_index);
+			if (vk_buffer_needs_sync(&rf->buffer))
+				gpu_host_wait_timeline(GPUTimeline_Transfer, rf->upload_complete_values[slot], -1ULL);
+		} else {
+			slot = (u32)(rf->last_consumed_index % slot_count);
+		}
+
+		BeamformerFrame *frame  = beamformer_frame_next(cs, cp->output_points, plan->iq);
+		frame->acquisition_kind = cp->acquisition_kind;
+		frame->contrast_mode    = cp->contrast_mode;
+		frame->compound_count   = cp->acquisition_count;
+		frame->parameter_block  = block;
+		frame->view_plane_tag   = work->compute_context.view_plane;
+		memory_copy(frame->voxel_transform.E, cp->voxel_transform.E, sizeof(cp->voxel_transform));
+
+		void *rf_data = push_array_no_zero(arena, u8, raw_size, .align = 64);
+		TraceZone("cpu_download_rf") gpu_buffer_range_download(rf_data, &rf->buffer, (u64)slot * rf->active_rf_size, raw_size, 1);
+		if (work->kind == BeamformerWorkKind_ComputeIndirect) {
+			memory_copy(frame->timestamps, rf->slot_timestamps[slot], sizeof(frame->timestamps));
+			beamformer_rf_consume(rf, sw->rf_index);
+		}
+
+		f32 *output = push_array_no_zero(arena, f32, beamformer_cpu_output_floats(plan), .align = 64);
+		TraceZone("cpu_beamform") beamformer_cpu_beamform(cs->cpu_beamformer, plan, rf_data, output);
+		gpu_buffer_range_upload(backlog, output, frame->gpu_pointer - backlog->gpu_pointer, frame_size, 1);
+
+		/* NOTE(rnp): consumers wait on the compute timeline before reading a frame; an empty
+		 * submission provides a value for one that was written by the host */
+		GPUCommandList cmd = gpu_command_list_begin(GPUTimeline_Compute);
+		frame->timestamps[BeamformerFrameTimestamp_ComputeSubmit] = os_timer_count();
+		atomic_store_u64(&frame->timeline_valid_value, gpu_command_list_end(cmd, (VulkanHandle){0}, (VulkanHandle){0}));
+		frame->timestamps[BeamformerFrameTimestamp_FrameReady] = os_timer_count();
+
+		beamformer_telemetry_write_begin(&ct->sequence);
+		ct->frames_cpu++;
+		beamformer_telemetry_write_end(&ct->sequence);
+
+		BeamformerStageTimings stages = {0};
+		beamformer_publish_compute_telemetry(sm, cs, sw, start_time, frame, &stages);
+
+		atomic_store_u64((u64 *)&ctx->latest_frame, (u64)frame);
+	} else {
+		if (work->kind == BeamformerWorkKind_ComputeIndirect) {
+			spin_wait(atomic_load_u64(&rf->insertion_index) <= sw->rf_index);
+			beamformer_rf_consume(rf, sw->rf_index);
+		}
+		beamformer_telemetry_write_begin(&ct->sequence);
+		ct->frames_rejected++;
+		beamformer_telemetry_write_end(&ct->sequence);
+	}
+
+	push_compute_timing_info(ctx->compute_timing_table, (ComputeTimingInfo){
+		.kind        = ComputeTimingInfoKind_ComputeFrameEnd,
+		.timer_count = os_timer_count(),
+	});
+}
+
+function void
+beamformer_compute_frame(BeamformerCtx *ctx, BeamformerScheduledWork *sw, Arena *arena)
+{
+	BeamformerComputeContext * cs   = &ctx->compute_context;
+	BeamformerSharedMemory *   sm   = ctx->shared_memory;
+	BeamformWork *             work = &sw->work;
+
+	u64 start_time = os_timer_count();
+	push_compute_timing_info(ctx->compute_timing_table, (ComputeTimingInfo){
+		.kind        = ComputeTimingInfoKind_ComputeFrameBegin,
+		.timer_count = start_time,
+	});
+
+	BeamformerComputePlan *cp = beamformer_compute_plan_for_block(cs, work->compute_context.parameter_block, arena);
+	if unlikely(beamformer_parameter_block_dirty(sm, work->compute_context.parameter_block)) {
+		u32 block = work->compute_context.parameter_block;
+		Temp scratch = temp_begin(arena);
+		TraceZone("commit_parameter_block") beamformer_commit_parameter_block(ctx, cp, block, arena);
+		temp_end(scratch);
+	}
+
+	post_sync_barrier(ctx->shared_memory, BeamformerSharedMemoryLockKind_DispatchCompute);
+
+	if unlikely(cp->admission == BeamformerPlanAdmission_Rejected) {
+		beamformer_compute_frame_fallback(ctx, cp, sw, start_time, arena);
+		return;
+	}
+
+	beamformer_interactive_tuning_update(ctx, cp, work->compute_context.parameter_block);
+
+	u32 dirty_programs = atomic_swap_u32(&cp->dirty_programs, 0);
+	static_assert(BeamformerMaxComputeShaderStages <= 32, "");
+	if unlikely(dirty_programs) {
+		cs->foreground_compiles[work->compute_context.parameter_block] += (u32)popcount_u64(dirty_programs);
+
+		/* NOTE(rnp): shaders are independent so compile them all at once */
+		Job root;
+		Job jobs[BeamformerMaxComputeShaderStages];
+		BeamformerShaderCompileJob compile_jobs[BeamformerMaxComputeShaderStages];
+		job_init(&root, 0, 0, str8("shader compile"));
+		for EachBit(dirty_programs, slot) {
+			assert(slot < BeamformerMaxComputeShaderStages);
+			compile_jobs[slot] = (BeamformerShaderCompileJob){
+				.pipeline          = cp->vulkan_pipelines + slot,
+				.shader            = cp->pipeline.shaders[slot],
+				.shader_descriptor = cp->shader_descriptors + slot,
+			};
+			job_init(jobs + slot, beamformer_compile_compute_shader_job, compile_jobs + slot,
+			         beamformer_shader_names[cp->pipeline.shaders[slot]]);
+			job_add_child(&root, jobs + slot);
+			job_submit(ctx->job_system, jobs + slot);
+		}
+		job_submit(ctx->job_system, &root);
+		TraceZone("shader_compile") job_wait(ctx->job_system, &root, arena);
+	}
+
+	b32 pipelines_valid = 1;
+	for (u32 i = 0; i < cp->pipeline.shader_count; i++)
+		pipelines_valid &= vk_pipeline_valid(cp->vulkan_pipelines[i]);
+	if unlikely(!pipelines_valid) {
+		beamformer_compute_frame_fallback(ctx, cp, sw, start_time, arena);
+		return;
+	}
+
+	atomic_store_u32(&cs->processing_compute, 1);
+
+	start_renderdoc_capture();
+
+	i32 das_index = -1;
+	i32 coherency_weighting = -1;
+	for (u32 i = 0; i < cp->pipeline.shader_count; i++) {
+		if (cp->pipeline.shaders[i] == BeamformerShaderKind_CoherencyWeighting)
+			coherency_weighting = (i32)i;
+
+		if (cp->pipeline.shaders[i] == BeamformerShaderKind_DAS)
+			das_index = (i32)i;
+	}
+
+	BeamformerFrame *frame  = beamformer_frame_next(cs, cp->output_points, cp->iq_pipeline);
+	frame->acquisition_kind = cp->acquisition_kind;
+	frame->contrast_mode    = cp->contrast_mode;
+	frame->compound_count   = cp->acquisition_count;
+	frame->parameter_block  = work->compute_context.parameter_block;
+	frame->view_plane_tag   = work->compute_context.view_plane;
+	memory_copy(frame->voxel_transform.E, cp->voxel_transform.E, sizeof(cp->voxel_transform));
+
+	trace_zone_begin(str8("compute_record"));
+	GPUCommandList cmd = gpu_command_list_begin(GPUTimeline_Compute);
+	/* NOTE(rnp): encloses the whole frame; used for GPUStart/GPUEnd */
+	gpu_profile_zone_begin(cmd, str8("Compute Frame"), 0);
+
+	if (das_index >= 0) {
+		GPUBuffer *backlog = cs->backlog.buffer;
+		u64 frame_size = beamformer_frame_byte_size(frame->points, frame->data_kind);
+		u64 offset     = frame->gpu_pointer - backlog->gpu_pointer;
+		gpu_command_clear_buffer(cmd, backlog, offset, frame_size, 0);
+	}
+
+	if (coherency_weighting >= 0) {
+		BeamformerCoherencyWeightingBakeParameters *cw = &cp->shader_descriptors[coherency_weighting].bake.CoherencyWeighting;
+		GPUBuffer *gpu_arena = &cp->gpu_temp_arena;
+		u64 coherent_size = beamformer_incoherent_frame_byte_size(frame->points, frame->data_kind);
+		gpu_command_clear_buffer(cmd, gpu_arena, cw->IncoherentSum - gpu_arena->gpu_pointer, coherent_size, 0);
+	}
+
+	BeamformerRFBuffer *rf = &cs->rf_buffer;
+	u32 slot_count = Max(rf->slot_count, 1);
+	u32 slot       = (u32)(sw->rf_index % slot_count);
+
+	if (work->kind == BeamformerWorkKind_ComputeIndirect) {
+		// TODO(rnp): this shouldn't be necessary, there should be a way of communicating
+		// what the value will be so that the only the command wait is needed.
+		TraceZone("wait_rf_upload") spin_wait(atomic_load_u64(&rf->insertion_index) <= sw->rf_index);
+		/* NOTE(rnp): the slot may be refilled as soon as the GPU is done with it */
+		memory_copy(frame->timestamps, rf->slot_timestamps[slot], sizeof(frame->timestamps));
+
+		/* NOTE(rnp): if the GPU supports BAR there may be no need to synchronize
+		 * other than the above spin */
+		if (vk_buffer_needs_sync(&rf->buffer))
+			gpu_command_wait_timeline(cmd, GPUTimeline_Transfer, rf->upload_complete_values[slot]);
+	} else {
+		slot = (u32)(rf->last_consumed_index % slot_count);
+	}
+
+	for (u32 channel_offset = 0;
+	     channel_offset < cp->channel_count;
+	     channel_offset += cp->chunk_channel_count)
+	{
+		u64 rf_pointer = rf->buffer.gpu_pointer + slot * rf->active_rf_size;
+		rf_pointer += cp->raw_channel_byte_stride * channel_offset;
+		for (u32 i = 0; i < cp->first_image_shader_index; i++) {
+			gpu_profile_zone_begin_tagged(cmd, beamformer_shader_names[cp->pipeline.shaders[i]],
+			                              GPUProfileZoneFlag_PipelineStatistics, i);
+			do_compute_shader(ctx, cmd, cp, frame, i, channel_offset, rf_pointer);
+			gpu_profile_zone_end(cmd);
+		}
+	}
+
+	for (u32 i = cp->first_image_shader_index; i < cp->pipeline.shader_count; i++) {
+		gpu_profile_zone_begin_tagged(cmd, beamformer_shader_names[cp->pipeline.shaders[i]],
+		                              GPUProfileZoneFlag_PipelineStatistics, i);
+		do_compute_shader(ctx, cmd, cp, frame, i, 0, 0);
+		gpu_profile_zone_end(cmd);
+	}
+	gpu_profile_zone_end(cmd);
+	u64 end_timeline_value = gpu_command_list_end(cmd, (VulkanHandle){0}, (VulkanHandle){0});
+	frame->timestamps[BeamformerFrameTimestamp_ComputeSubmit] = os_timer_count();
+	trace_zone_end();
+	if (work->kind == BeamformerWorkKind_ComputeIndirect) {
+		atomic_store_u64(rf->compute_complete_values + slot, end_timeline_value);
+		beamformer_rf_consume(rf, sw->rf_index);
+	}
+
+	atomic_store_u64(&frame->timeline_valid_value, end_timeline_value);
+
+	BeamformerStageTimings stages = {0};
+	Temp scratch;
+	DeferLoop(scratch = temp_begin(arena), temp_end(scratch))
+	{
+		/* NOTE(rnp): this blocks until work completes */
+		u32             zone_count = 0;
+		GPUProfileZone *zones      = 0;
+		TraceZone("wait_compute") zones = gpu_read_profile_zones(GPUTimeline_Compute, &zone_count, arena);
+		frame->timestamps[BeamformerFrameTimestamp_FrameReady] = os_timer_count();
+
+		if (zone_count > 0) {
+			GPUHostTimeMap map = gpu_host_time_map(zones[0].end, frame->timestamps[BeamformerFrameTimestamp_FrameReady]);
+			frame->timestamps[BeamformerFrameTimestamp_GPUStart] = gpu_host_time(&map, zones[0].begin);
+			frame->timestamps[BeamformerFrameTimestamp_GPUEnd]   = gpu_host_time(&map, zones[0].end);
+			beamformer_trace_gpu_zones(&map, zones, zone_count);
+		}
+
+		/* NOTE(rnp): stage zones are tagged with their pipeline slot so that repeated shader
+		 * kinds (e.g. two Filters or inserted Reshapes) stay separate */
+		u32 shader_count = cp->pipeline.shader_count;
+		GPUProfileZoneSummary *summaries = gpu_profile_zones_by_tag(zones, zone_count, shader_count, arena);
+
+		f32 gpu_clocks_to_seconds = 1.0e-9f * gpu_info()->timestamp_period_ns;
+		stages.count = shader_count;
+		for (u32 slot = 0; slot < shader_count; slot++) {
+			BeamformerStageCost cost = beamformer_compute_plan_frame_cost(cp, slot);
+			push_compute_timing_info(ctx->compute_timing_table, (ComputeTimingInfo){
+				.kind        = ComputeTimingInfoKind_Shader,
+				.shader      = (u16)cp->pipeline.shaders[slot],
+				.shader_slot = (u16)slot,
+				.bytes       = cost.bytes_read + cost.bytes_written,
+				.flops       = cost.flops,
+				.timer_count = summaries[slot].ticks,
+			});
+			stages.shaders[slot]     = cp->pipeline.shaders[slot];
+			stages.times[slot]       = (f32)summaries[slot].ticks * gpu_clocks_to_seconds;
+			stages.invocations[slot] = summaries[slot].invocations;
+		}
+	}
+
+	beamformer_publish_compute_telemetry(sm, cs, sw, start_time, frame, &stages);
+
+	u64 frame_start = frame->timestamps[BeamformerFrameTimestamp_PushBegin];
+	if (!frame_start) frame_start = frame->timestamps[BeamformerFrameTimestamp_UploadStart];
+	if (frame_start) {
+		push_compute_timing_info(ctx->compute_timing_table, (ComputeTimingInfo){
+			.kind        = ComputeTimingInfoKind_EndToEnd,
+			.timer_count = frame->timestamps[BeamformerFrameTimestamp_FrameReady] - frame_start,
+		});
+	}
+
+	cs->processing_progress = 1;
+
+	//if (has_sum) {
+	if (0) {
+		#if 0
+		u32 aframe_index = ((ctx->averaged_frame_index++) % countof(ctx->averaged_frames));
+		ctx->averaged_frames[aframe_index].view_plane_tag  = frame->view_plane_tag;
+		ctx->averaged_frames[aframe_index].ready_to_present = 1;
+		atomic_store_u64((u64 *)&ctx->latest_frame, (u64)(ctx->averaged_frames + aframe_index));
+		#endif
+	} else {
+		atomic_store_u64((u64 *)&ctx->latest_frame, (u64)frame);
+	}
+
+	atomic_store_u32(&cs->processing_compute, 0);
+
+	push_compute_timing_info(ctx->compute_timing_table, (ComputeTimingInfo){
+		.kind        = ComputeTimingInfoKind_ComputeFrameEnd,
+		.timer_count = os_timer_count(),
+	});
+
+	end_renderdoc_capture();
+}
+
+function b32
+beamformer_work_is_compute(BeamformWork *work)
+{
+	b32 result = work->kind == BeamformerWorkKind_Compute || work->kind == BeamformerWorkKind_ComputeIndirect;
+	return result;
+}
+
+/* NOTE(rnp): returns 0 if the block's queue is full */
+function b32
+beamformer_scheduler_push(BeamformerScheduler *s, BeamformWork *work)
+{
+	BeamformerSchedulerBlock *b = s->blocks + work->compute_context.parameter_block;
+	b32 result = beamformer_scheduler_block_count(b) < countof(b->items);
+	if (result) {
+		/* NOTE(rnp): a block doesn't get to bank the time it spent idle */
+		if (beamformer_scheduler_block_count(b) == 0)
+			b->virtual_time = Max(b->virtual_time, s->virtual_time);
+
+		BeamformerScheduledWork *sw = b->items + b->write_index++ % countof(b->items);
+		sw->work         = *work;
+		sw->enqueue_time = os_timer_count();
+		sw->rf_index     = 0;
+		if (work->kind == BeamformerWorkKind_ComputeIndirect)
+			sw->rf_index = s->next_rf_index++;
+		s->pending++;
+	}
+	return result;
+}
+
+/* NOTE(rnp): see BeamformerScheduling. ComputeIndirect work is only eligible once its raw
+ * data has been uploaded; when nothing is eligible the oldest raw data frame is chosen so
+ * that its upload (and the slot it frees) is never waiting on work behind it */
+function u32
+beamformer_scheduler_select(BeamformerScheduler *s, BeamformerScheduling *scheduling, BeamformerRFBuffer *rf)
+{
+	u64 now             = os_timer_count();
+	f64 timer_frequency = (f64)os_system_info()->timer_frequency;
+	u64 uploaded        = atomic_load_u64(&rf->insertion_index);
+
+	i32 best    = -1, overdue = -1, oldest_rf = -1;
+	u64 best_vt = 0,  overdue_by = 0, oldest_rf_index = U64_MAX;
+	for EachElement(s->blocks, block) {
+		BeamformerSchedulerBlock *b = s->blocks + block;
+		if (beamformer_scheduler_block_count(b) == 0) continue;
+
+		BeamformerScheduledWork *head = b->items + b->read_index % countof(b->items);
+		if (head->work.kind == BeamformerWorkKind_ComputeIndirect) {
+			if (head->rf_index < oldest_rf_index) {
+				oldest_rf_index = head->rf_index;
+				oldest_rf       = (i32)block;
+			}
+			if (head->rf_index >= uploaded) continue;
+		}
+
+		BeamformerScheduling *sp = scheduling + block;
+		if (sp->deadline > 0) {
+			u64 deadline = (u64)(sp->deadline * timer_frequency);
+			u64 waited   = now - head->enqueue_time;
+			if (waited >= deadline && (overdue < 0 || waited - deadline > overdue_by)) {
+				overdue    = (i32)block;
+				overdue_by = waited - deadline;
+			}
+		}
+
+		/* NOTE(rnp): the last block keeps going while it is less than a frame ahead */
+		u64 vt = b->virtual_time;
+		if (block == s->last_block)
+			vt -= Min(vt, b->average_cost / Max(sp->weight, 1u));
+
+		if (best < 0 || sp->priority > scheduling[best].priority ||
+		    (sp->priority == scheduling[best].priority && vt < best_vt))
+		{
+			best    = (i32)block;
+			best_vt = vt;
+		}
+	}
+
+	i32 result = overdue >= 0 ? overdue : best;
+	if (result < 0) result = oldest_rf;
+	assert(result >= 0);
+	return (u32)result;
+}
+
+function void
+beamformer_scheduler_run(BeamformerCtx *ctx, BeamformWorkQueue *q, Arena *arena)
+{
+	BeamformerComputeContext * cs = &ctx->compute_context;
+	BeamformerSharedMemory *   sm = ctx->shared_memory;
+	BeamformerScheduler *      s  = &cs->scheduler;
+
+	u32 block = beamformer_scheduler_select(s, sm->scheduling, &cs->rf_buffer);
+	BeamformerSchedulerBlock *b = s->blocks + block;
+	BeamformerScheduledWork sw  = b->items[b->read_index++ % countof(b->items)];
+	s->pending--;
+	s->last_block   = block;
+	s->virtual_time = Max(s->virtual_time, b->virtual_time);
+
+	u32 pending = beamformer_scheduler_block_count(b) + beamform_work_queue_pending_compute(q, block);
+	if (beamformer_backpressure_drop(sm->backpressure + block, pending)) {
+		/* NOTE(rnp): same as a rejected plan; the raw data must still be consumed.
+		 * parameter changes are picked up by the newer work */
+		if (sw.work.kind == BeamformerWorkKind_ComputeIndirect) {
+			BeamformerRFBuffer *rf = &cs->rf_buffer;
+			spin_wait(atomic_load_u64(&rf->insertion_index) <= sw.rf_index);
+			beamformer_rf_consume(rf, sw.rf_index);
+		}
+		post_sync_barrier(ctx->shared_memory, BeamformerSharedMemoryLockKind_DispatchCompute);
+		BeamformerComputeTelemetry *ct = &sm->telemetry.compute;
+		beamformer_telemetry_write_begin(&ct->sequence);
+		ct->blocks[block].frames_dropped++;
+		ct->blocks[block].queued = beamformer_scheduler_block_count(b);
+		beamformer_telemetry_write_end(&ct->sequence);
+	} else {
+		u64 start = os_timer_count();
+		beamformer_compute_frame(ctx, &sw, arena);
+		u64 cost  = os_timer_count() - start;
+
+		b->average_cost  = b->average_cost ? (15 * b->average_cost + cost) / 16 : cost;
+		b->virtual_time += cost / Max(sm->scheduling[block].weight, 1u);
+	}
+}
+
+/* NOTE(rnp): beamformed data exports are copied out of the backlog in pieces of this size
+ * by jobs; a piece waits for its own frame so later frames can still be in flight */
+#define BEAMFORMER_EXPORT_JOB_SIZE MB(4)
+typedef struct {
+	Job        job;
+	GPUBuffer *buffer;
+	u8        *output;
+	u64        offset;
+	u64        size;
+	u64        timeline_value;
+} BeamformerExportJob;
+
+function JOB_FUNCTION(beamformer_export_job)
+{
+	BeamformerExportJob *job = user_context;
+	trace_zone_begin(str8("export_copy"));
+	gpu_host_wait_timeline(GPUTimeline_Compute, job->timeline_value, -1ULL);
+	gpu_buffer_range_download(job->output, job->buffer, job->offset, job->size, 1);
+	trace_zone_end();
+}
+
 function void
 complete_queue(BeamformerCtx *ctx, BeamformWorkQueue *q, Arena *arena)
 {
 	BeamformerComputeContext * cs = &ctx->compute_context;
 	BeamformerSharedMemory *   sm = ctx->shared_memory;
+	BeamformerScheduler *      s  = &cs->scheduler;
+
+	for (;;) {
+		/* NOTE(rnp): compute work is handed to the scheduler. other work must observe the
+		 * compute queued before it so it acts as a barrier until the scheduler is empty */
+		BeamformWork *work = beamform_work_queue_pop(q);
+		while (work && beamformer_work_is_compute(work) && beamformer_scheduler_push(s, work)) {
+			beamform_work_queue_pop_commit(q);
+			work = beamform_work_queue_pop(q);
+		}
+
+		if (s->pending) {
+			beamformer_scheduler_run(ctx, q, arena);
+			continue;
+		}
+
+		if (!work) break;
 
-	for (BeamformWork *work = beamform_work_queue_pop(q);
-	     work;
-	     beamform_work_queue_pop_commit(q), work = beamform_work_queue_pop(q))
-	{
 		switch (work->kind) {
 
 		case BeamformerWorkKind_ExportBuffer:{
+			trace_zone_begin(str8("export_buffer"));
 			/* TODO(rnp): better way of handling DispatchCompute barrier */
 			post_sync_barrier(ctx->shared_memory, BeamformerSharedMemoryLockKind_DispatchCompute);
 			beamformer_shared_memory_take_lock(ctx->shared_memory, (i32)work->lock, (u32)-1);
@@ -1477,6 +3465,10 @@ complete_queue(BeamformerCtx *ctx, BeamformWorkQueue *q, Arena *arena)
 				u32 frame_idx = bl->counter - req_count;
 				u8 *sm_output = beamformer_shared_memory_data_pointer(sm, ctx->shared_memory_size);
 				u64 exported_size = 0;
+
+				Temp scratch = temp_begin(arena);
+				Job root;
+				job_init(&root, 0, 0, str8("export"));
 				for (u32 export_count = 0; export_count < req_count; export_count++, frame_idx++) {
 					BeamformerFrame *f = bl->frames + frame_idx % countof(bl->frames);
 					u64 frame_size = beamformer_frame_byte_size(f->points, f->data_kind);
@@ -1486,11 +3478,23 @@ complete_queue(BeamformerCtx *ctx, BeamformWorkQueue *q, Arena *arena)
 					// just fill up as much as possible.
 					if (exported_size + frame_size <= ec->size) {
 						u64 offset = f->gpu_pointer - bl->buffer->gpu_pointer;
-						gpu_host_wait_timeline(GPUTimeline_Compute, f->timeline_valid_value, -1ULL);
-						gpu_buffer_range_download(sm_output + exported_size, bl->buffer, offset, frame_size, 1);
+						for (u64 piece = 0; piece < frame_size; piece += BEAMFORMER_EXPORT_JOB_SIZE) {
+							BeamformerExportJob *ej = push_struct(arena, BeamformerExportJob);
+							ej->buffer         = bl->buffer;
+							ej->output         = sm_output + exported_size + piece;
+							ej->offset         = offset + piece;
+							ej->size           = Min(frame_size - piece, BEAMFORMER_EXPORT_JOB_SIZE);
+							ej->timeline_value = f->timeline_valid_value;
+							job_init(&ej->job, beamformer_export_job, ej, str8("export_copy"));
+							job_add_child(&root, &ej->job);
+							job_submit(ctx->job_system, &ej->job);
+						}
 						exported_size += frame_size;
 					}
 				}
+				job_submit(ctx->job_system, &root);
+				TraceZone("export_wait") job_wait(ctx->job_system, &root, arena);
+				temp_end(scratch);
 			}break;
 
 			case BeamformerExportKind_Stats:{
@@ -1498,14 +3502,35 @@ complete_queue(BeamformerCtx *ctx, BeamformWorkQueue *q, Arena *arena)
 				/* NOTE(rnp): do a little spin to let this finish updating */
 				spin_wait(table->write_index != atomic_load_u32(&table->read_index));
 				ComputeShaderStats *stats = ctx->compute_shader_stats;
-				if (sizeof(stats->table) <= ec->size)
-					memory_copy(beamformer_shared_memory_data_pointer(sm, ctx->shared_memory_size),
-					         &stats->table, sizeof(stats->table));
+				if (sizeof(stats->table) <= ec->size) {
+					BeamformerComputeStatsTable *output = beamformer_shared_memory_data_pointer(sm, ctx->shared_memory_size);
+					memory_copy(output, &stats->table, sizeof(stats->table));
+					output->memory = ctx->compute_context.memory_budget;
+					output->peak_bandwidth = ctx->compute_context.peak_bandwidth;
+					output->latency_window = stats->latency_window;
+					for EachIndex(BeamformerLatencyWindow_Count, window)
+						for EachElement(stats->latency, it)
+							output->latency[window][it] = latency_histogram_summary(stats->latency + it, stats->latency_window,
+							                                                        (BeamformerLatencyWindow)window);
+
+					BeamformerFrameBacklog *bl = &cs->backlog;
+					u64 available = Min(bl->counter, countof(output->frame_timings));
+					output->timer_frequency = os_system_info()->timer_frequency;
+					for (u64 id = bl->counter - available; id < bl->counter; id++) {
+						BeamformerFrame *f = bl->frames + id % countof(bl->frames);
+						if (f->timestamps[BeamformerFrameTimestamp_FrameReady] == 0) continue;
+						BeamformerFrameTiming *ft = output->frame_timings + output->frame_timing_count++;
+						ft->frame_id        = f->id;
+						ft->parameter_block = f->parameter_block;
+						memory_copy(ft->timestamps, f->timestamps, sizeof(ft->timestamps));
+					}
+				}
 			}break;
 			InvalidDefaultCase;
 			}
 			beamformer_shared_memory_release_lock(ctx->shared_memory, work->lock);
 			post_sync_barrier(ctx->shared_memory, BeamformerSharedMemoryLockKind_ExportSync);
+			trace_zone_end();
 		}break;
 
 		case BeamformerWorkKind_CreateFilter:{
@@ -1516,172 +3541,14 @@ complete_queue(BeamformerCtx *ctx, BeamformWorkQueue *q, Arena *arena)
 			cp->filter_parameters[slot] = fctx->parameters;
 		}break;
 
-		case BeamformerWorkKind_ComputeIndirect:
-		case BeamformerWorkKind_Compute:
-		{
-			push_compute_timing_info(ctx->compute_timing_table,
-			                         (ComputeTimingInfo){.kind = ComputeTimingInfoKind_ComputeFrameBegin});
-
-			BeamformerComputePlan *cp = beamformer_compute_plan_for_block(cs, work->compute_context.parameter_block, arena);
-			if unlikely(beamformer_parameter_block_dirty(sm, work->compute_context.parameter_block)) {
-				u32 block = work->compute_context.parameter_block;
-				Temp scratch = temp_begin(arena);
-				beamformer_commit_parameter_block(ctx, cp, block, arena);
-				temp_end(scratch);
-			}
-
-			post_sync_barrier(ctx->shared_memory, BeamformerSharedMemoryLockKind_DispatchCompute);
-
-			u32 dirty_programs = atomic_swap_u32(&cp->dirty_programs, 0);
-			static_assert(BeamformerMaxComputeShaderStages <= 32, "");
-			if unlikely(dirty_programs) {
-				for EachBit(dirty_programs, slot) {
-					assert(slot < BeamformerMaxComputeShaderStages);
-					Temp scratch = temp_begin(arena);
-					beamformer_reload_compute_pipeline(cp->vulkan_pipelines + slot,
-					                                   cp->pipeline.shaders[slot],
-					                                   cp->shader_descriptors + slot, arena);
-					temp_end(scratch);
-				}
-			}
-
-			atomic_store_u32(&cs->processing_compute, 1);
-
-			start_renderdoc_capture();
-
-			i32 das_index = -1;
-			i32 coherency_weighting = -1;
-			for (u32 i = 0; i < cp->pipeline.shader_count; i++) {
-				if (cp->pipeline.shaders[i] == BeamformerShaderKind_CoherencyWeighting)
-					coherency_weighting = (i32)i;
-
-				if (cp->pipeline.shaders[i] == BeamformerShaderKind_DAS)
-					das_index = (i32)i;
-			}
-
-			BeamformerFrame *frame  = beamformer_frame_next(cs, cp->output_points, cp->iq_pipeline);
-			frame->acquisition_kind = cp->acquisition_kind;
-			frame->contrast_mode    = cp->contrast_mode;
-			frame->compound_count   = cp->acquisition_count;
-			frame->parameter_block  = work->compute_context.parameter_block;
-			frame->view_plane_tag   = work->compute_context.view_plane;
-			memory_copy(frame->voxel_transform.E, cp->voxel_transform.E, sizeof(cp->voxel_transform));
-
-			GPUCommandList cmd = gpu_command_list_begin(GPUTimeline_Compute);
-			gpu_command_timestamp(cmd);
-
-			if (das_index >= 0) {
-				GPUBuffer *backlog = cs->backlog.buffer;
-				u64 frame_size = beamformer_frame_byte_size(frame->points, frame->data_kind);
-				u64 offset     = frame->gpu_pointer - backlog->gpu_pointer;
-				gpu_command_clear_buffer(cmd, backlog, offset, frame_size, 0);
-			}
-
-			if (coherency_weighting >= 0) {
-				BeamformerCoherencyWeightingBakeParameters *cw = &cp->shader_descriptors[coherency_weighting].bake.CoherencyWeighting;
-				GPUBuffer *gpu_arena = &cp->gpu_temp_arena;
-				u64 coherent_size = beamformer_incoherent_frame_byte_size(frame->points, frame->data_kind);
-				gpu_command_clear_buffer(cmd, gpu_arena, cw->IncoherentSum - gpu_arena->gpu_pointer, coherent_size, 0);
-			}
-
-			BeamformerRFBuffer *rf = &cs->rf_buffer;
-			u32 compute_index = rf->compute_index;
-			u32 slot = compute_index % countof(rf->upload_complete_values);
-
-			if (work->kind == BeamformerWorkKind_ComputeIndirect) {
-				// TODO(rnp): this shouldn't be necessary, there should be a way of communicating
-				// what the value will be so that the only the command wait is needed.
-				spin_wait(atomic_load_u64(&rf->insertion_index) <= compute_index);
-
-				/* NOTE(rnp): if the GPU supports BAR there may be no need to synchronize
-				 * other than the above spin */
-				if (vk_buffer_needs_sync(&rf->buffer))
-					gpu_command_wait_timeline(cmd, GPUTimeline_Transfer, rf->upload_complete_values[slot]);
-			} else {
-				slot = (rf->compute_index - 1) % countof(rf->upload_complete_values);
-			}
-
-			for (u32 channel_offset = 0;
-			     channel_offset < cp->channel_count;
-			     channel_offset += BeamformerChunkChannelCount)
-			{
-				u64 rf_pointer = rf->buffer.gpu_pointer + slot * rf->active_rf_size;
-				rf_pointer += cp->raw_channel_byte_stride * channel_offset;
-				for (u32 i = 0; i < cp->first_image_shader_index; i++) {
-					do_compute_shader(ctx, cmd, cp, frame, i, channel_offset, rf_pointer);
-					gpu_command_timestamp(cmd);
-				}
-			}
-
-			for (u32 i = cp->first_image_shader_index; i < cp->pipeline.shader_count; i++) {
-				do_compute_shader(ctx, cmd, cp, frame, i, 0, 0);
-				gpu_command_timestamp(cmd);
-			}
-			u64 end_timeline_value = gpu_command_list_end(cmd, (VulkanHandle){0}, (VulkanHandle){0});
-			if (work->kind == BeamformerWorkKind_ComputeIndirect) {
-				atomic_store_u64(rf->compute_complete_values + slot, end_timeline_value);
-				atomic_add_u64(&rf->compute_index, 1);
-			}
-
-			atomic_store_u64(&frame->timeline_valid_value, end_timeline_value);
-
-			Temp scratch;
-			DeferLoop(scratch = temp_begin(arena), temp_end(scratch))
-			{
-				/* NOTE(rnp): this blocks until work completes */
-				u64  count       = 0;
-				u64 *timestamps  = gpu_read_timestamps(GPUTimeline_Compute, &count, arena);
-
-				i32 steps        = ((i32)cp->channel_count / BeamformerChunkChannelCount) - 1;
-				i32 step         = 0;
-				u32 shader_index = 0;
-				u64 last_time    = count > 0 ? timestamps[0] : 0;
-
-				for (u64 i = 1; i < count; i++) {
-					push_compute_timing_info(ctx->compute_timing_table, (ComputeTimingInfo){
-						.kind        = ComputeTimingInfoKind_Shader,
-						.shader      = cp->pipeline.shaders[shader_index],
-						.shader_slot = shader_index,
-						.timer_count = timestamps[i] - last_time,
-					});
-					last_time = timestamps[i];
-
-					shader_index++;
-					if (shader_index == cp->first_image_shader_index && step < steps) {
-						shader_index = 0;
-						step++;
-					}
-				}
-			}
-
-			cs->processing_progress = 1;
-
-			//if (has_sum) {
-			if (0) {
-				#if 0
-				u32 aframe_index = ((ctx->averaged_frame_index++) % countof(ctx->averaged_frames));
-				ctx->averaged_frames[aframe_index].view_plane_tag  = frame->view_plane_tag;
-				ctx->averaged_frames[aframe_index].ready_to_present = 1;
-				atomic_store_u64((u64 *)&ctx->latest_frame, (u64)(ctx->averaged_frames + aframe_index));
-				#endif
-			} else {
-				atomic_store_u64((u64 *)&ctx->latest_frame, (u64)frame);
-			}
-
-			atomic_store_u32(&cs->processing_compute, 0);
-
-			push_compute_timing_info(ctx->compute_timing_table,
-			                         (ComputeTimingInfo){.kind = ComputeTimingInfoKind_ComputeFrameEnd});
-
-			end_renderdoc_capture();
-		}break;
 		InvalidDefaultCase;
 		}
+		beamform_work_queue_pop_commit(q);
 	}
 }
 
 function void
-coalesce_timing_table(ComputeTimingTable *t, ComputeShaderStats *stats)
+coalesce_timing_table(ComputeTimingTable *t, ComputeShaderStats *stats, u32 latency_window)
 {
 	/* TODO(rnp): we do not currently do anything to handle the potential for a half written
 	 * info item. this could result in garbage entries but they shouldn't really matter */
@@ -1691,6 +3558,15 @@ coalesce_timing_table(ComputeTimingTable *t, ComputeShaderStats *stats)
 
 	b32 has_rf = 0;
 	f32 gpu_clocks_to_nano = 1.0e-9f * gpu_info()->timestamp_period_ns;
+	f64 timer_to_ns        = 1.0e9 / (f64)os_system_info()->timer_frequency;
+
+	if (latency_window == 0) latency_window = BeamformerLatencyWindowDefaultSamples;
+	latency_window = Min(latency_window, BeamformerLatencyWindowMaxSamples);
+	if unlikely(stats->latency_window != latency_window) {
+		stats->latency_window = latency_window;
+		for EachElement(stats->latency, it)
+			latency_histogram_set_window(stats->latency + it, latency_window);
+	}
 
 	// NOTE(rnp): not equal (the index may wrap)
 	while (t->read_index != target) {
@@ -1700,23 +3576,37 @@ coalesce_timing_table(ComputeTimingTable *t, ComputeShaderStats *stats)
 		case ComputeTimingInfoKind_ComputeFrameBegin:{
 			assert(t->compute_frame_active == 0);
 			t->compute_frame_active = 1;
+			t->compute_frame_begin  = info.timer_count;
 			/* NOTE(rnp): allow multiple instances of same shader to accumulate */
 			t->in_flight_shader_count = 0;
 			memory_clear(t->in_flight_shader_ids, 0, sizeof(t->in_flight_shader_ids));
+			memory_clear(t->in_flight_bytes,      0, sizeof(t->in_flight_bytes));
+			memory_clear(t->in_flight_flops,      0, sizeof(t->in_flight_flops));
 			memory_clear(stats->table.times[stats_index], 0, sizeof(stats->table.times[stats_index]));
 		}break;
 
 		case ComputeTimingInfoKind_ComputeFrameEnd:{
 			assert(t->compute_frame_active == 1);
 			t->compute_frame_active = 0;
+
+			LatencyHistogram *stages = stats->latency + BeamformerLatencyHistogram_FirstStage;
+			for (u32 slot = 0; slot < t->in_flight_shader_count; slot++)
+				latency_histogram_push(stages + slot, latency_window, (u64)(stats->table.times[stats_index][slot] * 1e9f));
+			latency_histogram_push(stats->latency + BeamformerLatencyHistogram_FrameTime, latency_window,
+			                       (u64)((f64)(info.timer_count - t->compute_frame_begin) * timer_to_ns));
+
 			stats_index = stats->latest_frame_index = (stats_index + 1) % countof(stats->table.times);
 			stats->table.shader_count = t->in_flight_shader_count;
-			memory_copy(stats->table.shader_ids, t->in_flight_shader_ids, sizeof(t->in_flight_shader_ids));
+			memory_copy(stats->table.shader_ids,  t->in_flight_shader_ids, sizeof(t->in_flight_shader_ids));
+			memory_copy(stats->table.stage_bytes, t->in_flight_bytes,      sizeof(t->in_flight_bytes));
+			memory_copy(stats->table.stage_flops, t->in_flight_flops,      sizeof(t->in_flight_flops));
 		}break;
 
 		case ComputeTimingInfoKind_Shader:{
 			t->in_flight_shader_count = Max(t->in_flight_shader_count, info.shader_slot + 1u);
 			t->in_flight_shader_ids[info.shader_slot] = info.shader;
+			t->in_flight_bytes[info.shader_slot]     += info.bytes;
+			t->in_flight_flops[info.shader_slot]     += info.flops;
 			stats->table.times[stats_index][info.shader_slot] += info.timer_count * gpu_clocks_to_nano;
 		}break;
 
@@ -1726,6 +3616,16 @@ coalesce_timing_table(ComputeTimingTable *t, ComputeShaderStats *stats)
 			stats->table.rf_time_deltas[stats->latest_rf_index] = delta;
 			has_rf = 1;
 		}break;
+
+		case ComputeTimingInfoKind_Upload:{
+			latency_histogram_push(stats->latency + BeamformerLatencyHistogram_Upload, latency_window,
+			                       (u64)((f64)info.timer_count * timer_to_ns));
+		}break;
+
+		case ComputeTimingInfoKind_EndToEnd:{
+			latency_histogram_push(stats->latency + BeamformerLatencyHistogram_EndToEnd, latency_window,
+			                       (u64)((f64)info.timer_count * timer_to_ns));
+		}break;
 		}
 		/* NOTE(rnp): do this at the end so that stats table is always in a consistent state */
 		t->read_index++;
@@ -1753,6 +3653,49 @@ DEBUG_EXPORT BEAMFORMER_COMPLETE_COMPUTE_FN(beamformer_complete_compute)
 	complete_queue(ctx, ctx->beamform_work_queue, arena);
 }
 
+/* NOTE(rnp): below this size the barrier round trip costs more than a second lane saves */
+#define BEAMFORMER_UPLOAD_SPLIT_THRESHOLD MB(16)
+#define BEAMFORMER_UPLOAD_TUNING_FRAMES   (8)
+
+function u32
+beamformer_upload_tuner_lane_count(BeamformerUploadTuner *t, u64 rf_size)
+{
+	if (t->rf_size != rf_size) {
+		zero_struct(t);
+		t->rf_size    = rf_size;
+		t->lane_count = 1;
+	}
+	u32 result = rf_size >= BEAMFORMER_UPLOAD_SPLIT_THRESHOLD ? t->lane_count : 1;
+	return result;
+}
+
+function void
+beamformer_upload_tuner_update(BeamformerUploadTuner *t, u32 max_lane_count, u64 elapsed_ticks)
+{
+	if (!t->settled && t->rf_size >= BEAMFORMER_UPLOAD_SPLIT_THRESHOLD) {
+		t->trial_ticks += elapsed_ticks;
+		if (++t->trial_frames == BEAMFORMER_UPLOAD_TUNING_FRAMES) {
+			f64 seconds   = (f64)t->trial_ticks / (f64)os_system_info()->timer_frequency;
+			f32 bandwidth = (f32)((f64)(t->rf_size * BEAMFORMER_UPLOAD_TUNING_FRAMES) / seconds);
+
+			/* NOTE(rnp): an extra lane must be worth at least 5% to be kept */
+			u32 next_lane_count = Min(t->lane_count * 2, max_lane_count);
+			if (bandwidth > 1.05f * t->best_bandwidth) {
+				t->best_bandwidth  = bandwidth;
+				t->best_lane_count = t->lane_count;
+			}
+			if (t->best_lane_count != t->lane_count || next_lane_count == t->lane_count) {
+				t->lane_count = t->best_lane_count;
+				t->settled    = 1;
+			} else {
+				t->lane_count = next_lane_count;
+			}
+			t->trial_ticks  = 0;
+			t->trial_frames = 0;
+		}
+	}
+}
+
 DEBUG_EXPORT BEAMFORMER_RF_UPLOAD_FN(beamformer_rf_upload)
 {
 	BeamformerSharedMemory *sm                  = ctx->shared_memory;
@@ -1763,44 +3706,98 @@ DEBUG_EXPORT BEAMFORMER_RF_UPLOAD_FN(beamformer_rf_upload)
 	if (atomic_load_u32(sm->locks + upload_lock) &&
 	    (rf_block_rf_size = atomic_swap_u64(&sm->rf_block_rf_size, 0)))
 	{
+		u64 upload_start = os_timer_count();
 		beamformer_shared_memory_take_lock(ctx->shared_memory, (i32)scratch_lock, (u32)-1);
 
 		BeamformerRFBuffer *rf = ctx->rf_buffer;
 
 		rf->active_rf_size = gpu_round_up_to_sync_size(rf_block_rf_size & 0xFFFFFFFFULL, 64);
-		if unlikely(rf->buffer.size < countof(rf->upload_complete_values) * rf->active_rf_size) {
-			GPUBufferAllocateInfo allocate_info = {
-				.size  = countof(rf->upload_complete_values) * rf->active_rf_size,
-				.flags = VulkanUsageFlag_HostReadWrite,
-				.label = str8("RawRFBuffer"),
-			};
-			gpu_buffer_allocate(&rf->buffer, allocate_info);
+
+		/* NOTE(rnp): as many frames in flight as fit in the RFHistory budget. the client
+		 * is limited to a single frame of the budget by capabilities.max_rf_data_size */
+		BeamformerMemoryBudgetTable *mb = ctx->memory_budget;
+		u64 rf_budget  = mb->budget[BeamformerMemoryBudget_RFHistory];
+		u32 slot_count = (u32)Clamp(rf_budget / rf->active_rf_size, 1, countof(rf->upload_complete_values));
+		if unlikely(rf->slot_count != slot_count || (u64)rf->buffer.size < slot_count * rf->active_rf_size) {
+			/* NOTE(rnp): the slot mapping changes; compute must be done with all of them */
+			spin_wait(atomic_load_u64(&rf->compute_index) < rf->insertion_index);
+			for (u32 it = 0; it < rf->slot_count; it++)
+				gpu_host_wait_timeline(GPUTimeline_Compute, rf->compute_complete_values[it], -1ULL);
+
+			if ((u64)rf->buffer.size < slot_count * rf->active_rf_size) {
+				GPUBufferAllocateInfo allocate_info = {
+					.size  = slot_count * rf->active_rf_size,
+					.flags = VulkanUsageFlag_HostReadWrite,
+					.label = str8("RawRFBuffer"),
+				};
+				gpu_buffer_allocate(&rf->buffer, allocate_info);
+				mb->used[BeamformerMemoryBudget_RFHistory] = (u64)rf->buffer.size;
+			}
+			rf->slot_count          = slot_count;
+			mb->rf_frames_in_flight = slot_count;
 		}
 
-		u64 slot = rf->insertion_index % countof(rf->upload_complete_values);
+		u64 slot = rf->insertion_index % rf->slot_count;
 
-		/* NOTE(rnp): don't overwrite slot if the compute thread hasn't processed it */
-		spin_wait(atomic_load_u64(&rf->compute_index) < rf->insertion_index);
-		gpu_host_wait_timeline(GPUTimeline_Compute, rf->compute_complete_values[slot], -1ULL);
+		/* NOTE(rnp): don't overwrite slot if the compute thread hasn't processed it. when
+		 * the block's policy allows dropping frames uploads may run ahead of compute into the
+		 * free slots; the most recently consumed slot is kept since Compute work rereads it */
+		u32 block       = (u32)(rf_block_rf_size >> 32ULL);
+		u64 max_pending = 1;
+		if (sm->backpressure[block].policy != BeamformerBackpressurePolicy_Block)
+			max_pending = Max(rf->slot_count - 1, 1u);
 
-		gpu_buffer_range_upload(&rf->buffer, beamformer_shared_memory_data_pointer(sm, ctx->shared_memory_size),
-		                        slot * rf->active_rf_size, rf->active_rf_size, 1);
+		b32 slot_stall = rf->insertion_index - atomic_load_u64(&rf->compute_index) >= max_pending;
+		TraceZone("wait_rf_slot") {
+			spin_wait(rf->insertion_index - atomic_load_u64(&rf->compute_index) >= max_pending);
+			gpu_host_wait_timeline(GPUTimeline_Compute, rf->compute_complete_values[slot], -1ULL);
+		}
+
+		u64 *timestamps = rf->slot_timestamps[slot];
+		memory_clear(timestamps, 0, sizeof(rf->slot_timestamps[slot]));
+		timestamps[BeamformerFrameTimestamp_PushBegin]   = sm->rf_push_begin;
+		timestamps[BeamformerFrameTimestamp_PushEnd]     = sm->rf_push_end;
+		timestamps[BeamformerFrameTimestamp_UploadStart] = upload_start;
+
+		u32 lane_count = beamformer_upload_tuner_lane_count(&ctx->tuner, rf->active_rf_size);
+		u64 copy_start = os_timer_count();
+		TraceZone("rf_upload_copy") {
+			beamformer_upload_copy(ctx->copy_lanes, &rf->buffer,
+			                       beamformer_shared_memory_data_pointer(sm, ctx->shared_memory_size),
+			                       slot * rf->active_rf_size, rf->active_rf_size, lane_count);
+		}
+		beamformer_upload_tuner_update(&ctx->tuner, ctx->copy_lanes->lane_count, os_timer_count() - copy_start);
 		store_fence();
 
 		beamformer_shared_memory_release_lock(ctx->shared_memory, (i32)scratch_lock);
 		post_sync_barrier(ctx->shared_memory, upload_lock);
 
 		atomic_store_u64(rf->upload_complete_values + slot, gpu_host_signal_timeline(GPUTimeline_Transfer));
+		u64 current_time = os_timer_count();
+		timestamps[BeamformerFrameTimestamp_UploadEnd] = current_time;
 		atomic_add_u64(&rf->insertion_index, 1);
 
 		os_wake_all_waiters(ctx->compute_worker_sync);
 
-		u64 current_time = os_timer_count();
 		push_compute_timing_info(ctx->compute_timing_table, (ComputeTimingInfo){
 			.kind        = ComputeTimingInfoKind_RF_Data,
 			.timer_count = current_time - rf->timestamp,
 		});
+		push_compute_timing_info(ctx->compute_timing_table, (ComputeTimingInfo){
+			.kind        = ComputeTimingInfoKind_Upload,
+			.timer_count = current_time - upload_start,
+		});
 		rf->timestamp = current_time;
+
+		BeamformerUploadTelemetry *ut = &sm->telemetry.upload;
+		beamformer_telemetry_write_begin(&ut->sequence);
+		ut->copy_lanes        = lane_count;
+		ut->uploads_completed++;
+		ut->bytes_uploaded   += rf_block_rf_size & 0xFFFFFFFFULL;
+		ut->slot_stalls      += slot_stall;
+		ut->last_upload_time  = (f32)((f64)(current_time - upload_start) / (f64)os_system_info()->timer_frequency);
+		ut->last_upload_size  = (u32)rf_block_rf_size;
+		beamformer_telemetry_write_end(&ut->sequence);
 	}
 }
 
@@ -1852,6 +3849,7 @@ beamformer_process_input_events(BeamformerCtx *ctx, BeamformerInput *input,
 			}break;
 
 			case BeamformerFileReloadKind_ComputeShader:{
+				atomic_store_u32(&ctx->compute_context.plan_cache.invalid, 1);
 				for EachElement(ctx->compute_context.compute_plans, block) {
 					BeamformerComputePlan *cp = ctx->compute_context.compute_plans[block];
 					for (u32 slot = 0; cp && slot < cp->pipeline.shader_count; slot++) {
@@ -1911,12 +3909,15 @@ beamformer_frame_step(void *memory, BeamformerInput *input)
 	BeamformerCtx *ctx = beamformer_context = memory;
 	beamformer_input = input;
 
+	trace_zone_begin(str8("frame_step"));
+
 	u64 current_time = os_timer_count();
 	dt_for_frame = (f64)(current_time - ctx->frame_timestamp) / os_system_info()->timer_frequency;
 	ctx->frame_timestamp = current_time;
 	ctx->frame_index++;
 
-	coalesce_timing_table(ctx->compute_timing_table, ctx->compute_shader_stats);
+	coalesce_timing_table(ctx->compute_timing_table, ctx->compute_shader_stats,
+	                      atomic_load_u32(&ctx->shared_memory->latency_window));
 
 	// NOTE(rnp): reset frame state
 	{
@@ -1964,7 +3965,7 @@ beamformer_frame_step(void *memory, BeamformerInput *input)
 
 	beamformer_registers()->frame = (u64)(ctx->latest_frame - ctx->compute_context.backlog.frames);
 
-	beamformer_ui_frame();
+	TraceZone("ui_frame") beamformer_ui_frame();
 
 	// NOTE(rnp): execute commands
 	for (BeamformerCommandNode *node = ctx->command_queues[0].first;
@@ -2084,4 +4085,6 @@ beamformer_frame_step(void *memory, BeamformerInput *input)
 	}
 
 	ctx->render_shader_updated = 0;
+
+	trace_zone_end();
 }
@@ -0,0 +1,1189 @@
+/* See LICENSE for license details. */
+/* NOTE(rnp): CPU reference beamformer. mirrors the stages planned by plan_compute_pipeline()
+ * (Decode, Demodulate/Filter, Hilbert, DAS, CoherencyWeighting) with the same data layout
+ * between stages so it can be used where there is no usable GPU pipeline (see
+ * beamformer_compute_frame_fallback()) and as an oracle for the compute shaders. work is split
+ * across lanes with the threads.c lane machinery; lane 0 is always the calling thread.
+ *
+ * the math follows the shaders operation for operation where it matters for comparisons:
+ * DAS sums each channel chunk separately before adding it to the output, Decode divides
+ * after accumulating, and interpolation/apodization are evaluated with the same formulas.
+ * the GPU evaluates transcendentals at reduced precision and loads integer data as f16 so
+ * the comparison is tolerance based; the CPU results are identical for any lane count.
+ *
+ * Hilbert always takes the FFT path unless FIR taps are provided since there is no shared
+ * memory limit here. coherency weighting is applied by DAS once all chunks are summed.
+ *
+ * requires os_create_thread(), os_barrier_alloc(), and os_barrier_enter() (see beamformer.h)
+ * and threads.c to be included first.
+ */
+
+#if defined(__AVX512F__)
+  #define CPU_SIMD_WIDTH 16
+  typedef __m512 f32xN;
+  #define add_f32xN(a, b)      _mm512_add_ps(a, b)
+  #define div_f32xN(a, b)      _mm512_div_ps(a, b)
+  #define dup_f32xN(f)         _mm512_set1_ps(f)
+  #define load_f32xN(a)        _mm512_loadu_ps(a)
+  #define max_f32xN(a, b)      _mm512_max_ps(a, b)
+  #define mul_f32xN(a, b)      _mm512_mul_ps(a, b)
+  #define sqrt_f32xN(a)        _mm512_sqrt_ps(a)
+  #define store_f32xN(o, a)    _mm512_storeu_ps(o, a)
+  #define sub_f32xN(a, b)      _mm512_sub_ps(a, b)
+  #define lt_mask_f32xN(a, b)  (u32)_mm512_cmp_ps_mask(a, b, _CMP_LT_OQ)
+  #define load_i16_f32xN(a)    _mm512_cvtepi32_ps(_mm512_cvtepi16_epi32(_mm256_loadu_si256((__m256i *)(a))))
+#elif defined(__AVX2__)
+  #define CPU_SIMD_WIDTH 8
+  typedef __m256 f32xN;
+  #define add_f32xN(a, b)      _mm256_add_ps(a, b)
+  #define div_f32xN(a, b)      _mm256_div_ps(a, b)
+  #define dup_f32xN(f)         _mm256_set1_ps(f)
+  #define load_f32xN(a)        _mm256_loadu_ps(a)
+  #define max_f32xN(a, b)      _mm256_max_ps(a, b)
+  #define mul_f32xN(a, b)      _mm256_mul_ps(a, b)
+  #define sqrt_f32xN(a)        _mm256_sqrt_ps(a)
+  #define store_f32xN(o, a)    _mm256_storeu_ps(o, a)
+  #define sub_f32xN(a, b)      _mm256_sub_ps(a, b)
+  #define lt_mask_f32xN(a, b)  (u32)_mm256_movemask_ps(_mm256_cmp_ps(a, b, _CMP_LT_OQ))
+  #define load_i16_f32xN(a)    _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(_mm_loadu_si128((__m128i *)(a))))
+#else
+  #define CPU_SIMD_WIDTH 4
+  typedef f32x4 f32xN;
+  #define add_f32xN(a, b)      add_f32x4(a, b)
+  #define div_f32xN(a, b)      div_f32x4(a, b)
+  #define dup_f32xN(f)         dup_f32x4(f)
+  #define load_f32xN(a)        load_f32x4(a)
+  #define max_f32xN(a, b)      max_f32x4(a, b)
+  #define mul_f32xN(a, b)      mul_f32x4(a, b)
+  #define sqrt_f32xN(a)        sqrt_f32x4(a)
+  #define store_f32xN(o, a)    store_f32x4(o, a)
+  #define sub_f32xN(a, b)      sub_f32x4(a, b)
+  #if ARCH_ARM64
+    #define lt_mask_f32xN(a, b) vaddvq_u32(vandq_u32(vcltq_f32(a, b), (uint32x4_t){1, 2, 4, 8}))
+    #define load_i16_f32xN(a)   vcvtq_f32_s32(vmovl_s16(vld1_s16(a)))
+  #else
+    #define lt_mask_f32xN(a, b) (u32)_mm_movemask_ps(_mm_cmplt_ps(a, b))
+    #define load_i16_f32xN(a)   _mm_cvtepi32_ps(_mm_cvtepi16_epi32(_mm_loadl_epi64((__m128i *)(a))))
+  #endif
+#endif
+
+#define abs_f32xN(a) max_f32xN(a, sub_f32xN(dup_f32xN(0), a))
+
+#define BEAMFORMER_CPU_STAGE_LIST \
+	X(Load,       "Load")       \
+	X(Decode,     "Decode")     \
+	X(Demodulate, "Demodulate") \
+	X(Filter,     "Filter")     \
+	X(Hilbert,    "Hilbert")    \
+	X(DAS,        "DAS")        \
+
+typedef enum {
+	#define X(name, ...) BeamformerCPUStage_##name,
+	BEAMFORMER_CPU_STAGE_LIST
+	#undef X
+	BeamformerCPUStage_Count,
+} BeamformerCPUStage;
+
+read_only global str8 beamformer_cpu_stage_names[] = {
+	#define X(name, pretty) str8_comp(pretty),
+	BEAMFORMER_CPU_STAGE_LIST
+	#undef X
+};
+
+typedef struct {
+	void *data;
+	i32   length;
+	b32   complex;
+	f32   time_delay;
+} BeamformerCPUFilter;
+
+typedef struct {
+	BeamformerParameters parameters;
+	BeamformerDataKind   data_kind;
+
+	BeamformerShaderKind stages[BeamformerMaxComputeShaderStages];
+	u32                  stage_count;
+
+	/* NOTE(rnp): direct form taps (v2 when complex) for each Demodulate/Filter stage and
+	 * the optional FIR approximation for Hilbert (see hilbert_fir_filter()) */
+	BeamformerCPUFilter  filters[BeamformerMaxComputeShaderStages];
+
+	/* NOTE(rnp): only needed when single_focus/single_orientation are unset or for
+	 * sparse acquisitions (same as the DAS shader) */
+	BeamformerComputeArrayParameters *array_parameters;
+} BeamformerCPUPlanInfo;
+
+typedef struct {
+	BeamformerCPUStage kind;
+
+	u32 input_samples;
+	u32 output_samples;
+	b32 input_complex;
+	b32 output_complex;
+	u32 input_line_floats;
+	u32 output_line_floats;
+
+	/* NOTE(rnp): Demodulate/Filter */
+	u32   decimation_rate;
+	u32   filter_length;
+	b32   filter_complex;
+	f32   demodulation_scale;
+	v2   *phasors;
+	f32  *taps[2];
+	u32   tap_floats;
+
+	/* NOTE(rnp): Hilbert; FIR taps are in taps[0] when fft_size is 0 */
+	u32   fft_size;
+} BeamformerCPUStageInfo;
+
+typedef struct {
+	BeamformerCPUStageInfo stages[BeamformerMaxComputeShaderStages + 1];
+	u32                    stage_count;
+
+	BeamformerParameters   parameters;
+	BeamformerDataKind     data_kind;
+	BeamformerComputeArrayParameters *array_parameters;
+
+	f32 *hadamard;
+	/* NOTE(rnp): transposed, of order readi_group_count */
+	f32 *readi_hadamard;
+
+	/* NOTE(rnp): DAS */
+	m4  voxel_transform;
+	f32 sampling_frequency;
+	f32 time_offset;
+	u32 sample_count;
+	b32 iq;
+	b32 sparse;
+
+	u64 buffer_floats;
+	u64 scratch_floats;
+
+	str8 error;
+} BeamformerCPUPlan;
+
+typedef struct BeamformerCPUContext BeamformerCPUContext;
+
+typedef struct {
+	ThreadContext         thread;
+	BeamformerCPUContext *ctx;
+} BeamformerCPUWorker;
+
+struct BeamformerCPUContext {
+	BeamformerCPUPlan *plan;
+	void              *rf_data;
+	f32               *output;
+
+	f32 *buffers[2];
+	u64  buffer_floats;
+	f32 *scratch;
+	u64  scratch_floats;
+
+	u64  stage_ticks[BeamformerCPUStage_Count];
+
+	Arena               *arena;
+	BeamformerCPUWorker *workers;
+	u32                  lane_count;
+	b32                  quit;
+};
+
+/////////////////////////////////////
+// NOTE: Planning
+
+function f32 *
+cpu_expand_taps(Arena *arena, f32 *taps, u32 count, u32 stride, u32 repeat)
+{
+	u32  floats = (u32)round_up_to(count * repeat, CPU_SIMD_WIDTH);
+	f32 *result = push_array(arena, f32, floats);
+	for (u32 i = 0; i < count; i++)
+		for (u32 r = 0; r < repeat; r++)
+			result[i * repeat + r] = taps[i * stride];
+	return result;
+}
+
+function BeamformerCPUPlan *
+beamformer_cpu_plan(Arena *arena, BeamformerCPUPlanInfo *info)
+{
+	BeamformerCPUPlan *result = push_struct(arena, BeamformerCPUPlan);
+	BeamformerParameters *bp  = &info->parameters;
+
+	result->parameters       = *bp;
+	result->data_kind        = info->data_kind;
+	result->array_parameters = info->array_parameters;
+
+	u32 acquisition_count = bp->acquisition_count;
+	u32 decimation_rate   = Max(bp->decimation_rate, 1);
+
+	if (acquisition_count == 0 || bp->channel_count == 0 || bp->sample_count == 0)
+		result->error = str8("invalid parameters");
+
+	if (bp->readi_group_count > 1) {
+		u32 order = bp->readi_group_count;
+		f16 *h = make_hadamard_transpose(arena, (i32)order, 0);
+		if (!h || bp->readi_group >= order) {
+			result->error = str8("invalid READI group");
+		} else {
+			result->readi_hadamard = push_array(arena, f32, order * order);
+			for (u32 it = 0; it < order * order; it++)
+				result->readi_hadamard[it] = (f32)h[it];
+		}
+	}
+
+	b32 needs_array_parameters = !bp->single_focus || !bp->single_orientation;
+	u32 kind = bp->acquisition_kind;
+	result->sparse = kind == BeamformerAcquisitionKind_UFORCES || kind == BeamformerAcquisitionKind_UHERCULES;
+	if ((needs_array_parameters || result->sparse) && !info->array_parameters)
+		result->error = str8("array parameters are required");
+
+	BeamformerCPUStageInfo *load = result->stages + result->stage_count++;
+	load->kind           = BeamformerCPUStage_Load;
+	load->input_samples  = bp->sample_count;
+	load->input_complex  = beamformer_data_kind_complex[info->data_kind];
+	load->output_samples = load->input_samples;
+	load->output_complex = load->input_complex;
+
+	f32 sampling_frequency = bp->sampling_frequency;
+	f32 time_offset        = bp->time_offset;
+	b32 das_seen           = 0;
+
+	/* NOTE(rnp): same as plan_compute_pipeline(); demodulated data is already analytic */
+	b32 run_hilbert = !load->input_complex;
+	for (u32 i = 0; i < info->stage_count; i++)
+		if (info->stages[i] == BeamformerShaderKind_Demodulate)
+			run_hilbert = 0;
+
+	for (u32 i = 0; i < info->stage_count && result->error.length == 0; i++) {
+		BeamformerCPUStageInfo *prev = result->stages + result->stage_count - 1;
+
+		BeamformerCPUStage stage = BeamformerCPUStage_Count;
+		switch (info->stages[i]) {
+		case BeamformerShaderKind_Decode:{
+			if (bp->decode_mode != BeamformerDecodeMode_None)
+				stage = BeamformerCPUStage_Decode;
+		}break;
+		case BeamformerShaderKind_Demodulate:{ stage = BeamformerCPUStage_Demodulate; }break;
+		case BeamformerShaderKind_Filter:{     stage = BeamformerCPUStage_Filter;     }break;
+		case BeamformerShaderKind_DAS:{        stage = BeamformerCPUStage_DAS;        }break;
+		case BeamformerShaderKind_Hilbert:{
+			if (run_hilbert) stage = BeamformerCPUStage_Hilbert;
+		}break;
+		default:{
+			result->error = push_str8_from_parts(arena, str8(""), beamformer_shader_names[info->stages[i]],
+			                                     str8(" stage is unsupported"));
+		}break;
+		}
+		if (stage == BeamformerCPUStage_Count || das_seen)
+			continue;
+
+		BeamformerCPUStageInfo *s = result->stages + result->stage_count++;
+		s->kind           = stage;
+		s->input_samples  = prev->output_samples;
+		s->input_complex  = prev->output_complex;
+		s->output_samples = s->input_samples;
+		s->output_complex = s->input_complex;
+
+		switch (stage) {
+		case BeamformerCPUStage_Decode:{
+			if (result->hadamard == 0) {
+				f16 *h = make_hadamard_transpose(arena, (i32)acquisition_count, 0);
+				if (!h) {
+					result->error = str8("invalid Hadamard order");
+				} else {
+					result->hadamard = push_array(arena, f32, acquisition_count * acquisition_count);
+					for (u32 it = 0; it < acquisition_count * acquisition_count; it++)
+						result->hadamard[it] = (f32)h[it];
+				}
+			}
+		}break;
+
+		case BeamformerCPUStage_Demodulate:
+		case BeamformerCPUStage_Filter:
+		{
+			BeamformerCPUFilter *f = info->filters + i;
+			b32 demod = stage == BeamformerCPUStage_Demodulate;
+			if (f->length <= 0 || f->data == 0) {
+				result->error = str8("missing filter");
+				break;
+			}
+			if (demod && s->input_complex) {
+				result->error = str8("Demodulate requires real input data");
+				break;
+			}
+
+			s->filter_length   = (u32)f->length;
+			s->filter_complex  = f->complex;
+			s->decimation_rate = demod ? decimation_rate : 1;
+			time_offset       += f->time_delay;
+
+			if (demod) {
+				/* NOTE(rnp): see plan_compute_pipeline(); samples are taken as (I, Q) pairs with
+				 * an implicit decimation of 2. the phase reference matches the shader's shared
+				 * memory index, i.e. the first cached sample is FilterLength - 1 before the output */
+				u32 pair_count        = s->input_samples / 2;
+				s->input_complex      = 1;
+				s->output_complex     = 1;
+				s->input_samples      = pair_count;
+				s->output_samples     = pair_count / decimation_rate;
+				s->demodulation_scale = f->complex ? 1.0f : sqrt_f32(2.0f);
+				sampling_frequency   /= (f32)(2 * decimation_rate);
+
+				f32 fs = bp->sampling_frequency / 2;
+				s->phasors = push_array(arena, v2, pair_count);
+				for (u32 k = 0; k < pair_count; k++) {
+					f32 arg = 2 * PI * bp->demodulation_frequency * (f32)(k + s->filter_length - 1) / fs;
+					s->phasors[k] = (v2){{cos_f32(arg), -sin_f32(arg)}};
+				}
+			}
+			s->output_complex |= f->complex;
+
+			/* NOTE(rnp): taps are laid out to match the samples so every output is a plain dot
+			 * product: interleaved complex samples see each real tap twice */
+			f32 *taps = f->data;
+			u32  repeat = s->input_complex ? 2 : 1;
+			u32  stride = f->complex ? 2 : 1;
+			s->taps[0] = cpu_expand_taps(arena, taps, s->filter_length, stride, repeat);
+			if (f->complex)
+				s->taps[1] = cpu_expand_taps(arena, taps + 1, s->filter_length, stride, repeat);
+			s->tap_floats = (u32)round_up_to(s->filter_length * repeat, CPU_SIMD_WIDTH);
+
+			u64 line_floats = (u64)(s->filter_length - 1 + s->input_samples) * repeat + s->tap_floats;
+			result->scratch_floats = Max(result->scratch_floats, line_floats);
+		}break;
+
+		case BeamformerCPUStage_Hilbert:{
+			BeamformerCPUFilter *f = info->filters + i;
+			if (s->input_complex) {
+				result->error = str8("Hilbert requires real input data");
+				break;
+			}
+			s->output_complex = 1;
+
+			if (f->length > 0 && f->data) {
+				s->filter_length = (u32)f->length;
+				s->taps[0]       = f->data;
+			} else {
+				s->fft_size = (u32)round_up_power_of_two(s->input_samples);
+				result->scratch_floats = Max(result->scratch_floats, 2 * (u64)s->fft_size);
+			}
+		}break;
+
+		case BeamformerCPUStage_DAS:{
+			das_seen = 1;
+			result->iq = s->input_complex;
+		}break;
+
+		InvalidDefaultCase;
+		}
+	}
+
+	if (!das_seen && result->error.length == 0)
+		result->error = str8("pipeline must contain a DAS stage");
+
+	for (u32 i = 0; i < result->stage_count; i++) {
+		BeamformerCPUStageInfo *s = result->stages + i;
+		s->output_line_floats = s->output_samples * (s->output_complex ? 2 : 1);
+		s->input_line_floats  = i > 0 ? s[-1].output_line_floats : s->output_line_floats;
+		u64 line_floats = Max(s->input_line_floats, s->output_line_floats);
+		result->buffer_floats = Max(result->buffer_floats, line_floats * acquisition_count * bp->channel_count);
+	}
+	result->buffer_floats = (u64)round_up_to((i64)result->buffer_floats, CPU_SIMD_WIDTH);
+
+	result->sampling_frequency = sampling_frequency;
+	result->time_offset        = time_offset;
+	result->sample_count       = result->stages[result->stage_count - 1].output_samples;
+
+	result->voxel_transform = bp->das_voxel_transform;
+	if (kind == BeamformerAcquisitionKind_FORCES || kind == BeamformerAcquisitionKind_UFORCES)
+		result->voxel_transform = m4_mul(bp->xdc_transform, result->voxel_transform);
+
+	return result;
+}
+
+function u64
+beamformer_cpu_output_floats(BeamformerCPUPlan *plan)
+{
+	iv3 points = plan->parameters.output_points.xyz;
+	u64 result = (u64)points.x * (u64)points.y * (u64)points.z * (plan->iq ? 2 : 1);
+	return result;
+}
+
+/////////////////////////////////////
+// NOTE: Load
+
+function void
+cpu_load(BeamformerCPUPlan *p, void *rf_data, f32 *output)
+{
+	BeamformerParameters *bp = &p->parameters;
+	u64 count = (u64)bp->sample_count * bp->acquisition_count * bp->channel_count *
+	            (beamformer_data_kind_complex[p->data_kind] ? 2 : 1);
+
+	RangeU64 blocks = lane_range(count / CPU_SIMD_WIDTH);
+	u64 start = blocks.start * CPU_SIMD_WIDTH;
+	u64 stop  = blocks.stop  * CPU_SIMD_WIDTH;
+	if (lane_index() == lane_count() - 1) stop = count;
+
+	switch (p->data_kind) {
+	case BeamformerDataKind_Int16:
+	case BeamformerDataKind_Int16Complex:
+	{
+		i16 *in = rf_data;
+		u64 i = start;
+		for (; i + CPU_SIMD_WIDTH <= stop; i += CPU_SIMD_WIDTH)
+			store_f32xN(output + i, load_i16_f32xN(in + i));
+		for (; i < stop; i++)
+			output[i] = (f32)in[i];
+	}break;
+
+	case BeamformerDataKind_Float16:
+	case BeamformerDataKind_Float16Complex:
+	{
+		f16 *in = rf_data;
+		for (u64 i = start; i < stop; i++)
+			output[i] = (f32)in[i];
+	}break;
+
+	case BeamformerDataKind_Float32:
+	case BeamformerDataKind_Float32Complex:
+	{
+		f32 *in = rf_data;
+		u64 i = start;
+		for (; i + CPU_SIMD_WIDTH <= stop; i += CPU_SIMD_WIDTH)
+			store_f32xN(output + i, load_f32xN(in + i));
+		for (; i < stop; i++)
+			output[i] = in[i];
+	}break;
+
+	InvalidDefaultCase;
+	}
+}
+
+/////////////////////////////////////
+// NOTE: Decode
+
+function void
+cpu_decode(BeamformerCPUPlan *p, BeamformerCPUStageInfo *s, f32 *input, f32 *output)
+{
+	u32 transmit_count = p->parameters.acquisition_count;
+	u32 line_floats    = s->input_line_floats;
+	u32 channel_floats = line_floats * transmit_count;
+
+	/* NOTE(rnp): Hadamard decoding is real so interleaved complex data is decoded as if it
+	 * were twice as many real samples. work is split in blocks of samples for balance */
+	u32 block_floats = 64 * CPU_SIMD_WIDTH;
+	u32 block_count  = (line_floats + block_floats - 1) / block_floats;
+
+	f32xN scale = dup_f32xN((f32)transmit_count);
+
+	RangeU64 range = lane_range((u64)block_count * p->parameters.channel_count);
+	for (u64 it = range.start; it < range.stop; it++) {
+		u32 channel = (u32)(it / block_count);
+		u32 start   = (u32)(it % block_count) * block_floats;
+		u32 stop    = Min(start + block_floats, line_floats);
+
+		f32 *in  = input  + (u64)channel * channel_floats;
+		f32 *out = output + (u64)channel * channel_floats;
+		for (u32 transmit = 0; transmit < transmit_count; transmit++) {
+			f32 *o = out + transmit * line_floats;
+			u32 i  = start;
+			for (; i + CPU_SIMD_WIDTH <= stop; i += CPU_SIMD_WIDTH) {
+				f32xN result = dup_f32xN(0);
+				for (u32 j = 0; j < transmit_count; j++) {
+					f32xN h = dup_f32xN(p->hadamard[transmit_count * j + transmit]);
+					result  = add_f32xN(result, mul_f32xN(load_f32xN(in + j * line_floats + i), h));
+				}
+				store_f32xN(o + i, div_f32xN(result, scale));
+			}
+			for (; i < stop; i++) {
+				f32 result = 0;
+				for (u32 j = 0; j < transmit_count; j++)
+					result += in[j * line_floats + i] * p->hadamard[transmit_count * j + transmit];
+				o[i] = result / (f32)transmit_count;
+			}
+		}
+	}
+}
+
+/////////////////////////////////////
+// NOTE: Demodulate/Filter
+
+/* NOTE(rnp): returns the sums of the even and odd lanes separately */
+function v2
+cpu_dot(f32 *a, f32 *b, u32 count)
+{
+	f32xN acc = dup_f32xN(0);
+	for (u32 i = 0; i < count; i += CPU_SIMD_WIDTH)
+		acc = add_f32xN(acc, mul_f32xN(load_f32xN(a + i), load_f32xN(b + i)));
+
+	alignas(64) f32 lanes[CPU_SIMD_WIDTH];
+	store_f32xN(lanes, acc);
+
+	v2 result = {0};
+	for (u32 i = 0; i < CPU_SIMD_WIDTH; i += 2) {
+		result.x += lanes[i + 0];
+		result.y += lanes[i + 1];
+	}
+	return result;
+}
+
+function void
+cpu_filter(BeamformerCPUStageInfo *s, u32 line_count, f32 *input, f32 *output, f32 *scratch)
+{
+	u32 history = s->filter_length - 1;
+	u32 repeat  = s->input_complex ? 2 : 1;
+
+	/* NOTE(rnp): shader sample caching; the line is prefixed with zeros for the history
+	 * and suffixed with zeros so the padded taps can run past the end */
+	memory_clear(scratch, 0, history * repeat * sizeof(f32));
+	memory_clear(scratch + (history + s->input_samples) * repeat, 0, s->tap_floats * sizeof(f32));
+
+	RangeU64 range = lane_range(line_count);
+	for (u64 line = range.start; line < range.stop; line++) {
+		f32 *in  = input  + line * s->input_line_floats;
+		f32 *out = output + line * s->output_line_floats;
+		f32 *y   = scratch + history * repeat;
+
+		if (s->kind == BeamformerCPUStage_Demodulate) {
+			v2 *iq = (v2 *)y;
+			for (u32 k = 0; k < s->input_samples; k++) {
+				v2 a = {{in[2 * k + 0], -in[2 * k + 1]}};
+				v2 b = s->phasors[k];
+				iq[k].x = s->demodulation_scale * (b.x * a.x - b.y * a.y);
+				iq[k].y = s->demodulation_scale * (b.y * a.x + b.x * a.y);
+			}
+		} else {
+			memory_copy(y, in, s->input_samples * repeat * sizeof(f32));
+		}
+
+		for (u32 n = 0; n < s->output_samples; n++) {
+			f32 *x = scratch + (u64)s->decimation_rate * n * repeat;
+			v2   r = cpu_dot(x, s->taps[0], s->tap_floats);
+			if (s->input_complex && s->filter_complex) {
+				v2 i = cpu_dot(x, s->taps[1], s->tap_floats);
+				out[2 * n + 0] = r.x - i.y;
+				out[2 * n + 1] = r.y + i.x;
+			} else if (s->input_complex) {
+				out[2 * n + 0] = r.x;
+				out[2 * n + 1] = r.y;
+			} else if (s->filter_complex) {
+				v2 i = cpu_dot(x, s->taps[1], s->tap_floats);
+				out[2 * n + 0] = r.x + r.y;
+				out[2 * n + 1] = i.x + i.y;
+			} else {
+				out[n] = r.x + r.y;
+			}
+		}
+	}
+}
+
+/////////////////////////////////////
+// NOTE: Hilbert
+
+function void
+cpu_hilbert(BeamformerCPUStageInfo *s, u32 line_count, f32 *input, f32 *output, f32 *scratch)
+{
+	i32 sample_count = (i32)s->input_samples;
+
+	RangeU64 range = lane_range(line_count);
+	for (u64 line = range.start; line < range.stop; line++) {
+		f32 *in  = input  + line * s->input_line_floats;
+		f32 *out = output + line * s->output_line_floats;
+
+		if (s->fft_size) {
+			/* NOTE(rnp): see hilbert.glsl; DC and Nyquist are kept, positive frequencies are
+			 * doubled and negative ones removed with the inverse transform scale folded in */
+			v2 *x = (v2 *)scratch;
+			u32 n = s->fft_size;
+			for (u32 i = 0; i < n; i++)
+				x[i] = (v2){{(i32)i < sample_count ? in[i] : 0, 0}};
+
+			fft_complex(x, (i32)n, 0);
+			for (u32 i = 0; i < n; i++) {
+				f32 weight = 0;
+				if (i == 0 || i == n / 2) weight = 1;
+				else if (i < n / 2)       weight = 2;
+				x[i] = v2_scale(x[i], weight / (f32)n);
+			}
+			fft_complex(x, (i32)n, 1);
+
+			memory_copy(out, x, (u64)sample_count * sizeof(v2));
+		} else {
+			/* NOTE(rnp): H{x}[n] = Σ h[k] (x[n - k] - x[n + k]), k = 1, 3, ..., FIRLength / 2 */
+			f32 *h    = s->taps[0];
+			i32  half = (i32)s->filter_length / 2;
+			for (i32 i = 0; i < sample_count; i++) {
+				f32 result = 0;
+				for (i32 k = 1; k <= half; k += 2) {
+					f32 a = i - k >= 0           ? in[i - k] : 0;
+					f32 b = i + k < sample_count ? in[i + k] : 0;
+					result += h[half + k] * (a - b);
+				}
+				out[2 * i + 0] = in[i];
+				out[2 * i + 1] = result;
+			}
+		}
+	}
+}
+
+/////////////////////////////////////
+// NOTE: DAS
+
+#define CPU_DAS_C_SPLINE 0.5f
+
+function f32
+cpu_das_apodize(f32 arg)
+{
+	f32 a = cos_f32(PI * arg);
+	return a * a;
+}
+
+function v2
+cpu_das_load(BeamformerCPUPlan *p, f32 *rf, i32 index)
+{
+	v2 result;
+	if (p->iq) result = (v2){{rf[2 * index + 0], rf[2 * index + 1]}};
+	else       result = (v2){{rf[index], 0}};
+	return result;
+}
+
+function v2
+cpu_das_sample(BeamformerCPUPlan *p, f32 *rf, i32 rf_offset, f32 index)
+{
+	v2  result = {0};
+	f32 sample_count = (f32)p->sample_count;
+	b32 valid = 0;
+
+	switch (p->parameters.interpolation_mode) {
+	case BeamformerInterpolationMode_Nearest:{
+		if (index >= 0.f && index < (sample_count - 0.5f)) {
+			result = cpu_das_load(p, rf, rf_offset + (i32)(index + 0.5f));
+			valid  = 1;
+		}
+	}break;
+	case BeamformerInterpolationMode_Linear:{
+		if (index >= 0.f && index < sample_count - 1) {
+			i32 tk = (i32)index;
+			f32 t  = index - (f32)tk;
+			v2  a  = cpu_das_load(p, rf, rf_offset + tk);
+			v2  b  = cpu_das_load(p, rf, rf_offset + tk + 1);
+			result = v2_add(v2_scale(a, 1 - t), v2_scale(b, t));
+			valid  = 1;
+		}
+	}break;
+	case BeamformerInterpolationMode_Cubic:{
+		if (index >= 1.f && index < sample_count - 2) {
+			i32 tk = (i32)index;
+			f32 t  = index - (f32)tk;
+			v2 s0 = cpu_das_load(p, rf, rf_offset + tk + 0);
+			v2 s1 = cpu_das_load(p, rf, rf_offset + tk + 1);
+			v2 s2 = cpu_das_load(p, rf, rf_offset + tk + 2);
+			v2 s3 = cpu_das_load(p, rf, rf_offset + tk + 3);
+			/* NOTE: See: https://cubic.org/docs/hermite.htm */
+			for (u32 c = 0; c < 2; c++) {
+				f32 P1 = s1.E[c], P2 = s2.E[c];
+				f32 T1 = CPU_DAS_C_SPLINE * (P2 - s0.E[c]);
+				f32 T2 = CPU_DAS_C_SPLINE * (s3.E[c] - P1);
+				result.E[c] = t * t * t * (2 * P1 - 2 * P2 + T1 + T2) +
+				              t * t     * (-3 * P1 + 3 * P2 - 2 * T1 - T2) +
+				              t * T1 + P1;
+			}
+			valid = 1;
+		}
+	}break;
+	InvalidDefaultCase;
+	}
+
+	if (valid && p->iq) {
+		f32 arg = 2 * PI * p->parameters.demodulation_frequency * index / p->sampling_frequency;
+		f32 c = cos_f32(arg), s = sin_f32(arg);
+		result = (v2){{c * result.x - s * result.y, s * result.x + c * result.y}};
+	}
+	return result;
+}
+
+typedef struct {
+	f32xN x, y, z;
+} CPUPointN;
+
+typedef struct {
+	f32 re[CPU_SIMD_WIDTH];
+	f32 im[CPU_SIMD_WIDTH];
+	/* NOTE(rnp): sum of magnitudes; only used for coherency weighting */
+	f32 incoherent[CPU_SIMD_WIDTH];
+} CPUResultN;
+
+function void
+cpu_das_accumulate(BeamformerCPUPlan *p, f32 *rf, i32 rf_offset, f32xN index, f32 *apodization,
+                   u32 mask, CPUResultN *result)
+{
+	alignas(64) f32 indices[CPU_SIMD_WIDTH];
+	store_f32xN(indices, index);
+	for EachBit(mask, lane) {
+		v2 value = v2_scale(cpu_das_sample(p, rf, rf_offset, indices[lane]), apodization[lane]);
+		result->re[lane] += value.x;
+		result->im[lane] += value.y;
+		if (p->parameters.coherency_weighting)
+			result->incoherent[lane] += sqrt_f32(value.x * value.x + value.y * value.y);
+	}
+}
+
+function void
+cpu_das_apodization(f32 *out, f32xN argument, f32 scale, u32 mask)
+{
+	alignas(64) f32 args[CPU_SIMD_WIDTH];
+	store_f32xN(args, argument);
+	for EachBit(mask, lane) {
+		out[lane]  = scale;
+		out[lane] *= cpu_das_apodize(args[lane]);
+	}
+}
+
+function u8
+cpu_das_tx_rx_orientation(BeamformerCPUPlan *p, u32 acquisition)
+{
+	u8 result = (u8)p->parameters.transmit_receive_orientation;
+	if (!p->parameters.single_orientation) result = p->array_parameters->transmit_receive_orientations[acquisition];
+	return result;
+}
+
+function v2
+cpu_das_focal_vector(BeamformerCPUPlan *p, u32 acquisition)
+{
+	v2 result = p->parameters.focal_vector;
+	if (!p->parameters.single_focus) result = p->array_parameters->focal_vectors[acquisition];
+	return result;
+}
+
+function f32xN
+cpu_das_sample_index(BeamformerCPUPlan *p, f32xN distance)
+{
+	f32xN time = add_f32xN(div_f32xN(distance, dup_f32xN(p->parameters.speed_of_sound)), dup_f32xN(p->time_offset));
+	return mul_f32xN(time, dup_f32xN(p->sampling_frequency));
+}
+
+function f32xN
+cpu_das_rca_transmit_distance(CPUPointN point, v2 focal_vector, u8 tx_rx_orientation)
+{
+	f32xN result = dup_f32xN(0);
+	u8 tx = (tx_rx_orientation >> 4) & 0x0F;
+	if (tx != BeamformerRCAOrientation_None) {
+		f32xN px    = tx == BeamformerRCAOrientation_Rows ? point.y : point.x;
+		f32   angle = focal_vector.x * PI / 180.0f;
+		f32   depth = focal_vector.y;
+		f32xN sx    = dup_f32xN(sin_f32(angle));
+		f32xN sz    = dup_f32xN(cos_f32(angle));
+		if (depth == inf32() || depth == -inf32()) {
+			result = add_f32xN(mul_f32xN(px, sx), mul_f32xN(point.z, sz));
+		} else {
+			f32xN dx = sub_f32xN(px,      mul_f32xN(dup_f32xN(depth), sx));
+			f32xN dz = sub_f32xN(point.z, mul_f32xN(dup_f32xN(depth), sz));
+			result   = sqrt_f32xN(add_f32xN(mul_f32xN(dx, dx), mul_f32xN(dz, dz)));
+		}
+	}
+	return result;
+}
+
+function CPUPointN
+cpu_das_transform(m4 m, CPUPointN p)
+{
+	CPUPointN result;
+	#define ROW(r) add_f32xN(add_f32xN(mul_f32xN(dup_f32xN(m.c[0].E[r]), p.x), \
+	                                   mul_f32xN(dup_f32xN(m.c[1].E[r]), p.y)), \
+	                         add_f32xN(mul_f32xN(dup_f32xN(m.c[2].E[r]), p.z), dup_f32xN(m.c[3].E[r])))
+	result.x = ROW(0);
+	result.y = ROW(1);
+	result.z = ROW(2);
+	#undef ROW
+	return result;
+}
+
+function void
+cpu_das_forces(BeamformerCPUPlan *p, f32 *rf, CPUPointN point, u32 valid, u32 channel_offset,
+               u32 chunk_channel_count, CPUResultN *result)
+{
+	BeamformerParameters *bp = &p->parameters;
+	i32 sample_count  = (i32)p->sample_count;
+	i32 channel_floats = sample_count * (i32)bp->acquisition_count;
+	f32 fs_over_c     = p->sampling_frequency / bp->speed_of_sound;
+
+	f32xN z_delta_squared     = mul_f32xN(point.z, point.z);
+	f32xN transmit_y_delta    = sub_f32xN(point.y, dup_f32xN(bp->xdc_element_pitch.y * (f32)bp->channel_count / 2));
+	f32xN transmit_yz_squared = add_f32xN(mul_f32xN(transmit_y_delta, transmit_y_delta), z_delta_squared);
+
+	for (u32 chunk_channel = 0; chunk_channel < chunk_channel_count; chunk_channel++) {
+		f32   rx_channel      = (f32)(channel_offset + chunk_channel);
+		f32xN receive_x_delta = sub_f32xN(point.x, dup_f32xN(rx_channel * bp->xdc_element_pitch.x));
+		f32xN a_arg = abs_f32xN(div_f32xN(mul_f32xN(dup_f32xN(bp->f_number), receive_x_delta), point.z));
+
+		u32 mask = valid & lt_mask_f32xN(a_arg, dup_f32xN(0.5f));
+		if (mask) {
+			i32 rf_offset  = (i32)(channel_offset + chunk_channel) * channel_floats + (i32)p->sparse * sample_count;
+			rf_offset     -= bp->interpolation_mode == BeamformerInterpolationMode_Cubic;
+
+			f32xN receive_distance = sqrt_f32xN(add_f32xN(mul_f32xN(receive_x_delta, receive_x_delta), z_delta_squared));
+			f32xN receive_index    = cpu_das_sample_index(p, receive_distance);
+
+			alignas(64) f32 apodization[CPU_SIMD_WIDTH];
+			cpu_das_apodization(apodization, a_arg, 1.0f, mask);
+
+			for (u32 transmit = p->sparse; transmit < bp->acquisition_count; transmit++) {
+				f32 tx_channel = p->sparse ? (f32)p->array_parameters->sparse_elements[transmit - p->sparse] : (f32)transmit;
+				f32xN transmit_x_delta = sub_f32xN(point.x, dup_f32xN(bp->xdc_element_pitch.x * tx_channel));
+				f32xN transmit_index   = mul_f32xN(sqrt_f32xN(add_f32xN(transmit_yz_squared,
+				                                                        mul_f32xN(transmit_x_delta, transmit_x_delta))),
+				                                   dup_f32xN(fs_over_c));
+				cpu_das_accumulate(p, rf, rf_offset, add_f32xN(receive_index, transmit_index),
+				                   apodization, mask, result);
+				rf_offset += sample_count;
+			}
+		}
+	}
+}
+
+function void
+cpu_das_readi_forces(BeamformerCPUPlan *p, f32 *rf, CPUPointN point, u32 valid, u32 channel_offset,
+                     u32 chunk_channel_count, CPUResultN *result)
+{
+	BeamformerParameters *bp = &p->parameters;
+	i32 sample_count   = (i32)p->sample_count;
+	i32 channel_floats = sample_count * (i32)bp->acquisition_count;
+	f32 fs_over_c      = p->sampling_frequency / bp->speed_of_sound;
+
+	f32xN z_delta_squared     = mul_f32xN(point.z, point.z);
+	f32xN transmit_y_delta    = sub_f32xN(point.y, dup_f32xN(bp->xdc_element_pitch.y * (f32)bp->channel_count / 2));
+	f32xN transmit_yz_squared = add_f32xN(mul_f32xN(transmit_y_delta, transmit_y_delta), z_delta_squared);
+
+	/* NOTE(rnp): see READI_FORCES in das.glsl. the row matches the acquisition group and the
+	 * column is the element group being beamformed */
+	f32 *hadamard = p->readi_hadamard + bp->readi_group * bp->readi_group_count;
+
+	for (u32 chunk_channel = 0; chunk_channel < chunk_channel_count; chunk_channel++) {
+		f32   rx_channel      = (f32)(channel_offset + chunk_channel);
+		f32xN receive_x_delta = sub_f32xN(point.x, dup_f32xN(rx_channel * bp->xdc_element_pitch.x));
+		f32xN a_arg = abs_f32xN(div_f32xN(mul_f32xN(dup_f32xN(bp->f_number), receive_x_delta), point.z));
+
+		u32 mask = valid & lt_mask_f32xN(a_arg, dup_f32xN(0.5f));
+		if (mask) {
+			i32 channel_rf_offset  = (i32)(channel_offset + chunk_channel) * channel_floats;
+			channel_rf_offset     -= bp->interpolation_mode == BeamformerInterpolationMode_Cubic;
+
+			f32xN receive_distance = sqrt_f32xN(add_f32xN(mul_f32xN(receive_x_delta, receive_x_delta), z_delta_squared));
+			f32xN receive_index    = cpu_das_sample_index(p, receive_distance);
+
+			for (u32 tx_group = 0; tx_group < bp->readi_group_count; tx_group++) {
+				alignas(64) f32 apodization[CPU_SIMD_WIDTH];
+				cpu_das_apodization(apodization, a_arg, hadamard[tx_group], mask);
+
+				i32 rf_offset = channel_rf_offset;
+				for (u32 tx_event = 0; tx_event < bp->acquisition_count; tx_event++) {
+					f32 tx_element = (f32)(tx_group * bp->acquisition_count + tx_event);
+					f32xN transmit_x_delta = sub_f32xN(point.x, dup_f32xN(bp->xdc_element_pitch.x * tx_element));
+					f32xN transmit_index   = mul_f32xN(sqrt_f32xN(add_f32xN(transmit_yz_squared,
+					                                                        mul_f32xN(transmit_x_delta, transmit_x_delta))),
+					                                   dup_f32xN(fs_over_c));
+					cpu_das_accumulate(p, rf, rf_offset, add_f32xN(receive_index, transmit_index),
+					                   apodization, mask, result);
+					rf_offset += sample_count;
+				}
+			}
+		}
+	}
+}
+
+function void
+cpu_das_hercules(BeamformerCPUPlan *p, f32 *rf, CPUPointN point, u32 valid, u32 channel_offset,
+                 u32 chunk_channel_count, CPUResultN *result)
+{
+	BeamformerParameters *bp = &p->parameters;
+	i32 sample_count   = (i32)p->sample_count;
+	i32 channel_floats = sample_count * (i32)bp->acquisition_count;
+	f32 fs_over_c      = p->sampling_frequency / bp->speed_of_sound;
+
+	u8  tx_rx_orientation = cpu_das_tx_rx_orientation(p, 0);
+	b32 rx_cols           = (tx_rx_orientation & 0x0F) == BeamformerRCAOrientation_Columns;
+	v2  focal_vector      = cpu_das_focal_vector(p, 0);
+
+	CPUPointN xdc_point = cpu_das_transform(bp->xdc_transform, point);
+
+	f32xN transmit_index   = cpu_das_sample_index(p, cpu_das_rca_transmit_distance(point, focal_vector, tx_rx_orientation));
+	f32xN z_delta_squared  = mul_f32xN(xdc_point.z, xdc_point.z);
+	f32xN f_number_over_z  = abs_f32xN(div_f32xN(dup_f32xN(bp->f_number), xdc_point.z));
+	f32xN apodization_test = div_f32xN(dup_f32xN(0.25f), mul_f32xN(f_number_over_z, f_number_over_z));
+
+	for (u32 chunk_channel = 0; chunk_channel < chunk_channel_count; chunk_channel++) {
+		f32 rx_channel = (f32)(channel_offset + chunk_channel);
+		i32 rf_offset  = (i32)(channel_offset + chunk_channel) * channel_floats + (i32)p->sparse * sample_count;
+		rf_offset     -= bp->interpolation_mode == BeamformerInterpolationMode_Cubic;
+
+		f32xN rx_delta = rx_cols ? sub_f32xN(xdc_point.x, dup_f32xN(rx_channel * bp->xdc_element_pitch.x))
+		                         : sub_f32xN(xdc_point.y, dup_f32xN(rx_channel * bp->xdc_element_pitch.y));
+		f32xN rx_delta_squared = mul_f32xN(rx_delta, rx_delta);
+
+		for (u32 transmit = p->sparse; transmit < bp->acquisition_count; transmit++) {
+			f32 tx_channel = p->sparse ? (f32)p->array_parameters->sparse_elements[transmit - p->sparse] : (f32)transmit;
+
+			f32xN tx_delta = rx_cols ? sub_f32xN(xdc_point.y, dup_f32xN(tx_channel * bp->xdc_element_pitch.y))
+			                         : sub_f32xN(xdc_point.x, dup_f32xN(tx_channel * bp->xdc_element_pitch.x));
+			f32xN tx_delta_squared = mul_f32xN(tx_delta, tx_delta);
+
+			f32xN element_delta_squared = rx_cols ? add_f32xN(rx_delta_squared, tx_delta_squared)
+			                                      : add_f32xN(tx_delta_squared, rx_delta_squared);
+			u32 mask = valid & lt_mask_f32xN(element_delta_squared, apodization_test);
+			if (mask) {
+				/* NOTE: tribal knowledge */
+				f32 scale = transmit == 0 ? 1.0f / sqrt_f32((f32)bp->acquisition_count) : 1.0f;
+
+				alignas(64) f32 apodization[CPU_SIMD_WIDTH];
+				cpu_das_apodization(apodization, mul_f32xN(f_number_over_z, sqrt_f32xN(element_delta_squared)),
+				                    scale, mask);
+
+				f32xN distance = sqrt_f32xN(add_f32xN(z_delta_squared, element_delta_squared));
+				f32xN index    = add_f32xN(transmit_index, mul_f32xN(distance, dup_f32xN(fs_over_c)));
+				cpu_das_accumulate(p, rf, rf_offset, index, apodization, mask, result);
+			}
+			rf_offset += sample_count;
+		}
+	}
+}
+
+function void
+cpu_das_rca(BeamformerCPUPlan *p, f32 *rf, CPUPointN point, u32 valid, u32 channel_offset,
+            u32 chunk_channel_count, CPUResultN *result)
+{
+	BeamformerParameters *bp = &p->parameters;
+	i32 sample_count   = (i32)p->sample_count;
+	i32 channel_floats = sample_count * (i32)bp->acquisition_count;
+
+	CPUPointN xdc_point = cpu_das_transform(bp->xdc_transform, point);
+
+	for (u32 acquisition = 0; acquisition < bp->acquisition_count; acquisition++) {
+		u8  tx_rx_orientation = cpu_das_tx_rx_orientation(p, acquisition);
+		b32 rx_rows           = (tx_rx_orientation & 0x0F) == BeamformerRCAOrientation_Rows;
+		v2  focal_vector      = cpu_das_focal_vector(p, acquisition);
+
+		f32xN xdc_u = rx_rows ? xdc_point.y : xdc_point.x;
+		f32xN xdc_z = abs_f32xN(xdc_point.z);
+		f32xN transmit_distance = cpu_das_rca_transmit_distance(point, focal_vector, tx_rx_orientation);
+
+		i32 rf_offset  = (i32)channel_offset * channel_floats + (i32)acquisition * sample_count;
+		rf_offset     -= bp->interpolation_mode == BeamformerInterpolationMode_Cubic;
+		for (u32 chunk_channel = 0; chunk_channel < chunk_channel_count; chunk_channel++) {
+			f32   rx_channel = (f32)(channel_offset + chunk_channel);
+			f32   rx_center  = rx_channel * bp->xdc_element_pitch.E[rx_rows ? 1 : 0];
+			f32xN receive_u  = sub_f32xN(xdc_u, dup_f32xN(rx_center));
+			f32xN a_arg      = abs_f32xN(div_f32xN(mul_f32xN(dup_f32xN(bp->f_number), receive_u), xdc_z));
+
+			u32 mask = valid & lt_mask_f32xN(a_arg, dup_f32xN(0.5f));
+			if (mask) {
+				alignas(64) f32 apodization[CPU_SIMD_WIDTH];
+				cpu_das_apodization(apodization, a_arg, 1.0f, mask);
+
+				f32xN receive_distance = sqrt_f32xN(add_f32xN(mul_f32xN(receive_u, receive_u),
+				                                              mul_f32xN(xdc_point.z, xdc_point.z)));
+				f32xN index = cpu_das_sample_index(p, add_f32xN(transmit_distance, receive_distance));
+				cpu_das_accumulate(p, rf, rf_offset, index, apodization, mask, result);
+			}
+			rf_offset += channel_floats;
+		}
+	}
+}
+
+function void
+cpu_das(BeamformerCPUPlan *p, f32 *rf, f32 *output)
+{
+	BeamformerParameters *bp = &p->parameters;
+	iv3 points  = bp->output_points.xyz;
+	u32 tiles_x = ((u32)points.x + CPU_SIMD_WIDTH - 1) / CPU_SIMD_WIDTH;
+
+	v3 image_points = {{(f32)Max(1, points.x - 1), (f32)Max(1, points.y - 1), (f32)Max(1, points.z - 1)}};
+
+	alignas(64) f32 lane_offsets[CPU_SIMD_WIDTH];
+	for (u32 i = 0; i < CPU_SIMD_WIDTH; i++) lane_offsets[i] = (f32)i;
+
+	RangeU64 range = lane_range((u64)tiles_x * (u64)points.y * (u64)points.z);
+	for (u64 tile = range.start; tile < range.stop; tile++) {
+		u32 x0  = (u32)(tile % tiles_x) * CPU_SIMD_WIDTH;
+		u32 row = (u32)(tile / tiles_x);
+		u32 y   = row % (u32)points.y;
+		u32 z   = row / (u32)points.y;
+
+		u32 valid = 0;
+		for (u32 i = 0; i < CPU_SIMD_WIDTH; i++)
+			if (x0 + i < (u32)points.x) valid |= 1u << i;
+
+		CPUPointN voxel = {
+			.x = div_f32xN(add_f32xN(load_f32xN(lane_offsets), dup_f32xN((f32)x0)), dup_f32xN(image_points.x)),
+			.y = dup_f32xN((f32)y / image_points.y),
+			.z = dup_f32xN((f32)z / image_points.z),
+		};
+		CPUPointN point = cpu_das_transform(p->voxel_transform, voxel);
+
+		CPUResultN sum = {0};
+		for (u32 channel_offset = 0; channel_offset < bp->channel_count; channel_offset += BeamformerChunkChannelCount) {
+			u32 chunk_channel_count = Min(BeamformerChunkChannelCount, bp->channel_count - channel_offset);
+
+			CPUResultN chunk = {0};
+			switch (bp->acquisition_kind) {
+			case BeamformerAcquisitionKind_FORCES:
+			case BeamformerAcquisitionKind_UFORCES:
+			{
+				if (bp->readi_group_count > 1)
+					cpu_das_readi_forces(p, rf, point, valid, channel_offset, chunk_channel_count, &chunk);
+				else
+					cpu_das_forces(p, rf, point, valid, channel_offset, chunk_channel_count, &chunk);
+			}break;
+			case BeamformerAcquisitionKind_HERCULES:
+			case BeamformerAcquisitionKind_UHERCULES:
+			case BeamformerAcquisitionKind_HERO_PA:
+			{
+				cpu_das_hercules(p, rf, point, valid, channel_offset, chunk_channel_count, &chunk);
+			}break;
+			case BeamformerAcquisitionKind_Flash:
+			case BeamformerAcquisitionKind_RCA_TPW:
+			case BeamformerAcquisitionKind_RCA_VLS:
+			{
+				cpu_das_rca(p, rf, point, valid, channel_offset, chunk_channel_count, &chunk);
+			}break;
+			default:{}break;
+			}
+
+			for (u32 i = 0; i < CPU_SIMD_WIDTH; i++) {
+				sum.re[i]         += chunk.re[i];
+				sum.im[i]         += chunk.im[i];
+				sum.incoherent[i] += chunk.incoherent[i];
+			}
+		}
+
+		u64 out_index = (u64)points.x * (u64)points.y * z + (u64)points.x * y + x0;
+		for EachBit(valid, lane) {
+			/* NOTE(rnp): see coherency_weighting.glsl; complex data is weighted per component */
+			if (bp->coherency_weighting) {
+				sum.re[lane] *= sum.re[lane] / sum.incoherent[lane];
+				sum.im[lane] *= sum.im[lane] / sum.incoherent[lane];
+			}
+
+			if (p->iq) {
+				output[2 * (out_index + lane) + 0] = sum.re[lane];
+				output[2 * (out_index + lane) + 1] = sum.im[lane];
+			} else {
+				output[out_index + lane] = sum.re[lane];
+			}
+		}
+	}
+}
+
+/////////////////////////////////////
+// NOTE: Execution
+
+function void
+beamformer_cpu_lane(BeamformerCPUContext *ctx)
+{
+	BeamformerCPUPlan *p = ctx->plan;
+	u32 line_count = p->parameters.channel_count * p->parameters.acquisition_count;
+	f32 *scratch   = ctx->scratch + lane_index() * ctx->scratch_floats;
+
+	u32 current = 0;
+	u64 start   = os_timer_count();
+	for (u32 i = 0; i < p->stage_count; i++) {
+		BeamformerCPUStageInfo *s = p->stages + i;
+		f32 *input  = ctx->buffers[current];
+		f32 *output = ctx->buffers[!current];
+
+		switch (s->kind) {
+		case BeamformerCPUStage_Load:{       cpu_load(p, ctx->rf_data, output);                    }break;
+		case BeamformerCPUStage_Decode:{     cpu_decode(p, s, input, output);                       }break;
+		case BeamformerCPUStage_Demodulate:
+		case BeamformerCPUStage_Filter:{     cpu_filter(s, line_count, input, output, scratch);     }break;
+		case BeamformerCPUStage_Hilbert:{    cpu_hilbert(s, line_count, input, output, scratch);    }break;
+		case BeamformerCPUStage_DAS:{        cpu_das(p, input, ctx->output);                        }break;
+		InvalidDefaultCase;
+		}
+		current = !current;
+
+		lane_sync();
+		if (lane_index() == 0) {
+			u64 end = os_timer_count();
+			ctx->stage_ticks[s->kind] += end - start;
+			start = end;
+		}
+	}
+}
+
+function OS_THREAD_ENTRY_POINT_FN(beamformer_cpu_worker_entry_point)
+{
+	BeamformerCPUWorker  *worker = user_context;
+	BeamformerCPUContext *ctx    = worker->ctx;
+
+	lane_context(&worker->thread);
+	for (;;) {
+		lane_sync();
+		if (ctx->quit) break;
+		beamformer_cpu_lane(ctx);
+		lane_sync();
+	}
+	return 0;
+}
+
+function BeamformerCPUContext *
+beamformer_cpu_context_create(Arena *arena, u32 lane_count)
+{
+	BeamformerCPUContext *result = push_struct(arena, BeamformerCPUContext);
+	result->arena      = arena;
+	result->lane_count = Max(1, lane_count);
+	result->workers    = push_array(arena, BeamformerCPUWorker, result->lane_count);
+
+	OSBarrier barrier = os_barrier_alloc(result->lane_count);
+	u64 *broadcast    = push_array(arena, u64, 8);
+	for (u32 i = 0; i < result->lane_count; i++) {
+		LaneContext *lc = &result->workers[i].thread.lane_context;
+		lc->index            = i;
+		lc->count            = result->lane_count;
+		lc->barrier          = barrier;
+		lc->broadcast_memory = broadcast;
+		result->workers[i].ctx = result;
+	}
+
+	for (u32 i = 1; i < result->lane_count; i++)
+		os_create_thread("[cpu beamformer]", result->workers + i, beamformer_cpu_worker_entry_point);
+
+	return result;
+}
+
+function void
+beamformer_cpu_context_destroy(BeamformerCPUContext *ctx)
+{
+	lane_context(&ctx->workers[0].thread);
+	ctx->quit = 1;
+	lane_sync();
+}
+
+/* NOTE(rnp): output must hold beamformer_cpu_output_floats() floats; (re, im) pairs when
+ * the plan is iq. rf_data is laid out as it would be uploaded to the GPU */
+function b32
+beamformer_cpu_beamform(BeamformerCPUContext *ctx, BeamformerCPUPlan *plan, void *rf_data, f32 *output)
+{
+	b32 result = plan->error.length == 0;
+	if (result) {
+		if (ctx->buffer_floats < plan->buffer_floats) {
+			ctx->buffer_floats = plan->buffer_floats;
+			ctx->buffers[0] = push_array_no_zero(ctx->arena, f32, plan->buffer_floats, .align = 64);
+			ctx->buffers[1] = push_array_no_zero(ctx->arena, f32, plan->buffer_floats, .align = 64);
+		}
+		if (ctx->scratch_floats < plan->scratch_floats) {
+			ctx->scratch_floats = plan->scratch_floats;
+			ctx->scratch = push_array_no_zero(ctx->arena, f32, plan->scratch_floats * ctx->lane_count, .align = 64);
+		}
+
+		ctx->plan    = plan;
+		ctx->rf_data = rf_data;
+		ctx->output  = output;
+
+		/* NOTE(rnp): the caller may have its own lane context (e.g. the compute thread) */
+		ThreadContext *caller = thread_context_local;
+		lane_context(&ctx->workers[0].thread);
+		lane_sync();
+		beamformer_cpu_lane(ctx);
+		lane_sync();
+		lane_context(caller);
+	}
+	return result;
+}
@@ -109,8 +109,70 @@ typedef struct {
 
 	u64 gpu_heap_size;
 	u64 gpu_heap_used;
+
+	/* NOTE(rnp): PCI address of the device; only valid when pci_bus_info is set */
+	b32 pci_bus_info;
+	u32 pci_domain;
+	u32 pci_bus;
+	u32 pci_device;
+	u32 pci_function;
+
+	/* NOTE(rnp): device timestamps can be sampled together with os_timer_count() */
+	b32 calibrated_timestamps;
+	/* NOTE(rnp): profile zones can count compute shader invocations */
+	b32 pipeline_statistics;
 } GPUInfo;
 
+typedef struct {
+	str8 label;
+	u64  size;
+	b32  dedicated;
+} GPUMemoryAllocation;
+
+typedef struct {
+	/* NOTE(rnp): pooled blocks reserved from the driver and the part of them in use */
+	u64 block_bytes;
+	u64 suballocated_bytes;
+	u32 block_count;
+
+	u64 dedicated_bytes;
+	u32 dedicated_count;
+
+	/* NOTE(rnp): released but still waiting on the GPU */
+	u64 pending_bytes;
+
+	GPUMemoryAllocation *allocations;
+	u32                  allocation_count;
+} GPUMemoryReport;
+
+#define GPUProfileZoneNone (U32_MAX)
+
+typedef enum {
+	/* NOTE(rnp): count compute shader invocations; needs gpu_info()->pipeline_statistics */
+	GPUProfileZoneFlag_PipelineStatistics = 1 << 0,
+} GPUProfileZoneFlags;
+
+typedef struct {
+	str8 label;
+	/* NOTE(rnp): device timestamps (see GPUInfo.timestamp_period_ns) */
+	u64  begin;
+	u64  end;
+	u64  invocations;
+	/* NOTE(rnp): index of the enclosing zone or GPUProfileZoneNone */
+	u32  parent;
+	u32  depth;
+	/* NOTE(rnp): caller supplied (see gpu_profile_zone_begin_tagged()) or GPUProfileZoneNone */
+	u32  tag;
+} GPUProfileZone;
+
+typedef struct {
+	str8 label;
+	u32  depth;
+	u32  count;
+	u64  ticks;
+	u64  invocations;
+} GPUProfileZoneSummary;
+
 typedef struct {
 	i64               size;
 	VulkanUsageFlags  flags;
@@ -144,6 +206,7 @@ typedef struct {
 DEBUG_IMPORT void vk_load(OSLibrary vulkan, Stream *error);
 
 DEBUG_IMPORT GPUInfo *gpu_info(void);
+DEBUG_IMPORT GPUMemoryReport gpu_memory_report(Arena *arena);
 
 DEBUG_IMPORT void gpu_buffer_allocate(GPUBuffer *, GPUBufferAllocateInfo info);
 DEBUG_IMPORT void gpu_buffer_release(GPUBuffer *);
@@ -165,7 +228,7 @@ DEBUG_IMPORT void vk_bind_shader_resources(BeamformerShaderResourceInfo *infos,
  * In particular the push constants should contain pointers to gpu memory using the
  * BufferDeviceAddress extension. */
 // TODO(rnp): change this to accept SPIR-V directly and accept BakeParameters as specialization data
-DEBUG_IMPORT VulkanHandle vk_pipeline(VulkanPipelineCreateInfo *infos, u32 count, u32 push_constants_size);
+DEBUG_IMPORT VulkanHandle vk_pipeline(Arena *arena, VulkanPipelineCreateInfo *infos, u32 count, u32 push_constants_size);
 DEBUG_IMPORT b32          vk_pipeline_valid(VulkanHandle);
 DEBUG_IMPORT void         vk_pipeline_release(VulkanHandle);
 
@@ -185,7 +248,6 @@ DEBUG_IMPORT void            gpu_command_pipeline_barrier(GPUCommandList command
 DEBUG_IMPORT void            gpu_command_clear_buffer(GPUCommandList command, GPUBuffer *buffer, u64 offset, u64 size, u32 clear_word);
 DEBUG_IMPORT void            gpu_command_dispatch_compute(GPUCommandList command, uv3 dispatch);
 DEBUG_IMPORT void            gpu_command_push_constants(GPUCommandList command, u32 offset, u32 size, void *values);
-DEBUG_IMPORT void            gpu_command_timestamp(GPUCommandList command);
 DEBUG_IMPORT void            gpu_command_wait_timeline(GPUCommandList command, GPUTimeline timeline, u64 value);
 
 DEBUG_IMPORT void            gpu_command_begin_rendering(GPUCommandList command, GPUImage *restrict colour, GPUImage *restrict depth, GPUImage *restrict resolve);
@@ -196,8 +258,14 @@ DEBUG_IMPORT void            gpu_command_end_rendering(GPUCommandList command);
 
 DEBUG_IMPORT void            gpu_command_copy_buffer(GPUCommandList command, GPUBuffer *restrict destination, GPUBuffer *restrict source, u64 source_offset, i64 size);
 
-// NOTE: returns array of valid timestamps. Calling thread may stall until results available.
-DEBUG_IMPORT u64 *           gpu_read_timestamps(GPUTimeline timeline, u64 *count, Arena *arena);
+DEBUG_IMPORT void            gpu_profile_zone_begin(GPUCommandList command, str8 label, GPUProfileZoneFlags flags);
+DEBUG_IMPORT void            gpu_profile_zone_begin_tagged(GPUCommandList command, str8 label, GPUProfileZoneFlags flags, u32 tag);
+DEBUG_IMPORT void            gpu_profile_zone_end(GPUCommandList command);
+
+// NOTE: returns the zones of the last submitted command list. Calling thread may stall until results available.
+DEBUG_IMPORT GPUProfileZone *        gpu_read_profile_zones(GPUTimeline timeline, u32 *count, Arena *arena);
+DEBUG_IMPORT GPUProfileZoneSummary * gpu_profile_zones_by_tag(GPUProfileZone *zones, u32 count, u32 tag_count, Arena *arena);
+DEBUG_IMPORT b32             gpu_timestamp_calibration(u64 *gpu_ticks, u64 *host_ticks);
 
 #if BEAMFORMER_RENDERDOC_HOOKS
 DEBUG_IMPORT void *       vk_renderdoc_instance_handle(void);
@@ -229,6 +297,27 @@ DEBUG_IMPORT renderdoc_end_frame_capture_fn   *end_frame_capture;
 #endif
 
 #include "util_os.c"
+#include "jobs.c"
+
+///////////////////////////
+// NOTE: Trace Capture API
+#if BEAMFORMER_TRACING
+DEBUG_IMPORT void trace_thread_name(str8 name);
+DEBUG_IMPORT void trace_zone_begin(str8 name);
+DEBUG_IMPORT void trace_zone_end(void);
+DEBUG_IMPORT u32  trace_track(str8 name);
+DEBUG_IMPORT void trace_track_zone(u32 track, str8 name, u64 begin, u64 end);
+
+/* NOTE(rnp): the zone is not closed if the body is left with return/break/goto */
+#define TraceZone(name) DeferLoop(trace_zone_begin(str8(name)), trace_zone_end())
+#else
+#define trace_thread_name(...)
+#define trace_zone_begin(...)
+#define trace_zone_end(...)
+#define trace_track(...) (0)
+#define trace_track_zone(...)
+#define TraceZone(...)
+#endif
 
 ///////////////////////////////
 // NOTE: CUDA Library Bindings
@@ -265,12 +354,44 @@ CUDALibraryProcedureList
 
 #include "beamformer_compute_stats.c"
 #include "beamformer_shared_memory.c"
+#include "beamformer_cpu.c"
+
+read_only global str8 beamformer_memory_budget_names[] = {
+	#define X(_k, name) str8_comp(name),
+	BEAMFORMER_MEMORY_BUDGET_LIST
+	#undef X
+};
+
+read_only global str8 beamformer_latency_histogram_names[] = {
+	#define X(_k, name) str8_comp(name),
+	BEAMFORMER_LATENCY_HISTOGRAM_LIST
+	#undef X
+};
+
+read_only global str8 beamformer_frame_interval_names[] = {
+	#define X(_k, _name, interval) str8_comp(interval),
+	BEAMFORMER_FRAME_TIMESTAMP_LIST
+	#undef X
+};
+
+read_only global str8 beamformer_plan_admission_names[] = {
+	#define X(_k, name) str8_comp(name),
+	BEAMFORMER_PLAN_ADMISSION_LIST
+	#undef X
+};
 
 typedef struct {
 	BeamformerFilterParameters parameters;
 	f32                        time_delay;
 	i32                        length;
 	void                      *data;
+
+	/* NOTE(rnp): IFIR image rejection filter; data is the sparse model filter */
+	i32                        interpolation_factor;
+	i32                        image_length;
+	void                      *image_data;
+
+	b32                        symmetric;
 } BeamformerFilter;
 
 typedef struct {
@@ -282,6 +403,13 @@ typedef struct {
 	BeamformerShaderBakeParameters bake;
 } BeamformerShaderDescriptor;
 
+/* NOTE(rnp): expected cost of a single dispatch of a stage (see compute_plan_stage_cost()) */
+typedef struct {
+	u64 bytes_read;
+	u64 bytes_written;
+	u64 flops;
+} BeamformerStageCost;
+
 typedef struct BeamformerComputePlan BeamformerComputePlan;
 struct BeamformerComputePlan {
 	BeamformerComputePipeline pipeline;
@@ -290,10 +418,17 @@ struct BeamformerComputePlan {
 
 	u32 first_image_shader_index;
 	u32 channel_count;
+	/* NOTE(rnp): BeamformerChunkChannelCount unless downgraded to fit the memory budgets */
+	u32 chunk_channel_count;
 	u32 raw_channel_byte_stride;
 
 	u32 dirty_programs;
 
+	/* NOTE(rnp): result of checking the plan against the memory budgets. budget_mask holds
+	 * the budgets responsible for a downgrade or rejection */
+	BeamformerPlanAdmission admission;
+	u32                     admission_budget_mask;
+
 	BeamformerAcquisitionKind acquisition_kind;
 	u32                       acquisition_count;
 	BeamformerContrastMode    contrast_mode;
@@ -301,6 +436,14 @@ struct BeamformerComputePlan {
 	u32 rf_size;
 	b32 iq_pipeline;
 
+	// NOTE(rnp): planner estimate of bytes moved per channel chunk by the pre image stages
+	// with the negotiated layouts and with every stage in its default layout
+	u64 chunk_bytes_moved;
+	u64 chunk_bytes_moved_default;
+	u32 reshape_count;
+
+	BeamformerStageCost stage_costs[BeamformerMaxComputeShaderStages];
+
 	m4  ui_voxel_transform;
 	// NOTE(rnp): final voxel transform determining frame dimensions
 	m4  voxel_transform;
@@ -316,35 +459,97 @@ struct BeamformerComputePlan {
 
 	u32  readi_group;
 
+	/* NOTE(rnp): DAS runtime parameters; always pushed but only read by the interactive
+	 * variant (see BeamformerInteractiveTuning) */
+	f32 speed_of_sound;
+	f32 time_offset;
+	f32 f_number;
+	u32 interpolation_mode;
+	/* NOTE(rnp): delay added to the user time offset by the stages ahead of DAS */
+	f32 stage_time_delay;
+
+	/* NOTE(rnp): the DAS stage reads the runtime parameters instead of baking them. the
+	 * interactive pipeline is kept while the specialized one runs so that going back to
+	 * interactive doesn't compile. last_edit is the timer count of the last runtime only
+	 * parameter change */
+	b32          interactive;
+	u64          interactive_last_edit;
+	VulkanHandle interactive_pipeline;
+	u128         interactive_hash;
+
 	GPUBuffer array_parameters;
 	GPUBuffer gpu_temp_arena;
 
 	BeamformerFilterParameters filter_parameters[BeamformerFilterSlots];
 
+	/* NOTE(rnp): hash of the planning inputs; see beamformer_compute_plan_key(). the DAS
+	 * runtime parameters are hashed separately into runtime_key. a zero shader hash marks
+	 * a slot whose pipeline was given to another plan */
+	u128 plan_key;
+	u128 runtime_key;
 	u128 shader_hashes[BeamformerMaxComputeShaderStages];
 	BeamformerShaderDescriptor shader_descriptors[BeamformerMaxComputeShaderStages];
 
 	BeamformerComputePlan *next;
 };
 
+/* NOTE(rnp): fully built plans (pipelines, descriptors and the GPU temp arena holding
+ * filters and hadamard matrices) which were recently replaced, keyed by plan_key. returning
+ * a parameter block to one of these configurations swaps the cached plan back in instead of
+ * planning and compiling again. least recently used plans are evicted when the cache is full
+ * or when their temp arenas don't fit in the PlanCache budget */
+#define BeamformerPlanCacheCapacity (8)
+typedef struct {
+	BeamformerComputePlan plans[BeamformerPlanCacheCapacity];
+	u64                   last_used[BeamformerPlanCacheCapacity];
+	u32                   count;
+	u64                   use_counter;
+	/* NOTE(rnp): set when shaders are reloaded; cached pipelines are stale */
+	b32                   invalid;
+} BeamformerPlanCache;
+
 typedef struct {
 	u64 upload_complete_values[BeamformerMaxRawDataFramesInFlight];
 	u64 compute_complete_values[BeamformerMaxRawDataFramesInFlight];
+	/* NOTE(rnp): push and upload timestamps of the data in each slot */
+	u64 slot_timestamps[BeamformerMaxRawDataFramesInFlight][BeamformerFrameTimestamp_Count];
 
 	GPUBuffer buffer;
 
 	u32 active_rf_size;
+	/* NOTE(rnp): frames in flight that fit in the RFHistory budget; at most
+	 * BeamformerMaxRawDataFramesInFlight */
+	u32 slot_count;
 
 	u64 timestamp;
 
 	u64 insertion_index;
+	/* NOTE(rnp): frames before compute_index have all been consumed. the scheduler may
+	 * consume frames after it out of order; those are marked in consumed_mask (indexed by
+	 * frame % 64) until compute_index catches up. see beamformer_rf_consume() */
 	u64 compute_index;
+	u64 consumed_mask;
+	u64 last_consumed_index;
 } BeamformerRFBuffer;
 
+typedef struct {
+	u64 window[BeamformerLatencyBuckets];
+	u64 total[BeamformerLatencyBuckets];
+	u64 count;
+	u64 max_ns;
+	/* NOTE(rnp): bucket of each of the last BeamformerLatencyWindowMaxSamples samples; used
+	 * to retire samples from the window and to rebuild it when the window size changes */
+	u16 history[BeamformerLatencyWindowMaxSamples];
+	static_assert(BeamformerLatencyBuckets <= U16_MAX, "");
+} LatencyHistogram;
+
 typedef struct {
 	BeamformerComputeStatsTable table;
 	f32 average_times[BeamformerShaderKind_Count];
 
+	u32              latency_window;
+	LatencyHistogram latency[BeamformerLatencyHistogram_Count];
+
 	u64 last_rf_timer_count;
 	f32 rf_time_delta_average;
 
@@ -358,6 +563,8 @@ typedef enum {
 	ComputeTimingInfoKind_ComputeFrameEnd,
 	ComputeTimingInfoKind_Shader,
 	ComputeTimingInfoKind_RF_Data,
+	ComputeTimingInfoKind_Upload,
+	ComputeTimingInfoKind_EndToEnd,
 } ComputeTimingInfoKind;
 
 typedef struct {
@@ -368,6 +575,9 @@ typedef struct {
 			static_assert(BeamformerShaderKind_Count <= U16_MAX, "");
 			u16 shader;
 			u16 shader_slot;
+			/* NOTE(rnp): planner estimates for the whole frame */
+			u64 bytes;
+			u64 flops;
 		};
 	};
 } ComputeTimingInfo;
@@ -376,21 +586,111 @@ typedef struct {
 	u32 write_index;
 	u32 read_index;
 	b32 compute_frame_active;
+	u64 compute_frame_begin;
 
 	u32                  in_flight_shader_count;
 	BeamformerShaderKind in_flight_shader_ids[BeamformerMaxComputeShaderStages];
+	u64                  in_flight_bytes[BeamformerMaxComputeShaderStages];
+	u64                  in_flight_flops[BeamformerMaxComputeShaderStages];
 
 	ComputeTimingInfo buffer[4096];
 } ComputeTimingTable;
 
+#define BeamformerUploadMaxCopyLanes (8)
+
+typedef struct {
+	GPUBuffer *buffer;
+	u8        *data;
+	u64        offset;
+	u64        size;
+	u32        lane_count;
+} BeamformerUploadCopyJob;
+
+typedef struct BeamformerUploadCopyLanes BeamformerUploadCopyLanes;
 typedef struct {
-	BeamformerRFBuffer      *rf_buffer;
-	BeamformerSharedMemory  *shared_memory;
-	i64                      shared_memory_size;
-	ComputeTimingTable      *compute_timing_table;
-	i32                     *compute_worker_sync;
+	ThreadContext              thread;
+	BeamformerUploadCopyLanes *lanes;
+} BeamformerUploadCopyLane;
+
+/* NOTE(rnp): lane 0 is the upload thread itself; the rest park on the barrier between jobs */
+struct BeamformerUploadCopyLanes {
+	BeamformerUploadCopyJob  job;
+	BeamformerUploadCopyLane lanes[BeamformerUploadMaxCopyLanes];
+	u32                      lane_count;
+};
+
+/* NOTE(rnp): picks the number of copy lanes for an RF size by doubling the lane count
+ * until the measured bandwidth stops improving */
+typedef struct {
+	u64 rf_size;
+	u64 trial_ticks;
+	u32 trial_frames;
+	u32 lane_count;
+	u32 best_lane_count;
+	f32 best_bandwidth;
+	b32 settled;
+} BeamformerUploadTuner;
+
+typedef struct {
+	BeamformerRFBuffer          *rf_buffer;
+	BeamformerSharedMemory      *shared_memory;
+	i64                          shared_memory_size;
+	ComputeTimingTable          *compute_timing_table;
+	i32                         *compute_worker_sync;
+	BeamformerUploadCopyLanes   *copy_lanes;
+	BeamformerUploadTuner        tuner;
+	BeamformerMemoryBudgetTable *memory_budget;
 } BeamformerUploadThreadContext;
 
+/* NOTE(rnp): non-temporal upload of data into buffer split across lane_count copy lanes;
+ * returns once every lane has finished */
+DEBUG_IMPORT void beamformer_upload_copy(BeamformerUploadCopyLanes *, GPUBuffer *buffer, void *data,
+                                         u64 offset, u64 size, u32 lane_count);
+
+#define BeamformerThreadPlacementMaxThreads (64)
+
+#define BEAMFORMER_THREAD_PLACEMENT_POLICY_LIST \
+	X(None,     "none")      \
+	X(GPULocal, "gpu-local") \
+
+typedef enum {
+	#define X(name, ...) BeamformerThreadPlacementPolicy_##name,
+	BEAMFORMER_THREAD_PLACEMENT_POLICY_LIST
+	#undef X
+	BeamformerThreadPlacementPolicy_Count,
+} BeamformerThreadPlacementPolicy;
+
+read_only global str8 beamformer_thread_placement_policy_names[] = {
+	#define X(_, name) str8_comp(name),
+	BEAMFORMER_THREAD_PLACEMENT_POLICY_LIST
+	#undef X
+};
+
+typedef struct {
+	str8 name;
+	/* NOTE(rnp): dedicated logical processor; -1 when sharing the rest of the local set */
+	i32  cpu;
+	u32  cpu_count;
+	b16  pinned;
+	b16  realtime;
+} BeamformerThreadPlacement;
+
+/* NOTE(rnp): placement actually applied by the platform; filled in after init */
+typedef struct {
+	BeamformerThreadPlacementPolicy policy;
+	b32 realtime_requested;
+	i32 realtime_priority;
+
+	i32 numa_node;
+	u32 local_cpu_count;
+	b32 shared_memory_bound;
+
+	u32 thread_count;
+	BeamformerThreadPlacement threads[BeamformerThreadPlacementMaxThreads];
+} BeamformerThreadPlacementLayout;
+
+DEBUG_IMPORT BeamformerThreadPlacementLayout *beamformer_thread_placement(void);
+
 typedef struct {
 	u64 gpu_pointer;
 	u64 timeline_valid_value;
@@ -408,6 +708,8 @@ typedef struct {
 	BeamformerAcquisitionKind acquisition_kind;
 	BeamformerContrastMode    contrast_mode;
 	BeamformerViewPlaneTag    view_plane_tag;
+
+	u64 timestamps[BeamformerFrameTimestamp_Count];
 } BeamformerFrame;
 
 /* NOTE(rnp): backing storage for beamformed frames. The amount of backlog frames
@@ -421,11 +723,61 @@ typedef struct {
 	BeamformerFrame frames[BeamformerMaxBacklogFrames];
 } BeamformerFrameBacklog;
 
+typedef struct {
+	BeamformWork work;
+	u64          enqueue_time;
+	/* NOTE(rnp): raw data frame consumed by ComputeIndirect work */
+	u64          rf_index;
+} BeamformerScheduledWork;
+
+#define BeamformerSchedulerBlockCapacity (64)
+typedef struct {
+	BeamformerScheduledWork items[BeamformerSchedulerBlockCapacity];
+	u32 read_index;
+	u32 write_index;
+
+	/* NOTE(rnp): [timer ticks]; compute received scaled by the inverse of the block's weight */
+	u64 virtual_time;
+	/* NOTE(rnp): [timer ticks]; EMA of the time a frame takes from start to ready */
+	u64 average_cost;
+} BeamformerSchedulerBlock;
+
+/* NOTE(rnp): compute work is moved out of the work queues into per block queues so that
+ * the next frame can be chosen from all waiting blocks. see BeamformerScheduling */
+typedef struct {
+	BeamformerSchedulerBlock blocks[BeamformerMaxParameterBlocks];
+	u32 pending;
+	u32 last_block;
+	/* NOTE(rnp): virtual_time of the most recently started block */
+	u64 virtual_time;
+	/* NOTE(rnp): ComputeIndirect work is assigned raw data frames in the order it was queued */
+	u64 next_rf_index;
+} BeamformerScheduler;
+
+/* NOTE(rnp): background compile of the specialized DAS pipeline of an interactive plan.
+ * the result is only used if hash still matches the plan when the job is done */
+typedef struct {
+	Job                        job;
+	BeamformerShaderDescriptor descriptor;
+	VulkanHandle               pipeline;
+	u128                       hash;
+	b32                        running;
+} BeamformerSpecializeJob;
+
 typedef struct {
 	BeamformerRFBuffer rf_buffer;
+	BeamformerScheduler scheduler;
 
 	BeamformerComputePlan *compute_plans[BeamformerMaxParameterBlocks];
 	BeamformerComputePlan *compute_plan_freelist;
+	BeamformerPlanCache    plan_cache;
+
+	BeamformerSpecializeJob specialize_jobs[BeamformerMaxParameterBlocks];
+	u32 foreground_compiles[BeamformerMaxParameterBlocks];
+	u32 background_compiles[BeamformerMaxParameterBlocks];
+
+	/* NOTE(rnp): one per pipeline stage; see beamformer_filter_design_job() */
+	Arena *filter_design_arenas[BeamformerMaxComputeShaderStages];
 
 	/* NOTE(rnp): used to ping pong data between compute stages.
 	 *
@@ -438,6 +790,18 @@ typedef struct {
 	GPUBuffer ping_pong_buffer;
 	OSHandle  ping_pong_export_handle;
 	u32       ping_pong_input_index;
+	/* NOTE(rnp): the DAS slot is dropped when the PingPong budget can't fit it */
+	u32       ping_pong_slot_count;
+	u64       ping_pong_slot_size;
+
+	BeamformerMemoryBudgetTable memory_budget;
+
+	/* NOTE(rnp): beamforms frames whose plan can't run on the GPU; see
+	 * beamformer_compute_frame_fallback() */
+	BeamformerCPUContext *cpu_beamformer;
+
+	/* NOTE(rnp): [B/s]; see beamformer_measure_copy_bandwidth() */
+	f32 peak_bandwidth;
 
 	f32 processing_progress;
 	b32 processing_compute;
@@ -628,6 +992,7 @@ typedef struct {
 
 	GLWorkerThreadContext  upload_worker;
 	GLWorkerThreadContext  compute_worker;
+	JobSystem             *job_system;
 
 	BeamformerComputeContext compute_context;
 
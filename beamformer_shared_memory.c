@@ -1,5 +1,5 @@
 /* See LICENSE for license details. */
-#define BEAMFORMER_SHARED_MEMORY_VERSION (33UL)
+#define BEAMFORMER_SHARED_MEMORY_VERSION (45UL)
 
 typedef enum {
 	BeamformerWorkKind_Compute,
@@ -90,6 +90,10 @@ typedef enum {
 
 typedef union {
 	u8 filter_slot;
+	/* NOTE: Hilbert: 0 selects the FFT implementation when the data fits */
+	u8 hilbert_fir_length;
+	/* NOTE: Decode: nonzero keeps the stage from being fused with an adjacent Demodulate or Filter */
+	u8 decode_unfused;
 } BeamformerShaderParameters;
 
 typedef struct {
@@ -130,6 +134,119 @@ read_only global u16 BeamformerParameterBlockRegionOffsets[BeamformerParameterBl
 };
 #undef X
 
+/* NOTE(rnp): telemetry is published without locks or work items so that any number of
+ * monitoring processes can sample it without perturbing the beamformer. each section has a
+ * single writer and a seqlock: the sequence is odd while the writer is updating it and a
+ * reader retries until it sees the same even sequence before and after its copy. see
+ * beamformer_telemetry_write_begin/end and beamformer_telemetry_read */
+typedef struct {
+	u64 frames_completed;
+	/* NOTE(rnp): compute work discarded by the block's backpressure policy */
+	u64 frames_dropped;
+	/* NOTE(rnp): [s]; push (or upload) to frame ready. the average is an EMA over ~16 frames */
+	f32 last_latency;
+	f32 average_latency;
+	/* NOTE(rnp): [s]; time the last frame waited in the scheduler before being started */
+	f32 last_queue_wait;
+	/* NOTE(rnp): work held by the scheduler for this block when the last frame completed */
+	u32 queued;
+	/* NOTE(rnp): 1 while the block's plan runs the interactive DAS variant */
+	u32 interactive;
+	/* NOTE(rnp): compute pipelines compiled for the block; in the foreground (the frame
+	 * waits for them) and in the background (see BeamformerInteractiveTuning) */
+	u32 foreground_compiles;
+	u32 background_compiles;
+} BeamformerBlockTelemetry;
+
+typedef struct {
+	u32 sequence;
+	u32 shader_count;
+
+	u64 frames_completed;
+	/* NOTE(rnp): compute work skipped because the plan was rejected (see admission) and
+	 * could not be run by the CPU beamformer either */
+	u64 frames_rejected;
+	/* NOTE(rnp): frames beamformed on the CPU because the plan couldn't run on the GPU;
+	 * these are also counted in frames_completed */
+	u64 frames_cpu;
+
+	u32 last_frame_id;
+	u32 last_parameter_block;
+
+	/* NOTE(rnp): external work items waiting for the compute thread and uploaded raw data
+	 * frames not yet consumed by it */
+	u32 work_queue_depth;
+	u32 rf_frames_pending;
+
+	u32 shader_ids[BeamformerMaxComputeShaderStages];
+	/* NOTE(rnp): [s]; GPU time of each stage of the last frame */
+	f32 stage_times[BeamformerMaxComputeShaderStages];
+	/* NOTE(rnp): compute shader invocations of each stage; 0 when the driver does not
+	 * support pipeline statistics queries */
+	u64 stage_invocations[BeamformerMaxComputeShaderStages];
+
+	BeamformerFrameTiming       last_frame;
+	BeamformerMemoryBudgetTable memory;
+
+	BeamformerBlockTelemetry blocks[BeamformerMaxParameterBlocks];
+} BeamformerComputeTelemetry;
+
+typedef struct {
+	u32 sequence;
+	u32 copy_lanes;
+
+	u64 uploads_completed;
+	u64 bytes_uploaded;
+	/* NOTE(rnp): uploads which had to wait for the compute thread to free an RF slot */
+	u64 slot_stalls;
+
+	/* NOTE(rnp): [s]; from pick up to the data being available to compute */
+	f32 last_upload_time;
+	u32 last_upload_size;
+} BeamformerUploadTelemetry;
+
+typedef struct {
+	u64 timer_frequency;
+	alignas(64) BeamformerComputeTelemetry compute;
+	alignas(64) BeamformerUploadTelemetry  upload;
+} BeamformerTelemetry;
+
+/* NOTE(rnp): what happens when a parameter block's frames arrive faster than they can be
+ * beamformed:
+ *   Block:      producers wait for the compute thread; nothing is dropped
+ *   DropOldest: when a frame is about to be beamformed it is dropped if queue_depth_target
+ *               or more newer frames are queued. uploads may run ahead into free RF slots
+ *   LatestWins: DropOldest with a target of 1; only the newest pending frame is beamformed
+ * a queue_depth_target of 0 is treated as 1 */
+typedef struct {
+	BeamformerBackpressurePolicy policy;
+	u32                          queue_depth_target;
+} BeamformerBackpressure;
+
+/* NOTE(rnp): how the compute thread shares itself between parameter blocks with work waiting:
+ *   1. blocks whose oldest work has waited longer than its deadline, most overdue first
+ *   2. the highest priority
+ *   3. the block which has received the least compute time scaled by its weight
+ * consecutive frames of one block are kept together while that stays within a frame of
+ * fairness. a weight of 0 is treated as 1 and a deadline of 0 disables it */
+typedef struct {
+	u32 priority;
+	u32 weight;
+	f32 deadline; /* [s] */
+} BeamformerScheduling;
+
+/* NOTE(rnp): parameter changes which only touch the DAS runtime parameters (speed of sound,
+ * time offset, f-number and interpolation mode) switch the block's plan to an interactive
+ * DAS variant which reads them from push constants; further changes apply to the next frame
+ * without compiling. once no change has arrived for settle_time the fully specialized
+ * variant is compiled in the background and swapped in when it is ready. a settle_time of
+ * 0 selects BeamformerInteractiveSettleTimeDefault */
+#define BeamformerInteractiveSettleTimeDefault (0.5f)
+typedef struct {
+	b32 disabled;
+	f32 settle_time; /* [s] */
+} BeamformerInteractiveTuning;
+
 typedef struct {
 	u32 version;
 
@@ -148,6 +265,10 @@ typedef struct {
 
 	/* TODO(rnp): this is really sucky. we need a better way to communicate this */
 	u64 rf_block_rf_size;
+	/* NOTE(rnp): os_timer_count() around the client's copy of the data; written before
+	 * rf_block_rf_size */
+	u64 rf_push_begin;
+	u64 rf_push_end;
 
 	// NOTE(rnp): currently this cannot be directly user readable. its interpretation
 	// requires beamformer implementation details
@@ -159,12 +280,56 @@ typedef struct {
 		b8  hilbert;
 	} capabilities;
 
+	/* NOTE(rnp): samples covered by the windowed latency percentiles in the compute stats.
+	 * 0 selects BeamformerLatencyWindowDefaultSamples */
+	u32 latency_window;
+
 	BeamformerLiveImagingParameters live_imaging_parameters;
 	BeamformerLiveImagingDirtyFlags live_imaging_dirty_flags;
 
+	BeamformerBackpressure backpressure[BeamformerMaxParameterBlocks];
+	BeamformerScheduling   scheduling[BeamformerMaxParameterBlocks];
+
+	BeamformerInteractiveTuning interactive_tuning[BeamformerMaxParameterBlocks];
+
 	BeamformWorkQueue external_work_queue;
+
+	BeamformerTelemetry telemetry;
 } BeamformerSharedMemory;
 
+function void
+beamformer_telemetry_write_begin(u32 *sequence)
+{
+	atomic_store_u32(sequence, *sequence + 1);
+	store_fence();
+}
+
+function void
+beamformer_telemetry_write_end(u32 *sequence)
+{
+	store_fence();
+	atomic_store_u32(sequence, *sequence + 1);
+}
+
+/* NOTE(rnp): returns 0 if the writer kept the section busy for every attempt */
+function b32
+beamformer_telemetry_read(void *restrict out, void *restrict section, u64 size, u32 *sequence)
+{
+	b32 result = 0;
+	for (u32 attempt = 0; !result && attempt < 1024; attempt++) {
+		u32 before = atomic_load_u32(sequence);
+		if (before & 1) {
+			cpu_yield();
+			continue;
+		}
+		load_fence();
+		memory_copy(out, section, size);
+		load_fence();
+		result = atomic_load_u32(sequence) == before;
+	}
+	return result;
+}
+
 function BeamformWork *
 beamform_work_queue_pop(BeamformWorkQueue *q)
 {
@@ -211,6 +376,48 @@ beamform_work_queue_push(BeamformWorkQueue *q)
 	return result;
 }
 
+function u32
+beamform_work_queue_depth(BeamformWorkQueue *q)
+{
+	u64 val    = atomic_load_u64(&q->queue);
+	u64 mask   = countof(q->work_items) - 1;
+	u32 result = (u32)(((val & mask) - (val >> 32 & mask)) & mask);
+	return result;
+}
+
+/* NOTE(rnp): compute work for parameter block waiting in the queue */
+function u32
+beamform_work_queue_pending_compute(BeamformWorkQueue *q, u32 parameter_block)
+{
+	u32 result = 0;
+	u64 val    = atomic_load_u64(&q->queue);
+	u64 mask   = countof(q->work_items) - 1;
+	u64 widx   = val & mask;
+	for (u64 index = val >> 32 & mask; index != widx; index = (index + 1) & mask) {
+		BeamformWork *w = q->work_items + index;
+		if ((w->kind == BeamformerWorkKind_Compute || w->kind == BeamformerWorkKind_ComputeIndirect) &&
+		    w->compute_context.parameter_block == parameter_block)
+		{
+			result++;
+		}
+	}
+	return result;
+}
+
+/* NOTE(rnp): returns 1 if the policy says work should be skipped in favour of the
+ * newer frames pending behind it */
+function b32
+beamformer_backpressure_drop(BeamformerBackpressure *bp, u32 pending)
+{
+	b32 result = 0;
+	if (bp->policy != BeamformerBackpressurePolicy_Block) {
+		u32 target = Max(bp->queue_depth_target, 1u);
+		if (bp->policy == BeamformerBackpressurePolicy_LatestWins) target = 1;
+		result = pending >= target;
+	}
+	return result;
+}
+
 function void
 beamform_work_queue_push_commit(BeamformWorkQueue *q)
 {
@@ -0,0 +1,122 @@
+/* See LICENSE for license details. */
+/* NOTE(rnp): binary buddy suballocator over a power of two range of bytes
+ *
+ * the range is handed out in power of two chunks of at least BuddyMinimumSize bytes. every
+ * chunk is aligned to its own size so any alignment up to the chunk size is free. the only
+ * state is a complete binary tree with one byte per node holding 1 + the order of the
+ * largest free chunk below that node (0 when nothing below it is free). allocation walks
+ * down the tree preferring the tighter fitting child and free walks back up from the leaf,
+ * merging buddies as it goes, so both are O(log(size / BuddyMinimumSize)).
+ *
+ * the allocator does no locking and does not touch the memory it manages; the tree storage
+ * (buddy_tree_size() bytes) is provided by the caller.
+ */
+
+#define BuddyMinimumSizeLog2 (12ull)
+#define BuddyMinimumSize     (1ull << BuddyMinimumSizeLog2)
+#define BuddyInvalidOffset   (-1ull)
+
+typedef struct {
+	u8  *longest;
+	u64  size;
+	u64  used;
+	u32  max_order;
+} BuddyAllocator;
+
+function u64
+buddy_tree_size(u64 size)
+{
+	u64 result = 2 * (size / BuddyMinimumSize) - 1;
+	return result;
+}
+
+function u32
+buddy_order_for_size(u64 size, u64 alignment)
+{
+	u64 chunk  = round_up_power_of_two(Max(Max(size, alignment), BuddyMinimumSize));
+	u32 result = (u32)(ctz_u64(chunk) - BuddyMinimumSizeLog2);
+	return result;
+}
+
+function void
+buddy_init(BuddyAllocator *b, u8 *tree, u64 size)
+{
+	assert(IsPowerOfTwo(size) && size >= BuddyMinimumSize);
+	b->longest   = tree;
+	b->size      = size;
+	b->used      = 0;
+	b->max_order = (u32)(ctz_u64(size) - BuddyMinimumSizeLog2);
+
+	u64 node = 0;
+	for (u32 level = 0; level <= b->max_order; level++)
+		for (u64 it = 0; it < (1ull << level); it++)
+			tree[node++] = (u8)(b->max_order - level + 1);
+}
+
+function u64
+buddy_allocate(BuddyAllocator *b, u64 size, u64 alignment)
+{
+	u64 result = BuddyInvalidOffset;
+	u32 order  = buddy_order_for_size(size, alignment);
+	if (order <= b->max_order && b->longest[0] >= order + 1) {
+		u64 node       = 0;
+		u32 node_order = b->max_order;
+		while (node_order != order) {
+			u8 left  = b->longest[2 * node + 1];
+			u8 right = b->longest[2 * node + 2];
+			/* NOTE(rnp): best fit; leave the larger free chunk intact for larger requests */
+			b32 go_left = left >= order + 1 && (right < order + 1 || left <= right);
+			node = 2 * node + (go_left ? 1 : 2);
+			node_order--;
+		}
+
+		b->longest[node] = 0;
+		result  = (node + 1 - (1ull << (b->max_order - order))) << (order + BuddyMinimumSizeLog2);
+		b->used += 1ull << (order + BuddyMinimumSizeLog2);
+
+		while (node) {
+			node = (node - 1) / 2;
+			b->longest[node] = Max(b->longest[2 * node + 1], b->longest[2 * node + 2]);
+		}
+	}
+	return result;
+}
+
+/* NOTE(rnp): returns the size of the chunk that was released */
+function u64
+buddy_free(BuddyAllocator *b, u64 offset)
+{
+	assert(offset < b->size && (offset % BuddyMinimumSize) == 0);
+
+	/* NOTE(rnp): the allocated chunk is the first node on the path up from the leaf that
+	 * has nothing free below it; nodes under an allocated chunk are left untouched */
+	u32 order = 0;
+	u64 node  = (1ull << b->max_order) - 1 + (offset >> BuddyMinimumSizeLog2);
+	while (b->longest[node] != 0) {
+		assert(node != 0);
+		node = (node - 1) / 2;
+		order++;
+	}
+
+	u64 result = 1ull << (order + BuddyMinimumSizeLog2);
+	b->longest[node] = (u8)(order + 1);
+	b->used -= result;
+
+	while (node) {
+		node = (node - 1) / 2;
+		order++;
+		u8 left  = b->longest[2 * node + 1];
+		u8 right = b->longest[2 * node + 2];
+		if (left == order && right == order) b->longest[node] = (u8)(order + 1);
+		else                                 b->longest[node] = Max(left, right);
+	}
+
+	return result;
+}
+
+function b32
+buddy_empty(BuddyAllocator *b)
+{
+	b32 result = b->used == 0;
+	return result;
+}
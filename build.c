@@ -143,6 +143,7 @@ typedef struct {
 	b32   bake_shaders;
 	b32   debug;
 	b32   generic;
+	b32   no_tracing;
 	b32   sanitize;
 	b32   tests;
 	b32   time;
@@ -663,9 +664,10 @@ check_rebuild_self(Arena *arena, i32 argc, char *argv[])
 function void
 usage(char *argv0)
 {
-	printf("%s [--bake-shaders] [--debug] [--sanitize] [--time]\n"
+	printf("%s [--bake-shaders] [--debug] [--no-tracing] [--sanitize] [--time]\n"
 	       "    --debug:       dynamically link and build with debug symbols\n"
 	       "    --generic:     compile for a generic target (x86-64-v3 or armv8 with NEON)\n"
+	       "    --no-tracing:  compile out the trace zones (see trace.c)\n"
 	       "    --sanitize:    build with ASAN and UBSAN\n"
 	       "    --tests:       also build programs in tests/\n"
 	       "    --time:        print build time\n"
@@ -686,6 +688,8 @@ parse_config(i32 argc, char *argv[])
 			config.debug = 1;
 		} else if (str8_equal(str, str8("--generic"))) {
 			config.generic = 1;
+		} else if (str8_equal(str, str8("--no-tracing"))) {
+			config.no_tracing = 1;
 		} else if (str8_equal(str, str8("--sanitize"))) {
 			config.sanitize = 1;
 		} else if (str8_equal(str, str8("--tests"))) {
@@ -889,6 +893,7 @@ cmd_beamformer_base(Arena *a, CommandList *c)
 	cmd_append(a, c, EXTRA_FLAGS);
 	cmd_append(a, c, config.bake_shaders? "-DBakeShaders=1" : "-DBakeShaders=0");
 	if (config.debug) cmd_append(a, c, "-DBEAMFORMER_DEBUG", "-DBEAMFORMER_RENDERDOC_HOOKS");
+	if (config.no_tracing) cmd_append(a, c, "-DBEAMFORMER_NO_TRACING");
 
 	/* NOTE(rnp): impossible to autodetect on GCC versions < 14 (ci has 13) */
 	cmd_append(a, c, use_sanitization() ? "-DASAN_ACTIVE=1" : "-DASAN_ACTIVE=0");
@@ -960,6 +965,22 @@ build_tests(Arena *arena)
 	#define TEST_PROGRAMS \
 		X("throughput", LINK_LIB("m"), LINK_LIB("zstd"), W32_DECL(LINK_LIB("Synchronization"))) \
 		X("decode", LINK_LIB("m"), W32_DECL(LINK_LIB("Synchronization"))) \
+		X("matched_filter", LINK_LIB("m"), W32_DECL(LINK_LIB("Synchronization"))) \
+		X("hilbert",        LINK_LIB("m"), W32_DECL(LINK_LIB("Synchronization"))) \
+		X("cpu_beamform",   LINK_LIB("m"), W32_DECL(LINK_LIB("Synchronization"))) \
+		X("regression",     LINK_LIB("m"), LINK_LIB("zstd"), W32_DECL(LINK_LIB("Synchronization"))) \
+		X("simulate",       LINK_LIB("m"), LINK_LIB("zstd"), W32_DECL(LINK_LIB("Synchronization"))) \
+		X("sweep",          LINK_LIB("m"), LINK_LIB("zstd"), W32_DECL(LINK_LIB("Synchronization"))) \
+		X("memory",         LINK_LIB("m"), W32_DECL(LINK_LIB("Synchronization"))) \
+		X("job_system",     LINK_LIB("m"), W32_DECL(LINK_LIB("Synchronization"))) \
+		X("jitter",         LINK_LIB("m"), W32_DECL(LINK_LIB("Synchronization"))) \
+		X("gpu_churn",      LINK_LIB("m"), W32_DECL(LINK_LIB("Synchronization"))) \
+		X("tracing",        LINK_LIB("m"), W32_DECL(LINK_LIB("Synchronization"))) \
+		X("monitor",        LINK_LIB("m"), W32_DECL(LINK_LIB("Synchronization"))) \
+		X("multi_client",   LINK_LIB("m"), W32_DECL(LINK_LIB("Synchronization"))) \
+		X("overload",       LINK_LIB("m"), W32_DECL(LINK_LIB("Synchronization"))) \
+		X("plan_cache",     LINK_LIB("m"), W32_DECL(LINK_LIB("Synchronization"))) \
+		X("interactive",    LINK_LIB("m"), W32_DECL(LINK_LIB("Synchronization"))) \
 
 	os_make_directory(OUTPUT("tests"));
 	if (!is_msvc) cmd_append(arena, &cc, "-Wno-unused-function");
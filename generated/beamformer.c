@@ -79,6 +79,13 @@ typedef enum {
 	BeamformerViewPlaneTag_Count,
 } BeamformerViewPlaneTag;
 
+typedef enum {
+	BeamformerBackpressurePolicy_Block      = 0,
+	BeamformerBackpressurePolicy_DropOldest = 1,
+	BeamformerBackpressurePolicy_LatestWins = 2,
+	BeamformerBackpressurePolicy_Count,
+} BeamformerBackpressurePolicy;
+
 typedef enum {
 	BeamformerAcquisitionKind_FORCES         = 0,
 	BeamformerAcquisitionKind_UFORCES        = 1,
@@ -136,19 +143,33 @@ typedef enum {
 } BeamformerDecodeCompileFlags;
 
 typedef enum {
-	BeamformerFilterCompileFlags_ComplexFilter = 1 << 0,
-	BeamformerFilterCompileFlags_Demodulate    = 1 << 1,
+	BeamformerFilterCompileFlags_ComplexFilter      = 1 << 0,
+	BeamformerFilterCompileFlags_Demodulate         = 1 << 1,
+	BeamformerFilterCompileFlags_FastConvolution    = 1 << 2,
+	BeamformerFilterCompileFlags_InterpolatedFilter = 1 << 3,
+	BeamformerFilterCompileFlags_SymmetricFilter    = 1 << 4,
 } BeamformerFilterCompileFlags;
 
 typedef enum {
 	BeamformerDASCompileFlags_CoherencyWeighting = 1 << 0,
+	BeamformerDASCompileFlags_Interactive        = 1 << 1,
 } BeamformerDASCompileFlags;
 
+typedef enum {
+	BeamformerHilbertCompileFlags_FIRApproximation = 1 << 0,
+} BeamformerHilbertCompileFlags;
+
 typedef enum {
 	BeamformerReshapeCompileFlags_Deinterleave = 1 << 0,
 	BeamformerReshapeCompileFlags_Interleave   = 1 << 1,
 } BeamformerReshapeCompileFlags;
 
+typedef enum {
+	BeamformerDecodeDemodulateCompileFlags_ComplexFilter   = 1 << 0,
+	BeamformerDecodeDemodulateCompileFlags_Demodulate      = 1 << 1,
+	BeamformerDecodeDemodulateCompileFlags_SymmetricFilter = 1 << 2,
+} BeamformerDecodeDemodulateCompileFlags;
+
 typedef enum {
 	BeamformerShaderKind_Decode             = 0,
 	BeamformerShaderKind_Filter             = 1,
@@ -159,15 +180,16 @@ typedef enum {
 	BeamformerShaderKind_Reshape            = 6,
 	BeamformerShaderKind_MinMax             = 7,
 	BeamformerShaderKind_Sum                = 8,
-	BeamformerShaderKind_RenderBeamformed   = 9,
+	BeamformerShaderKind_DecodeDemodulate   = 9,
+	BeamformerShaderKind_RenderBeamformed   = 10,
 	BeamformerShaderKind_Count,
 
 	BeamformerShaderKind_ComputeFirst        = BeamformerShaderKind_Decode,
 	BeamformerShaderKind_ComputeLast         = BeamformerShaderKind_Hilbert,
 	BeamformerShaderKind_ComputeCount        = 5,
 	BeamformerShaderKind_ComputeHelpersFirst = BeamformerShaderKind_CoherencyWeighting,
-	BeamformerShaderKind_ComputeHelpersLast  = BeamformerShaderKind_Sum,
-	BeamformerShaderKind_ComputeHelpersCount = 4,
+	BeamformerShaderKind_ComputeHelpersLast  = BeamformerShaderKind_DecodeDemodulate,
+	BeamformerShaderKind_ComputeHelpersCount = 5,
 	BeamformerShaderKind_RenderFirst         = BeamformerShaderKind_RenderBeamformed,
 	BeamformerShaderKind_RenderLast          = BeamformerShaderKind_RenderBeamformed,
 	BeamformerShaderKind_RenderCount         = 1,
@@ -176,6 +198,9 @@ typedef enum {
 typedef struct {
 	u64 Hadamard;
 	u32 DecodeMode;
+	u32 InputChannelStride;
+	u32 InputSampleStride;
+	u32 InputTransmitStride;
 	u32 OutputChannelStride;
 	u32 OutputSampleStride;
 	u32 OutputTransmitStride;
@@ -189,7 +214,11 @@ typedef struct {
 
 typedef struct {
 	u64 FilterCoefficients;
+	u64 ImageFilterCoefficients;
 	u32 FilterLength;
+	u32 FFTSize;
+	u32 ImageFilterLength;
+	u32 InterpolationFactor;
 	f32 SamplingFrequency;
 	f32 DemodulationFrequency;
 	u32 DecimationRate;
@@ -230,6 +259,19 @@ typedef struct {
 	u32 ReadiGroupCount;
 } BeamformerDASBakeParameters;
 
+typedef struct {
+	u64 FIRCoefficients;
+	u32 FIRLength;
+	u32 FFTSize;
+	u32 SampleCount;
+	u32 InputChannelStride;
+	u32 InputSampleStride;
+	u32 InputTransmitStride;
+	u32 OutputChannelStride;
+	u32 OutputSampleStride;
+	u32 OutputTransmitStride;
+} BeamformerHilbertBakeParameters;
+
 typedef struct {
 	u64 IncoherentSum;
 	f32 Scale;
@@ -248,6 +290,23 @@ typedef struct {
 	u32 OutputStrideZ;
 } BeamformerReshapeBakeParameters;
 
+typedef struct {
+	u64 Hadamard;
+	u64 FilterCoefficients;
+	u32 FilterLength;
+	u32 TransmitCount;
+	f32 SamplingFrequency;
+	f32 DemodulationFrequency;
+	u32 DecimationRate;
+	u32 SampleCount;
+	u32 InputChannelStride;
+	u32 InputSampleStride;
+	u32 InputTransmitStride;
+	u32 OutputChannelStride;
+	u32 OutputSampleStride;
+	u32 OutputTransmitStride;
+} BeamformerDecodeDemodulateBakeParameters;
+
 typedef struct {
 	u64 rf_buffer;
 	u64 output_buffer;
@@ -266,8 +325,17 @@ typedef struct {
 	u32 rf_element_offset;
 	i32 channel_offset;
 	u32 readi_group;
+	f32 speed_of_sound;
+	f32 time_offset;
+	f32 f_number;
+	u32 interpolation_mode;
 } BeamformerDASPushConstants;
 
+typedef struct {
+	u64 input_data;
+	u32 output_element_offset;
+} BeamformerHilbertPushConstants;
+
 typedef struct {
 	u64 coherent_sum;
 } BeamformerCoherencyWeightingPushConstants;
@@ -285,6 +353,11 @@ typedef struct {
 	f32 scale;
 } BeamformerSumPushConstants;
 
+typedef struct {
+	u64 input_data;
+	u32 output_element_offset;
+} BeamformerDecodeDemodulatePushConstants;
+
 typedef struct {
 	m4  mvp_matrix;
 	u64 positions;
@@ -324,6 +397,7 @@ typedef struct {
 	f32 cutoff_frequency;
 	f32 beta;
 	u32 length;
+	u32 interpolation_factor;
 } BeamformerKaiserFilterParameters;
 
 typedef struct {
@@ -470,8 +544,10 @@ typedef union {
 	BeamformerDecodeBakeParameters             Decode;
 	BeamformerFilterBakeParameters             Filter;
 	BeamformerDASBakeParameters                DAS;
+	BeamformerHilbertBakeParameters            Hilbert;
 	BeamformerCoherencyWeightingBakeParameters CoherencyWeighting;
 	BeamformerReshapeBakeParameters            Reshape;
+	BeamformerDecodeDemodulateBakeParameters   DecodeDemodulate;
 } BeamformerShaderBakeParameters;
 
 read_only global u32 beamformer_compute_array_parameter_sizes[] = {
@@ -608,8 +684,10 @@ typedef enum {
 	BeamformerStructKind_DecodeBakeParameters             = 0,
 	BeamformerStructKind_FilterBakeParameters             = 1,
 	BeamformerStructKind_DASBakeParameters                = 2,
-	BeamformerStructKind_CoherencyWeightingBakeParameters = 3,
-	BeamformerStructKind_ReshapeBakeParameters            = 4,
+	BeamformerStructKind_HilbertBakeParameters            = 3,
+	BeamformerStructKind_CoherencyWeightingBakeParameters = 4,
+	BeamformerStructKind_ReshapeBakeParameters            = 5,
+	BeamformerStructKind_DecodeDemodulateBakeParameters   = 6,
 	BeamformerStructKind_Count,
 } BeamformerStructKind;
 
@@ -626,21 +704,28 @@ read_only global MetaStructMember *meta_struct_members_by_id[] = {
 		{18, 36, 1, 0},
 		{18, 40, 1, 0},
 		{18, 44, 1, 0},
+		{18, 48, 1, 0},
+		{18, 52, 1, 0},
+		{18, 56, 1, 0},
 	},
 	(MetaStructMember []){
 		{17, 0,  1, 0},
-		{18, 8,  1, 0},
-		{8,  12, 1, 0},
-		{8,  16, 1, 0},
+		{17, 8,  1, 0},
+		{18, 16, 1, 0},
 		{18, 20, 1, 0},
 		{18, 24, 1, 0},
 		{18, 28, 1, 0},
-		{18, 32, 1, 0},
-		{18, 36, 1, 0},
+		{8,  32, 1, 0},
+		{8,  36, 1, 0},
 		{18, 40, 1, 0},
 		{18, 44, 1, 0},
 		{18, 48, 1, 0},
 		{18, 52, 1, 0},
+		{18, 56, 1, 0},
+		{18, 60, 1, 0},
+		{18, 64, 1, 0},
+		{18, 68, 1, 0},
+		{18, 72, 1, 0},
 	},
 	(MetaStructMember []){
 		{17, 0,   1, 0},
@@ -668,6 +753,18 @@ read_only global MetaStructMember *meta_struct_members_by_id[] = {
 		{18, 100, 1, 0},
 		{18, 104, 1, 0},
 	},
+	(MetaStructMember []){
+		{17, 0,  1, 0},
+		{18, 8,  1, 0},
+		{18, 12, 1, 0},
+		{18, 16, 1, 0},
+		{18, 20, 1, 0},
+		{18, 24, 1, 0},
+		{18, 28, 1, 0},
+		{18, 32, 1, 0},
+		{18, 36, 1, 0},
+		{18, 40, 1, 0},
+	},
 	(MetaStructMember []){
 		{17, 0,  1, 0},
 		{8,  8,  1, 0},
@@ -684,12 +781,31 @@ read_only global MetaStructMember *meta_struct_members_by_id[] = {
 		{18, 28, 1, 0},
 		{18, 32, 1, 0},
 	},
+	(MetaStructMember []){
+		{17, 0,  1, 0},
+		{17, 8,  1, 0},
+		{18, 16, 1, 0},
+		{18, 20, 1, 0},
+		{8,  24, 1, 0},
+		{8,  28, 1, 0},
+		{18, 32, 1, 0},
+		{18, 36, 1, 0},
+		{18, 40, 1, 0},
+		{18, 44, 1, 0},
+		{18, 48, 1, 0},
+		{18, 52, 1, 0},
+		{18, 56, 1, 0},
+		{18, 60, 1, 0},
+	},
 };
 
 read_only global str8 *meta_struct_member_names_by_id[] = {
 	(str8 []){
 		str8_comp("Hadamard"),
 		str8_comp("DecodeMode"),
+		str8_comp("InputChannelStride"),
+		str8_comp("InputSampleStride"),
+		str8_comp("InputTransmitStride"),
 		str8_comp("OutputChannelStride"),
 		str8_comp("OutputSampleStride"),
 		str8_comp("OutputTransmitStride"),
@@ -702,7 +818,11 @@ read_only global str8 *meta_struct_member_names_by_id[] = {
 	},
 	(str8 []){
 		str8_comp("FilterCoefficients"),
+		str8_comp("ImageFilterCoefficients"),
 		str8_comp("FilterLength"),
+		str8_comp("FFTSize"),
+		str8_comp("ImageFilterLength"),
+		str8_comp("InterpolationFactor"),
 		str8_comp("SamplingFrequency"),
 		str8_comp("DemodulationFrequency"),
 		str8_comp("DecimationRate"),
@@ -741,6 +861,18 @@ read_only global str8 *meta_struct_member_names_by_id[] = {
 		str8_comp("OutputSizeZ"),
 		str8_comp("ReadiGroupCount"),
 	},
+	(str8 []){
+		str8_comp("FIRCoefficients"),
+		str8_comp("FIRLength"),
+		str8_comp("FFTSize"),
+		str8_comp("SampleCount"),
+		str8_comp("InputChannelStride"),
+		str8_comp("InputSampleStride"),
+		str8_comp("InputTransmitStride"),
+		str8_comp("OutputChannelStride"),
+		str8_comp("OutputSampleStride"),
+		str8_comp("OutputTransmitStride"),
+	},
 	(str8 []){
 		str8_comp("IncoherentSum"),
 		str8_comp("Scale"),
@@ -757,14 +889,32 @@ read_only global str8 *meta_struct_member_names_by_id[] = {
 		str8_comp("OutputStrideY"),
 		str8_comp("OutputStrideZ"),
 	},
+	(str8 []){
+		str8_comp("Hadamard"),
+		str8_comp("FilterCoefficients"),
+		str8_comp("FilterLength"),
+		str8_comp("TransmitCount"),
+		str8_comp("SamplingFrequency"),
+		str8_comp("DemodulationFrequency"),
+		str8_comp("DecimationRate"),
+		str8_comp("SampleCount"),
+		str8_comp("InputChannelStride"),
+		str8_comp("InputSampleStride"),
+		str8_comp("InputTransmitStride"),
+		str8_comp("OutputChannelStride"),
+		str8_comp("OutputSampleStride"),
+		str8_comp("OutputTransmitStride"),
+	},
 };
 
 read_only global MetaStructInfo meta_struct_info_by_id[] = {
-	{str8_comp("DecodeBakeParameters"),             11, 48,  0},
-	{str8_comp("FilterBakeParameters"),             13, 56,  0},
+	{str8_comp("DecodeBakeParameters"),             14, 60,  0},
+	{str8_comp("FilterBakeParameters"),             17, 76,  0},
 	{str8_comp("DASBakeParameters"),                24, 108, 0},
+	{str8_comp("HilbertBakeParameters"),            10, 44,  0},
 	{str8_comp("CoherencyWeightingBakeParameters"), 3,  16,  0},
 	{str8_comp("ReshapeBakeParameters"),            9,  36,  0},
+	{str8_comp("DecodeDemodulateBakeParameters"),   14, 64,  0},
 };
 
 read_only global str8 beamformer_shader_names[] = {
@@ -777,6 +927,7 @@ read_only global str8 beamformer_shader_names[] = {
 	str8_comp("Reshape"),
 	str8_comp("MinMax"),
 	str8_comp("Sum"),
+	str8_comp("DecodeDemodulate"),
 	str8_comp("RenderBeamformed"),
 };
 
@@ -784,10 +935,12 @@ read_only global BeamformerShaderKind beamformer_reloadable_shader_kinds[] = {
 	BeamformerShaderKind_Decode,
 	BeamformerShaderKind_Filter,
 	BeamformerShaderKind_DAS,
+	BeamformerShaderKind_Hilbert,
 	BeamformerShaderKind_CoherencyWeighting,
 	BeamformerShaderKind_Reshape,
 	BeamformerShaderKind_MinMax,
 	BeamformerShaderKind_Sum,
+	BeamformerShaderKind_DecodeDemodulate,
 	BeamformerShaderKind_RenderBeamformed,
 };
 
@@ -795,10 +948,12 @@ read_only global str8 *beamformer_reloadable_shader_files[] = {
 	(str8 []){str8_comp("decode.glsl")},
 	(str8 []){str8_comp("filter.glsl")},
 	(str8 []){str8_comp("das.glsl")},
+	(str8 []){str8_comp("hilbert.glsl")},
 	(str8 []){str8_comp("coherency_weighting.glsl")},
 	(str8 []){str8_comp("reshape.glsl")},
 	(str8 []){str8_comp("min_max.glsl")},
 	(str8 []){str8_comp("sum.glsl")},
+	(str8 []){str8_comp("decode_demodulate.glsl")},
 	(str8 []){str8_comp("render_3d.vert.glsl"), str8_comp("render_3d.frag.glsl")},
 };
 
@@ -807,29 +962,32 @@ read_only global i32 beamformer_shader_reloadable_index_by_shader[] = {
 	1,
 	1,
 	2,
-	-1,
 	3,
 	4,
 	5,
 	6,
 	7,
+	8,
+	9,
 };
 
 read_only global i32 beamformer_reloadable_compute_shader_info_indices[] = {
 	0,
 	1,
 	2,
+	3,
 };
 
 read_only global i32 beamformer_reloadable_compute_helpers_shader_info_indices[] = {
-	3,
 	4,
 	5,
 	6,
+	7,
+	8,
 };
 
 read_only global i32 beamformer_reloadable_render_shader_info_indices[] = {
-	7,
+	9,
 };
 
 read_only global str8 beamformer_shader_global_header_strings[] = {
@@ -855,8 +1013,11 @@ read_only global str8 beamformer_shader_global_header_strings[] = {
 	"#define ShaderResourceKind_Buffer 0\n"
 	"\n"),
 	str8_comp(""
-	"#define ComplexFilter ((CompileFlags & (1 << 0)) != 0)\n"
-	"#define Demodulate    ((CompileFlags & (1 << 1)) != 0)\n"
+	"#define ComplexFilter      ((CompileFlags & (1 << 0)) != 0)\n"
+	"#define Demodulate         ((CompileFlags & (1 << 1)) != 0)\n"
+	"#define FastConvolution    ((CompileFlags & (1 << 2)) != 0)\n"
+	"#define InterpolatedFilter ((CompileFlags & (1 << 3)) != 0)\n"
+	"#define SymmetricFilter    ((CompileFlags & (1 << 4)) != 0)\n"
 	"\n"),
 	str8_comp(""
 	"layout(push_constant, std430) uniform PushConstants {\n"
@@ -904,16 +1065,30 @@ read_only global str8 beamformer_shader_global_header_strings[] = {
 	"\n"),
 	str8_comp(""
 	"#define CoherencyWeighting ((CompileFlags & (1 << 0)) != 0)\n"
+	"#define Interactive        ((CompileFlags & (1 << 1)) != 0)\n"
 	"\n"),
 	str8_comp(""
 	"layout(push_constant, std430) uniform PushConstants {\n"
-	"  f32mat4  xdc_transform;\n"
-	"  f32mat4  voxel_transform;\n"
-	"  f32vec2  xdc_element_pitch;\n"
-	"  uint64_t output_frame;\n"
-	"  uint32_t rf_element_offset;\n"
-	"  int32_t  channel_offset;\n"
-	"  uint32_t readi_group;\n"
+	"  f32mat4   xdc_transform;\n"
+	"  f32mat4   voxel_transform;\n"
+	"  f32vec2   xdc_element_pitch;\n"
+	"  uint64_t  output_frame;\n"
+	"  uint32_t  rf_element_offset;\n"
+	"  int32_t   channel_offset;\n"
+	"  uint32_t  readi_group;\n"
+	"  float32_t speed_of_sound;\n"
+	"  float32_t time_offset;\n"
+	"  float32_t f_number;\n"
+	"  uint32_t  interpolation_mode;\n"
+	"};\n"
+	"\n"),
+	str8_comp(""
+	"#define FIRApproximation ((CompileFlags & (1 << 0)) != 0)\n"
+	"\n"),
+	str8_comp(""
+	"layout(push_constant, std430) uniform PushConstants {\n"
+	"  uint64_t input_data;\n"
+	"  uint32_t output_element_offset;\n"
 	"};\n"
 	"\n"),
 	str8_comp(""
@@ -941,6 +1116,17 @@ read_only global str8 beamformer_shader_global_header_strings[] = {
 	"};\n"
 	"\n"),
 	str8_comp(""
+	"#define ComplexFilter   ((CompileFlags & (1 << 0)) != 0)\n"
+	"#define Demodulate      ((CompileFlags & (1 << 1)) != 0)\n"
+	"#define SymmetricFilter ((CompileFlags & (1 << 2)) != 0)\n"
+	"\n"),
+	str8_comp(""
+	"layout(push_constant, std430) uniform PushConstants {\n"
+	"  uint64_t input_data;\n"
+	"  uint32_t output_element_offset;\n"
+	"};\n"
+	"\n"),
+	str8_comp(""
 	"layout(push_constant, std430) uniform PushConstants {\n"
 	"  f32mat4   mvp_matrix;\n"
 	"  uint64_t  positions;\n"
@@ -967,6 +1153,8 @@ read_only global b8 beamformer_shader_has_primitive[] = {
 	0,
 	0,
 	0,
+	0,
+	0,
 	1,
 };
 
@@ -978,6 +1166,8 @@ read_only global b8 beamformer_shader_primitive_is_vertex[] = {
 	0,
 	0,
 	0,
+	0,
+	0,
 	1,
 };
 
@@ -985,21 +1175,25 @@ read_only global i32 *beamformer_shader_header_vectors[] = {
 	(i32 []){0, 1, 2},
 	(i32 []){3, 4, 5, 6},
 	(i32 []){7, 8, 9, 10, 3, 4, 11, 12, 13},
-	(i32 []){14},
-	(i32 []){15, 16},
+	(i32 []){3, 4, 14, 15},
+	(i32 []){16},
+	(i32 []){17, 18},
 	0,
-	(i32 []){17},
-	(i32 []){18},
+	(i32 []){19},
+	(i32 []){3, 4, 20, 21},
+	(i32 []){22},
 };
 
 read_only global i32 beamformer_shader_header_vector_lengths[] = {
 	3,
 	4,
 	9,
+	4,
 	1,
 	2,
 	0,
 	1,
+	4,
 	1,
 };
 
@@ -1011,9 +1205,16 @@ read_only global str8 *beamformer_shader_compile_flag_names[] = {
 	(str8 []){
 		str8_comp("ComplexFilter"),
 		str8_comp("Demodulate"),
+		str8_comp("FastConvolution"),
+		str8_comp("InterpolatedFilter"),
+		str8_comp("SymmetricFilter"),
 	},
 	(str8 []){
 		str8_comp("CoherencyWeighting"),
+		str8_comp("Interactive"),
+	},
+	(str8 []){
+		str8_comp("FIRApproximation"),
 	},
 	0,
 	(str8 []){
@@ -1022,17 +1223,24 @@ read_only global str8 *beamformer_shader_compile_flag_names[] = {
 	},
 	0,
 	0,
+	(str8 []){
+		str8_comp("ComplexFilter"),
+		str8_comp("Demodulate"),
+		str8_comp("SymmetricFilter"),
+	},
 	0,
 };
 
 read_only global u8 beamformer_shader_compile_flag_counts[] = {
 	2,
+	5,
 	2,
 	1,
 	0,
 	2,
 	0,
 	0,
+	3,
 	0,
 };
 
@@ -1042,8 +1250,10 @@ read_only global i32 beamformer_base_shader_to_bake_struct_id[] = {
 	2,
 	3,
 	4,
+	5,
 	-1,
 	-1,
+	6,
 	-1,
 };
 
@@ -1051,10 +1261,12 @@ read_only global u8 beamformer_shader_push_constant_sizes[] = {
 	sizeof(BeamformerDecodePushConstants),
 	sizeof(BeamformerFilterPushConstants),
 	sizeof(BeamformerDASPushConstants),
+	sizeof(BeamformerHilbertPushConstants),
 	sizeof(BeamformerCoherencyWeightingPushConstants),
 	sizeof(BeamformerReshapePushConstants),
 	0,
 	sizeof(BeamformerSumPushConstants),
+	sizeof(BeamformerDecodeDemodulatePushConstants),
 	sizeof(BeamformerRenderBeamformedPushConstants),
 };
 
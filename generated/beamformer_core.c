@@ -8,11 +8,12 @@ typedef enum {
 	BeamformerPanelKind_TabGroup            = 2,
 	BeamformerPanelKind_ComputeBarGraph     = 3,
 	BeamformerPanelKind_ComputeStats        = 4,
-	BeamformerPanelKind_FrameViewLive       = 5,
-	BeamformerPanelKind_FrameViewCopy       = 6,
-	BeamformerPanelKind_FrameViewXPlane     = 7,
-	BeamformerPanelKind_LiveImagingControls = 8,
-	BeamformerPanelKind_ParameterListing    = 9,
+	BeamformerPanelKind_FrameLatency        = 5,
+	BeamformerPanelKind_FrameViewLive       = 6,
+	BeamformerPanelKind_FrameViewCopy       = 7,
+	BeamformerPanelKind_FrameViewXPlane     = 8,
+	BeamformerPanelKind_LiveImagingControls = 9,
+	BeamformerPanelKind_ParameterListing    = 10,
 	BeamformerPanelKind_Count,
 } BeamformerPanelKind;
 
@@ -80,6 +81,7 @@ read_only global BeamformerPanelInfo beamformer_panel_infos[] = {
 	{str8_comp(""), str8_comp("group"), str8_comp(""), (0*BeamformerPanelFlags_List)|(0*BeamformerPanelFlags_NeedsFrame)|(0*BeamformerPanelFlags_HasSettings)},
 	{str8_comp("Compute Bar Graph"), str8_comp("compute_bar_graph"), str8_comp("Bar graph showing portions of compute occupied by each stage."), (1*BeamformerPanelFlags_List)|(0*BeamformerPanelFlags_NeedsFrame)|(0*BeamformerPanelFlags_HasSettings)},
 	{str8_comp("Compute Stats"), str8_comp("compute_stats"), str8_comp("Average stats about beamforming computations."), (1*BeamformerPanelFlags_List)|(0*BeamformerPanelFlags_NeedsFrame)|(0*BeamformerPanelFlags_HasSettings)},
+	{str8_comp("Frame Latency"), str8_comp("frame_latency"), str8_comp("Time frames spend in each step from client push to ready for export."), (1*BeamformerPanelFlags_List)|(0*BeamformerPanelFlags_NeedsFrame)|(0*BeamformerPanelFlags_HasSettings)},
 	{str8_comp("Frame View"), str8_comp("frame_view_live"), str8_comp("Latest frame with selected tag."), (1*BeamformerPanelFlags_List)|(0*BeamformerPanelFlags_NeedsFrame)|(1*BeamformerPanelFlags_HasSettings)},
 	{str8_comp("Frame View (Copy)"), str8_comp("frame_view_copy"), str8_comp("Copy of an old frame. Useful for comparisons."), (0*BeamformerPanelFlags_List)|(1*BeamformerPanelFlags_NeedsFrame)|(1*BeamformerPanelFlags_HasSettings)},
 	{str8_comp("3D X-Plane"), str8_comp("frame_view_xplane"), str8_comp("3D Cross Plane View."), (1*BeamformerPanelFlags_List)|(0*BeamformerPanelFlags_NeedsFrame)|(1*BeamformerPanelFlags_HasSettings)},
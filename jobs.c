@@ -0,0 +1,402 @@
+/* See LICENSE for license details. */
+/* NOTE(rnp): work stealing job system
+ *
+ * each worker owns a Chase-Lev deque; jobs submitted from a worker go to the bottom of its
+ * own deque while jobs submitted from any other thread go to a shared injection queue.
+ * workers pop from their own deque, then take from the injection queue, then steal from
+ * the top of the other workers' deques. idle workers park on a futex.
+ *
+ * jobs are owned by the caller and must stay alive until they finish. a job finishes when
+ * its function has returned and all of its children have finished. a job with dependencies
+ * is held back until every dependency has finished. the job graph (children and
+ * dependencies) must be wired up before the jobs involved are submitted. a job without a
+ * function is a pure join point.
+ *
+ * job_wait() helps with outstanding work instead of blocking so it may be called from any
+ * thread, including from inside a job.
+ */
+
+#define JobSystemMaxWorkers      (32)
+#define JobMaxContinuations      (8)
+#define JobDequeCapacity         (4096)
+#define JobInjectionCapacity     (4096)
+#define JobTimingHistoryCount    (1024)
+
+#define JOB_FUNCTION(name) void name(void *user_context, Arena *scratch)
+typedef JOB_FUNCTION(job_function);
+
+typedef struct Job Job;
+struct Job {
+	job_function *fn;
+	void         *user_context;
+	str8          label;
+
+	Job *parent;
+	Job *continuations[JobMaxContinuations];
+	u32  continuation_count;
+
+	/* NOTE(rnp): 1 + unfinished children; the job is finished when this reaches 0 */
+	i32 unfinished;
+	/* NOTE(rnp): 1 (held until submitted) + unfinished dependencies */
+	i32 dependencies;
+
+	u64 submit_time;
+};
+
+typedef struct {
+	str8 label;
+	u64  submit_time;
+	u64  start_time;
+	u64  end_time;
+	u32  worker;
+} JobTiming;
+
+typedef struct {
+	u64 executed;
+	u64 stolen;
+	u64 parked;
+	u64 busy_ticks;
+} JobWorkerStats;
+
+typedef struct {
+	u64  top;
+	u64  bottom;
+	u64 *jobs;
+} JobDeque;
+
+typedef struct JobSystem JobSystem;
+typedef struct {
+	JobDeque        deque;
+	JobWorkerStats  stats;
+	Arena          *arena;
+	JobSystem      *system;
+	u32             index;
+	u32             steal_seed;
+} JobWorker;
+
+struct JobSystem {
+	JobWorker *workers;
+	u32        worker_count;
+
+	/* NOTE(rnp): futexes follow the same protocol as GLWorkerThreadContext.sync_variable:
+	 * a waiter registers itself, sets the futex to 1, rechecks its condition and then
+	 * waits while the futex is 1. os_wake_all_waiters() resets it to 0 */
+	i32 work_futex;
+	i32 sleeping;
+	i32 finish_futex;
+	i32 waiting;
+
+	i32  injection_lock;
+	u32  injection_read;
+	u32  injection_write;
+	Job *injection[JobInjectionCapacity];
+
+	u64       timing_index;
+	JobTiming timings[JobTimingHistoryCount];
+
+	b32 quit;
+};
+
+/* NOTE(rnp): worker index + 1 of the current thread; 0 for threads outside the system */
+thread_static u32 job_worker_local;
+
+function void
+job_init(Job *job, job_function *fn, void *user_context, str8 label)
+{
+	zero_struct(job);
+	job->fn           = fn;
+	job->user_context = user_context;
+	job->label        = label;
+	job->unfinished   = 1;
+	job->dependencies = 1;
+}
+
+function void
+job_add_child(Job *parent, Job *child)
+{
+	assert(child->parent == 0);
+	child->parent = parent;
+	atomic_add_u32(&parent->unfinished, 1);
+}
+
+function void
+job_depends_on(Job *job, Job *dependency)
+{
+	assert(dependency->continuation_count < JobMaxContinuations);
+	dependency->continuations[dependency->continuation_count++] = job;
+	atomic_add_u32(&job->dependencies, 1);
+}
+
+function b32
+job_finished(Job *job)
+{
+	b32 result = atomic_load_u32(&job->unfinished) == 0;
+	return result;
+}
+
+function b32
+job_deque_push(JobDeque *d, Job *job)
+{
+	u64 b = atomic_load_u64(&d->bottom);
+	u64 t = atomic_load_u64(&d->top);
+	b32 result = (i64)(b - t) < JobDequeCapacity;
+	if (result) {
+		atomic_store_u64(d->jobs + (b % JobDequeCapacity), (u64)job);
+		atomic_store_u64(&d->bottom, b + 1);
+	}
+	return result;
+}
+
+function Job *
+job_deque_pop(JobDeque *d)
+{
+	u64 b = atomic_load_u64(&d->bottom) - 1;
+	atomic_store_u64(&d->bottom, b);
+	u64 t = atomic_load_u64(&d->top);
+
+	Job *result = 0;
+	if ((i64)(b - t) >= 0) {
+		result = (Job *)atomic_load_u64(d->jobs + (b % JobDequeCapacity));
+		if (b == t) {
+			/* NOTE(rnp): last job; race any thieves for it */
+			if (!atomic_cas_u64(&d->top, &t, t + 1))
+				result = 0;
+			atomic_store_u64(&d->bottom, b + 1);
+		}
+	} else {
+		atomic_store_u64(&d->bottom, b + 1);
+	}
+	return result;
+}
+
+function Job *
+job_deque_steal(JobDeque *d)
+{
+	u64 t = atomic_load_u64(&d->top);
+	u64 b = atomic_load_u64(&d->bottom);
+
+	Job *result = 0;
+	if ((i64)(b - t) > 0) {
+		result = (Job *)atomic_load_u64(d->jobs + (t % JobDequeCapacity));
+		if (!atomic_cas_u64(&d->top, &t, t + 1))
+			result = 0;
+	}
+	return result;
+}
+
+function void
+job_injection_lock(JobSystem *js)
+{
+	for (;;) {
+		i32 expected = 0;
+		if (atomic_cas_u32(&js->injection_lock, &expected, 1))
+			break;
+		cpu_yield();
+	}
+}
+
+function b32
+job_injection_push(JobSystem *js, Job *job)
+{
+	job_injection_lock(js);
+	b32 result = js->injection_write - js->injection_read < JobInjectionCapacity;
+	if (result) js->injection[js->injection_write++ % JobInjectionCapacity] = job;
+	atomic_store_u32(&js->injection_lock, 0);
+	return result;
+}
+
+function Job *
+job_injection_pop(JobSystem *js)
+{
+	Job *result = 0;
+	if (atomic_load_u32(&js->injection_write) != atomic_load_u32(&js->injection_read)) {
+		job_injection_lock(js);
+		if (js->injection_write != js->injection_read)
+			result = js->injection[js->injection_read++ % JobInjectionCapacity];
+		atomic_store_u32(&js->injection_lock, 0);
+	}
+	return result;
+}
+
+function void
+job_wake_workers(JobSystem *js)
+{
+	if (atomic_load_u32(&js->sleeping))
+		os_wake_all_waiters(&js->work_futex);
+}
+
+function void job_execute(JobSystem *js, Job *job, Arena *scratch);
+
+function void
+job_schedule(JobSystem *js, Job *job)
+{
+	job->submit_time = os_timer_count();
+
+	JobWorker *worker = job_worker_local ? js->workers + job_worker_local - 1 : 0;
+	if (worker && worker->system != js) worker = 0;
+
+	b32 pushed = worker && job_deque_push(&worker->deque, job);
+	if (!pushed) pushed = job_injection_push(js, job);
+	/* NOTE(rnp): everything is full. a worker does the job itself; any other thread waits
+	 * for the workers to drain the injection queue */
+	if (!pushed && worker) {
+		job_execute(js, job, worker->arena);
+	} else {
+		while (!pushed) {
+			cpu_yield();
+			pushed = job_injection_push(js, job);
+		}
+		job_wake_workers(js);
+	}
+}
+
+function void
+job_finish(JobSystem *js, Job *job)
+{
+	/* NOTE(rnp): copy out everything needed first; a waiter may release job once it finishes */
+	Job *parent = job->parent;
+	u32  continuation_count = job->continuation_count;
+	Job *continuations[JobMaxContinuations];
+	for (u32 i = 0; i < continuation_count; i++)
+		continuations[i] = job->continuations[i];
+
+	if (atomic_add_u32(&job->unfinished, -1) == 1) {
+		for (u32 i = 0; i < continuation_count; i++)
+			if (atomic_add_u32(&continuations[i]->dependencies, -1) == 1)
+				job_schedule(js, continuations[i]);
+
+		if (atomic_load_u32(&js->waiting))
+			os_wake_all_waiters(&js->finish_futex);
+
+		if (parent) job_finish(js, parent);
+	}
+}
+
+function void
+job_execute(JobSystem *js, Job *job, Arena *scratch)
+{
+	u32 worker = job_worker_local;
+	u64 start  = os_timer_count();
+	if (job->fn) {
+		Temp temp = {0};
+		if (scratch) temp = temp_begin(scratch);
+		job->fn(job->user_context, scratch);
+		if (scratch) temp_end(temp);
+	}
+	u64 end = os_timer_count();
+
+	JobTiming *t = js->timings + (atomic_add_u64(&js->timing_index, 1) % JobTimingHistoryCount);
+	t->label       = job->label;
+	t->submit_time = job->submit_time;
+	t->start_time  = start;
+	t->end_time    = end;
+	t->worker      = worker;
+
+	if (worker) {
+		JobWorkerStats *stats = &js->workers[worker - 1].stats;
+		stats->executed++;
+		stats->busy_ticks += end - start;
+	}
+
+	job_finish(js, job);
+}
+
+function void
+job_submit(JobSystem *js, Job *job)
+{
+	if (atomic_add_u32(&job->dependencies, -1) == 1)
+		job_schedule(js, job);
+}
+
+function Job *
+job_find(JobSystem *js, JobWorker *worker)
+{
+	Job *result = worker ? job_deque_pop(&worker->deque) : 0;
+	if (!result) result = job_injection_pop(js);
+	if (!result) {
+		u32 start = worker ? (worker->steal_seed = worker->steal_seed * 1664525u + 1013904223u) : 0;
+		for (u32 i = 0; !result && i < js->worker_count; i++) {
+			JobWorker *victim = js->workers + (start + i) % js->worker_count;
+			if (victim != worker) result = job_deque_steal(&victim->deque);
+		}
+		if (result && worker) worker->stats.stolen++;
+	}
+	return result;
+}
+
+function void
+job_wait(JobSystem *js, Job *job, Arena *scratch)
+{
+	JobWorker *worker = job_worker_local ? js->workers + job_worker_local - 1 : 0;
+	if (worker && worker->system != js) worker = 0;
+	while (!job_finished(job)) {
+		Job *next = job_find(js, worker);
+		if (next) {
+			job_execute(js, next, scratch);
+		} else {
+			/* NOTE(rnp): the remaining work is running elsewhere */
+			atomic_add_u32(&js->waiting, 1);
+			atomic_store_u32(&js->finish_futex, 1);
+			if (!job_finished(job))
+				os_wait_on_address(&js->finish_futex, 1, (u32)-1);
+			atomic_add_u32(&js->waiting, -1);
+		}
+	}
+}
+
+function OS_THREAD_ENTRY_POINT_FN(job_worker_entry_point)
+{
+	JobWorker *worker = user_context;
+	JobSystem *js     = worker->system;
+
+	job_worker_local = worker->index + 1;
+
+	while (!atomic_load_u32(&js->quit)) {
+		Job *job = job_find(js, worker);
+		if (job) {
+			job_execute(js, job, worker->arena);
+		} else {
+			atomic_add_u32(&js->sleeping, 1);
+			atomic_store_u32(&js->work_futex, 1);
+			job = job_find(js, worker);
+			if (!job && !atomic_load_u32(&js->quit)) {
+				worker->stats.parked++;
+				os_wait_on_address(&js->work_futex, 1, (u32)-1);
+			}
+			atomic_add_u32(&js->sleeping, -1);
+			if (job) job_execute(js, job, worker->arena);
+		}
+	}
+
+	return 0;
+}
+
+function JobSystem *
+job_system_create(Arena *arena, u32 worker_count)
+{
+	JobSystem *result    = push_struct(arena, JobSystem);
+	result->worker_count = Clamp(worker_count, 1, JobSystemMaxWorkers);
+	result->workers      = push_array(arena, JobWorker, result->worker_count);
+
+	for (u32 i = 0; i < result->worker_count; i++) {
+		JobWorker *w  = result->workers + i;
+		w->deque.jobs = push_array(arena, u64, JobDequeCapacity);
+		w->arena      = arena_create();
+		w->system     = result;
+		w->index      = i;
+		w->steal_seed = i * 0x9E3779B9u + 1;
+	}
+
+	for (u32 i = 0; i < result->worker_count; i++)
+		os_create_thread("[job]", result->workers + i, job_worker_entry_point);
+
+	return result;
+}
+
+/* NOTE(rnp): workers exit once they run out of work; outstanding jobs are not waited for */
+function void
+job_system_destroy(JobSystem *js)
+{
+	atomic_store_u32(&js->quit, 1);
+	os_wake_all_waiters(&js->work_futex);
+}
@@ -492,6 +492,7 @@ function b32
 beamformer_push_data_base(void *data, u32 data_size, i32 timeout_ms, u32 block)
 {
 	b32 result = 0;
+	u64 push_begin = os_timer_count();
 	Arena *scratch = beamformer_shared_memory_scratch_arena(g_beamformer_library_context.bp,
 	                                                        g_beamformer_library_context.shared_memory_size);
 	BeamformerParameterBlock *b  = beamformer_parameter_block(g_beamformer_library_context.bp, block);
@@ -559,6 +560,8 @@ beamformer_push_data_base(void *data, u32 data_size, i32 timeout_ms, u32 block)
 				}
 
 				lib_release_lock(BeamformerSharedMemoryLockKind_ScratchSpace);
+				g_beamformer_library_context.bp->rf_push_begin = push_begin;
+				g_beamformer_library_context.bp->rf_push_end   = os_timer_count();
 				/* TODO(rnp): need a better way to communicate this */
 				u64 rf_block_rf_size = (u64)block << 32ULL | (u64)rf_size;
 				atomic_store_u64(&g_beamformer_library_context.bp->rf_block_rf_size, rf_block_rf_size);
@@ -735,6 +738,91 @@ beamformer_beamform_data(BeamformerSimpleParameters *bp, void *data, uint32_t da
 	return result;
 }
 
+b32
+beamformer_set_latency_window(u32 samples)
+{
+	b32 result = check_shared_memory();
+	if (result) atomic_store_u32(&g_beamformer_library_context.bp->latency_window, samples);
+	return result;
+}
+
+b32
+beamformer_set_backpressure_policy_at(BeamformerBackpressurePolicy policy, u32 queue_depth_target, u32 block)
+{
+	b32 result = valid_parameter_block(block) &&
+	             lib_error_check(policy < BeamformerBackpressurePolicy_Count, InvalidBackpressurePolicy);
+	if (result) {
+		BeamformerBackpressure *bp = g_beamformer_library_context.bp->backpressure + block;
+		atomic_store_u32(&bp->queue_depth_target, queue_depth_target);
+		atomic_store_u32((u32 *)&bp->policy, policy);
+	}
+	return result;
+}
+
+b32
+beamformer_set_backpressure_policy(BeamformerBackpressurePolicy policy, u32 queue_depth_target)
+{
+	b32 result = beamformer_set_backpressure_policy_at(policy, queue_depth_target, 0);
+	return result;
+}
+
+b32
+beamformer_set_block_scheduling_at(u32 priority, u32 weight, f32 deadline, u32 block)
+{
+	b32 result = valid_parameter_block(block) &&
+	             lib_error_check(deadline >= 0 && deadline < inf32(), InvalidSchedulingDeadline);
+	if (result) {
+		BeamformerScheduling *s = g_beamformer_library_context.bp->scheduling + block;
+		atomic_store_u32(&s->priority, priority);
+		atomic_store_u32(&s->weight,   Max(weight, 1u));
+		s->deadline = deadline;
+	}
+	return result;
+}
+
+b32
+beamformer_set_block_scheduling(u32 priority, u32 weight, f32 deadline)
+{
+	b32 result = beamformer_set_block_scheduling_at(priority, weight, deadline, 0);
+	return result;
+}
+
+b32
+beamformer_set_interactive_tuning_at(b32 enabled, f32 settle_time, u32 block)
+{
+	b32 result = valid_parameter_block(block) &&
+	             lib_error_check(settle_time >= 0 && settle_time < inf32(), InvalidSettleTime);
+	if (result) {
+		BeamformerInteractiveTuning *it = g_beamformer_library_context.bp->interactive_tuning + block;
+		it->settle_time = settle_time;
+		atomic_store_u32(&it->disabled, !enabled);
+	}
+	return result;
+}
+
+b32
+beamformer_set_interactive_tuning(b32 enabled, f32 settle_time)
+{
+	b32 result = beamformer_set_interactive_tuning_at(enabled, settle_time, 0);
+	return result;
+}
+
+/* NOTE(rnp): lock free; does not queue any work for the beamformer */
+BEAMFORMER_LIB_EXPORT b32
+beamformer_read_telemetry(BeamformerTelemetry *output)
+{
+	b32 result = 0;
+	if (check_shared_memory()) {
+		BeamformerTelemetry *t = &g_beamformer_library_context.bp->telemetry;
+		output->timer_frequency = t->timer_frequency;
+		result = lib_error_check(beamformer_telemetry_read(&output->compute, &t->compute, sizeof(t->compute),
+		                                                   &t->compute.sequence) &&
+		                         beamformer_telemetry_read(&output->upload, &t->upload, sizeof(t->upload),
+		                                                   &t->upload.sequence), SyncVariable);
+	}
+	return result;
+}
+
 BEAMFORMER_LIB_EXPORT b32
 beamformer_compute_timings(BeamformerComputeStatsTable *output, i32 timeout_ms)
 {
@@ -29,6 +29,9 @@
 	X(SyncVariable,                 18, "failed to acquire lock within timeout period")      \
 	X(FrameSizeOverflow,            19, "maximum frame size exceeded")                       \
 	X(RFDataSizeOverflow,           20, "raw rf size exceeds available GPU space")           \
+	X(InvalidBackpressurePolicy,    21, "invalid backpressure policy")                       \
+	X(InvalidSchedulingDeadline,    22, "scheduling deadline must be finite and >= 0")       \
+	X(InvalidSettleTime,            23, "interactive settle time must be finite and >= 0")   \
 
 #define X(type, num, string) BeamformerLibErrorKind_##type = num,
 typedef enum {BEAMFORMER_LIB_ERRORS} BeamformerLibErrorKind;
@@ -102,6 +105,43 @@ BEAMFORMER_LIB_EXPORT uint32_t beamformer_push_data_with_compute(void *data, uin
  */
 BEAMFORMER_LIB_EXPORT uint32_t beamformer_get_last_frames(void *out_data, uint64_t out_data_size, uint32_t count);
 
+/* NOTE: sets how many of the most recent samples the windowed latency percentiles of the
+ * compute stats cover. 0 restores the default (1024) and larger values are clamped to 4096 */
+BEAMFORMER_LIB_EXPORT uint32_t beamformer_set_latency_window(uint32_t samples);
+
+/* NOTE: selects what happens to a parameter block's frames when they are pushed faster
+ * than they can be beamformed (Default: Block):
+ *   Block:      push_data_with_compute waits until the beamformer catches up
+ *   DropOldest: a frame is skipped if queue_depth_target or more newer frames are waiting;
+ *               0 is treated as 1
+ *   LatestWins: only the newest waiting frame is beamformed; queue_depth_target is ignored
+ * dropped frames are counted in the compute telemetry */
+BEAMFORMER_LIB_EXPORT uint32_t beamformer_set_backpressure_policy(BeamformerBackpressurePolicy policy,
+                                                                  uint32_t queue_depth_target);
+BEAMFORMER_LIB_EXPORT uint32_t beamformer_set_backpressure_policy_at(BeamformerBackpressurePolicy policy,
+                                                                     uint32_t queue_depth_target,
+                                                                     uint32_t parameter_slot);
+
+/* NOTE: controls how the beamformer shares compute between parameter blocks with work
+ * waiting (Default: priority 0, weight 1, no deadline). Work whose block has waited longer
+ * than deadline [s] goes first, then the highest priority. Blocks of equal priority receive
+ * compute time in proportion to their weight; a weight of 0 is treated as 1 and a deadline
+ * of 0 disables it. per block frame rates and latencies are reported in the telemetry */
+BEAMFORMER_LIB_EXPORT uint32_t beamformer_set_block_scheduling(uint32_t priority, uint32_t weight, float deadline);
+BEAMFORMER_LIB_EXPORT uint32_t beamformer_set_block_scheduling_at(uint32_t priority, uint32_t weight,
+                                                                  float deadline, uint32_t parameter_slot);
+
+/* NOTE: interactive tuning (Default: enabled, 0.5 s). Parameter updates which only change
+ * the speed of sound, time offset, f-number or interpolation mode switch the block to a
+ * beamforming variant which reads them at runtime so they take effect on the next frame
+ * without compiling a new pipeline. Once no such update has arrived for settle_time [s]
+ * the fully specialized pipeline is compiled in the background and used when it is ready.
+ * A settle_time of 0 selects the default. When disabled every update is compiled before
+ * the next frame is beamformed */
+BEAMFORMER_LIB_EXPORT uint32_t beamformer_set_interactive_tuning(uint32_t enabled, float settle_time);
+BEAMFORMER_LIB_EXPORT uint32_t beamformer_set_interactive_tuning_at(uint32_t enabled, float settle_time,
+                                                                    uint32_t parameter_slot);
+
 ///////////////////////////
 // Parameter Configuration
 BEAMFORMER_LIB_EXPORT uint32_t beamformer_reserve_parameter_blocks(uint32_t count);
@@ -161,6 +201,13 @@ BEAMFORMER_LIB_EXPORT uint32_t beamformer_push_transmit_receive_orientations_at(
  *   β = 0                                           if       A <  21
  * M:
  *   M = (A - 8) / (2.285 (ω_s - ω_p))
+ *
+ * interpolation_factor (L):
+ *   when > 1 the filter is realized as an interpolated FIR (IFIR): a model filter with
+ *   ceil(M / L) taps spaced L samples apart followed by a short image rejection filter.
+ *   narrow band filters (ω_c much less than π) need far fewer multiplies this way. L is
+ *   clamped so that the image rejection filter's transition band stays reasonable;
+ *   0 or 1 selects the regular direct form filter.
  */
 
 BEAMFORMER_LIB_EXPORT uint32_t beamformer_create_filter(BeamformerFilterParameters *filter,
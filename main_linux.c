@@ -26,11 +26,18 @@
 
 #define OS_RENDERDOC_SONAME    "librenderdoc.so"
 
+/* NOTE(rnp): low enough that kernel threads (irq handlers run at 50) still preempt us */
+#define OS_REALTIME_PRIORITY   (10)
+
+/* NOTE(rnp): written in the working directory when SIGUSR1 is received */
+#define OS_TRACE_SNAPSHOT_NAME "ogl_trace.json"
+
 #define OS_VULKAN_SONAME_LIST \
 	X("libvulkan.so") \
 	X("libvulkan.so.1") \
 
 #include <dlfcn.h>
+#include <signal.h>
 
 typedef struct OSLinuxEntity OSLinuxEntity;
 typedef struct {
@@ -100,6 +107,18 @@ typedef struct {
 	} windows;
 
 	OSLinuxEntity *entity_freelist;
+
+	struct {
+		BeamformerThreadPlacementPolicy policy;
+		b32           realtime;
+		b32           resolved;
+		OSLinuxCPUSet shared_cpus;
+		OSLinuxCPUSet dedicated_cpus;
+		u64           threads[BeamformerThreadPlacementMaxThreads];
+	} placement;
+
+	/* NOTE(rnp): set from the SIGUSR1 handler */
+	b32 trace_snapshot_requested;
 } OSLinux_Context;
 global OSLinux_Context os_linux_context;
 
@@ -118,6 +137,170 @@ os_entity_allocate(OSLinuxEntityKind kind)
 	return result;
 }
 
+/* NOTE(rnp): the compute and upload threads get a logical processor to themselves, the
+ * copy lanes share the upload thread's deadline so they are also eligible for realtime */
+function b32
+os_thread_placement_dedicated(str8 name)
+{
+	b32 result = str8_equal(name, str8("[compute]")) || str8_equal(name, str8("[upload]"));
+	return result;
+}
+
+function b32
+os_thread_placement_realtime(str8 name)
+{
+	b32 result = os_thread_placement_dedicated(name) || str8_equal(name, str8("[upload copy]"));
+	return result;
+}
+
+function void
+os_thread_placement_apply(u32 index)
+{
+	BeamformerThreadPlacementLayout *layout = &beamformer_thread_placement_layout;
+	BeamformerThreadPlacement       *tp     = layout->threads + index;
+	u64 thread = os_linux_context.placement.threads[index];
+
+	tp->cpu = -1;
+	if (layout->policy == BeamformerThreadPlacementPolicy_GPULocal) {
+		OSLinuxCPUSet cpus = os_linux_context.placement.shared_cpus;
+		if (os_thread_placement_dedicated(tp->name)) {
+			OSLinuxCPUSet *dedicated = &os_linux_context.placement.dedicated_cpus;
+			for (u32 cpu = 0; tp->cpu == -1 && cpu < countof(dedicated->bits) * 64; cpu++) {
+				if (os_linux_cpu_set_has(dedicated, cpu)) {
+					dedicated->bits[cpu / 64] &= ~(1ull << (cpu % 64));
+					zero_struct(&cpus);
+					os_linux_cpu_set_add(&cpus, cpu);
+					tp->cpu = (i32)cpu;
+				}
+			}
+		}
+		tp->cpu_count = os_linux_cpu_set_count(&cpus);
+		tp->pinned    = tp->cpu_count > 0 && os_linux_thread_set_affinity(thread, &cpus);
+	}
+
+	if (os_linux_context.placement.realtime && os_thread_placement_realtime(tp->name))
+		tp->realtime = os_linux_thread_set_realtime(thread, OS_REALTIME_PRIORITY);
+}
+
+function void
+os_thread_placement_push(str8 name, u64 thread)
+{
+	BeamformerThreadPlacementLayout *layout = &beamformer_thread_placement_layout;
+	DeferLoop(take_lock(&os_linux_context.arena_lock, -1), release_lock(&os_linux_context.arena_lock))
+	{
+		if (layout->thread_count < BeamformerThreadPlacementMaxThreads) {
+			u32 index = layout->thread_count++;
+			layout->threads[index].name               = name;
+			os_linux_context.placement.threads[index] = thread;
+			if (os_linux_context.placement.resolved)
+				os_thread_placement_apply(index);
+		}
+	}
+}
+
+/* NOTE(rnp): called once the GPU is known. threads created before this are placed here,
+ * threads created after are placed as they are created */
+function void
+os_thread_placement_resolve(void *shared_memory, u64 shared_memory_size)
+{
+	BeamformerThreadPlacementLayout *layout = &beamformer_thread_placement_layout;
+	layout->policy             = os_linux_context.placement.policy;
+	layout->realtime_requested = os_linux_context.placement.realtime;
+	layout->realtime_priority  = OS_REALTIME_PRIORITY;
+	layout->numa_node          = -1;
+
+	if (layout->policy == BeamformerThreadPlacementPolicy_GPULocal) {
+		OSLinuxCPUSet process = os_linux_process_cpu_set();
+		OSLinuxCPUSet local   = process;
+
+		GPUInfo *gi = gpu_info();
+		if (gi->pci_bus_info) {
+			OSLinuxCPUSet pci = {0};
+			layout->numa_node = os_linux_pci_device_locality(gi->pci_domain, gi->pci_bus, gi->pci_device,
+			                                                 gi->pci_function, &pci);
+			for EachElement(pci.bits, it)
+				pci.bits[it] &= process.bits[it];
+			if (os_linux_cpu_set_count(&pci) > 0)
+				local = pci;
+		}
+		layout->local_cpu_count = os_linux_cpu_set_count(&local);
+
+		/* NOTE(rnp): take dedicated processors from the top of the local set but always leave
+		 * at least one for everything else */
+		u32 dedicated = 0;
+		for (u32 it = 0; it < layout->thread_count; it++)
+			dedicated += os_thread_placement_dedicated(layout->threads[it].name);
+		dedicated = Min(dedicated, layout->local_cpu_count - 1);
+
+		OSLinuxCPUSet *dedicated_cpus = &os_linux_context.placement.dedicated_cpus;
+		for (i32 cpu = countof(local.bits) * 64 - 1; dedicated > 0 && cpu >= 0; cpu--) {
+			if (os_linux_cpu_set_has(&local, (u32)cpu)) {
+				local.bits[cpu / 64] &= ~(1ull << (cpu % 64));
+				os_linux_cpu_set_add(dedicated_cpus, (u32)cpu);
+				dedicated--;
+			}
+		}
+		os_linux_context.placement.shared_cpus = local;
+
+		if (layout->numa_node >= 0)
+			layout->shared_memory_bound = os_linux_memory_bind_node(shared_memory, shared_memory_size,
+			                                                        layout->numa_node);
+	}
+
+	DeferLoop(take_lock(&os_linux_context.arena_lock, -1), release_lock(&os_linux_context.arena_lock))
+	{
+		for (u32 it = 0; it < layout->thread_count; it++)
+			os_thread_placement_apply(it);
+		os_linux_context.placement.resolved = 1;
+	}
+}
+
+function void
+os_thread_placement_log(void)
+{
+	BeamformerThreadPlacementLayout *layout = &beamformer_thread_placement_layout;
+
+	u8 buffer[4096];
+	Stream sb = {.data = buffer, .cap = countof(buffer)};
+	stream_append_str8s(&sb, str8("[os] thread placement: "),
+	                    beamformer_thread_placement_policy_names[layout->policy]);
+	if (layout->policy == BeamformerThreadPlacementPolicy_GPULocal) {
+		stream_append_str8(&sb, str8(", numa node: "));
+		stream_append_i64(&sb, layout->numa_node);
+		stream_append_str8(&sb, str8(", local cpus: "));
+		stream_append_u64(&sb, layout->local_cpu_count);
+		stream_append_str8(&sb, layout->shared_memory_bound ? str8(", shared memory bound")
+		                                                    : str8(", shared memory unbound"));
+	}
+	stream_append_byte(&sb, '\n');
+
+	for (u32 it = 0; it < layout->thread_count; it++) {
+		BeamformerThreadPlacement *tp = layout->threads + it;
+		if (!tp->pinned && !tp->realtime) continue;
+		stream_append_str8s(&sb, str8("[os]   "), tp->name);
+		if (tp->cpu >= 0) {
+			stream_append_str8(&sb, str8(" cpu: "));
+			stream_append_u64(&sb, (u64)tp->cpu);
+		} else if (tp->pinned) {
+			stream_append_str8(&sb, str8(" cpus: "));
+			stream_append_u64(&sb, tp->cpu_count);
+		}
+		if (tp->realtime) stream_append_str8(&sb, str8(" (SCHED_FIFO)"));
+		stream_append_byte(&sb, '\n');
+	}
+
+	if (layout->realtime_requested) {
+		b32 any_realtime = 0;
+		for (u32 it = 0; it < layout->thread_count; it++)
+			any_realtime |= layout->threads[it].realtime;
+		if (!any_realtime)
+			stream_append_str8(&sb, str8("[os] warning: SCHED_FIFO was requested but not permitted "
+			                             "(requires CAP_SYS_NICE or RLIMIT_RTPRIO)\n"));
+	}
+
+	os_console_log(sb.data, sb.widx);
+}
+
 BEAMFORMER_IMPORT OSThread
 os_create_thread(const char *name, void *user_context, os_thread_entry_point_fn *fn)
 {
@@ -133,6 +316,8 @@ os_create_thread(const char *name, void *user_context, os_thread_entry_point_fn
 		pthread_setname_np(thread, buffer);
 	}
 
+	os_thread_placement_push(name ? str8_from_c_str((char *)name) : str8("[thread]"), (u64)thread);
+
 	OSThread result = {(u64)thread};
 	return result;
 }
@@ -178,6 +363,22 @@ os_release_handle(OSHandle h)
 		close(h.value[0]);
 }
 
+BEAMFORMER_IMPORT OSHandle
+os_create_file(const char *path)
+{
+	OSHandle result = {OSInvalidHandleValue};
+	i32 fd = open(path, O_WRONLY|O_TRUNC|O_CREAT|O_CLOEXEC, 0644);
+	if (fd != INVALID_FILE) result.value[0] = (u64)fd;
+	return result;
+}
+
+BEAMFORMER_IMPORT b32
+os_append_file(OSHandle file, u8 *data, i64 length)
+{
+	b32 result = os_write_file((i32)file.value[0], data, length);
+	return result;
+}
+
 BEAMFORMER_IMPORT void *
 os_lookup_symbol(OSLibrary library, const char *symbol)
 {
@@ -433,12 +634,78 @@ dispatch_file_watch_events(void *beamformer, BeamformerInput *input)
 	}
 }
 
+#if BEAMFORMER_TRACING
+function void
+os_trace_snapshot_signal(i32 signal_number)
+{
+	atomic_store_u32(&os_linux_context.trace_snapshot_requested, 1);
+}
+
+function void
+os_trace_snapshot(void)
+{
+	TraceWriter stats = {0};
+	u8 buffer[256];
+	Stream sb = {.data = buffer, .cap = countof(buffer)};
+	if (trace_write(OS_TRACE_SNAPSHOT_NAME, &stats)) {
+		stream_appendf(&sb, "[trace] wrote %llu events to " OS_TRACE_SNAPSHOT_NAME " (%llu dropped)\n",
+		               (unsigned long long)stats.events, (unsigned long long)stats.dropped);
+	} else {
+		stream_append_str8(&sb, str8("[trace] failed to write " OS_TRACE_SNAPSHOT_NAME "\n"));
+	}
+	os_console_log(sb.data, sb.widx);
+}
+#endif
+
 BASE_IMPORT void
 entry_point(i32 argc, char *argv[])
 {
 	os_linux_context.arena          = arena_create(.name = "Platform Arena");
 	os_linux_context.inotify_handle = inotify_init1(IN_NONBLOCK|IN_CLOEXEC);
 
+	char *trace_path = 0;
+	for (i32 it = 1; it < argc; it++) {
+		str8 arg = str8_from_c_str(argv[it]);
+		if (str8_equal(arg, str8("--thread-placement")) && it + 1 < argc) {
+			str8 policy = str8_from_c_str(argv[++it]);
+			b32  found  = 0;
+			for EachElement(beamformer_thread_placement_policy_names, p) {
+				if (str8_equal(policy, beamformer_thread_placement_policy_names[p])) {
+					os_linux_context.placement.policy = (BeamformerThreadPlacementPolicy)p;
+					found = 1;
+				}
+			}
+			if (!found) fatal(str8("[os] --thread-placement: expected one of: none, gpu-local\n"));
+		} else if (str8_equal(arg, str8("--realtime"))) {
+			os_linux_context.placement.realtime = 1;
+		} else if (str8_equal(arg, str8("--trace")) && it + 1 < argc) {
+			trace_path = argv[++it];
+		} else {
+			fatal(str8("usage: ogl [--thread-placement none|gpu-local] [--realtime] [--trace file.json]\n"));
+		}
+	}
+
+	#if BEAMFORMER_TRACING
+	trace_thread_name(str8("[main]"));
+	signal(SIGUSR1, os_trace_snapshot_signal);
+	if (trace_path) {
+		u8 buffer[256];
+		Stream sb = {.data = buffer, .cap = countof(buffer)};
+		if (trace_stream_begin(trace_path)) {
+			stream_appendf(&sb, "[trace] streaming to %s (zone overhead: %0.1f ns)\n",
+			               trace_path, trace_context.zone_overhead_ns);
+		} else {
+			stream_appendf(&sb, "[trace] failed to open %s\n", trace_path);
+		}
+		os_console_log(sb.data, sb.widx);
+	}
+	#else
+	if (trace_path) {
+		str8 message = str8("[trace] tracing was compiled out\n");
+		os_console_log(message.data, message.length);
+	}
+	#endif
+
 	BeamformerInput *input = push_struct(os_linux_context.arena, BeamformerInput);
 	os_linux_context.input = input;
 	input->shared_memory   = allocate_shared_memory(OS_SHARED_MEMORY_NAME, OS_SHARED_MEMORY_SIZE,
@@ -456,6 +723,10 @@ entry_point(i32 argc, char *argv[])
 
 	void *beamformer = beamformer_init(input);
 
+	os_thread_placement_push(str8("[main]"), (u64)pthread_self());
+	os_thread_placement_resolve(input->shared_memory, input->shared_memory_size);
+	os_thread_placement_log();
+
 	struct pollfd fds[1] = {{0}};
 	fds[0].fd     = os_linux_context.inotify_handle;
 	fds[0].events = POLLIN;
@@ -469,6 +740,11 @@ entry_point(i32 argc, char *argv[])
 
 		beamformer_frame_step(beamformer, input);
 
+		#if BEAMFORMER_TRACING
+		if (atomic_swap_u32(&os_linux_context.trace_snapshot_requested, 0))
+			os_trace_snapshot();
+		#endif
+
 		// NOTE(rnp): this must happen at the end of frame to allow the pre loop events through
 		// TODO(rnp): hack: until raylib is removed this happens in ui since raylib will cause
 		// glfw to call the input callbacks in during EndDrawing()
@@ -477,6 +753,10 @@ entry_point(i32 argc, char *argv[])
 
 	beamformer_terminate(beamformer, input);
 
+	#if BEAMFORMER_TRACING
+	trace_stream_end();
+	#endif
+
 	/* NOTE: make sure this will get cleaned up after external
 	 * programs release their references */
 	shm_unlink(OS_SHARED_MEMORY_NAME);
@@ -213,6 +213,22 @@ os_release_handle(OSHandle h)
 		CloseHandle(h.value[0]);
 }
 
+BEAMFORMER_IMPORT OSHandle
+os_create_file(const char *path)
+{
+	OSHandle result = {OSInvalidHandleValue};
+	iptr h = CreateFileA((c8 *)path, GENERIC_WRITE, FILE_SHARE_READ, 0, CREATE_ALWAYS, 0, 0);
+	if (h != INVALID_FILE) result.value[0] = (u64)h;
+	return result;
+}
+
+BEAMFORMER_IMPORT b32
+os_append_file(OSHandle file, u8 *data, i64 length)
+{
+	b32 result = os_write_file((iptr)file.value[0], data, length);
+	return result;
+}
+
 BEAMFORMER_IMPORT void *
 os_lookup_symbol(OSLibrary library, const char *symbol)
 {
@@ -516,6 +532,36 @@ entry_point(i32 argc, char *argv[])
 	os_w32_context.error_handle         = GetStdHandle(STD_ERROR_HANDLE);
 	os_w32_context.io_completion_handle = CreateIoCompletionPort(INVALID_FILE, 0, 0, 0);
 
+	char *trace_path = 0;
+	for (i32 it = 1; it < argc; it++) {
+		str8 arg = str8_from_c_str(argv[it]);
+		if (str8_equal(arg, str8("--trace")) && it + 1 < argc) {
+			trace_path = argv[++it];
+		} else {
+			fatal(str8("usage: ogl [--trace file.json]\n"));
+		}
+	}
+
+	#if BEAMFORMER_TRACING
+	trace_thread_name(str8("[main]"));
+	if (trace_path) {
+		u8 buffer[256];
+		Stream sb = {.data = buffer, .cap = countof(buffer)};
+		if (trace_stream_begin(trace_path)) {
+			stream_appendf(&sb, "[trace] streaming to %s (zone overhead: %0.1f ns)\n",
+			               trace_path, trace_context.zone_overhead_ns);
+		} else {
+			stream_appendf(&sb, "[trace] failed to open %s\n", trace_path);
+		}
+		os_console_log(sb.data, sb.widx);
+	}
+	#else
+	if (trace_path) {
+		str8 message = str8("[trace] tracing was compiled out\n");
+		os_console_log(message.data, message.length);
+	}
+	#endif
+
 	BeamformerInput *input = push_struct(os_w32_context.arena, BeamformerInput);
 	os_w32_context.input   = input;
 	input->shared_memory   = allocate_shared_memory(OS_SHARED_MEMORY_NAME, OS_SHARED_MEMORY_SIZE,
@@ -552,4 +598,8 @@ entry_point(i32 argc, char *argv[])
 	}
 
 	beamformer_terminate(beamformer, input);
+
+	#if BEAMFORMER_TRACING
+	trace_stream_end();
+	#endif
 }
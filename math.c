@@ -766,6 +766,95 @@ kaiser_low_pass_filter(Arena *arena, f32 cutoff_frequency, f32 sampling_frequenc
 	return result;
 }
 
+/* NOTE(rnp): inverse of the β selection formula for a Kaiser window. returns the
+ * stopband attenuation A (dB) achieved by a given β */
+function f32
+kaiser_attenuation_from_beta(f32 beta)
+{
+	f32 result = 21;
+	if (beta > 4.5513f) {
+		result = beta / 0.1102f + 8.7f;
+	} else if (beta > 0) {
+		// NOTE(rnp): no closed form for β = 0.5842 * (A - 21)^0.4 + 0.07886(A − 21).
+		// substituting A - 21 = v^5 gives a polynomial in v which is bisected instead
+		f32 lo = 0, hi = 2;
+		for (i32 i = 0; i < 24; i++) {
+			f32 v  = (lo + hi) / 2;
+			f32 v2 = v * v;
+			f32 b  = 0.5842f * v2 + 0.07886f * v2 * v2 * v;
+			if (b < beta) lo = v;
+			else          hi = v;
+		}
+		f32 v  = (lo + hi) / 2;
+		result = 21 + v * v * v * v * v;
+	}
+	return result;
+}
+
+/* NOTE(rnp): Interpolated FIR (IFIR) low pass design (Neuvo, Dong, Mitra 1984).
+ * H(z) = G(z^L) I(z): G is designed as a Kaiser low pass at L times the cutoff
+ * and then upsampled by L (only every L-th tap is nonzero), I rejects the L - 1
+ * spectral images of G(z^L). the images begin at fs/L - fc and so I only needs a
+ * transition band of fs/L - 2fc. the returned factor is clamped such that this
+ * band is at least 2fc wide; 1 means that an IFIR design is not applicable */
+function i32
+kaiser_ifir_interpolation_factor(f32 cutoff_frequency, f32 sampling_frequency, i32 requested_factor)
+{
+	i32 result = 1;
+	if (cutoff_frequency > 0)
+		result = Clamp(requested_factor, 1, (i32)(sampling_frequency / (4 * cutoff_frequency)));
+	return result;
+}
+
+function f32 *
+kaiser_ifir_model_filter(Arena *arena, f32 cutoff_frequency, f32 sampling_frequency, f32 beta,
+                         i32 length, i32 interpolation_factor)
+{
+	f32 *result = kaiser_low_pass_filter(arena, (f32)interpolation_factor * cutoff_frequency,
+	                                     sampling_frequency, beta, length);
+	return result;
+}
+
+/* NOTE(rnp): M = (A - 8) / (2.285 Δω) with Δω the image rejection transition width */
+function i32
+kaiser_ifir_image_filter_length(f32 cutoff_frequency, f32 sampling_frequency, f32 beta,
+                                i32 interpolation_factor)
+{
+	f32 transition = sampling_frequency / (f32)interpolation_factor - 2 * cutoff_frequency;
+	f32 dw         = 2 * PI * transition / sampling_frequency;
+	i32 result     = (i32)ceil_f32((kaiser_attenuation_from_beta(beta) - 8) / (2.285f * dw));
+	result = Max(result, 2);
+	return result;
+}
+
+function f32 *
+kaiser_ifir_image_filter(Arena *arena, f32 sampling_frequency, f32 beta, i32 length, i32 interpolation_factor)
+{
+	// NOTE(rnp): cutoff midway between the passband edge and the first image
+	f32 *result = kaiser_low_pass_filter(arena, sampling_frequency / (2 * (f32)interpolation_factor),
+	                                     sampling_frequency, beta, length);
+	return result;
+}
+
+/* NOTE(rnp): Kaiser windowed ideal Hilbert transformer, h[k] = 2 / (πk) for odd k and 0
+ * for even k, centered on length / 2. length is forced odd so that the filter has no delay */
+function f32 *
+hilbert_fir_filter(Arena *arena, i32 length, f32 beta)
+{
+	length |= 1;
+	f32 *result = push_array(arena, f32, length);
+	i32 half    = length / 2;
+	f32 i0_b    = (f32)cephes_i0(beta);
+	for (i32 k = 1; k <= half; k += 2) {
+		f32 t      = (f32)k / (f32)half;
+		f32 window = (f32)cephes_i0(beta * sqrt_f32(1 - t * t)) / i0_b;
+		f32 value  = 2 / (PI * (f32)k) * window;
+		result[half + k] =  value;
+		result[half - k] = -value;
+	}
+	return result;
+}
+
 function f32 *
 rf_chirp(Arena *arena, f32 min_frequency, f32 max_frequency, f32 sampling_frequency,
          i32 length, b32 reverse)
@@ -796,6 +885,35 @@ baseband_chirp(Arena *arena, f32 min_frequency, f32 max_frequency, f32 sampling_
 	return result;
 }
 
+/* NOTE(rnp): in place iterative radix-2 FFT. length must be a power of 2.
+ * the inverse transform is left unscaled */
+function void
+fft_complex(v2 *data, i32 length, b32 inverse)
+{
+	u32 bits = (u32)ctz_u64((u64)length);
+	for (u32 i = 0; i < (u32)length; i++) {
+		u32 j = 0;
+		for (u32 bit = 0; bit < bits; bit++)
+			j |= ((i >> bit) & 1u) << (bits - 1 - bit);
+		if (i < j) swap(data[i], data[j]);
+	}
+
+	f32 sign = inverse ? 1.0f : -1.0f;
+	for (i32 half = 1; half < length; half *= 2) {
+		for (i32 k = 0; k < half; k++) {
+			f32 arg = sign * PI * (f32)k / (f32)half;
+			v2  w   = {{cos_f32(arg), sin_f32(arg)}};
+			for (i32 i = k; i < length; i += 2 * half) {
+				v2 u = data[i];
+				v2 v = data[i + half];
+				v2 t = {{v.x * w.x - v.y * w.y, v.x * w.y + v.y * w.x}};
+				data[i]        = v2_add(u, t);
+				data[i + half] = v2_sub(u, t);
+			}
+		}
+	}
+}
+
 function iv3
 das_output_dimension(iv3 points)
 {
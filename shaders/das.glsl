@@ -31,6 +31,15 @@
   #define RESULT_STORE(a) (a)
 #endif
 
+/* NOTE(rnp): interactive variant; the frequently tuned parameters come from the push
+ * constants so that changing them doesn't require a new pipeline */
+#if Interactive
+  #define SpeedOfSound      speed_of_sound
+  #define TimeOffset        time_offset
+  #define FNumber           f_number
+  #define InterpolationMode interpolation_mode
+#endif
+
 layout(set = ShaderResourceKind_Buffer, binding = ShaderBufferSlot_PingPong) readonly buffer RF {
 	InputDataType rf[];
 };
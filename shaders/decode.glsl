@@ -34,11 +34,11 @@ void run_decode_large(void)
 	u32 thread_index_x      = gl_LocalInvocationID.x;
 	u32 samples_this_thread = samples_per_thread + u32(thread_index_x < leftover_samples);
 
-	u32 rf_offset = TransmitCount * ChunkChannelCount * gl_WorkGroupID.z + TransmitCount * channel;
+	u32 rf_offset = InputSampleStride * gl_WorkGroupID.z + InputChannelStride * channel;
 
 	for (u32 i = 0; i < samples_this_thread; i++) {
 		u32 index = i * gl_WorkGroupSize.x + thread_index_x;
-		rf[gl_LocalInvocationID.y][index] = RF(rf_buffer).x[rf_offset + index];
+		rf[gl_LocalInvocationID.y][index] = RF(rf_buffer).x[rf_offset + InputTransmitStride * index];
 	}
 
 	barrier();
@@ -120,12 +120,12 @@ void run_decode_small(void)
 {
 	u32 time_sample = gl_GlobalInvocationID.x;
 	u32 channel     = gl_GlobalInvocationID.y;
-	u32 rf_offset   = TransmitCount * ChunkChannelCount * time_sample + TransmitCount * channel;
+	u32 rf_offset   = InputSampleStride * time_sample + InputChannelStride * channel;
 
 	if (time_sample < OutputTransmitStride) {
 		InputDataType rf[TransmitCount];
 		for (s32 j = 0; j < TransmitCount; j++)
-			rf[j] = RF(rf_buffer).x[rf_offset + j];
+			rf[j] = RF(rf_buffer).x[rf_offset + InputTransmitStride * j];
 
 		OutputDataType result[TransmitCount];
 		for (s32 j = 0; j < TransmitCount; j++)
@@ -0,0 +1,162 @@
+/* See LICENSE for license details. */
+/* NOTE(rnp): fused Decode + Demodulate/Filter. decoding is linear across transmits while
+ * filtering is linear along samples so the two commute and can be applied in either order.
+ * each workgroup handles a tile of output samples for every transmit of one channel: rows
+ * of threads demodulate and filter one transmit at a time into shared memory, then the
+ * tile is decoded from shared memory and written once in the layout of the next stage.
+ * this removes the intermediate round trip through the ping pong buffer */
+#if  (InputDataKind == DataKind_Int16Complex         || \
+     (InputDataKind == DataKind_Int16 && Demodulate) || \
+     (InputDataKind == DataKind_Float16 && Demodulate))
+  #define SAMPLE_TYPE f16vec2
+#elif InputDataKind == DataKind_Int16
+  #define SAMPLE_TYPE f16
+#elif InputDataKind == DataKind_Float32 && Demodulate
+  #define SAMPLE_TYPE f32vec2
+#endif
+
+#ifndef SAMPLE_TYPE
+  #define SAMPLE_TYPE InputDataType
+#endif
+
+#define ComplexSampleType (InputDataKind == DataKind_Float32Complex || \
+                           InputDataKind == DataKind_Float16Complex || \
+                           InputDataKind == DataKind_Int16Complex   || \
+                           Demodulate)
+#if ComplexSampleType
+  #define RESULT_TYPE f32vec2
+#else
+  #define RESULT_TYPE f32
+#endif
+
+#if ComplexFilter
+  #define FILTER_TYPE f32vec2
+#else
+  #define FILTER_TYPE f32
+#endif
+
+#if ComplexFilter && ComplexSampleType
+  #define apply_filter(iq, h) complex_mul(f32vec2(iq), f32vec2(h))
+#else
+  #define apply_filter(iq, h) ((iq) * (h))
+#endif
+
+#define FilterHistory (FilterLength - 1)
+
+layout(std430, buffer_reference, buffer_reference_align = 64) restrict readonly buffer Input {
+	InputDataType x[];
+};
+
+layout(set = ShaderResourceKind_Buffer, binding = ShaderBufferSlot_PingPong) buffer Output {
+	OutputDataType output_data[];
+};
+
+layout(std430, buffer_reference, buffer_reference_align = 64) restrict readonly buffer Filter {
+	FILTER_TYPE values[];
+};
+
+layout(std430, buffer_reference) restrict readonly buffer F16 { f16 x[]; };
+
+shared SAMPLE_TYPE rf[gl_WorkGroupSize.y][DecimationRate * gl_WorkGroupSize.x + FilterHistory];
+shared RESULT_TYPE filtered[TransmitCount][gl_WorkGroupSize.x];
+
+f32vec2 complex_mul(f32vec2 a, f32vec2 b)
+{
+	mat2 m = mat2(b.x, b.y, -b.y, b.x);
+	f32vec2 result = m * a;
+	return result;
+}
+
+#if Demodulate
+SAMPLE_TYPE rotate_iq(SAMPLE_TYPE iq, uint index)
+{
+	float arg          = radians(360) * DemodulationFrequency * index / SamplingFrequency;
+	SAMPLE_TYPE result = SAMPLE_TYPE(complex_mul(iq, f32vec2(cos(arg), -sin(arg))));
+	return result;
+}
+#endif
+
+u64 input_address_for(uint channel, uint transmit)
+{
+	u32 in_offset = InputDataKindByteSize * (InputChannelStride * channel + InputTransmitStride * transmit);
+	// NOTE(rnp): see filter.glsl; demodulation loads two elements at a time
+	if (Demodulate)
+		in_offset /= 2;
+	u64 result = input_data + in_offset;
+	return result;
+}
+
+RESULT_TYPE rf_fir(uint row, uint offset)
+{
+	Filter h = Filter(FilterCoefficients);
+	RESULT_TYPE result = RESULT_TYPE(0);
+#if SymmetricFilter
+	result += apply_filter(rf[row][offset], h.values[0]);
+	for (uint j = 1; j < (FilterLength + 1) / 2; j++)
+		result += apply_filter(RESULT_TYPE(rf[row][offset + j]) + RESULT_TYPE(rf[row][offset + FilterLength - j]), h.values[j]);
+	if ((FilterLength % 2) == 0)
+		result += apply_filter(rf[row][offset + FilterLength / 2], h.values[FilterLength / 2]);
+#else
+	for (uint j = 0; j < FilterLength; j++)
+		result += apply_filter(rf[row][offset + j], h.values[j]);
+#endif
+	return result;
+}
+
+void main()
+{
+	uint out_sample = gl_GlobalInvocationID.x;
+	uint column     = gl_LocalInvocationID.x;
+	uint row        = gl_LocalInvocationID.y;
+	uint channel    = gl_WorkGroupID.z;
+
+	uint sample_offset = DecimationRate * gl_WorkGroupID.x * gl_WorkGroupSize.x;
+	bool offset_wraps  = sample_offset < FilterHistory;
+
+	/////////////////////////////////
+	// NOTE: demodulate and filter
+	const SAMPLE_TYPE scale = SAMPLE_TYPE(bool(ComplexFilter) ? 1 : sqrt(2.0f));
+	for (uint transmit_base = 0; transmit_base < TransmitCount; transmit_base += gl_WorkGroupSize.y) {
+		uint transmit = transmit_base + row;
+		if (transmit < TransmitCount) {
+			// NOTE(rnp): broken out to avoid overflow from the subtraction
+			u64 input_address = input_address_for(channel, transmit);
+			input_address += InputDataKindByteSize * sample_offset;
+			input_address -= InputDataKindByteSize * FilterHistory;
+
+			for (uint index = column; index < uint(rf[row].length()); index += gl_WorkGroupSize.x) {
+				SAMPLE_TYPE s = SAMPLE_TYPE(0);
+				if (!offset_wraps || index >= FilterHistory) {
+					s = SAMPLE_TYPE(Input(input_address).x[index]);
+					#if Demodulate
+					s = scale * rotate_iq(s * SAMPLE_TYPE(1, -1), index);
+					#endif
+				}
+				rf[row][index] = s;
+			}
+		}
+		barrier();
+
+		if (transmit < TransmitCount)
+			filtered[transmit][column] = rf_fir(row, DecimationRate * column);
+		barrier();
+	}
+
+	/////////////////////////////////
+	// NOTE: decode
+	if (out_sample < SampleCount / DecimationRate) {
+		F16 h = F16(Hadamard);
+		for (uint transmit = row; transmit < TransmitCount; transmit += gl_WorkGroupSize.y) {
+			RESULT_TYPE result = RESULT_TYPE(0);
+			for (uint j = 0; j < TransmitCount; j++)
+				result += filtered[j][column] * f32(h.x[TransmitCount * j + transmit]);
+			result /= f32(TransmitCount);
+
+			u32 out_offset = OutputChannelStride  * channel +
+			                 OutputTransmitStride * transmit +
+			                 OutputSampleStride   * out_sample +
+			                 output_element_offset;
+			output_data[out_offset] = OutputDataType(result);
+		}
+	}
+}
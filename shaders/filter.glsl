@@ -44,7 +44,7 @@ layout(set = ShaderResourceKind_Buffer, binding = ShaderBufferSlot_PingPong) buf
 };
 
 layout(std430, buffer_reference, buffer_reference_align = 64) restrict readonly buffer Filter {
-	FILTER_TYPE values[FilterLength];
+	FILTER_TYPE values[];
 };
 
 f32vec2 complex_mul(f32vec2 a, f32vec2 b)
@@ -63,7 +63,189 @@ SAMPLE_TYPE rotate_iq(SAMPLE_TYPE iq, uint index)
 }
 #endif
 
-shared SAMPLE_TYPE rf[DecimationRate * gl_WorkGroupSize.x + FilterLength - 1];
+void store_result(uint out_sample, uint channel, uint transmit, RESULT_TYPE result)
+{
+	u32 out_offset = OutputChannelStride  * channel +
+	                 OutputTransmitStride * transmit +
+	                 OutputSampleStride   * out_sample +
+	                 output_element_offset;
+
+	if (BatchSampleCount != 0) {
+		// NOTE(rnp): deinterleave
+		output_data[out_offset] = OutputDataType(result.x);
+		out_offset += BatchSampleCount;
+		output_data[out_offset] = OutputDataType(result.y);
+	} else {
+		output_data[out_offset] = OutputDataType(result);
+	}
+}
+
+u64 input_address_for(uint channel, uint transmit)
+{
+	u32 in_offset = InputDataKindByteSize * (InputChannelStride * channel + InputTransmitStride * transmit);
+	// NOTE(rnp): when demodulating we want to load 2 elements at a time but the
+	// input strides were specified in terms of a single element. therefore we
+	// must divide this by two. by doing this here we can gracefully handle
+	// the case where there are an odd number of samples (this drops the last one).
+	if (Demodulate)
+		in_offset /= 2;
+	u64 result = input_data + in_offset;
+	return result;
+}
+
+#if FastConvolution
+/* NOTE(rnp): overlap-save fast convolution. each workgroup transforms one block of
+ * FFTSize input samples, of which the first FilterLength - 1 overlap the previous block
+ * and are discarded after the inverse transform. the filter spectrum is precomputed on
+ * the host (time reversed to match the direct form and prescaled by 1/FFTSize).
+ * demodulation is applied while loading and decimation while storing. */
+#if ComplexSampleType
+  #define to_complex(s) f32vec2(s)
+  #define from_complex(s) (s)
+#else
+  #define to_complex(s) f32vec2(f32(s), 0)
+  #define from_complex(s) (s).x
+#endif
+
+layout(std430, buffer_reference, buffer_reference_align = 64) restrict readonly buffer FilterSpectrum {
+	f32vec2 values[FFTSize];
+};
+
+shared f32vec2 fft_data[FFTSize];
+
+void fft_shared(bool inverse)
+{
+	uint thread_index = gl_LocalInvocationIndex;
+	uint thread_count = gl_WorkGroupSize.x * gl_WorkGroupSize.y * gl_WorkGroupSize.z;
+
+	int bits = findMSB(FFTSize);
+	for (uint i = thread_index; i < FFTSize; i += thread_count) {
+		uint j = bitfieldReverse(i) >> (32 - bits);
+		if (i < j) {
+			f32vec2 t   = fft_data[i];
+			fft_data[i] = fft_data[j];
+			fft_data[j] = t;
+		}
+	}
+	barrier();
+
+	float sign = inverse ? 1.0f : -1.0f;
+	for (uint half_size = 1; half_size < FFTSize; half_size *= 2) {
+		for (uint butterfly = thread_index; butterfly < FFTSize / 2; butterfly += thread_count) {
+			uint k  = butterfly % half_size;
+			uint i0 = 2 * half_size * (butterfly / half_size) + k;
+			uint i1 = i0 + half_size;
+
+			float   arg = sign * radians(180) * float(k) / float(half_size);
+			f32vec2 t   = complex_mul(fft_data[i1], f32vec2(cos(arg), sin(arg)));
+			f32vec2 u   = fft_data[i0];
+			fft_data[i0] = u + t;
+			fft_data[i1] = u - t;
+		}
+		barrier();
+	}
+}
+
+void main()
+{
+	uint channel  = gl_WorkGroupID.y;
+	uint transmit = gl_WorkGroupID.z;
+
+	uint thread_index = gl_LocalInvocationIndex;
+	uint thread_count = gl_WorkGroupSize.x * gl_WorkGroupSize.y * gl_WorkGroupSize.z;
+
+	uint valid_count = FFTSize - FilterLength + 1;
+	uint block_start = valid_count * gl_WorkGroupID.x;
+
+	u64 input_address = input_address_for(channel, transmit);
+	const SAMPLE_TYPE scale = SAMPLE_TYPE(bool(ComplexFilter) ? 1 : sqrt(2.0f));
+	for (uint i = thread_index; i < FFTSize; i += thread_count) {
+		f32vec2 s = f32vec2(0);
+		// NOTE(rnp): block_start + i - (FilterLength - 1) but broken out to avoid underflow
+		if (block_start + i >= FilterLength - 1) {
+			uint index = block_start + i - (FilterLength - 1);
+			SAMPLE_TYPE sample = SAMPLE_TYPE(Input(input_address).x[index]);
+			#if Demodulate
+			sample = scale * rotate_iq(sample * SAMPLE_TYPE(1, -1), index + FilterLength - 1);
+			#endif
+			s = to_complex(sample);
+		}
+		fft_data[i] = s;
+	}
+	barrier();
+
+	fft_shared(false);
+
+	FilterSpectrum h = FilterSpectrum(FilterCoefficients);
+	for (uint i = thread_index; i < FFTSize; i += thread_count)
+		fft_data[i] = complex_mul(fft_data[i], h.values[i]);
+	barrier();
+
+	fft_shared(true);
+
+	uint out_count = SampleCount / DecimationRate;
+	for (uint i = FilterLength - 1 + thread_index; i < FFTSize; i += thread_count) {
+		uint sample = block_start + i - (FilterLength - 1);
+		if ((sample % DecimationRate) == 0 && (sample / DecimationRate) < out_count)
+			store_result(sample / DecimationRate, channel, transmit, RESULT_TYPE(from_complex(fft_data[i])));
+	}
+}
+#else
+/* NOTE(rnp): direct form, only the decimated outputs are evaluated. an interpolated FIR
+ * (IFIR) filter is applied in two passes over shared memory: first the short image
+ * rejection filter at the input rate, then the sparse model filter, whose nonzero taps
+ * are InterpolationFactor samples apart, at the output rate */
+#if InterpolatedFilter
+  #define ModelFilterSpan ((FilterLength - 1) * InterpolationFactor + 1)
+  #define FilterHistory   (ModelFilterSpan + ImageFilterLength - 2)
+#else
+  #define FilterHistory   (FilterLength - 1)
+#endif
+
+shared SAMPLE_TYPE rf[DecimationRate * gl_WorkGroupSize.x + FilterHistory];
+
+RESULT_TYPE rf_fir(uint offset, u64 coefficients, uint length)
+{
+	Filter h = Filter(coefficients);
+	RESULT_TYPE result = RESULT_TYPE(0);
+#if SymmetricFilter
+	// NOTE(rnp): linear phase taps satisfy h[j] == h[length - j] for 0 < j < length.
+	// folding the mirrored samples first halves the multiplies
+	result += apply_filter(rf[offset], h.values[0]);
+	for (uint j = 1; j < (length + 1) / 2; j++)
+		result += apply_filter(RESULT_TYPE(rf[offset + j]) + RESULT_TYPE(rf[offset + length - j]), h.values[j]);
+	if ((length % 2) == 0)
+		result += apply_filter(rf[offset + length / 2], h.values[length / 2]);
+#else
+	for (uint j = 0; j < length; j++)
+		result += apply_filter(rf[offset + j], h.values[j]);
+#endif
+	return result;
+}
+
+#if InterpolatedFilter
+shared RESULT_TYPE image_rejected[DecimationRate * gl_WorkGroupSize.x + ModelFilterSpan - 1];
+
+RESULT_TYPE model_fir(uint offset)
+{
+	Filter g = Filter(FilterCoefficients);
+	RESULT_TYPE result = RESULT_TYPE(0);
+#if SymmetricFilter
+	result += apply_filter(image_rejected[offset], g.values[0]);
+	for (uint j = 1; j < (FilterLength + 1) / 2; j++) {
+		RESULT_TYPE folded = image_rejected[offset + InterpolationFactor * j] +
+		                     image_rejected[offset + InterpolationFactor * (FilterLength - j)];
+		result += apply_filter(folded, g.values[j]);
+	}
+	if ((FilterLength % 2) == 0)
+		result += apply_filter(image_rejected[offset + InterpolationFactor * FilterLength / 2], g.values[FilterLength / 2]);
+#else
+	for (uint j = 0; j < FilterLength; j++)
+		result += apply_filter(image_rejected[offset + InterpolationFactor * j], g.values[j]);
+#endif
+	return result;
+}
+#endif
 
 void main()
 {
@@ -76,20 +258,12 @@ void main()
 	/////////////////////////
 	// NOTE: sample caching
 	{
-		bool offset_wraps = (DecimationRate * gl_WorkGroupID.x * gl_WorkGroupSize.x) < (FilterLength - 1);
-
-		u32 in_offset = InputDataKindByteSize * (InputChannelStride * channel + InputTransmitStride * transmit);
-		// NOTE(rnp): when demodulating we want to load 2 elements at a time but the
-		// input strides were specified in terms of a single element. therefore we
-		// must divide this by two. by doing this here we can gracefully handle
-		// the case where there are an odd number of samples (this drops the last one).
-		if (Demodulate)
-			in_offset /= 2;
+		bool offset_wraps = (DecimationRate * gl_WorkGroupID.x * gl_WorkGroupSize.x) < FilterHistory;
 
 		// NOTE(rnp): broken out to avoid overflow from the subtraction
-		u64 input_address = input_data + in_offset;
+		u64 input_address = input_address_for(channel, transmit);
 		input_address += InputDataKindByteSize * (DecimationRate * gl_WorkGroupID.x * gl_WorkGroupSize.x);
-		input_address -= InputDataKindByteSize * (FilterLength - 1);
+		input_address -= InputDataKindByteSize * FilterHistory;
 
 		uint total_samples       = rf.length();
 		uint samples_per_thread  = total_samples / thread_count;
@@ -100,7 +274,7 @@ void main()
 		for (uint i = 0; i < samples_this_thread; i++) {
 			uint index = thread_count * i + thread_index;
 			SAMPLE_TYPE s = SAMPLE_TYPE(0);
-			if (!offset_wraps || index >= FilterLength - 1) {
+			if (!offset_wraps || index >= FilterHistory) {
 				s = SAMPLE_TYPE(Input(input_address).x[index]);
 				#if Demodulate
 				s = scale * rotate_iq(s * SAMPLE_TYPE(1, -1), index);
@@ -111,25 +285,19 @@ void main()
 	}
 	barrier();
 
-	Filter f = Filter(FilterCoefficients);
+	#if InterpolatedFilter
+	for (uint index = thread_index; index < uint(image_rejected.length()); index += thread_count)
+		image_rejected[index] = rf_fir(index, ImageFilterCoefficients, ImageFilterLength);
+	barrier();
+	#endif
+
 	if (out_sample < SampleCount / DecimationRate) {
-		RESULT_TYPE result = RESULT_TYPE(0);
-		u32 offset = DecimationRate * thread_index;
-		for (u32 j = 0; j < FilterLength; j++)
-			result += apply_filter(rf[offset + j], f.values[j]);
-
-		u32 out_offset = OutputChannelStride  * channel +
-		                 OutputTransmitStride * transmit +
-		                 OutputSampleStride   * out_sample +
-		                 output_element_offset;
-
-		if (BatchSampleCount != 0) {
-			// NOTE(rnp): deinterleave
-			output_data[out_offset] = OutputDataType(result.x);
-			out_offset += BatchSampleCount;
-			output_data[out_offset] = OutputDataType(result.y);
-		} else {
-			output_data[out_offset] = OutputDataType(result);
-		}
+		#if InterpolatedFilter
+		RESULT_TYPE result = model_fir(DecimationRate * thread_index);
+		#else
+		RESULT_TYPE result = rf_fir(DecimationRate * thread_index, FilterCoefficients, FilterLength);
+		#endif
+		store_result(out_sample, channel, transmit, result);
 	}
 }
+#endif
@@ -0,0 +1,148 @@
+/* See LICENSE for license details. */
+/* NOTE(rnp): analytic signal generation for real RF data. the default path transforms
+ * a whole line (all samples of one channel and transmit) in shared memory, zeroes the
+ * negative frequencies, doubles the positive ones and transforms back. the FIR path
+ * instead applies a windowed Hilbert transformer and is used for lines which are too
+ * long for shared memory or when explicitly requested */
+layout(std430, buffer_reference, buffer_reference_align = 64) restrict readonly buffer Input {
+	InputDataType x[];
+};
+
+layout(set = ShaderResourceKind_Buffer, binding = ShaderBufferSlot_PingPong) buffer Output {
+	OutputDataType output_data[];
+};
+
+layout(std430, buffer_reference, buffer_reference_align = 64) restrict readonly buffer Filter {
+	f32 values[];
+};
+
+f32vec2 complex_mul(f32vec2 a, f32vec2 b)
+{
+	mat2 m = mat2(b.x, b.y, -b.y, b.x);
+	f32vec2 result = m * a;
+	return result;
+}
+
+f32 load_sample(uint channel, uint transmit, uint sample)
+{
+	uint index  = InputChannelStride * channel + InputTransmitStride * transmit + InputSampleStride * sample;
+	f32  result = f32(Input(input_data).x[index]);
+	return result;
+}
+
+void store_sample(uint channel, uint transmit, uint sample, f32vec2 value)
+{
+	uint out_offset = OutputChannelStride  * channel +
+	                  OutputTransmitStride * transmit +
+	                  OutputSampleStride   * sample +
+	                  output_element_offset;
+	output_data[out_offset] = OutputDataType(value);
+}
+
+#if FIRApproximation
+/* NOTE(rnp): the ideal transformer h[k] = 2 / (πk) for odd k and 0 otherwise. the taps
+ * are antisymmetric so only the odd positive half is evaluated:
+ *   H{x}[n] = Σ h[k] (x[n - k] - x[n + k]), k = 1, 3, ..., FIRLength / 2 */
+#define FIRHalfLength (FIRLength / 2)
+
+shared f32 rf[gl_WorkGroupSize.x + 2 * FIRHalfLength];
+
+void main()
+{
+	uint sample   = gl_GlobalInvocationID.x;
+	uint channel  = gl_GlobalInvocationID.y;
+	uint transmit = gl_GlobalInvocationID.z;
+
+	uint thread_index = gl_LocalInvocationIndex;
+	uint thread_count = gl_WorkGroupSize.x * gl_WorkGroupSize.y * gl_WorkGroupSize.z;
+
+	uint base_sample = gl_WorkGroupID.x * gl_WorkGroupSize.x;
+	for (uint i = thread_index; i < uint(rf.length()); i += thread_count) {
+		f32 s = 0;
+		// NOTE(rnp): base_sample + i - FIRHalfLength but broken out to avoid underflow
+		if (base_sample + i >= FIRHalfLength && base_sample + i - FIRHalfLength < SampleCount)
+			s = load_sample(channel, transmit, base_sample + i - FIRHalfLength);
+		rf[i] = s;
+	}
+	barrier();
+
+	if (sample < SampleCount) {
+		Filter h = Filter(FIRCoefficients);
+		uint center = thread_index + FIRHalfLength;
+		f32  result = 0;
+		for (uint k = 1; k <= FIRHalfLength; k += 2)
+			result += h.values[FIRHalfLength + k] * (rf[center - k] - rf[center + k]);
+		store_sample(channel, transmit, sample, f32vec2(rf[center], result));
+	}
+}
+
+#else
+shared f32vec2 fft_data[FFTSize];
+
+void fft_shared(bool inverse)
+{
+	uint thread_index = gl_LocalInvocationIndex;
+	uint thread_count = gl_WorkGroupSize.x * gl_WorkGroupSize.y * gl_WorkGroupSize.z;
+
+	int bits = findMSB(FFTSize);
+	for (uint i = thread_index; i < FFTSize; i += thread_count) {
+		uint j = bitfieldReverse(i) >> (32 - bits);
+		if (i < j) {
+			f32vec2 t   = fft_data[i];
+			fft_data[i] = fft_data[j];
+			fft_data[j] = t;
+		}
+	}
+	barrier();
+
+	float sign = inverse ? 1.0f : -1.0f;
+	for (uint half_size = 1; half_size < FFTSize; half_size *= 2) {
+		for (uint butterfly = thread_index; butterfly < FFTSize / 2; butterfly += thread_count) {
+			uint k  = butterfly % half_size;
+			uint i0 = 2 * half_size * (butterfly / half_size) + k;
+			uint i1 = i0 + half_size;
+
+			float   arg = sign * radians(180) * float(k) / float(half_size);
+			f32vec2 t   = complex_mul(fft_data[i1], f32vec2(cos(arg), sin(arg)));
+			f32vec2 u   = fft_data[i0];
+			fft_data[i0] = u + t;
+			fft_data[i1] = u - t;
+		}
+		barrier();
+	}
+}
+
+void main()
+{
+	uint channel  = gl_WorkGroupID.y;
+	uint transmit = gl_WorkGroupID.z;
+
+	uint thread_index = gl_LocalInvocationIndex;
+	uint thread_count = gl_WorkGroupSize.x * gl_WorkGroupSize.y * gl_WorkGroupSize.z;
+
+	for (uint i = thread_index; i < FFTSize; i += thread_count) {
+		f32 s = 0;
+		if (i < SampleCount)
+			s = load_sample(channel, transmit, i);
+		fft_data[i] = f32vec2(s, 0);
+	}
+	barrier();
+
+	fft_shared(false);
+
+	// NOTE(rnp): DC and Nyquist are kept, positive frequencies doubled, negative removed.
+	// the 1 / FFTSize inverse transform scale is folded in here
+	for (uint i = thread_index; i < FFTSize; i += thread_count) {
+		f32 weight = 0;
+		if (i == 0 || i == FFTSize / 2) weight = 1;
+		else if (i < FFTSize / 2)       weight = 2;
+		fft_data[i] *= weight / f32(FFTSize);
+	}
+	barrier();
+
+	fft_shared(true);
+
+	for (uint i = thread_index; i < SampleCount; i += thread_count)
+		store_sample(channel, transmit, i, fft_data[i]);
+}
+#endif
@@ -0,0 +1,293 @@
+/* See LICENSE for license details. */
+/* NOTE(rnp): benchmark and self check for the CPU reference beamformer. a synthetic
+ * acquisition is beamformed with a single lane and with the requested lane count; the two
+ * outputs must match bit for bit. per stage times are then reported for the multi lane
+ * context. no GPU or running beamformer is needed */
+#define BASE_EXPORT           function
+#define BASE_IMPORT           function
+#define BEAMFORMER_LIB_EXPORT function
+#include "base_platform.h"
+#include "ogl_beamformer_lib.c"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define RF_TIME_SAMPLES   2048
+#define CHANNEL_COUNT     64
+#define ACQUISITION_COUNT 16
+#define OUTPUT_POINTS_X   128
+#define OUTPUT_POINTS_Z   256
+#define SAMPLING_FREQUENCY 40e6f
+#define CENTER_FREQUENCY   5e6f
+
+typedef struct {
+	u32 lane_count;
+	u32 frame_count;
+	b32 demodulate;
+
+	i32 acquisition_kind;
+	i32 interpolation_mode;
+} Options;
+
+#define die(...) die_((char *)__func__, __VA_ARGS__)
+function no_return void
+die_(char *function_name, char *format, ...)
+{
+	if (function_name)
+		fprintf(stderr, "%s: ", function_name);
+
+	va_list ap;
+
+	va_start(ap, format);
+	vfprintf(stderr, format, ap);
+	va_end(ap);
+
+	os_exit(1);
+}
+
+#include "cpu_platform.c"
+
+#define shift_n(v, c, n) v += n, c -= n
+#define shift(v, c)   shift_n(v, c, 1)
+
+read_only global str8 interpolation_mode_names[] = {
+	str8_comp("nearest"),
+	str8_comp("linear"),
+	str8_comp("cubic"),
+};
+
+read_only global BeamformerAcquisitionKind benchmark_acquisition_kinds[] = {
+	BeamformerAcquisitionKind_FORCES,
+	BeamformerAcquisitionKind_HERCULES,
+	BeamformerAcquisitionKind_RCA_TPW,
+};
+
+function void
+usage(char *argv0)
+{
+	die("%s [--lanes n] [--frames n] [--demodulate] [--kind forces|hercules|tpw] "
+	    "[--interpolation nearest|linear|cubic]\n", argv0);
+}
+
+function i32
+option_index(str8 *names, i32 count, char *value)
+{
+	i32 result = -1;
+	for (i32 i = 0; i < count && result < 0; i++)
+		if (str8_match(names[i], str8_from_c_str(value), StringMatchFlag_CaseInsensitive))
+			result = i;
+	return result;
+}
+
+function Options
+parse_argv(i32 argc, char *argv[])
+{
+	Options result = {
+		.lane_count         = os_system_info()->logical_processor_count,
+		.frame_count        = 4,
+		.acquisition_kind   = -1,
+		.interpolation_mode = -1,
+	};
+
+	char *argv0 = argv[0];
+	shift(argv, argc);
+
+	while (argc > 0) {
+		str8 arg = str8_from_c_str(*argv);
+		shift(argv, argc);
+
+		if (str8_equal(arg, str8("--demodulate"))) {
+			result.demodulate = 1;
+		} else if (str8_equal(arg, str8("--lanes")) && argc) {
+			result.lane_count = Max(1, (u32)atoi(*argv));
+			shift(argv, argc);
+		} else if (str8_equal(arg, str8("--frames")) && argc) {
+			result.frame_count = Max(1, (u32)atoi(*argv));
+			shift(argv, argc);
+		} else if (str8_equal(arg, str8("--kind")) && argc) {
+			result.acquisition_kind = option_index((str8 *)beamformer_acquisition_kind_strings,
+			                                       countof(beamformer_acquisition_kind_strings), *argv);
+			if (result.acquisition_kind < 0) usage(argv0);
+			shift(argv, argc);
+		} else if (str8_equal(arg, str8("--interpolation")) && argc) {
+			result.interpolation_mode = option_index((str8 *)interpolation_mode_names,
+			                                         countof(interpolation_mode_names), *argv);
+			if (result.interpolation_mode < 0) usage(argv0);
+			shift(argv, argc);
+		} else {
+			usage(argv0);
+		}
+	}
+
+	return result;
+}
+
+/* NOTE(rnp): windowed tone bursts with a deterministic noise floor; the content only
+ * needs to exercise every code path, the throughput does not depend on it */
+function i16 *
+generate_rf_data(Arena *arena, u32 sample_count, u32 line_count)
+{
+	i16 *result = push_array(arena, i16, (u64)sample_count * line_count);
+	u32 state   = 0x9E3779B9u;
+	for (u32 line = 0; line < line_count; line++) {
+		u32 burst_start = 128 + (line * 37) % (sample_count / 2);
+		for (u32 i = 0; i < sample_count; i++) {
+			state = state * 1664525u + 1013904223u;
+			f32 s = (f32)((i32)(state >> 20) - 2048) / 16.0f;
+			if (i >= burst_start && i < burst_start + 64) {
+				f32 t = (f32)(i - burst_start);
+				s += 4096.0f * sin_f32(2 * PI * CENTER_FREQUENCY * t / SAMPLING_FREQUENCY)
+				           * sin_f32(PI * t / 64.0f);
+			}
+			result[(u64)line * sample_count + i] = (i16)s;
+		}
+	}
+	return result;
+}
+
+function BeamformerCPUPlan *
+make_plan(Arena *arena, BeamformerAcquisitionKind kind, BeamformerInterpolationMode interpolation,
+          b32 demodulate)
+{
+	BeamformerCPUPlanInfo info = {.data_kind = BeamformerDataKind_Int16};
+	BeamformerParameters *bp   = &info.parameters;
+
+	bp->acquisition_kind   = kind;
+	bp->acquisition_count  = ACQUISITION_COUNT;
+	bp->channel_count      = CHANNEL_COUNT;
+	bp->sample_count       = RF_TIME_SAMPLES;
+	bp->sampling_frequency = SAMPLING_FREQUENCY;
+	bp->speed_of_sound     = 1540.0f;
+	bp->f_number           = 0.5f;
+	bp->interpolation_mode = interpolation;
+	bp->xdc_element_pitch  = (v2){{0.1e-3f, 0.1e-3f}};
+	bp->xdc_transform      = m4_translation((v3){0});
+	bp->decimation_rate    = 1;
+
+	iv3 points = {{OUTPUT_POINTS_X, 1, OUTPUT_POINTS_Z}};
+	bp->das_voxel_transform = das_transform((v3){{-3.2e-3f, 2e-3f, 0}}, (v3){{3.2e-3f, 25e-3f, 0}}, &points);
+	bp->output_points.xyz   = points;
+	bp->output_points.w     = 1;
+
+	bp->single_focus       = 1;
+	bp->single_orientation = 1;
+	bp->focal_vector       = (v2){{0, inf32()}};
+	bp->transmit_receive_orientation = (BeamformerRCAOrientation_Rows << 4) | BeamformerRCAOrientation_Columns;
+
+	if (kind == BeamformerAcquisitionKind_RCA_TPW) {
+		BeamformerComputeArrayParameters *ap = push_struct(arena, BeamformerComputeArrayParameters);
+		for (u32 i = 0; i < ACQUISITION_COUNT; i++)
+			ap->focal_vectors[i] = (v2){{-15.0f + 30.0f * (f32)i / (ACQUISITION_COUNT - 1), inf32()}};
+		bp->single_focus      = 0;
+		info.array_parameters = ap;
+	} else {
+		bp->decode_mode = BeamformerDecodeMode_Hadamard;
+	}
+
+	info.stages[info.stage_count++] = BeamformerShaderKind_Decode;
+	if (demodulate) {
+		u32 length = 36;
+		bp->demodulation_frequency = CENTER_FREQUENCY;
+		info.filters[info.stage_count] = (BeamformerCPUFilter){
+			.data       = kaiser_low_pass_filter(arena, 0.5f * CENTER_FREQUENCY, SAMPLING_FREQUENCY / 2, 5.65f, (i32)length),
+			.length     = (i32)length,
+			.time_delay = (f32)length / 2 / (SAMPLING_FREQUENCY / 2),
+		};
+		info.stages[info.stage_count++] = BeamformerShaderKind_Demodulate;
+	}
+	info.stages[info.stage_count++] = BeamformerShaderKind_DAS;
+
+	BeamformerCPUPlan *result = beamformer_cpu_plan(arena, &info);
+	if (result->error.length)
+		die("failed to plan: %.*s\n", (i32)result->error.length, result->error.data);
+
+	return result;
+}
+
+/* NOTE(rnp): arena must not be the one backing the contexts; they grow their buffers on
+ * demand and the plan memory is released after each study */
+function b32
+execute_study(Arena *arena, BeamformerCPUContext *single, BeamformerCPUContext *multi, i16 *rf_data,
+              BeamformerAcquisitionKind kind, BeamformerInterpolationMode interpolation, Options *options)
+{
+	Temp temp = temp_begin(arena);
+	BeamformerCPUPlan *plan = make_plan(arena, kind, interpolation, options->demodulate);
+
+	u64 output_floats = beamformer_cpu_output_floats(plan);
+	f32 *reference = push_array(arena, f32, output_floats);
+	f32 *output    = push_array(arena, f32, output_floats);
+
+	beamformer_cpu_beamform(single, plan, rf_data, reference);
+	beamformer_cpu_beamform(multi,  plan, rf_data, output);
+	b32 result = memory_equal(reference, output, output_floats * sizeof(f32));
+
+	memory_clear(multi->stage_ticks, 0, sizeof(multi->stage_ticks));
+	for (u32 i = 0; i < options->frame_count; i++)
+		beamformer_cpu_beamform(multi, plan, rf_data, output);
+
+	f64 frequency = os_timer_frequency();
+	f64 frames    = (f64)options->frame_count;
+	f64 samples   = (f64)RF_TIME_SAMPLES * CHANNEL_COUNT * ACQUISITION_COUNT;
+	f64 voxels    = (f64)output_floats / (plan->iq ? 2 : 1);
+	f64 total     = 0;
+
+	printf("%.*s / %.*s%s: %s\n",
+	       (i32)beamformer_acquisition_kind_strings[kind].length, beamformer_acquisition_kind_strings[kind].data,
+	       (i32)interpolation_mode_names[interpolation].length, interpolation_mode_names[interpolation].data,
+	       options->demodulate ? " / demodulate" : "", result ? "PASS" : "FAIL (lane results differ)");
+	for (u32 i = 0; i < plan->stage_count; i++) {
+		BeamformerCPUStage stage = plan->stages[i].kind;
+		f64 seconds = (f64)multi->stage_ticks[stage] / frequency / frames;
+		total += seconds;
+		if (stage == BeamformerCPUStage_DAS) {
+			printf("  %-12.*s %9.3f [ms] %9.2f [MVoxel/s]\n", (i32)beamformer_cpu_stage_names[stage].length,
+			       beamformer_cpu_stage_names[stage].data, seconds * 1e3, voxels / seconds * 1e-6);
+		} else {
+			printf("  %-12.*s %9.3f [ms] %9.2f [MSample/s]\n", (i32)beamformer_cpu_stage_names[stage].length,
+			       beamformer_cpu_stage_names[stage].data, seconds * 1e3, samples / seconds * 1e-6);
+		}
+	}
+	printf("  %-12s %9.3f [ms] %9.2f [MVoxel/s]\n", "Total", total * 1e3, voxels / total * 1e-6);
+
+	temp_end(temp);
+
+	return result;
+}
+
+BASE_IMPORT void
+entry_point(i32 argc, char *argv[])
+{
+	Arena *arena      = arena_create(.reserve_size = GB(1));
+	Arena *plan_arena = arena_create();
+	g_platform_arena  = arena;
+
+	Options options = parse_argv(argc, argv);
+
+	i16 *rf_data = generate_rf_data(arena, RF_TIME_SAMPLES, CHANNEL_COUNT * ACQUISITION_COUNT);
+
+	BeamformerCPUContext *single = beamformer_cpu_context_create(arena, 1);
+	BeamformerCPUContext *multi  = beamformer_cpu_context_create(arena, options.lane_count);
+
+	printf("CPU beamformer: %u lanes, %u-wide SIMD, %u frames\n", options.lane_count, CPU_SIMD_WIDTH,
+	       options.frame_count);
+
+	b32 result = 1;
+	for (u32 k = 0; k < countof(benchmark_acquisition_kinds); k++) {
+		BeamformerAcquisitionKind kind = benchmark_acquisition_kinds[k];
+		if (options.acquisition_kind >= 0 && options.acquisition_kind != (i32)kind)
+			continue;
+		for (i32 mode = 0; mode < BeamformerInterpolationMode_Count; mode++) {
+			if (options.interpolation_mode >= 0 && options.interpolation_mode != mode)
+				continue;
+			result &= execute_study(plan_arena, single, multi, rf_data, kind, (BeamformerInterpolationMode)mode, &options);
+		}
+	}
+
+	beamformer_cpu_context_destroy(multi);
+	beamformer_cpu_context_destroy(single);
+
+	/* NOTE(rnp): os_exit() skips the stdio flush */
+	fflush(stdout);
+	if (!result) os_exit(1);
+}
@@ -0,0 +1,115 @@
+/* See LICENSE for license details. */
+/* NOTE(rnp): the thread and barrier primitives the CPU beamformer needs, normally provided
+ * by main_linux.c/main_w32.c, for test programs. g_platform_arena must be set before any
+ * beamformer_cpu_context_create(). also provides the mapping from library filter parameters
+ * to CPU filters */
+global Arena *g_platform_arena;
+
+#if OS_LINUX
+
+function OSThread
+os_create_thread(const char *name, void *user_context, os_thread_entry_point_fn *fn)
+{
+	pthread_t thread;
+	pthread_create(&thread, 0, (void *)fn, (void *)user_context);
+	OSThread result = {(u64)thread};
+	return result;
+}
+
+function OSBarrier
+os_barrier_alloc(u32 count)
+{
+	pthread_barrier_t *barrier = push_struct(g_platform_arena, pthread_barrier_t);
+	pthread_barrier_init(barrier, 0, count);
+	OSBarrier result = {(u64)barrier};
+	return result;
+}
+
+function void
+os_barrier_enter(OSBarrier barrier)
+{
+	pthread_barrier_t *b = (pthread_barrier_t *)barrier.value[0];
+	if (b) pthread_barrier_wait(b);
+}
+
+#elif OS_WINDOWS
+
+typedef struct {
+	u32 reserved1;
+	u32 reserved2;
+	u64 Reserved3[2];
+	u32 reserved4;
+	u32 reserved5;
+} w32_synchronization_barrier;
+
+W32(u64) CreateThread(iptr, u64, iptr, iptr, u32, u32 *);
+W32(b32) EnterSynchronizationBarrier(w32_synchronization_barrier *, u32);
+W32(b32) InitializeSynchronizationBarrier(w32_synchronization_barrier *, i32, i32);
+
+function OSThread
+os_create_thread(const char *name, void *user_context, os_thread_entry_point_fn *fn)
+{
+	OSThread result = {CreateThread(0, 0, (iptr)fn, (iptr)user_context, 0, 0)};
+	return result;
+}
+
+function OSBarrier
+os_barrier_alloc(u32 count)
+{
+	w32_synchronization_barrier *barrier = push_struct(g_platform_arena, w32_synchronization_barrier);
+	InitializeSynchronizationBarrier(barrier, (i32)count, -1);
+	OSBarrier result = {(u64)barrier};
+	return result;
+}
+
+function void
+os_barrier_enter(OSBarrier barrier)
+{
+	w32_synchronization_barrier *b = (w32_synchronization_barrier *)barrier.value[0];
+	if (b) EnterSynchronizationBarrier(b, 0);
+}
+
+#else
+#error Unsupported Platform
+#endif
+
+#include "threads.c"
+#include "beamformer_cpu.c"
+
+/* NOTE(rnp): same filters as beamformer_filter_create() for the direct form cases */
+function BeamformerCPUFilter
+cpu_filter_from_parameters(Arena *arena, BeamformerFilterParameters *fp)
+{
+	BeamformerCPUFilter result = {.complex = fp->complex};
+	f32 fs = fp->sampling_frequency;
+	switch (fp->kind) {
+	case BeamformerFilterKind_Kaiser:{
+		f32 *taps = kaiser_low_pass_filter(arena, fp->kaiser.cutoff_frequency, fs, fp->kaiser.beta,
+		                                   (i32)fp->kaiser.length);
+		result.length     = (i32)fp->kaiser.length;
+		result.time_delay = (f32)result.length / 2.0f / fs;
+		result.data       = taps;
+		if (fp->complex) {
+			v2 *complex_taps = push_array(arena, v2, result.length);
+			for (i32 i = 0; i < result.length; i++)
+				complex_taps[i].x = taps[i];
+			result.data = complex_taps;
+		}
+	}break;
+	case BeamformerFilterKind_MatchedChirp:{
+		typeof(fp->matched_chirp) *mc = &fp->matched_chirp;
+		result.length = (i32)(mc->duration * fs);
+		if (fp->complex) {
+			v2 *taps = baseband_chirp(arena, mc->min_frequency, mc->max_frequency, fs, result.length, 1, 0.5f);
+			result.time_delay = complex_filter_first_moment(taps, result.length, fs);
+			result.data       = taps;
+		} else {
+			f32 *taps = rf_chirp(arena, mc->min_frequency, mc->max_frequency, fs, result.length, 1);
+			result.time_delay = real_filter_first_moment(taps, result.length, fs);
+			result.data       = taps;
+		}
+	}break;
+	InvalidDefaultCase;
+	}
+	return result;
+}
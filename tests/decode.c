@@ -23,6 +23,7 @@ typedef struct {
 	b32 once;
 	b32 dump;
 	b32 full_aperture;
+	b32 demodulate;
 
 	u32 warmup_count;
 
@@ -79,10 +80,11 @@ os_make_directory(char *name)
 function void
 usage(char *argv0)
 {
-	die("%s [--loop] [--once] [--full-aperture] [--warmup n] [--dump dir]\n"
+	die("%s [--loop] [--once] [--full-aperture] [--demodulate] [--warmup n] [--dump dir]\n"
 	    "    --loop:          reupload data forever\n"
 	    "    --once:          only run a single frame\n"
 	    "    --full-aperture: recieve on full 256 channel aperture\n"
+	    "    --demodulate:    Demodulate + Decode; compare fused and unfused stages\n"
 	    "    --warmup:        warmup with n runs\n"
 	    "    --dump:          dump output stats files to dir\n",
 	    argv0);
@@ -104,6 +106,8 @@ parse_argv(i32 argc, char *argv[])
 			result.loop = 1;
 		} else if (str8_equal(arg, str8("--full-aperture"))) {
 			result.full_aperture = 1;
+		} else if (str8_equal(arg, str8("--demodulate"))) {
+			result.demodulate = 1;
 		} else if (str8_equal(arg, str8("--dump"))) {
 			if (argc) {
 				result.outdir = *argv;
@@ -187,7 +191,7 @@ dump_stats(BeamformerComputeStatsTable *stats, Options *options, u32 transmit_co
 }
 
 function void
-send_parameters(Options *options, u32 transmit_count)
+send_parameters(Options *options, u32 transmit_count, b32 unfused)
 {
 	BeamformerParameters bp = {0};
 	bp.decode_mode    = BeamformerDecodeMode_Hadamard;
@@ -198,6 +202,12 @@ send_parameters(Options *options, u32 transmit_count)
 	bp.acquisition_count = dec_data_dim.z;
 
 	bp.raw_data_dimensions = raw_data_dim(transmit_count, full_aperture);
+
+	if (options->demodulate) {
+		bp.sampling_frequency     = 40e6f;
+		bp.demodulation_frequency = 5e6f;
+		bp.decimation_rate        = 2;
+	}
 	beamformer_push_parameters(&bp);
 
 	/* NOTE(rnp): use real channel mapping so that we still get ~random~ access pattern */
@@ -221,15 +231,31 @@ send_parameters(Options *options, u32 transmit_count)
 	};
 	beamformer_push_channel_mapping(channel_mapping, countof(channel_mapping));
 
-	i32 shader_stages = BeamformerShaderKind_Decode;
-	beamformer_push_pipeline(&shader_stages, 1, BeamformerDataKind_Int16);
+	if (options->demodulate) {
+		BeamformerFilterParameters filter = {
+			.kind               = BeamformerFilterKind_Kaiser,
+			.sampling_frequency = bp.sampling_frequency / 2,
+		};
+		filter.kaiser.beta             = 5.65f;
+		filter.kaiser.cutoff_frequency = 0.5f * bp.demodulation_frequency;
+		filter.kaiser.length           = 36;
+		beamformer_create_filter(&filter, 0, 0);
+
+		i32 shader_stages[] = {BeamformerShaderKind_Demodulate, BeamformerShaderKind_Decode};
+		beamformer_push_pipeline(shader_stages, countof(shader_stages), BeamformerDataKind_Int16);
+		beamformer_set_pipeline_stage_parameters(0, 0);
+		beamformer_set_pipeline_stage_parameters(1, unfused);
+	} else {
+		i32 shader_stages = BeamformerShaderKind_Decode;
+		beamformer_push_pipeline(&shader_stages, 1, BeamformerDataKind_Int16);
+	}
 	beamformer_set_global_timeout(1000);
 }
 
 function f32
-execute_study(Options *options, u32 transmit_count, i16 *restrict data)
+execute_study(Options *options, u32 transmit_count, i16 *restrict data, b32 unfused)
 {
-	send_parameters(options, transmit_count);
+	send_parameters(options, transmit_count, unfused);
 	u32 data_size = data_size_for_transmit_count(transmit_count, options->full_aperture);
 	for (u32 i = 0; !g_should_exit && i < options->warmup_count; i++)
 		send_frame(data, data_size);
@@ -249,6 +275,29 @@ print_result(u32 transmit_count, f32 time)
 	printf("decode %3u | %uF Average: %8.3f [ms]\n", transmit_count, (u32)AVERAGE_SAMPLES, time * 1e3);
 }
 
+/* NOTE(rnp): stages are reported as planned by the beamformer so fusion shows up here */
+function void
+print_plan(str8 label)
+{
+	BeamformerComputeStatsTable stats = {0};
+	if (beamformer_compute_timings(&stats, 1000)) {
+		printf("    %-8.*s:", (i32)label.length, (char *)label.data);
+		for (u64 it = 0; it < stats.shader_count; it++) {
+			str8 name = beamformer_shader_names[stats.shader_ids[it]];
+			printf(" %.*s", (i32)name.length, (char *)name.data);
+		}
+		printf("\n");
+	}
+}
+
+function void
+print_fusion_result(u32 transmit_count, f32 fused_time, f32 unfused_time)
+{
+	printf("demodulate + decode %3u | %uF Average: fused %8.3f [ms] | unfused %8.3f [ms] | %5.2fx\n",
+	       transmit_count, (u32)AVERAGE_SAMPLES, fused_time * 1e3, unfused_time * 1e3,
+	       unfused_time / fused_time);
+}
+
 function void
 sigint(i32 _signo)
 {
@@ -278,19 +327,28 @@ entry_point(i32 argc, char *argv[])
 	if (options.loop) {
 		for (;!g_should_exit;) {
 			u32 transmit_count = decode_transmit_counts[0];
-			f32 time = execute_study(&options, transmit_count, data);
+			f32 time = execute_study(&options, transmit_count, data, 0);
 			if (!g_should_exit) print_result(transmit_count, time);
 		}
 	} else if (options.once) {
 		u32 transmit_count = decode_transmit_counts[0];
 		u32 data_size = data_size_for_transmit_count(transmit_count, options.full_aperture);
-		send_parameters(&options, transmit_count);
+		send_parameters(&options, transmit_count, 0);
 		send_frame(data, data_size);
 	} else {
 		BeamformerComputeStatsTable stats = {0};
 		for (i64 i = 0; i < countof(decode_transmit_counts); i++) {
 			u32 transmit_count = decode_transmit_counts[i];
-			f32 time = execute_study(&options, transmit_count, data);
+			if (options.demodulate) {
+				f32 unfused_time = execute_study(&options, transmit_count, data, 1);
+				if (!g_should_exit) print_plan(str8("unfused"));
+				f32 fused_time   = execute_study(&options, transmit_count, data, 0);
+				if (!g_should_exit) print_plan(str8("fused"));
+				if (!g_should_exit) print_fusion_result(transmit_count, fused_time, unfused_time);
+				continue;
+			}
+
+			f32 time = execute_study(&options, transmit_count, data, 0);
 			if (options.dump) {
 				beamformer_compute_timings(&stats, 1000);
 				dump_stats(&stats, &options, transmit_count);
@@ -0,0 +1,424 @@
+/* See LICENSE for license details. */
+/* NOTE(rnp): stress test for the pooled GPU memory suballocator (see buddy.c and vulkan.c).
+ * parameter churn is simulated on the CPU: each frame a random subset of the beamformer's
+ * buffers is released and reallocated with new sizes, the same as changing the acquisition
+ * or output parameters. released buffers only return to their block after --in-flight more
+ * frames, like the deferred frees waiting on timeline values. buffers larger than half a
+ * block get a dedicated allocation just like in vulkan.c. every allocation is checked
+ * against a shadow bitmap for overlap and the pool must be empty at the end. the number of
+ * driver allocations is compared against giving every buffer its own allocation */
+#define BASE_EXPORT           function
+#define BASE_IMPORT           function
+#define BEAMFORMER_LIB_EXPORT function
+#include "base_platform.h"
+#include "ogl_beamformer_lib.c"
+#include "buddy.c"
+
+#include <math.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define CHURN_MAX_BLOCKS (256)
+
+typedef struct {
+	u64 block_size;
+	u32 frames;
+	u32 in_flight;
+	u32 churn;
+	u64 seed;
+} Options;
+
+#define die(...) die_((char *)__func__, __VA_ARGS__)
+function no_return void
+die_(char *function_name, char *format, ...)
+{
+	if (function_name)
+		fprintf(stderr, "%s: ", function_name);
+
+	va_list ap;
+
+	va_start(ap, format);
+	vfprintf(stderr, format, ap);
+	va_end(ap);
+
+	os_exit(1);
+}
+
+#include "cpu_platform.c"
+
+#define shift_n(v, c, n) v += n, c -= n
+#define shift(v, c)   shift_n(v, c, 1)
+
+/* NOTE(rnp): rough mix of the buffers the beamformer keeps: RF input, decoded data,
+ * beamformed frames and averages, and the small parameter arrays */
+#define CHURN_RESOURCE_LIST \
+	X(RF,            MB(8),  MB(192), 1) \
+	X(Decoded,       MB(4),  MB(128), 2) \
+	X(Beamformed,    MB(1),  MB(96),  4) \
+	X(Average,       MB(1),  MB(96),  2) \
+	X(FocalVectors,  KB(1),  KB(64),  2) \
+	X(SparseElements,KB(1),  KB(32),  2) \
+	X(ChannelMapping,KB(1),  KB(4),   2) \
+	X(Filter,        KB(4),  MB(2),   4) \
+	X(Parameters,    256,    KB(16),  4)
+
+typedef enum {
+	#define X(name, ...) ChurnResource_##name,
+	CHURN_RESOURCE_LIST
+	#undef X
+	ChurnResource_Count,
+} ChurnResourceKind;
+
+read_only global struct { str8 name; u64 min, max; u32 count; } churn_resources[] = {
+	#define X(name, min, max, count) {str8_comp(#name), min, max, count},
+	CHURN_RESOURCE_LIST
+	#undef X
+};
+
+typedef struct {
+	BuddyAllocator allocator;
+	u8            *shadow;
+	b32            live;
+} ChurnBlock;
+
+typedef struct {
+	u64 size;
+	u64 offset;
+	/* NOTE(rnp): -1 for dedicated allocations */
+	i32 block;
+	/* NOTE(rnp): frame at which the GPU would be done with it */
+	u32 retire_frame;
+} ChurnAllocation;
+
+typedef struct {
+	ChurnBlock blocks[CHURN_MAX_BLOCKS];
+	u8        *trees;
+	u8        *shadows;
+	u64        block_size;
+	u32        block_count;
+
+	ChurnAllocation *pending;
+	u32              pending_count;
+
+	u64 live_bytes;
+	u64 dedicated_bytes;
+	u64 peak_reserved_bytes;
+	u64 peak_live_bytes;
+	u32 peak_blocks;
+
+	u64 allocations;
+	u64 device_allocations;
+	u64 device_frees;
+	u64 dedicated_allocations;
+	u64 retries;
+
+	u64 allocate_ticks;
+	u64 allocate_max_ticks;
+	u64 free_ticks;
+} ChurnPool;
+
+function void
+usage(char *argv0)
+{
+	die("%s [--block-size bytes] [--frames n] [--in-flight n] [--churn n] [--seed n]\n"
+	    "    --block-size: size of the pooled blocks (default: 256M); accepts K, M and G suffixes\n"
+	    "    --frames:     simulated frames (default: 20000)\n"
+	    "    --in-flight:  frames before a released buffer may be reused (default: 3)\n"
+	    "    --churn:      buffers reallocated per frame (default: 4)\n"
+	    "    --seed:       random seed (default: 1)\n", argv0);
+}
+
+function u64
+parse_size(char *s)
+{
+	char *end;
+	u64 result = strtoull(s, &end, 10);
+	switch (*end) {
+	case 'k': case 'K':{ result = KB(result); }break;
+	case 'm': case 'M':{ result = MB(result); }break;
+	case 'g': case 'G':{ result = GB(result); }break;
+	}
+	return result;
+}
+
+function Options
+parse_argv(i32 argc, char *argv[])
+{
+	Options result = {
+		.block_size = MB(256),
+		.frames     = 20000,
+		.in_flight  = 3,
+		.churn      = 4,
+		.seed       = 1,
+	};
+
+	char *argv0 = argv[0];
+	shift(argv, argc);
+
+	while (argc > 0) {
+		str8 arg = str8_from_c_str(*argv);
+		shift(argv, argc);
+
+		if (arg.length > 2 && arg.data[0] == '-' && arg.data[1] == '-' && argc) {
+			char *value = *argv;
+			if      (str8_equal(arg, str8("--block-size"))) result.block_size = parse_size(value);
+			else if (str8_equal(arg, str8("--frames")))     result.frames     = Max(1, (u32)atoi(value));
+			else if (str8_equal(arg, str8("--in-flight")))  result.in_flight  = (u32)atoi(value);
+			else if (str8_equal(arg, str8("--churn")))      result.churn      = Max(1, (u32)atoi(value));
+			else if (str8_equal(arg, str8("--seed")))       result.seed       = strtoull(value, 0, 10);
+			else usage(argv0);
+			shift(argv, argc);
+		} else {
+			usage(argv0);
+		}
+	}
+
+	if (!IsPowerOfTwo(result.block_size) || result.block_size < MB(1) || result.block_size > GB(2))
+		die("block size must be a power of two between 1M and 2G\n");
+
+	return result;
+}
+
+function u64
+churn_random(u64 *state)
+{
+	*state ^= *state << 13;
+	*state ^= *state >> 7;
+	*state ^= *state << 17;
+	return *state;
+}
+
+/* NOTE(rnp): log uniform so that small buffers are as likely as large ones */
+function u64
+churn_random_size(u64 *state, u64 min, u64 max)
+{
+	f64 t      = (f64)(churn_random(state) >> 11) / (f64)(1ull << 53);
+	u64 result = (u64)((f64)min * pow((f64)max / (f64)min, t));
+	result     = Clamp(result, min, max);
+	return result;
+}
+
+function void
+churn_shadow_mark(ChurnPool *cp, ChurnAllocation *a, b32 set)
+{
+	ChurnBlock *block = cp->blocks + a->block;
+	u64 first = a->offset / BuddyMinimumSize;
+	u64 count = round_up_power_of_two(Max(a->size, BuddyMinimumSize)) / BuddyMinimumSize;
+	for (u64 it = first; it < first + count; it++) {
+		b32 marked = (block->shadow[it / 8] >> (it % 8)) & 1;
+		if (marked == set)
+			die("block %d offset %llu: chunk %llu is %s\n", a->block, (unsigned long long)a->offset,
+			    (unsigned long long)it, set ? "already in use" : "not in use");
+		block->shadow[it / 8] ^= (u8)(1u << (it % 8));
+	}
+}
+
+function void
+churn_update_peaks(ChurnPool *cp)
+{
+	u64 reserved = cp->block_count * cp->block_size + cp->dedicated_bytes;
+	cp->peak_reserved_bytes = Max(cp->peak_reserved_bytes, reserved);
+	cp->peak_live_bytes     = Max(cp->peak_live_bytes,     cp->live_bytes);
+	cp->peak_blocks         = Max(cp->peak_blocks,         cp->block_count);
+}
+
+function b32
+churn_suballocate(ChurnPool *cp, ChurnAllocation *a)
+{
+	b32 result = 0;
+	for (u32 it = 0; !result && it < CHURN_MAX_BLOCKS; it++) {
+		ChurnBlock *block = cp->blocks + it;
+		if (block->live) {
+			a->offset = buddy_allocate(&block->allocator, a->size, BuddyMinimumSize);
+			a->block  = (i32)it;
+			result    = a->offset != BuddyInvalidOffset;
+		}
+	}
+
+	for (u32 it = 0; !result && it < CHURN_MAX_BLOCKS; it++) {
+		ChurnBlock *block = cp->blocks + it;
+		if (!block->live) {
+			u64 tree_size = buddy_tree_size(cp->block_size);
+			u64 chunks    = cp->block_size / BuddyMinimumSize;
+			buddy_init(&block->allocator, cp->trees + it * tree_size, cp->block_size);
+			block->shadow = cp->shadows + it * (chunks / 8);
+			block->live   = 1;
+			cp->block_count++;
+			cp->device_allocations++;
+
+			a->offset = buddy_allocate(&block->allocator, a->size, BuddyMinimumSize);
+			a->block  = (i32)it;
+			result    = a->offset != BuddyInvalidOffset;
+		}
+	}
+
+	return result;
+}
+
+function void
+churn_release(ChurnPool *cp, ChurnAllocation *a)
+{
+	cp->live_bytes -= a->size;
+	if (a->block < 0) {
+		cp->dedicated_bytes -= a->size;
+		cp->device_frees++;
+	} else {
+		churn_shadow_mark(cp, a, 0);
+
+		u64 start = os_timer_count();
+		ChurnBlock *block = cp->blocks + a->block;
+		buddy_free(&block->allocator, a->offset);
+		cp->free_ticks += os_timer_count() - start;
+
+		/* NOTE(rnp): same policy as vk_memory_release(): keep one empty block around */
+		if (buddy_empty(&block->allocator) && cp->block_count > 1) {
+			block->live = 0;
+			cp->block_count--;
+			cp->device_frees++;
+		}
+	}
+}
+
+function void
+churn_collect(ChurnPool *cp, u32 frame)
+{
+	for (u32 it = 0; it < cp->pending_count;) {
+		if (cp->pending[it].retire_frame <= frame) {
+			churn_release(cp, cp->pending + it);
+			cp->pending[it] = cp->pending[--cp->pending_count];
+		} else {
+			it++;
+		}
+	}
+}
+
+function ChurnAllocation
+churn_allocate(ChurnPool *cp, u64 size, u32 frame)
+{
+	ChurnAllocation result = {.size = size, .block = -1};
+	cp->allocations++;
+	cp->live_bytes += size;
+
+	if (size <= cp->block_size / 2) {
+		u64 start = os_timer_count();
+		b32 ok    = churn_suballocate(cp, &result);
+		u64 ticks = os_timer_count() - start;
+		cp->allocate_ticks     += ticks;
+		cp->allocate_max_ticks  = Max(cp->allocate_max_ticks, ticks);
+
+		if (!ok) {
+			/* NOTE(rnp): equivalent of waiting on the timelines before the second attempt */
+			cp->retries++;
+			churn_collect(cp, (u32)-1);
+			ok = churn_suballocate(cp, &result);
+		}
+		if (!ok) die("out of blocks (%u) allocating %llu bytes\n", CHURN_MAX_BLOCKS, (unsigned long long)size);
+
+		if ((result.offset % round_up_power_of_two(Max(size, BuddyMinimumSize))) != 0)
+			die("misaligned offset %llu for size %llu\n", (unsigned long long)result.offset,
+			    (unsigned long long)size);
+		churn_shadow_mark(cp, &result, 1);
+	} else {
+		cp->dedicated_bytes += size;
+		cp->dedicated_allocations++;
+		cp->device_allocations++;
+	}
+
+	churn_update_peaks(cp);
+	return result;
+}
+
+BASE_IMPORT void
+entry_point(i32 argc, char *argv[])
+{
+	Options options  = parse_argv(argc, argv);
+	Arena  *arena    = arena_create(.reserve_size = GB(1));
+	g_platform_arena = arena;
+
+	u32 resource_count = 0;
+	for EachElement(churn_resources, it) resource_count += churn_resources[it].count;
+
+	ChurnPool *cp  = push_struct(arena, ChurnPool);
+	cp->block_size = options.block_size;
+	cp->trees      = push_array(arena, u8, CHURN_MAX_BLOCKS * buddy_tree_size(options.block_size));
+	cp->shadows    = push_array(arena, u8, CHURN_MAX_BLOCKS * (options.block_size / BuddyMinimumSize / 8));
+	cp->pending    = push_array(arena, ChurnAllocation, resource_count * (options.in_flight + 2));
+
+	ChurnAllocation *live  = push_array(arena, ChurnAllocation, resource_count);
+	u8              *kinds = push_array(arena, u8, resource_count);
+
+	u64 state = options.seed ? options.seed : 1;
+	for (u32 it = 0, index = 0; it < ChurnResource_Count; it++) {
+		for (u32 i = 0; i < churn_resources[it].count; i++, index++) {
+			kinds[index] = (u8)it;
+			live[index]  = churn_allocate(cp, churn_random_size(&state, churn_resources[it].min,
+			                                                    churn_resources[it].max), 0);
+		}
+	}
+
+	u64 requested_bytes = 0, chunk_bytes = 0;
+	for (u32 frame = 1; frame <= options.frames; frame++) {
+		churn_collect(cp, frame);
+
+		for (u32 it = 0; it < options.churn; it++) {
+			u32 index = (u32)(churn_random(&state) % resource_count);
+			u32 kind  = kinds[index];
+
+			live[index].retire_frame = frame + options.in_flight;
+			cp->pending[cp->pending_count++] = live[index];
+
+			u64 size = churn_random_size(&state, churn_resources[kind].min, churn_resources[kind].max);
+			live[index] = churn_allocate(cp, size, frame);
+		}
+
+		for (u32 it = 0; it < resource_count; it++) {
+			if (live[it].block >= 0) {
+				requested_bytes += live[it].size;
+				chunk_bytes     += round_up_power_of_two(Max(live[it].size, BuddyMinimumSize));
+			}
+		}
+	}
+
+	for (u32 it = 0; it < resource_count; it++)
+		churn_release(cp, live + it);
+	churn_collect(cp, (u32)-1);
+
+	b32 empty = cp->live_bytes == 0 && cp->dedicated_bytes == 0 && cp->block_count == 1;
+	for (u32 it = 0; it < CHURN_MAX_BLOCKS; it++) {
+		ChurnBlock *block = cp->blocks + it;
+		if (block->live) {
+			empty &= buddy_empty(&block->allocator);
+			for (u64 i = 0; i < options.block_size / BuddyMinimumSize / 8; i++)
+				empty &= block->shadow[i] == 0;
+		}
+	}
+
+	u64 suballocations = cp->allocations - cp->dedicated_allocations;
+	f64 ns_per_tick    = 1e9 / (f64)os_timer_frequency();
+
+	printf("block size: %llu MiB, frames: %u, in flight: %u, churn: %u buffers/frame, buffers: %u\n",
+	       (unsigned long long)(options.block_size / MB(1)), options.frames, options.in_flight,
+	       options.churn, resource_count);
+	printf("allocations:          %llu (%llu suballocated, %llu dedicated)\n",
+	       (unsigned long long)cp->allocations, (unsigned long long)suballocations,
+	       (unsigned long long)cp->dedicated_allocations);
+	printf("driver allocations:   %llu (%llu without pooling, %0.1fx fewer)\n",
+	       (unsigned long long)cp->device_allocations, (unsigned long long)cp->allocations,
+	       (f64)cp->allocations / (f64)Max(1, cp->device_allocations));
+	printf("driver frees:         %llu\n", (unsigned long long)cp->device_frees);
+	printf("waited on frees:      %llu\n", (unsigned long long)cp->retries);
+	printf("peak blocks:          %u\n", cp->peak_blocks);
+	printf("peak reserved:        %0.1f MiB (live peak %0.1f MiB)\n",
+	       (f64)cp->peak_reserved_bytes / MB(1), (f64)cp->peak_live_bytes / MB(1));
+	printf("internal waste:       %0.1f%% (power of two rounding)\n",
+	       chunk_bytes ? 100.0 * (1.0 - (f64)requested_bytes / (f64)chunk_bytes) : 0.0);
+	printf("allocate:             %0.1f ns mean, %0.1f ns max\n",
+	       (f64)cp->allocate_ticks * ns_per_tick / (f64)Max(1, suballocations),
+	       (f64)cp->allocate_max_ticks * ns_per_tick);
+	printf("free:                 %0.1f ns mean\n",
+	       (f64)cp->free_ticks * ns_per_tick / (f64)Max(1, suballocations));
+
+	if (!empty) die("pool was not empty after releasing every buffer\n");
+	printf("pool empty: ok\n");
+}
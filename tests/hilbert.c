@@ -0,0 +1,336 @@
+/* See LICENSE for license details. */
+/* NOTE(rnp): analytic signal generation. first checks the FFT and FIR Hilbert algorithms
+ * used by shaders/hilbert.glsl against the closed form analytic signal of a tone burst,
+ * then compares beamformer throughput of Decode + Hilbert against Demodulate + Decode */
+#define BASE_EXPORT           function
+#define BASE_IMPORT           function
+#define BEAMFORMER_LIB_EXPORT function
+#include "base_platform.h"
+#include "ogl_beamformer_lib.c"
+
+#include <signal.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define AVERAGE_SAMPLES    countof(((BeamformerComputeStatsTable *)0)->times)
+#define RF_TIME_SAMPLES    4096
+#define CHANNEL_COUNT      128
+#define ACQUISITION_COUNT  32
+#define SAMPLING_FREQUENCY 40e6f
+#define CENTER_FREQUENCY   5e6f
+
+#define REFERENCE_FIR_LENGTH 63
+#define REFERENCE_TOLERANCE  2e-2f
+
+typedef struct {
+	b32 loop;
+	u32 warmup_count;
+	u32 fir_length;
+
+	char **remaining;
+	i32    remaining_count;
+} Options;
+
+typedef enum {
+	Study_HilbertFFT,
+	Study_HilbertFIR,
+	Study_Demodulate,
+	Study_Count,
+} Study;
+
+read_only global str8 study_names[] = {
+	str8_comp("Decode + Hilbert (FFT)"),
+	str8_comp("Decode + Hilbert (FIR)"),
+	str8_comp("Demodulate + Decode"),
+};
+
+global b32 g_should_exit;
+
+#define die(...) die_((char *)__func__, __VA_ARGS__)
+function no_return void
+die_(char *function_name, char *format, ...)
+{
+	if (function_name)
+		fprintf(stderr, "%s: ", function_name);
+
+	va_list ap;
+
+	va_start(ap, format);
+	vfprintf(stderr, format, ap);
+	va_end(ap);
+
+	os_exit(1);
+}
+
+#define shift_n(v, c, n) v += n, c -= n
+#define shift(v, c)   shift_n(v, c, 1)
+#define unshift(v, c) shift_n(v, c, -1)
+
+function void
+usage(char *argv0)
+{
+	die("%s [--loop] [--warmup n] [--fir n]\n"
+	    "    --loop:   rerun the comparison forever\n"
+	    "    --warmup: warmup with n runs\n"
+	    "    --fir:    Hilbert FIR length for the FIR study (default: 31)\n",
+	    argv0);
+}
+
+function Options
+parse_argv(i32 argc, char *argv[])
+{
+	Options result = {.fir_length = 31};
+
+	char *argv0 = argv[0];
+	shift(argv, argc);
+
+	while (argc > 0) {
+		str8 arg = str8_from_c_str(*argv);
+		shift(argv, argc);
+
+		if (str8_equal(arg, str8("--loop"))) {
+			result.loop = 1;
+		} else if (str8_equal(arg, str8("--warmup"))) {
+			if (argc) {
+				result.warmup_count = (u32)atoi(*argv);
+				shift(argv, argc);
+			}
+		} else if (str8_equal(arg, str8("--fir"))) {
+			if (argc) {
+				result.fir_length = Clamp((u32)atoi(*argv), 3, 255);
+				shift(argv, argc);
+			}
+		} else if (arg.length > 0 && arg.data[0] == '-') {
+			usage(argv0);
+		} else {
+			unshift(argv, argc);
+			break;
+		}
+	}
+
+	result.remaining       = argv;
+	result.remaining_count = argc;
+
+	return result;
+}
+
+//////////////////////////
+// NOTE: CPU reference
+
+function f32
+tone_burst_envelope(i32 n)
+{
+	f32 t = ((f32)n - RF_TIME_SAMPLES / 2.0f) / (RF_TIME_SAMPLES / 8.0f);
+	f32 result = exp_f64(-(f64)(t * t));
+	return result;
+}
+
+function v2
+tone_burst_analytic(i32 n)
+{
+	f32 arg = 2 * PI * CENTER_FREQUENCY * (f32)n / SAMPLING_FREQUENCY;
+	v2 result = v2_scale((v2){{cos_f32(arg), sin_f32(arg)}}, tone_burst_envelope(n));
+	return result;
+}
+
+/* NOTE(rnp): mirrors the shared memory FFT path */
+function v2 *
+analytic_signal_fft(Arena *arena, f32 *x, i32 count)
+{
+	i32 fft_size = (i32)round_up_power_of_two((u64)count);
+	v2 *result   = push_array(arena, v2, fft_size);
+	for (i32 i = 0; i < count; i++)
+		result[i].x = x[i];
+
+	fft_complex(result, fft_size, 0);
+	for (i32 i = 0; i < fft_size; i++) {
+		f32 weight = 0;
+		if (i == 0 || i == fft_size / 2) weight = 1;
+		else if (i < fft_size / 2)       weight = 2;
+		result[i] = v2_scale(result[i], weight / (f32)fft_size);
+	}
+	fft_complex(result, fft_size, 1);
+
+	return result;
+}
+
+/* NOTE(rnp): mirrors the FIR approximation path */
+function v2 *
+analytic_signal_fir(Arena *arena, f32 *x, i32 count, i32 fir_length)
+{
+	f32 *h      = hilbert_fir_filter(arena, fir_length, 5.65f);
+	i32  half   = (fir_length | 1) / 2;
+	v2  *result = push_array(arena, v2, count);
+	for (i32 n = 0; n < count; n++) {
+		f32 sum = 0;
+		for (i32 k = 1; k <= half; k += 2) {
+			f32 a = n - k >= 0    ? x[n - k] : 0;
+			f32 b = n + k < count ? x[n + k] : 0;
+			sum += h[half + k] * (a - b);
+		}
+		result[n] = (v2){{x[n], sum}};
+	}
+	return result;
+}
+
+function f32
+analytic_signal_error(v2 *analytic)
+{
+	// NOTE(rnp): the envelope is negligible at the edges where zero padding dominates
+	f32 result = 0;
+	for (i32 n = RF_TIME_SAMPLES / 8; n < 7 * RF_TIME_SAMPLES / 8; n++)
+		result = Max(result, v2_magnitude(v2_sub(analytic[n], tone_burst_analytic(n))));
+	return result;
+}
+
+function b32
+reference_check(Arena arena)
+{
+	f32 *x = push_array(&arena, f32, RF_TIME_SAMPLES);
+	for (i32 n = 0; n < RF_TIME_SAMPLES; n++)
+		x[n] = tone_burst_analytic(n).x;
+
+	f32 fft_error = analytic_signal_error(analytic_signal_fft(&arena, x, RF_TIME_SAMPLES));
+	f32 fir_error = analytic_signal_error(analytic_signal_fir(&arena, x, RF_TIME_SAMPLES, REFERENCE_FIR_LENGTH));
+
+	b32 result = fft_error < REFERENCE_TOLERANCE && fir_error < REFERENCE_TOLERANCE;
+	printf("reference: FFT max error %0.3e | FIR(%u) max error %0.3e | %s\n",
+	       fft_error, REFERENCE_FIR_LENGTH, fir_error, result ? "PASS" : "FAIL");
+	return result;
+}
+
+//////////////////////////
+// NOTE: throughput
+
+function u32
+data_size(void)
+{
+	u32 result = RF_TIME_SAMPLES * ACQUISITION_COUNT * CHANNEL_COUNT * sizeof(i16);
+	return result;
+}
+
+function b32
+send_frame(i16 *restrict data)
+{
+	b32 result = beamformer_push_data_with_compute(data, data_size(), BeamformerViewPlaneTag_XZ, 0);
+	if (!result && !g_should_exit) printf("lib error: %s\n", beamformer_get_last_error_string());
+	return result;
+}
+
+function void
+send_parameters(Options *options, Study study)
+{
+	BeamformerParameters bp = {0};
+	bp.decode_mode            = BeamformerDecodeMode_Hadamard;
+	bp.sample_count           = RF_TIME_SAMPLES;
+	bp.channel_count          = CHANNEL_COUNT;
+	bp.acquisition_count      = ACQUISITION_COUNT;
+	bp.sampling_frequency     = SAMPLING_FREQUENCY;
+	bp.demodulation_frequency = CENTER_FREQUENCY;
+	bp.decimation_rate        = 1;
+	bp.raw_data_dimensions    = (uv2){{RF_TIME_SAMPLES * ACQUISITION_COUNT, CHANNEL_COUNT}};
+	beamformer_push_parameters(&bp);
+
+	i16 channel_mapping[CHANNEL_COUNT];
+	for EachElement(channel_mapping, it)
+		channel_mapping[it] = (i16)it;
+	beamformer_push_channel_mapping(channel_mapping, countof(channel_mapping));
+
+	i32 shaders[2];
+	switch (study) {
+	case Study_HilbertFFT:
+	case Study_HilbertFIR:
+	{
+		shaders[0] = BeamformerShaderKind_Decode;
+		shaders[1] = BeamformerShaderKind_Hilbert;
+		beamformer_push_pipeline(shaders, countof(shaders), BeamformerDataKind_Int16);
+		beamformer_set_pipeline_stage_parameters(1, study == Study_HilbertFIR ? (i32)options->fir_length : 0);
+	}break;
+
+	case Study_Demodulate:{
+		BeamformerFilterParameters filter = {
+			.kind               = BeamformerFilterKind_Kaiser,
+			.sampling_frequency = SAMPLING_FREQUENCY / 2,
+		};
+		filter.kaiser.beta             = 5.65f;
+		filter.kaiser.cutoff_frequency = 0.5f * CENTER_FREQUENCY;
+		filter.kaiser.length           = 36;
+		beamformer_create_filter(&filter, 0, 0);
+
+		shaders[0] = BeamformerShaderKind_Demodulate;
+		shaders[1] = BeamformerShaderKind_Decode;
+		beamformer_push_pipeline(shaders, countof(shaders), BeamformerDataKind_Int16);
+		beamformer_set_pipeline_stage_parameters(0, 0);
+	}break;
+
+	InvalidDefaultCase;
+	}
+
+	beamformer_set_global_timeout(1000);
+}
+
+function f32
+execute_study(Options *options, Study study, i16 *restrict data)
+{
+	send_parameters(options, study);
+	for (u32 i = 0; !g_should_exit && i < options->warmup_count; i++)
+		send_frame(data);
+
+	u64 start     = os_timer_count();
+	f64 frequency = os_timer_frequency();
+	for (u32 i = 0; !g_should_exit && i < AVERAGE_SAMPLES; i++)
+		send_frame(data);
+	f32 result = (os_timer_count() - start) / frequency / (f32)AVERAGE_SAMPLES;
+
+	return result;
+}
+
+function void
+print_result(Study study, f32 time)
+{
+	printf("%-24.*s | %uF Average: %8.3f [ms] | %8.3f GB/s\n", (i32)study_names[study].length,
+	       (char *)study_names[study].data, (u32)AVERAGE_SAMPLES, time * 1e3,
+	       (f32)data_size() / (time * (f32)GB(1)));
+}
+
+function void
+sigint(i32 _signo)
+{
+	g_should_exit = 1;
+}
+
+BASE_IMPORT void
+entry_point(i32 argc, char *argv[])
+{
+	Options options = parse_argv(argc, argv);
+
+	if (options.remaining_count)
+		usage(argv[0]);
+
+	signal(SIGINT, sigint);
+
+	Arena *arena = arena_create();
+	if (!reference_check(*arena))
+		os_exit(1);
+
+	BeamformerLiveImagingParameters lip = {.active = 1, .save_enabled = 1};
+	str8 short_name = str8("Hilbert Bench");
+	memory_copy(lip.save_name_tag, short_name.data, (u64)short_name.length);
+	lip.save_name_tag_length = (i32)short_name.length;
+	beamformer_set_live_parameters(&lip);
+
+	i16 *data = push_array(arena, i16, data_size() / sizeof(i16));
+	for (u32 i = 0; i < data_size() / sizeof(i16); i++)
+		data[i] = (i16)(1024 * tone_burst_analytic((i32)(i % RF_TIME_SAMPLES)).x);
+
+	do {
+		for (Study study = 0; !g_should_exit && study < Study_Count; study++) {
+			f32 time = execute_study(&options, study, data);
+			if (!g_should_exit) print_result(study, time);
+		}
+	} while (options.loop && !g_should_exit);
+
+	lip.active = 0;
+	beamformer_set_live_parameters(&lip);
+}
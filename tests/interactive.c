@@ -0,0 +1,192 @@
+/* See LICENSE for license details. */
+/* NOTE(rnp): edit to image latency of DAS runtime parameter changes against a running
+ * beamformer. the speed of sound and f-number of a parameter block are changed --edits
+ * times, first with interactive tuning disabled (every edit compiles a new DAS pipeline)
+ * and then enabled (edits are pushed to the interactive variant). each edit pushes the
+ * parameters and one frame and times the push until that frame is ready. afterwards frames
+ * are pushed without edits until the block is back on the specialized pipeline. the
+ * program fails if interactive edits compiled in the foreground after the first one or if
+ * the block never returns to the specialized pipeline */
+#define BASE_EXPORT           function
+#define BASE_IMPORT           function
+#define BEAMFORMER_LIB_EXPORT function
+#include "base_platform.h"
+#include "ogl_beamformer_lib.c"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+typedef struct {
+	u32 edits;
+	u32 points;
+	f32 settle_time;
+} Options;
+
+#define die(...) die_((char *)__func__, __VA_ARGS__)
+function no_return void
+die_(char *function_name, char *format, ...)
+{
+	if (function_name)
+		fprintf(stderr, "%s: ", function_name);
+
+	va_list ap;
+
+	va_start(ap, format);
+	vfprintf(stderr, format, ap);
+	va_end(ap);
+
+	fflush(stdout);
+	os_exit(1);
+}
+
+#include "cpu_platform.c"
+#include "rf_simulator.c"
+
+#define shift_n(v, c, n) v += n, c -= n
+#define shift(v, c)   shift_n(v, c, 1)
+
+function void
+usage(char *argv0)
+{
+	die("%s [--edits n] [--points n] [--settle ms]\n"
+	    "    --edits:  parameter edits timed in each mode (default: 16)\n"
+	    "    --points: output points along x and z (default: 256)\n"
+	    "    --settle: interactive settle time in milliseconds (default: 500)\n", argv0);
+}
+
+function Options
+parse_argv(i32 argc, char *argv[])
+{
+	Options result = {.edits = 16, .points = 256, .settle_time = 0.5f};
+
+	char *argv0 = argv[0];
+	shift(argv, argc);
+
+	while (argc > 0) {
+		str8 arg = str8_from_c_str(*argv);
+		shift(argv, argc);
+
+		if (arg.length > 2 && arg.data[0] == '-' && arg.data[1] == '-' && argc) {
+			char *value = *argv;
+			if      (str8_equal(arg, str8("--edits")))  result.edits       = Max(2, (u32)atoi(value));
+			else if (str8_equal(arg, str8("--points"))) result.points      = Max(16, (u32)atoi(value));
+			else if (str8_equal(arg, str8("--settle"))) result.settle_time = (f32)Max(1, atoi(value)) * 1e-3f;
+			else usage(argv0);
+			shift(argv, argc);
+		} else {
+			usage(argv0);
+		}
+	}
+
+	return result;
+}
+
+/* NOTE(rnp): only the speed of sound and f-number change between edits; the same as
+ * dragging them in the parameter listing */
+function void
+interactive_parameters(BeamformerSimpleParameters *bp, u32 points, f32 speed_of_sound, f32 f_number)
+{
+	rf_simulation_client_parameters(bp, points, 40e-3f);
+	bp->interpolation_mode = BeamformerInterpolationMode_Cubic;
+	bp->speed_of_sound     = speed_of_sound;
+	bp->f_number           = f_number;
+}
+
+/* NOTE(rnp): pushes bp (if any) and one frame and waits until the frame is ready */
+function u64
+interactive_push_frame(BeamformerSimpleParameters *bp, i16 *data, u32 data_size, BeamformerTelemetry *now)
+{
+	u64 frames = now->compute.frames_completed;
+	u64 start  = os_timer_count();
+	if ((bp && !beamformer_push_simple_parameters(bp)) ||
+	    !beamformer_push_data_with_compute(data, data_size, BeamformerViewPlaneTag_XZ, 0))
+	{
+		die("failed to push frame: %s\n", beamformer_get_last_error_string());
+	}
+
+	u64 timeout = start + 10 * os_system_info()->timer_frequency;
+	while (now->compute.frames_completed == frames) {
+		if (!beamformer_read_telemetry(now) || os_timer_count() > timeout)
+			die("no frame was beamformed; is the beamformer running?\n");
+		cpu_yield();
+	}
+	u64 result = os_timer_count() - start;
+	return result;
+}
+
+BASE_IMPORT void
+entry_point(i32 argc, char *argv[])
+{
+	Options options = parse_argv(argc, argv);
+	Arena  *arena   = arena_create();
+
+	BeamformerSimpleParameters *bp = push_struct(arena, BeamformerSimpleParameters);
+	interactive_parameters(bp, options.points, 1540.0f, 0.5f);
+	u32 data_size = bp->raw_data_dimensions.x * bp->raw_data_dimensions.y * sizeof(i16);
+	i16 *data     = push_array(arena, i16, data_size / sizeof(i16));
+
+	u64 *specialized = push_array(arena, u64, options.edits);
+	u64 *interactive = push_array(arena, u64, options.edits);
+
+	beamformer_set_global_timeout(1000);
+
+	BeamformerTelemetry now = {0};
+	if (!beamformer_read_telemetry(&now))
+		die("failed to read telemetry: %s\n", beamformer_get_last_error_string());
+
+	BeamformerBlockTelemetry *bt = now.compute.blocks + 0;
+
+	/* NOTE(rnp): build the plan once so the first timed edit only changes runtime parameters */
+	if (!beamformer_set_interactive_tuning(0, options.settle_time))
+		die("failed to configure interactive tuning: %s\n", beamformer_get_last_error_string());
+	interactive_push_frame(bp, data, data_size, &now);
+
+	/* NOTE(rnp): every value is new so no compiled pipeline can be reused */
+	u32 specialized_compiles = bt->foreground_compiles;
+	for (u32 edit = 0; edit < options.edits; edit++) {
+		interactive_parameters(bp, options.points, 1400.0f + (f32)edit, 0.5f + 0.01f * (f32)edit);
+		specialized[edit] = interactive_push_frame(bp, data, data_size, &now);
+	}
+	specialized_compiles = bt->foreground_compiles - specialized_compiles;
+
+	if (!beamformer_set_interactive_tuning(1, options.settle_time))
+		die("failed to configure interactive tuning: %s\n", beamformer_get_last_error_string());
+
+	/* NOTE(rnp): the first edit may have to compile the interactive variant */
+	u32 interactive_compiles = bt->foreground_compiles;
+	for (u32 edit = 0; edit < options.edits; edit++) {
+		interactive_parameters(bp, options.points, 1600.0f + (f32)edit, 1.0f + 0.01f * (f32)edit);
+		interactive[edit] = interactive_push_frame(bp, data, data_size, &now);
+		if (edit == 0) interactive_compiles = bt->foreground_compiles;
+	}
+	interactive_compiles = bt->foreground_compiles - interactive_compiles;
+	b32 was_interactive  = bt->interactive;
+
+	/* NOTE(rnp): frames without edits until the specialized pipeline has been swapped in */
+	u32 background_compiles = bt->background_compiles;
+	u64 settle_start = os_timer_count();
+	u64 timeout      = settle_start + (u64)((10.0 + options.settle_time) * (f64)os_system_info()->timer_frequency);
+	while (bt->interactive && os_timer_count() < timeout)
+		interactive_push_frame(0, data, data_size, &now);
+	u64 settle_elapsed  = os_timer_count() - settle_start;
+	background_compiles = bt->background_compiles - background_compiles;
+
+	f64 ms = 1e3 / (f64)os_system_info()->timer_frequency;
+	printf("edits: %u, points: %u x %u, settle: %0.0f ms\n", options.edits, options.points,
+	       options.points, 1e3 * options.settle_time);
+	printf("edit to image: specialized p50 %8.3f ms (%u compiles) | interactive p50 %8.3f ms (%u compiles after the first edit)\n",
+	       (f64)rf_simulation_percentile(specialized, options.edits, 0.5) * ms, specialized_compiles,
+	       (f64)rf_simulation_percentile(interactive, options.edits, 0.5) * ms, interactive_compiles);
+	printf("back to specialized after %8.3f ms (%u background compiles)\n",
+	       (f64)settle_elapsed * ms, background_compiles);
+
+	b32 passed = was_interactive && interactive_compiles == 0 && !bt->interactive;
+	if (passed)                         printf("PASS\n");
+	else if (!was_interactive)          printf("FAIL: edits did not switch the block to interactive tuning\n");
+	else if (interactive_compiles != 0) printf("FAIL: interactive edits compiled pipelines in the foreground\n");
+	else                                printf("FAIL: block did not return to the specialized pipeline\n");
+	fflush(stdout);
+
+	if (!passed) os_exit(1);
+}
@@ -0,0 +1,233 @@
+/* See LICENSE for license details. */
+/* NOTE(rnp): wakeup jitter benchmark for the thread placement policy (see main_linux.c).
+ * a thread sleeps until absolute deadlines --period apart and records how late it woke up.
+ * this is repeated with the default scheduling, pinned to a single logical processor,
+ * with SCHED_FIFO and with both, optionally while --load threads keep every processor busy.
+ * placement goes through the same base_linux.c helpers the beamformer uses. SCHED_FIFO
+ * requires CAP_SYS_NICE or RLIMIT_RTPRIO; those runs are skipped when it is not permitted */
+#define BASE_EXPORT           function
+#define BASE_IMPORT           function
+#define BEAMFORMER_LIB_EXPORT function
+#include "base_platform.h"
+#include "ogl_beamformer_lib.c"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define JITTER_REALTIME_PRIORITY (10)
+
+typedef struct {
+	u32 period_us;
+	u32 count;
+	u32 load;
+	i32 cpu;
+} Options;
+
+#define die(...) die_((char *)__func__, __VA_ARGS__)
+function no_return void
+die_(char *function_name, char *format, ...)
+{
+	if (function_name)
+		fprintf(stderr, "%s: ", function_name);
+
+	va_list ap;
+
+	va_start(ap, format);
+	vfprintf(stderr, format, ap);
+	va_end(ap);
+
+	fflush(stdout);
+	os_exit(1);
+}
+
+#include "cpu_platform.c"
+
+#define shift_n(v, c, n) v += n, c -= n
+#define shift(v, c)   shift_n(v, c, 1)
+
+#if OS_LINUX
+
+typedef struct {
+	u64 *latencies;
+	u32  count;
+	u64  period_ns;
+
+	/* NOTE(rnp): os_wake_all_waiters() resets the futex so the flag is kept separately */
+	b32  start;
+	i32  start_futex;
+} JitterRun;
+
+typedef struct {
+	b32 quit;
+	u64 sink;
+} JitterLoad;
+
+function void
+usage(char *argv0)
+{
+	die("%s [--period us] [--count n] [--load n] [--cpu n]\n"
+	    "    --period: wakeup period in microseconds (default: 1000)\n"
+	    "    --count:  wakeups per configuration (default: 5000)\n"
+	    "    --load:   busy threads competing for the processors (default: 0)\n"
+	    "    --cpu:    logical processor used for the pinned runs (default: last available)\n", argv0);
+}
+
+function Options
+parse_argv(i32 argc, char *argv[])
+{
+	Options result = {
+		.period_us = 1000,
+		.count     = 5000,
+		.cpu       = -1,
+	};
+
+	char *argv0 = argv[0];
+	shift(argv, argc);
+
+	while (argc > 0) {
+		str8 arg = str8_from_c_str(*argv);
+		shift(argv, argc);
+
+		if (arg.length > 2 && arg.data[0] == '-' && arg.data[1] == '-' && argc) {
+			char *value = *argv;
+			if      (str8_equal(arg, str8("--period"))) result.period_us = Max(1, (u32)atoi(value));
+			else if (str8_equal(arg, str8("--count")))  result.count     = Max(1, (u32)atoi(value));
+			else if (str8_equal(arg, str8("--load")))   result.load      = (u32)atoi(value);
+			else if (str8_equal(arg, str8("--cpu")))    result.cpu       = atoi(value);
+			else usage(argv0);
+			shift(argv, argc);
+		} else {
+			usage(argv0);
+		}
+	}
+
+	return result;
+}
+
+function OS_THREAD_ENTRY_POINT_FN(jitter_entry_point)
+{
+	JitterRun *run = user_context;
+
+	while (!atomic_load_u32(&run->start)) {
+		atomic_store_u32(&run->start_futex, 1);
+		if (!atomic_load_u32(&run->start))
+			os_wait_on_address(&run->start_futex, 1, (u32)-1);
+	}
+
+	u64 target = os_timer_count() + run->period_ns;
+	for (u32 i = 0; i < run->count; i++) {
+		struct timespec ts = {.tv_sec = (i64)(target / 1000000000ull), .tv_nsec = (i64)(target % 1000000000ull)};
+		while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, 0) == EINTR);
+		run->latencies[i] = os_timer_count() - target;
+		target += run->period_ns;
+	}
+
+	return 0;
+}
+
+function OS_THREAD_ENTRY_POINT_FN(jitter_load_entry_point)
+{
+	JitterLoad *load = user_context;
+	u64 x = (u64)user_context;
+	while (!atomic_load_u32(&load->quit))
+		for (u32 i = 0; i < 4096; i++) x = x * 6364136223846793005ull + 1442695040888963407ull;
+	load->sink = x;
+	return 0;
+}
+
+function i32
+u64_compare(const void *a, const void *b)
+{
+	u64 va = *(u64 *)a, vb = *(u64 *)b;
+	return va < vb ? -1 : va > vb;
+}
+
+function void
+jitter_report(JitterRun *run, char *name)
+{
+	qsort(run->latencies, run->count, sizeof(*run->latencies), u64_compare);
+
+	f64 sum = 0;
+	for (u32 i = 0; i < run->count; i++)
+		sum += (f64)run->latencies[i];
+
+	#define percentile(p) ((f64)run->latencies[Min((u32)((f64)run->count * (p)), run->count - 1)] * 1e-3)
+	printf("%-12s %9.2f %9.2f %9.2f %9.2f %9.2f %9.2f\n", name,
+	       (f64)run->latencies[0] * 1e-3, sum / (f64)run->count * 1e-3,
+	       percentile(0.5), percentile(0.99), percentile(0.999),
+	       (f64)run->latencies[run->count - 1] * 1e-3);
+	#undef percentile
+	fflush(stdout);
+}
+
+function void
+jitter_run(Arena *arena, char *name, Options *options, OSLinuxCPUSet *pin, b32 realtime)
+{
+	Temp temp = temp_begin(arena);
+	JitterRun *run = push_struct(arena, JitterRun);
+	run->latencies = push_array(arena, u64, options->count);
+	run->count     = options->count;
+	run->period_ns = (u64)options->period_us * 1000ull;
+
+	OSThread thread = os_create_thread("[jitter]", run, jitter_entry_point);
+
+	b32 pinned = !pin || os_linux_thread_set_affinity(thread.value[0], pin);
+	b32 fifo   = !realtime || os_linux_thread_set_realtime(thread.value[0], JITTER_REALTIME_PRIORITY);
+
+	atomic_store_u32(&run->start, 1);
+	os_wake_all_waiters(&run->start_futex);
+	pthread_join((pthread_t)thread.value[0], 0);
+
+	if (!pinned || !fifo) {
+		printf("%-12s %s\n", name, !pinned ? "affinity not permitted, skipped"
+		                                   : "SCHED_FIFO not permitted, skipped");
+	} else {
+		jitter_report(run, name);
+	}
+	temp_end(temp);
+}
+
+BASE_IMPORT void
+entry_point(i32 argc, char *argv[])
+{
+	Options options  = parse_argv(argc, argv);
+	Arena  *arena    = arena_create(.reserve_size = MB(64) + options.count * sizeof(u64));
+	g_platform_arena = arena;
+
+	OSLinuxCPUSet process = os_linux_process_cpu_set();
+	if (options.cpu < 0) {
+		for (i32 cpu = countof(process.bits) * 64 - 1; options.cpu < 0 && cpu >= 0; cpu--)
+			if (os_linux_cpu_set_has(&process, (u32)cpu)) options.cpu = cpu;
+	}
+	if (!os_linux_cpu_set_has(&process, (u32)options.cpu))
+		die("cpu %d is not available to this process\n", options.cpu);
+
+	OSLinuxCPUSet pin = {0};
+	os_linux_cpu_set_add(&pin, (u32)options.cpu);
+
+	JitterLoad *load = push_struct(arena, JitterLoad);
+	for (u32 i = 0; i < options.load; i++)
+		os_create_thread("[load]", load, jitter_load_entry_point);
+
+	printf("period: %u us, wakeups: %u, load threads: %u, pinned cpu: %d\n",
+	       options.period_us, options.count, options.load, options.cpu);
+	printf("%-12s %9s %9s %9s %9s %9s %9s\n", "[us]", "min", "mean", "p50", "p99", "p99.9", "max");
+
+	jitter_run(arena, "default",     &options, 0,    0);
+	jitter_run(arena, "pinned",      &options, &pin, 0);
+	jitter_run(arena, "fifo",        &options, 0,    1);
+	jitter_run(arena, "pinned+fifo", &options, &pin, 1);
+
+	atomic_store_u32(&load->quit, 1);
+}
+
+#else
+
+BASE_IMPORT void
+entry_point(i32 argc, char *argv[])
+{
+	die("thread placement is only implemented for Linux\n");
+}
+
+#endif
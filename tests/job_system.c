@@ -0,0 +1,322 @@
+/* See LICENSE for license details. */
+/* NOTE(rnp): job system (jobs.c) scheduling microbenchmark. measures the per job overhead
+ * of fanning out from outside the system and from inside a worker (which exercises the
+ * deques and stealing), the latency of a dependency chain, and the speedup of a parallel
+ * reduction. every scenario is checked for lost or repeated jobs; exits non zero on error */
+#define BASE_EXPORT           function
+#define BASE_IMPORT           function
+#define BEAMFORMER_LIB_EXPORT function
+#include "base_platform.h"
+#include "ogl_beamformer_lib.c"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+typedef struct {
+	u32 worker_count;
+	u32 job_count;
+	u32 chain_length;
+	u32 work;
+	u32 repeats;
+} Options;
+
+#define die(...) die_((char *)__func__, __VA_ARGS__)
+function no_return void
+die_(char *function_name, char *format, ...)
+{
+	if (function_name)
+		fprintf(stderr, "%s: ", function_name);
+
+	va_list ap;
+
+	va_start(ap, format);
+	vfprintf(stderr, format, ap);
+	va_end(ap);
+
+	os_exit(1);
+}
+
+#include "cpu_platform.c"
+#include "jobs.c"
+
+#define shift_n(v, c, n) v += n, c -= n
+#define shift(v, c)   shift_n(v, c, 1)
+
+function void
+usage(char *argv0)
+{
+	die("%s [--workers n] [--jobs n] [--chain n] [--work n] [--repeats n]\n"
+	    "    --workers:   job system worker threads (default: logical processors)\n"
+	    "    --jobs:      jobs per fan out (default: 65536)\n"
+	    "    --chain:     length of the dependency chain (default: 4096)\n"
+	    "    --work:      busy loop iterations per job (default: 0)\n"
+	    "    --repeats:   runs per scenario; the fastest is reported (default: 8)\n", argv0);
+}
+
+function Options
+parse_argv(i32 argc, char *argv[])
+{
+	Options result = {
+		.worker_count = os_system_info()->logical_processor_count,
+		.job_count    = 65536,
+		.chain_length = 4096,
+		.repeats      = 8,
+	};
+
+	char *argv0 = argv[0];
+	shift(argv, argc);
+
+	while (argc > 0) {
+		str8 arg = str8_from_c_str(*argv);
+		shift(argv, argc);
+
+		if (arg.length > 2 && arg.data[0] == '-' && arg.data[1] == '-' && argc) {
+			char *value = *argv;
+			if      (str8_equal(arg, str8("--workers"))) result.worker_count = Clamp((u32)atoi(value), 1, JobSystemMaxWorkers);
+			else if (str8_equal(arg, str8("--jobs")))    result.job_count    = Max(1, (u32)atoi(value));
+			else if (str8_equal(arg, str8("--chain")))   result.chain_length = Max(1, (u32)atoi(value));
+			else if (str8_equal(arg, str8("--work")))    result.work         = (u32)atoi(value);
+			else if (str8_equal(arg, str8("--repeats"))) result.repeats      = Max(1, (u32)atoi(value));
+			else usage(argv0);
+			shift(argv, argc);
+		} else {
+			usage(argv0);
+		}
+	}
+
+	return result;
+}
+
+typedef struct {
+	JobSystem *js;
+	Job       *jobs;
+	u32       *hits;
+	u32        job_count;
+	u32        work;
+	u32        last;
+	u32        order_errors;
+	f32       *data;
+	f64       *partial_sums;
+	u64        data_count;
+} Benchmark;
+
+typedef struct {
+	Benchmark *b;
+	u32        index;
+} BenchmarkJob;
+
+function void
+busy_work(u32 iterations)
+{
+	for (u32 i = 0; i < iterations; i++)
+		cpu_yield();
+}
+
+function JOB_FUNCTION(count_job)
+{
+	BenchmarkJob *j = user_context;
+	busy_work(j->b->work);
+	atomic_add_u32(j->b->hits + j->index, 1);
+}
+
+/* NOTE(rnp): chain links must run strictly in order */
+function JOB_FUNCTION(chain_job)
+{
+	BenchmarkJob *j = user_context;
+	if (j->index != j->b->last + 1) j->b->order_errors++;
+	j->b->last = j->index;
+	atomic_add_u32(j->b->hits + j->index, 1);
+}
+
+function JOB_FUNCTION(sum_job)
+{
+	BenchmarkJob *j = user_context;
+	Benchmark    *b = j->b;
+	RangeU64      r = subrange_n_from_n_m_count(j->index, b->job_count, b->data_count);
+	f64 sum = 0;
+	for (u64 i = r.start; i < r.stop; i++)
+		sum += b->data[i];
+	b->partial_sums[j->index] = sum;
+}
+
+/* NOTE(rnp): spawns every child from inside a worker so that they land on its deque */
+function JOB_FUNCTION(spawn_job)
+{
+	Benchmark *b = user_context;
+	for (u32 i = 0; i < b->job_count; i++)
+		job_submit(b->js, b->jobs + i);
+}
+
+function u32
+check_hits(Benchmark *b, u32 count, char *name)
+{
+	u32 result = 0;
+	for (u32 i = 0; i < count; i++) {
+		if (b->hits[i] != 1) result++;
+		b->hits[i] = 0;
+	}
+	if (result) printf("%s: %u jobs did not run exactly once\n", name, result);
+	return result;
+}
+
+function void
+print_result(char *name, u64 ticks, u32 job_count)
+{
+	f64 seconds = (f64)ticks / (f64)os_system_info()->timer_frequency;
+	printf("%-24s %10.3f ms %10.1f ns/job %12.0f jobs/s\n", name, seconds * 1e3,
+	       seconds * 1e9 / job_count, job_count / seconds);
+	fflush(stdout);
+}
+
+BASE_IMPORT void
+entry_point(i32 argc, char *argv[])
+{
+	Arena *arena     = arena_create(.reserve_size = GB(1));
+	g_platform_arena = arena;
+
+	Options options = parse_argv(argc, argv);
+	JobSystem *js   = job_system_create(arena, options.worker_count);
+
+	u32 max_jobs = Max(options.job_count, options.chain_length);
+	Benchmark b = {
+		.js        = js,
+		.jobs      = push_array(arena, Job, max_jobs),
+		.hits      = push_array(arena, u32, max_jobs),
+		.job_count = options.job_count,
+		.work      = options.work,
+	};
+	BenchmarkJob *contexts = push_array(arena, BenchmarkJob, max_jobs);
+	for (u32 i = 0; i < max_jobs; i++)
+		contexts[i] = (BenchmarkJob){.b = &b, .index = i};
+
+	printf("%u workers, %u jobs, %u busy iterations per job\n",
+	       js->worker_count, options.job_count, options.work);
+
+	u32 errors = 0;
+	u64 best[4] = {U64_MAX, U64_MAX, U64_MAX, U64_MAX};
+	u64 serial_ticks = U64_MAX;
+	for (u32 repeat = 0; repeat < options.repeats; repeat++) {
+		/* NOTE(rnp): fan out from outside of the system (injection queue) */
+		{
+			Job root;
+			job_init(&root, 0, 0, str8("root"));
+			u64 start = os_timer_count();
+			for (u32 i = 0; i < b.job_count; i++) {
+				job_init(b.jobs + i, count_job, contexts + i, str8("count"));
+				job_add_child(&root, b.jobs + i);
+				job_submit(js, b.jobs + i);
+			}
+			job_submit(js, &root);
+			job_wait(js, &root, arena);
+			best[0] = Min(best[0], os_timer_count() - start);
+			errors += check_hits(&b, b.job_count, "external fan out");
+		}
+
+		/* NOTE(rnp): fan out from a worker (deque push, pop and steal) */
+		{
+			Job root;
+			job_init(&root, spawn_job, &b, str8("spawn"));
+			u64 start = os_timer_count();
+			for (u32 i = 0; i < b.job_count; i++) {
+				job_init(b.jobs + i, count_job, contexts + i, str8("count"));
+				job_add_child(&root, b.jobs + i);
+			}
+			job_submit(js, &root);
+			job_wait(js, &root, arena);
+			best[1] = Min(best[1], os_timer_count() - start);
+			errors += check_hits(&b, b.job_count, "worker fan out");
+		}
+
+		/* NOTE(rnp): each link depends on the previous one */
+		{
+			b.last = (u32)-1;
+			for (u32 i = 0; i < options.chain_length; i++) {
+				job_init(b.jobs + i, chain_job, contexts + i, str8("chain"));
+				if (i > 0) job_depends_on(b.jobs + i, b.jobs + i - 1);
+			}
+			u64 start = os_timer_count();
+			for (u32 i = options.chain_length; i > 0; i--)
+				job_submit(js, b.jobs + i - 1);
+			job_wait(js, b.jobs + options.chain_length - 1, arena);
+			best[2] = Min(best[2], os_timer_count() - start);
+			errors += check_hits(&b, options.chain_length, "dependency chain");
+			if (b.order_errors) printf("dependency chain: %u links ran out of order\n", b.order_errors);
+			errors += b.order_errors;
+			b.order_errors = 0;
+		}
+
+		/* NOTE(rnp): parallel reduction over 64M floats split into one job per worker x 4 */
+		{
+			u32 saved_count = b.job_count;
+			b.job_count  = js->worker_count * 4;
+			b.data_count = MB(64) / sizeof(f32) * 4;
+			if (!b.data) {
+				b.data         = push_array(arena, f32, b.data_count);
+				b.partial_sums = push_array(arena, f64, b.job_count);
+				for (u64 i = 0; i < b.data_count; i++) b.data[i] = (f32)(i & 7);
+			}
+
+			u64 start = os_timer_count();
+			f64 serial = 0;
+			for (u64 i = 0; i < b.data_count; i++) serial += b.data[i];
+			serial_ticks = Min(serial_ticks, os_timer_count() - start);
+
+			Job root;
+			job_init(&root, 0, 0, str8("sum"));
+			start = os_timer_count();
+			for (u32 i = 0; i < b.job_count; i++) {
+				job_init(b.jobs + i, sum_job, contexts + i, str8("sum"));
+				job_add_child(&root, b.jobs + i);
+				job_submit(js, b.jobs + i);
+			}
+			job_submit(js, &root);
+			job_wait(js, &root, arena);
+			f64 parallel = 0;
+			for (u32 i = 0; i < b.job_count; i++) parallel += b.partial_sums[i];
+			best[3] = Min(best[3], os_timer_count() - start);
+
+			/* NOTE(rnp): partial sums of small integers are exact */
+			if (parallel != serial) {
+				printf("parallel sum: %f != %f\n", parallel, serial);
+				errors++;
+			}
+			b.job_count = saved_count;
+		}
+	}
+
+	print_result("external fan out",  best[0], options.job_count);
+	print_result("worker fan out",    best[1], options.job_count);
+	print_result("dependency chain",  best[2], options.chain_length);
+	print_result("parallel sum",      best[3], js->worker_count * 4);
+	printf("parallel sum speedup: %.2fx over serial\n", (f64)serial_ticks / (f64)best[3]);
+
+	/* NOTE(rnp): queue delay and run time of the most recent jobs */
+	f64 frequency = (f64)os_system_info()->timer_frequency;
+	u64 history   = Min(js->timing_index, JobTimingHistoryCount);
+	f64 delay = 0, run = 0;
+	for (u64 i = 0; i < history; i++) {
+		JobTiming *t = js->timings + i;
+		delay += (f64)(t->start_time - t->submit_time);
+		run   += (f64)(t->end_time   - t->start_time);
+	}
+	printf("last %llu jobs: mean queue delay %.2f us, mean run time %.2f us\n", (unsigned long long)history,
+	       delay / (f64)history / frequency * 1e6, run / (f64)history / frequency * 1e6);
+
+	printf("%6s %12s %12s %10s %10s\n", "worker", "executed", "stolen", "parked", "busy [ms]");
+	for (u32 i = 0; i < js->worker_count; i++) {
+		JobWorkerStats *s = &js->workers[i].stats;
+		printf("%6u %12llu %12llu %10llu %10.2f\n", i, (unsigned long long)s->executed,
+		       (unsigned long long)s->stolen, (unsigned long long)s->parked,
+		       (f64)s->busy_ticks / frequency * 1e3);
+	}
+
+	job_system_destroy(js);
+
+	if (errors) {
+		printf("%u errors\n", errors);
+		fflush(stdout);
+		os_exit(1);
+	}
+	fflush(stdout);
+}
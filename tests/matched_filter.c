@@ -0,0 +1,199 @@
+/* See LICENSE for license details. */
+/* NOTE(rnp): matched filter throughput over a sweep of filter lengths. short filters
+ * run as a direct form FIR while long ones are switched by the planner to overlap-save
+ * fast convolution; the sweep covers both sides of the crossover */
+#define BASE_EXPORT           function
+#define BASE_IMPORT           function
+#define BEAMFORMER_LIB_EXPORT function
+#include "base_platform.h"
+#include "ogl_beamformer_lib.c"
+
+#include <signal.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define AVERAGE_SAMPLES    countof(((BeamformerComputeStatsTable *)0)->times)
+#define RF_TIME_SAMPLES    4096
+#define CHANNEL_COUNT      128
+#define ACQUISITION_COUNT  32
+#define SAMPLING_FREQUENCY 40e6f
+
+read_only global u32 filter_lengths[] = {16, 32, 64, 128, 256, 512, 1024};
+
+typedef struct {
+	b32 loop;
+	u32 warmup_count;
+
+	char **remaining;
+	i32    remaining_count;
+} Options;
+
+global b32 g_should_exit;
+
+#define die(...) die_((char *)__func__, __VA_ARGS__)
+function no_return void
+die_(char *function_name, char *format, ...)
+{
+	if (function_name)
+		fprintf(stderr, "%s: ", function_name);
+
+	va_list ap;
+
+	va_start(ap, format);
+	vfprintf(stderr, format, ap);
+	va_end(ap);
+
+	os_exit(1);
+}
+
+#define shift_n(v, c, n) v += n, c -= n
+#define shift(v, c)   shift_n(v, c, 1)
+#define unshift(v, c) shift_n(v, c, -1)
+
+function void
+usage(char *argv0)
+{
+	die("%s [--loop] [--warmup n]\n"
+	    "    --loop:   rerun the sweep forever\n"
+	    "    --warmup: warmup with n runs\n",
+	    argv0);
+}
+
+function Options
+parse_argv(i32 argc, char *argv[])
+{
+	Options result = {0};
+
+	char *argv0 = argv[0];
+	shift(argv, argc);
+
+	while (argc > 0) {
+		str8 arg = str8_from_c_str(*argv);
+		shift(argv, argc);
+
+		if (str8_equal(arg, str8("--loop"))) {
+			result.loop = 1;
+		} else if (str8_equal(arg, str8("--warmup"))) {
+			if (argc) {
+				result.warmup_count = (u32)atoi(*argv);
+				shift(argv, argc);
+			}
+		} else if (arg.length > 0 && arg.data[0] == '-') {
+			usage(argv0);
+		} else {
+			unshift(argv, argc);
+			break;
+		}
+	}
+
+	result.remaining       = argv;
+	result.remaining_count = argc;
+
+	return result;
+}
+
+function u32
+data_size(void)
+{
+	u32 result = RF_TIME_SAMPLES * ACQUISITION_COUNT * CHANNEL_COUNT * sizeof(i16);
+	return result;
+}
+
+function b32
+send_frame(i16 *restrict data)
+{
+	b32 result = beamformer_push_data_with_compute(data, data_size(), BeamformerViewPlaneTag_XZ, 0);
+	if (!result && !g_should_exit) printf("lib error: %s\n", beamformer_get_last_error_string());
+	return result;
+}
+
+function void
+send_parameters(u32 filter_length)
+{
+	BeamformerParameters bp = {0};
+	bp.sample_count           = RF_TIME_SAMPLES;
+	bp.channel_count          = CHANNEL_COUNT;
+	bp.acquisition_count      = ACQUISITION_COUNT;
+	bp.sampling_frequency     = SAMPLING_FREQUENCY;
+	bp.demodulation_frequency = SAMPLING_FREQUENCY / 4;
+	bp.decimation_rate        = 1;
+	bp.raw_data_dimensions    = (uv2){{RF_TIME_SAMPLES * ACQUISITION_COUNT, CHANNEL_COUNT}};
+	beamformer_push_parameters(&bp);
+
+	BeamformerFilterParameters filter = {
+		.kind               = BeamformerFilterKind_MatchedChirp,
+		.sampling_frequency = SAMPLING_FREQUENCY / 2,
+		.complex            = 1,
+	};
+	filter.matched_chirp.duration      = (f32)filter_length / filter.sampling_frequency;
+	filter.matched_chirp.min_frequency = -0.25f * bp.demodulation_frequency;
+	filter.matched_chirp.max_frequency =  0.25f * bp.demodulation_frequency;
+	beamformer_create_filter(&filter, 0, 0);
+
+	i32 shader_stages = BeamformerShaderKind_Demodulate;
+	beamformer_push_pipeline(&shader_stages, 1, BeamformerDataKind_Int16);
+	beamformer_set_pipeline_stage_parameters(0, 0);
+	beamformer_set_global_timeout(1000);
+}
+
+function f32
+execute_study(Options *options, u32 filter_length, i16 *restrict data)
+{
+	send_parameters(filter_length);
+	for (u32 i = 0; !g_should_exit && i < options->warmup_count; i++)
+		send_frame(data);
+
+	u64 start     = os_timer_count();
+	f64 frequency = os_timer_frequency();
+	for (u32 i = 0; !g_should_exit && i < AVERAGE_SAMPLES; i++)
+		send_frame(data);
+	f32 result = (os_timer_count() - start) / frequency / (f32)AVERAGE_SAMPLES;
+
+	return result;
+}
+
+function void
+print_result(u32 filter_length, f32 time)
+{
+	f32 samples = (f32)RF_TIME_SAMPLES * ACQUISITION_COUNT * CHANNEL_COUNT / 2;
+	printf("matched filter %4u taps | %uF Average: %8.3f [ms] | %8.3f GB/s | %8.3f GSamples/s\n",
+	       filter_length, (u32)AVERAGE_SAMPLES, time * 1e3,
+	       (f32)data_size() / (time * (f32)GB(1)), samples / (time * 1e9f));
+}
+
+function void
+sigint(i32 _signo)
+{
+	g_should_exit = 1;
+}
+
+BASE_IMPORT void
+entry_point(i32 argc, char *argv[])
+{
+	Options options = parse_argv(argc, argv);
+
+	if (options.remaining_count)
+		usage(argv[0]);
+
+	signal(SIGINT, sigint);
+
+	BeamformerLiveImagingParameters lip = {.active = 1, .save_enabled = 1};
+	str8 short_name = str8("Matched Filter Bench");
+	memory_copy(lip.save_name_tag, short_name.data, (u64)short_name.length);
+	lip.save_name_tag_length = (i32)short_name.length;
+	beamformer_set_live_parameters(&lip);
+
+	i16 *data = malloc(data_size());
+	if (!data) die("malloc\n");
+
+	do {
+		for (i64 i = 0; !g_should_exit && i < countof(filter_lengths); i++) {
+			f32 time = execute_study(&options, filter_lengths[i], data);
+			if (!g_should_exit) print_result(filter_lengths[i], time);
+		}
+	} while (options.loop && !g_should_exit);
+
+	lip.active = 0;
+	beamformer_set_live_parameters(&lip);
+}
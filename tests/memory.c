@@ -0,0 +1,374 @@
+/* See LICENSE for license details. */
+/* NOTE(rnp): checks and benchmarks every memory primitive implementation (see util.c) that
+ * the CPU supports. each implementation is first checked against a bytewise reference over
+ * all short lengths and misalignments, then copy, non-temporal copy, clear and equal are
+ * timed over sizes from --min-size to --max-size in steps of 4x. finally a --max-size non
+ * temporal copy is split across 1 to --lanes threads the same way the beamformer splits RF
+ * uploads to show where memory bandwidth saturates. exits non zero if any implementation
+ * disagrees with the reference */
+#define BASE_EXPORT           function
+#define BASE_IMPORT           function
+#define BEAMFORMER_LIB_EXPORT function
+#include "base_platform.h"
+#include "ogl_beamformer_lib.c"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define MEMORY_CHECK_MAX_LENGTH 256
+#define MEMORY_CHECK_MAX_OFFSET 64
+
+typedef struct {
+	u64 min_size;
+	u64 max_size;
+	u32 offset;
+	u32 lane_count;
+	f64 time;
+} Options;
+
+#define die(...) die_((char *)__func__, __VA_ARGS__)
+function no_return void
+die_(char *function_name, char *format, ...)
+{
+	if (function_name)
+		fprintf(stderr, "%s: ", function_name);
+
+	va_list ap;
+
+	va_start(ap, format);
+	vfprintf(stderr, format, ap);
+	va_end(ap);
+
+	os_exit(1);
+}
+
+#include "cpu_platform.c"
+
+#define shift_n(v, c, n) v += n, c -= n
+#define shift(v, c)   shift_n(v, c, 1)
+
+function void
+usage(char *argv0)
+{
+	die("%s [--min-size bytes] [--max-size bytes] [--offset n] [--lanes n] [--time s]\n"
+	    "    --min-size:  smallest benchmark size (default: 64)\n"
+	    "    --max-size:  largest benchmark size (default: 1G); accepts K, M and G suffixes\n"
+	    "    --offset:    destination misalignment in bytes (default: 0)\n"
+	    "    --lanes:     maximum threads for the threaded copy (default: logical processors)\n"
+	    "    --time:      minimum time spent on each measurement in seconds (default: 0.25)\n", argv0);
+}
+
+function u64
+parse_size(char *s)
+{
+	char *end;
+	u64 result = strtoull(s, &end, 10);
+	switch (*end) {
+	case 'k': case 'K':{ result = KB(result); }break;
+	case 'm': case 'M':{ result = MB(result); }break;
+	case 'g': case 'G':{ result = GB(result); }break;
+	}
+	return result;
+}
+
+function Options
+parse_argv(i32 argc, char *argv[])
+{
+	Options result = {
+		.min_size   = 64,
+		.max_size   = GB(1),
+		.time       = 0.25,
+		.lane_count = os_system_info()->logical_processor_count,
+	};
+
+	char *argv0 = argv[0];
+	shift(argv, argc);
+
+	while (argc > 0) {
+		str8 arg = str8_from_c_str(*argv);
+		shift(argv, argc);
+
+		if (arg.length > 2 && arg.data[0] == '-' && arg.data[1] == '-' && argc) {
+			char *value = *argv;
+			if      (str8_equal(arg, str8("--min-size"))) result.min_size = Max(1, parse_size(value));
+			else if (str8_equal(arg, str8("--max-size"))) result.max_size = parse_size(value);
+			else if (str8_equal(arg, str8("--offset")))   result.offset   = (u32)atoi(value) % MEMORY_CHECK_MAX_OFFSET;
+			else if (str8_equal(arg, str8("--lanes")))    result.lane_count = Clamp((u32)atoi(value), 1, 64);
+			else if (str8_equal(arg, str8("--time")))     result.time     = atof(value);
+			else usage(argv0);
+			shift(argv, argc);
+		} else {
+			usage(argv0);
+		}
+	}
+
+	if (result.max_size < result.min_size)
+		die("--max-size must be at least --min-size\n");
+
+	return result;
+}
+
+function void
+fill_pattern(u8 *data, u64 size, u32 seed)
+{
+	for (u64 i = 0; i < size; i++)
+		data[i] = (u8)((i * 131 + seed) ^ (i >> 8));
+}
+
+function b32
+check_region(u8 *data, u64 size, u8 *expected)
+{
+	b32 result = 1;
+	for (u64 i = 0; result && i < size; i++)
+		result = data[i] == expected[i];
+	return result;
+}
+
+/* NOTE(rnp): the destination is surrounded by guard bytes so that writes outside of the
+ * requested range are caught along with wrong values inside of it */
+function u32
+check_functions(MemoryFunctions *mf, u8 *a, u8 *b, u8 *expected)
+{
+	u32 result = 0;
+	u64 size   = MEMORY_CHECK_MAX_LENGTH + 2 * MEMORY_CHECK_MAX_OFFSET;
+	for (u32 offset = 0; offset < MEMORY_CHECK_MAX_OFFSET; offset++) {
+		for (u32 length = 0; length <= MEMORY_CHECK_MAX_LENGTH; length++) {
+			u8 *src = b + ((offset * 7) % MEMORY_CHECK_MAX_OFFSET);
+
+			fill_pattern(b, size, offset);
+			for (u32 non_temporal = 0; non_temporal < 2; non_temporal++) {
+				fill_pattern(a, size, length + 1);
+				fill_pattern(expected, size, length + 1);
+				for (u32 i = 0; i < length; i++) expected[offset + i] = src[i];
+				mf->copy(a + offset, src, length, non_temporal);
+				if (!check_region(a, size, expected)) {
+					printf("  %s copy%s failed: length %u offset %u\n", mf->name.data,
+					       non_temporal ? " (non-temporal)" : "", length, offset);
+					result++;
+				}
+			}
+
+			fill_pattern(a, size, length + 1);
+			fill_pattern(expected, size, length + 1);
+			for (u32 i = 0; i < length; i++) expected[offset + i] = 0xA5;
+			if (mf->clear(a + offset, 0xA5, length) != a + offset || !check_region(a, size, expected)) {
+				printf("  %s clear failed: length %u offset %u\n", mf->name.data, length, offset);
+				result++;
+			}
+
+			for (u32 i = 0; i < length; i++) a[offset + i] = src[i];
+			if (!mf->equal(a + offset, src, length)) {
+				printf("  %s equal failed: length %u offset %u (equal)\n", mf->name.data, length, offset);
+				result++;
+			}
+			/* NOTE(rnp): a single differing byte must be found wherever it is */
+			for (u32 i = 0; i < length; i++) {
+				a[offset + i] ^= 0x10;
+				if (mf->equal(a + offset, src, length)) {
+					printf("  %s equal failed: length %u offset %u (differs at %u)\n",
+					       mf->name.data, length, offset, i);
+					result++;
+				}
+				a[offset + i] ^= 0x10;
+			}
+		}
+	}
+	return result;
+}
+
+typedef enum {
+	MemoryBenchmark_Copy,
+	MemoryBenchmark_CopyNonTemporal,
+	MemoryBenchmark_Clear,
+	MemoryBenchmark_Equal,
+	MemoryBenchmark_Count,
+} MemoryBenchmark;
+
+/* NOTE(rnp): returns GB/s of bytes touched by the destination (copy/clear) or by both inputs (equal) */
+function f64
+benchmark(MemoryFunctions *mf, MemoryBenchmark kind, u8 *a, u8 *b, u64 size, f64 min_time)
+{
+	f64 frequency = (f64)os_system_info()->timer_frequency;
+	u64 target    = (u64)(min_time * frequency);
+	u64 count     = 0;
+	u64 elapsed   = 0;
+	b32 sink      = 0;
+
+	/* NOTE(rnp): equal must see identical inputs so that it scans the whole range */
+	if (kind == MemoryBenchmark_Equal)
+		mf->copy(a, b, size, 0);
+
+	u64 start = os_timer_count();
+	do {
+		switch (kind) {
+		case MemoryBenchmark_Copy:{            mf->copy(a, b, size, 0);               }break;
+		case MemoryBenchmark_CopyNonTemporal:{ mf->copy(a, b, size, 1);               }break;
+		case MemoryBenchmark_Clear:{           mf->clear(a, (u8)count, size);         }break;
+		case MemoryBenchmark_Equal:{           sink += mf->equal(a, b, size);         }break;
+		InvalidDefaultCase;
+		}
+		count++;
+		elapsed = os_timer_count() - start;
+	} while (elapsed < target);
+
+	/* NOTE(rnp): keep the equal calls from being discarded */
+	if (sink == (b32)-1) printf(" ");
+
+	f64 bytes = (f64)size * (f64)count * (kind == MemoryBenchmark_Equal ? 2.0 : 1.0);
+	return bytes / ((f64)elapsed / frequency) / (1024.0 * 1024.0 * 1024.0);
+}
+
+function void
+print_size(u64 size)
+{
+	if      (size >= GB(1)) printf("%6lluG", (unsigned long long)(size >> 30));
+	else if (size >= MB(1)) printf("%6lluM", (unsigned long long)(size >> 20));
+	else if (size >= KB(1)) printf("%6lluK", (unsigned long long)(size >> 10));
+	else                    printf("%7llu",  (unsigned long long)size);
+}
+
+typedef struct {
+	u8  *dest;
+	u8  *src;
+	u64  size;
+	u32  active_lane_count;
+	b32  quit;
+} ThreadedCopy;
+
+typedef struct {
+	ThreadContext  thread;
+	ThreadedCopy  *copy;
+} ThreadedCopyLane;
+
+/* NOTE(rnp): same page granular split as beamformer_upload_copy_lane() */
+function void
+threaded_copy_lane(ThreadedCopy *tc)
+{
+	if (lane_index() < tc->active_lane_count) {
+		u64      page_count = (tc->size + KB(4) - 1) / KB(4);
+		RangeU64 pages      = subrange_n_from_n_m_count(lane_index(), tc->active_lane_count, page_count);
+		u64      start      = pages.start * KB(4);
+		u64      stop       = Min(pages.stop * KB(4), tc->size);
+		if (stop > start)
+			memory_copy_non_temporal(tc->dest + start, tc->src + start, stop - start);
+	}
+}
+
+function OS_THREAD_ENTRY_POINT_FN(threaded_copy_entry_point)
+{
+	ThreadedCopyLane *lane = user_context;
+	lane_context(&lane->thread);
+	for (;;) {
+		lane_sync();
+		if (lane->copy->quit) break;
+		threaded_copy_lane(lane->copy);
+		lane_sync();
+	}
+	return 0;
+}
+
+function void
+threaded_copy_benchmark(Arena *arena, u8 *dest, u8 *src, u64 size, u32 lane_count, f64 min_time)
+{
+	ThreadedCopy     *tc    = push_struct(arena, ThreadedCopy);
+	ThreadedCopyLane *lanes = push_array(arena, ThreadedCopyLane, lane_count);
+	tc->dest = dest;
+	tc->src  = src;
+	tc->size = size;
+
+	OSBarrier barrier = os_barrier_alloc(lane_count);
+	u64 *broadcast    = push_array(arena, u64, 8);
+	for (u32 i = 0; i < lane_count; i++) {
+		LaneContext *lc = &lanes[i].thread.lane_context;
+		lc->index            = i;
+		lc->count            = lane_count;
+		lc->barrier          = barrier;
+		lc->broadcast_memory = broadcast;
+		lanes[i].copy        = tc;
+	}
+	for (u32 i = 1; i < lane_count; i++)
+		os_create_thread("[copy]", lanes + i, threaded_copy_entry_point);
+
+	lane_context(&lanes[0].thread);
+
+	f64 frequency = (f64)os_system_info()->timer_frequency;
+	printf("threaded non-temporal copy: ");
+	print_size(size);
+	printf("\n%7s %10s %10s\n", "lanes", "GB/s", "scaling");
+
+	f64 single_lane = 0;
+	for (u32 active = 1; active <= lane_count; active = active == lane_count ? active + 1 : Min(active * 2, lane_count)) {
+		tc->active_lane_count = active;
+
+		u64 count   = 0;
+		u64 elapsed = 0;
+		u64 start   = os_timer_count();
+		do {
+			lane_sync();
+			threaded_copy_lane(tc);
+			lane_sync();
+			count++;
+			elapsed = os_timer_count() - start;
+		} while (elapsed < (u64)(min_time * frequency));
+
+		f64 bandwidth = (f64)size * (f64)count / ((f64)elapsed / frequency) / (1024.0 * 1024.0 * 1024.0);
+		if (active == 1) single_lane = bandwidth;
+		printf("%7u %10.2f %9.2fx\n", active, bandwidth, bandwidth / single_lane);
+		fflush(stdout);
+	}
+
+	tc->quit = 1;
+	lane_sync();
+}
+
+BASE_IMPORT void
+entry_point(i32 argc, char *argv[])
+{
+	Options options = parse_argv(argc, argv);
+
+	u64    buffer_size = options.max_size + MEMORY_CHECK_MAX_OFFSET;
+	Arena *arena       = arena_create(.reserve_size = 2 * buffer_size + MB(1));
+	g_platform_arena   = arena;
+
+	u64 check_size = MEMORY_CHECK_MAX_LENGTH + 2 * MEMORY_CHECK_MAX_OFFSET;
+	u8 *expected   = push_array(arena, u8, check_size, .align = 64);
+	u8 *a          = push_array(arena, u8, buffer_size, .align = 64);
+	u8 *b          = push_array(arena, u8, buffer_size, .align = 64);
+
+	u32 cpu_features = os_system_info()->cpu_features;
+	printf("memory functions: %s selected\n", memory_functions_for_features(cpu_features)->name.data);
+
+	u32 failures = 0;
+	for EachElement(memory_function_table, it) {
+		MemoryFunctions *mf = memory_function_table + it;
+		if ((cpu_features & mf->required_features) != mf->required_features) {
+			printf("%s: unsupported by this CPU, skipping\n", mf->name.data);
+			continue;
+		}
+
+		u32 errors = check_functions(mf, a, b, expected);
+		printf("%s: %s\n", mf->name.data, errors ? "FAILED" : "OK");
+		failures += errors;
+		if (errors) continue;
+
+		printf("%7s %10s %10s %10s %10s  [GB/s]\n", "size", "copy", "copy (nt)", "clear", "equal");
+		for (u64 size = options.min_size; size <= options.max_size; size *= 4) {
+			print_size(size);
+			for (u32 kind = 0; kind < MemoryBenchmark_Count; kind++)
+				printf(" %10.2f", benchmark(mf, kind, a + options.offset, b, size, options.time));
+			printf("\n");
+			fflush(stdout);
+		}
+	}
+
+	if (!failures)
+		threaded_copy_benchmark(arena, a + options.offset, b, options.max_size, options.lane_count, options.time);
+
+	if (failures) {
+		printf("%u failures\n", failures);
+		fflush(stdout);
+		os_exit(1);
+	}
+	fflush(stdout);
+}
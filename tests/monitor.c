@@ -0,0 +1,171 @@
+/* See LICENSE for license details. */
+/* NOTE(rnp): command line monitor for a running beamformer. every --interval it samples the
+ * telemetry block in shared memory (see beamformer_read_telemetry()) and prints rates and
+ * the state of the last frame. no work is queued so this can run alongside any client */
+#define BASE_EXPORT           function
+#define BASE_IMPORT           function
+#define BEAMFORMER_LIB_EXPORT function
+#include "base_platform.h"
+#include "ogl_beamformer_lib.c"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+typedef struct {
+	u32 interval_ms;
+	u32 count;
+} Options;
+
+#define die(...) die_((char *)__func__, __VA_ARGS__)
+function no_return void
+die_(char *function_name, char *format, ...)
+{
+	if (function_name)
+		fprintf(stderr, "%s: ", function_name);
+
+	va_list ap;
+
+	va_start(ap, format);
+	vfprintf(stderr, format, ap);
+	va_end(ap);
+
+	fflush(stdout);
+	os_exit(1);
+}
+
+#define shift_n(v, c, n) v += n, c -= n
+#define shift(v, c)   shift_n(v, c, 1)
+
+#define X(k, name) name,
+read_only global char *monitor_budget_names[] = {BEAMFORMER_MEMORY_BUDGET_LIST};
+#undef X
+
+function void
+usage(char *argv0)
+{
+	die("%s [--interval ms] [--count n]\n"
+	    "    --interval: time between samples in milliseconds (default: 500)\n"
+	    "    --count:    samples to print before exiting; 0 runs forever (default: 0)\n", argv0);
+}
+
+function Options
+parse_argv(i32 argc, char *argv[])
+{
+	Options result = {.interval_ms = 500};
+
+	char *argv0 = argv[0];
+	shift(argv, argc);
+
+	while (argc > 0) {
+		str8 arg = str8_from_c_str(*argv);
+		shift(argv, argc);
+
+		if (arg.length > 2 && arg.data[0] == '-' && arg.data[1] == '-' && argc) {
+			char *value = *argv;
+			if      (str8_equal(arg, str8("--interval"))) result.interval_ms = Max(1, (u32)atoi(value));
+			else if (str8_equal(arg, str8("--count")))    result.count       = (u32)atoi(value);
+			else usage(argv0);
+			shift(argv, argc);
+		} else {
+			usage(argv0);
+		}
+	}
+
+	return result;
+}
+
+function void
+monitor_print(BeamformerTelemetry *now, BeamformerTelemetry *last, f64 dt)
+{
+	BeamformerComputeTelemetry *c = &now->compute;
+	BeamformerUploadTelemetry  *u = &now->upload;
+
+	f64 frames  = (f64)(c->frames_completed  - last->compute.frames_completed);
+	f64 uploads = (f64)(u->uploads_completed - last->upload.uploads_completed);
+	f64 bytes   = (f64)(u->bytes_uploaded    - last->upload.bytes_uploaded);
+
+	u64 dropped = 0, last_dropped = 0;
+	for EachElement(c->blocks, it) {
+		dropped      += c->blocks[it].frames_dropped;
+		last_dropped += last->compute.blocks[it].frames_dropped;
+	}
+
+	printf("frames: %7.1f/s | last: %u (block %u) | queue: %u work, %u rf | cpu: %llu | rejected: %llu | dropped: %llu (%.1f/s)\n",
+	       frames / dt, c->last_frame_id, c->last_parameter_block, c->work_queue_depth,
+	       c->rf_frames_pending, (unsigned long long)c->frames_cpu, (unsigned long long)c->frames_rejected,
+	       (unsigned long long)dropped, (f64)(dropped - last_dropped) / dt);
+	printf("upload: %7.1f/s | %6.2f GB/s | last: %7.3f ms, %u B | slot stalls: %llu | copy lanes: %u\n",
+	       uploads / dt, bytes / dt / 1e9, 1e3 * u->last_upload_time, u->last_upload_size,
+	       (unsigned long long)u->slot_stalls, u->copy_lanes);
+
+	f64 total = 0;
+	for (u32 it = 0; it < c->shader_count; it++) {
+		str8 name = beamformer_shader_names[c->shader_ids[it]];
+		printf("  %-24.*s %9.3f ms", (i32)name.length, name.data, 1e3 * c->stage_times[it]);
+		if (c->stage_invocations[it]) printf(" %12llu invocations", (unsigned long long)c->stage_invocations[it]);
+		printf("\n");
+		total += c->stage_times[it];
+	}
+	if (c->shader_count) printf("  %-24s %9.3f ms\n", "Total", 1e3 * total);
+
+	u64 *ts = c->last_frame.timestamps;
+	if (now->timer_frequency && ts[BeamformerFrameTimestamp_FrameReady]) {
+		u64 start = ts[BeamformerFrameTimestamp_PushBegin];
+		if (!start) start = ts[BeamformerFrameTimestamp_UploadStart];
+		if (!start) start = ts[BeamformerFrameTimestamp_ComputeSubmit];
+		f64 latency = (f64)(ts[BeamformerFrameTimestamp_FrameReady] - start) / (f64)now->timer_frequency;
+		printf("  %-24s %9.3f ms\n", "End to End", 1e3 * latency);
+	}
+
+	for EachElement(c->blocks, it) {
+		BeamformerBlockTelemetry *b = c->blocks + it, *lb = last->compute.blocks + it;
+		if (!b->frames_completed && !b->frames_dropped) continue;
+		printf("  block %-18u %7.1f/s | latency: %7.3f ms (avg %7.3f ms) | wait: %7.3f ms | queued: %u | dropped: %.1f/s"
+		       " | %s | compiles: %u + %u background\n",
+		       (u32)it, (f64)(b->frames_completed - lb->frames_completed) / dt, 1e3 * b->last_latency,
+		       1e3 * b->average_latency, 1e3 * b->last_queue_wait, b->queued,
+		       (f64)(b->frames_dropped - lb->frames_dropped) / dt,
+		       b->interactive ? "interactive" : "specialized", b->foreground_compiles, b->background_compiles);
+	}
+
+	BeamformerMemoryBudgetTable *mb = &c->memory;
+	for (u32 it = 0; it < BeamformerMemoryBudget_Count; it++) {
+		printf("  %-24s %9.1f / %9.1f MiB\n", monitor_budget_names[it],
+		       (f64)mb->used[it] / (f64)MB(1), (f64)mb->budget[it] / (f64)MB(1));
+	}
+	u64 plan_lookups = mb->plan_cache_hits + mb->plan_cache_misses;
+	printf("  %-24s %9.1f %% (%llu / %llu, %u cached)\n", "Plan Cache Hits",
+	       plan_lookups ? 100.0 * (f64)mb->plan_cache_hits / (f64)plan_lookups : 0.0,
+	       (unsigned long long)mb->plan_cache_hits, (unsigned long long)plan_lookups, mb->plan_cache_count);
+	printf("\n");
+	fflush(stdout);
+}
+
+BASE_IMPORT void
+entry_point(i32 argc, char *argv[])
+{
+	Options options = parse_argv(argc, argv);
+
+	BeamformerTelemetry last = {0};
+	if (!beamformer_read_telemetry(&last))
+		die("failed to read telemetry: %s\n", beamformer_get_last_error_string());
+
+	u64 last_time = os_timer_count();
+	f64 timer_frequency = (f64)os_timer_frequency();
+
+	/* NOTE(rnp): never woken; only used as a timed sleep */
+	i32 sleeper = 0;
+	for (u32 sample = 0; !options.count || sample < options.count; sample++) {
+		os_wait_on_address(&sleeper, 0, options.interval_ms);
+
+		BeamformerTelemetry now;
+		if (!beamformer_read_telemetry(&now))
+			die("failed to read telemetry: %s\n", beamformer_get_last_error_string());
+
+		u64 time = os_timer_count();
+		monitor_print(&now, &last, Max(1e-6, (f64)(time - last_time) / timer_frequency));
+		last      = now;
+		last_time = time;
+	}
+}
@@ -0,0 +1,276 @@
+/* See LICENSE for license details. */
+/* NOTE(rnp): multi client scheduling benchmark against a running beamformer. each --client
+ * gets its own parameter block and thread which pushes frames back to back (or at --rate)
+ * for --seconds. the blocks' scheduling parameters are set from the client description and
+ * the main thread samples the per block telemetry to report each client's share of the
+ * beamformed frames and its latency. all clients share the same raw data size since the
+ * beamformer only has one RF buffer; --points changes the cost of each client's frames */
+#define BASE_EXPORT           function
+#define BASE_IMPORT           function
+#define BEAMFORMER_LIB_EXPORT function
+#include "base_platform.h"
+#include "ogl_beamformer_lib.c"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define MULTI_CLIENT_MAX_CLIENTS (8)
+#define MULTI_CLIENT_MAX_SAMPLES (1u << 18)
+
+typedef struct {
+	u32 points;
+	u32 rate;     /* [frames/s]; 0 pushes back to back */
+	u32 priority;
+	u32 weight;
+	f32 deadline; /* [s] */
+
+	/* NOTE(rnp): filled in by the client thread */
+	u32 block;
+	u32 pushes;
+	u32 push_failures;
+	u64 end_time;
+	i16 *data;
+	u32  data_size;
+	i32 *running;
+
+	u64 *latencies;
+	u32  latency_count;
+} Client;
+
+typedef struct {
+	Client clients[MULTI_CLIENT_MAX_CLIENTS];
+	u32    client_count;
+	u32    seconds;
+} Options;
+
+#define die(...) die_((char *)__func__, __VA_ARGS__)
+function no_return void
+die_(char *function_name, char *format, ...)
+{
+	if (function_name)
+		fprintf(stderr, "%s: ", function_name);
+
+	va_list ap;
+
+	va_start(ap, format);
+	vfprintf(stderr, format, ap);
+	va_end(ap);
+
+	fflush(stdout);
+	os_exit(1);
+}
+
+#include "cpu_platform.c"
+#include "rf_simulator.c"
+
+#define shift_n(v, c, n) v += n, c -= n
+#define shift(v, c)   shift_n(v, c, 1)
+
+function void
+usage(char *argv0)
+{
+	die("%s [--seconds n] [--client points:rate:priority:weight:deadline_ms]...\n"
+	    "    --seconds: duration of the run (default: 5)\n"
+	    "    --client:  adds a client (at most %u). rate is in frames/s with 0 pushing back to\n"
+	    "               back and a deadline of 0 disables it. trailing fields may be omitted\n"
+	    "               (default: 256:0:0:1:0 256:0:0:2:0 128:30:1:1:0)\n",
+	    argv0, MULTI_CLIENT_MAX_CLIENTS);
+}
+
+function Client
+parse_client(char *argv0, char *spec)
+{
+	Client result = {.points = 256, .weight = 1};
+	u32   *fields[] = {&result.points, &result.rate, &result.priority, &result.weight};
+
+	f32 deadline_ms = 0;
+	for (u32 field = 0; *spec; field++) {
+		char *end;
+		if (field < countof(fields)) *fields[field] = (u32)strtoul(spec, &end, 10);
+		else if (field == 4)         deadline_ms    = strtof(spec, &end);
+		else                         usage(argv0);
+
+		if (end == spec || (*end && *end != ':')) usage(argv0);
+		spec = *end ? end + 1 : end;
+	}
+	result.points   = Max(16, result.points);
+	result.weight   = Max(1,  result.weight);
+	result.deadline = Max(0, deadline_ms) * 1e-3f;
+	return result;
+}
+
+function Options
+parse_argv(i32 argc, char *argv[])
+{
+	Options result = {.seconds = 5};
+
+	char *argv0 = argv[0];
+	shift(argv, argc);
+
+	while (argc > 0) {
+		str8 arg = str8_from_c_str(*argv);
+		shift(argv, argc);
+
+		if (arg.length > 2 && arg.data[0] == '-' && arg.data[1] == '-' && argc) {
+			char *value = *argv;
+			if (str8_equal(arg, str8("--seconds"))) {
+				result.seconds = Max(1, (u32)atoi(value));
+			} else if (str8_equal(arg, str8("--client"))) {
+				if (result.client_count == MULTI_CLIENT_MAX_CLIENTS) usage(argv0);
+				result.clients[result.client_count++] = parse_client(argv0, value);
+			} else {
+				usage(argv0);
+			}
+			shift(argv, argc);
+		} else {
+			usage(argv0);
+		}
+	}
+
+	if (result.client_count == 0) {
+		result.clients[result.client_count++] = parse_client(argv0, "256:0:0:1:0");
+		result.clients[result.client_count++] = parse_client(argv0, "256:0:0:2:0");
+		result.clients[result.client_count++] = parse_client(argv0, "128:30:1:1:0");
+	}
+
+	return result;
+}
+
+function OS_THREAD_ENTRY_POINT_FN(multi_client_entry_point)
+{
+	Client *c = user_context;
+
+	f64 timer_frequency = (f64)os_timer_frequency();
+	u64 interval        = c->rate ? (u64)(timer_frequency / c->rate) : 0;
+
+	/* NOTE(rnp): never woken; only used as a timed sleep */
+	i32 sleeper = 0;
+	for (u64 next = os_timer_count(), time = next; time < c->end_time; time = os_timer_count()) {
+		if (interval) {
+			if (time < next) {
+				u32 ms = (u32)((f64)(next - time) * 1e3 / timer_frequency);
+				if (ms) os_wait_on_address(&sleeper, 0, ms);
+				else    cpu_yield();
+				continue;
+			}
+			next += interval;
+		}
+
+		if (beamformer_push_data_with_compute(c->data, c->data_size, BeamformerViewPlaneTag_XZ, c->block))
+			c->pushes++;
+		else
+			c->push_failures++;
+	}
+
+	atomic_add_u32((u32 *)c->running, (u32)-1);
+	return 0;
+}
+
+BASE_IMPORT void
+entry_point(i32 argc, char *argv[])
+{
+	Options options  = parse_argv(argc, argv);
+	Arena  *arena    = arena_create();
+	g_platform_arena = arena;
+
+	beamformer_set_global_timeout(1000);
+	if (!beamformer_reserve_parameter_blocks(options.client_count))
+		die("failed to reserve parameter blocks: %s\n", beamformer_get_last_error_string());
+
+	/* NOTE(rnp): only the output grid differs between clients so they share the RF data */
+	BeamformerSimpleParameters *bp = push_struct(arena, BeamformerSimpleParameters);
+	rf_simulation_client_parameters(bp, options.clients[0].points, 40e-3f);
+	u32 data_size = bp->raw_data_dimensions.x * bp->raw_data_dimensions.y * sizeof(i16);
+	i16 *data     = push_array(arena, i16, data_size / sizeof(i16));
+
+	BeamformerTelemetry first = {0}, now = {0};
+	if (!beamformer_read_telemetry(&first))
+		die("failed to read telemetry: %s\n", beamformer_get_last_error_string());
+
+	f64 timer_frequency = (f64)os_timer_frequency();
+	for (u32 it = 0; it < options.client_count; it++) {
+		Client *c = options.clients + it;
+		c->block     = it;
+		c->data      = data;
+		c->data_size = data_size;
+		c->latencies = push_array(arena, u64, MULTI_CLIENT_MAX_SAMPLES);
+
+		rf_simulation_client_parameters(bp, c->points, 40e-3f);
+		if (!beamformer_push_simple_parameters_at(bp, it) ||
+		    !beamformer_set_block_scheduling_at(c->priority, c->weight, c->deadline, it))
+		{
+			die("failed to configure block %u: %s\n", it, beamformer_get_last_error_string());
+		}
+
+		/* NOTE(rnp): the first frame of each block compiles its shaders; keep it out of
+		 * the measurement */
+		u64 blocks_done = first.compute.blocks[it].frames_completed;
+		if (!beamformer_push_data_with_compute(data, data_size, BeamformerViewPlaneTag_XZ, it))
+			die("failed to push data: %s\n", beamformer_get_last_error_string());
+
+		u64 warmup_end = os_timer_count() + (u64)(10 * timer_frequency);
+		for (now = first; now.compute.blocks[it].frames_completed == blocks_done; cpu_yield()) {
+			if (!beamformer_read_telemetry(&now) || os_timer_count() > warmup_end)
+				die("no frame was beamformed; is the beamformer running?\n");
+		}
+	}
+	first = now;
+
+	i32 running = (i32)options.client_count;
+	u64 start   = os_timer_count();
+	u64 end     = start + (u64)(options.seconds * timer_frequency);
+	for (u32 it = 0; it < options.client_count; it++) {
+		options.clients[it].end_time = end;
+		options.clients[it].running  = &running;
+		os_create_thread("[client]", options.clients + it, multi_client_entry_point);
+	}
+
+	/* NOTE(rnp): each block's last latency is recorded whenever its frame count changes */
+	BeamformerTelemetry last = first;
+	while (atomic_load_u32((u32 *)&running)) {
+		if (!beamformer_read_telemetry(&now))
+			die("failed to read telemetry: %s\n", beamformer_get_last_error_string());
+		for (u32 it = 0; it < options.client_count; it++) {
+			Client *c = options.clients + it;
+			if (now.compute.blocks[it].frames_completed != last.compute.blocks[it].frames_completed &&
+			    c->latency_count < MULTI_CLIENT_MAX_SAMPLES)
+			{
+				c->latencies[c->latency_count++] = (u64)(now.compute.blocks[it].last_latency * 1e9f);
+			}
+		}
+		last = now;
+		cpu_yield();
+	}
+	f64 elapsed = (f64)(os_timer_count() - start) / timer_frequency;
+
+	u64 total = now.compute.frames_completed - first.compute.frames_completed;
+	if (total == 0)
+		die("no frames were completed; is the beamformer running?\n");
+
+	u32 total_weight = 0;
+	for (u32 it = 0; it < options.client_count; it++)
+		total_weight += options.clients[it].weight;
+
+	printf("clients: %u, %.1f s, beamformed: %llu (%.1f/s)\n", options.client_count, elapsed,
+	       (unsigned long long)total, (f64)total / elapsed);
+	printf("%-5s %6s %5s %4s %4s %8s | %9s %9s %7s %7s %9s | %9s %9s %9s\n",
+	       "block", "points", "rate", "prio", "wgt", "deadline", "pushed/s", "frames/s", "share",
+	       "weight", "dropped", "p50 [ms]", "p99 [ms]", "max [ms]");
+	for (u32 it = 0; it < options.client_count; it++) {
+		Client *c = options.clients + it;
+		BeamformerBlockTelemetry *b = now.compute.blocks + it, *fb = first.compute.blocks + it;
+		u64 frames  = b->frames_completed - fb->frames_completed;
+		u64 dropped = b->frames_dropped   - fb->frames_dropped;
+		printf("%-5u %6u %5u %4u %4u %8.1f | %9.1f %9.1f %6.1f%% %6.1f%% %9llu | %9.3f %9.3f %9.3f\n",
+		       it, c->points, c->rate, c->priority, c->weight, 1e3 * c->deadline,
+		       (f64)c->pushes / elapsed, (f64)frames / elapsed, 100.0 * (f64)frames / (f64)total,
+		       100.0 * c->weight / total_weight, (unsigned long long)dropped,
+		       (f64)rf_simulation_percentile(c->latencies, c->latency_count, 0.5)  * 1e-6,
+		       (f64)rf_simulation_percentile(c->latencies, c->latency_count, 0.99) * 1e-6,
+		       (f64)rf_simulation_percentile(c->latencies, c->latency_count, 1.0)  * 1e-6);
+		if (c->push_failures)
+			printf("      %u pushes failed\n", c->push_failures);
+	}
+	fflush(stdout);
+}
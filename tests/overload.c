@@ -0,0 +1,230 @@
+/* See LICENSE for license details. */
+/* NOTE(rnp): backpressure check against a running beamformer. frames are pushed back to back
+ * for --seconds with an output grid large enough that the GPU can't keep up. the end to end
+ * latency of every frame seen in the telemetry is recorded. with a dropping policy the
+ * latency must settle: the steady state maximum has to stay within the frames that may be
+ * queued (the policy's depth plus the RF slots) times the measured frame interval and must
+ * not trend upwards. with Block the producer absorbs the overload instead so the time spent
+ * in each push is reported as well. the program fails if the latency is unbounded */
+#define BASE_EXPORT           function
+#define BASE_IMPORT           function
+#define BEAMFORMER_LIB_EXPORT function
+#include "base_platform.h"
+#include "ogl_beamformer_lib.c"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define OVERLOAD_MAX_SAMPLES (1u << 20)
+
+typedef struct {
+	BeamformerBackpressurePolicy policy;
+	u32 depth;
+	u32 seconds;
+	u32 points;
+} Options;
+
+#define die(...) die_((char *)__func__, __VA_ARGS__)
+function no_return void
+die_(char *function_name, char *format, ...)
+{
+	if (function_name)
+		fprintf(stderr, "%s: ", function_name);
+
+	va_list ap;
+
+	va_start(ap, format);
+	vfprintf(stderr, format, ap);
+	va_end(ap);
+
+	fflush(stdout);
+	os_exit(1);
+}
+
+#include "cpu_platform.c"
+#include "rf_simulator.c"
+
+#define shift_n(v, c, n) v += n, c -= n
+#define shift(v, c)   shift_n(v, c, 1)
+
+read_only global str8 overload_policy_names[] = {
+	[BeamformerBackpressurePolicy_Block]      = str8_comp("block"),
+	[BeamformerBackpressurePolicy_DropOldest] = str8_comp("drop-oldest"),
+	[BeamformerBackpressurePolicy_LatestWins] = str8_comp("latest-wins"),
+};
+
+function void
+usage(char *argv0)
+{
+	die("%s [--policy name] [--depth n] [--seconds n] [--points n]\n"
+	    "    --policy:  block, drop-oldest or latest-wins (default: latest-wins)\n"
+	    "    --depth:   queue depth target for drop-oldest (default: 1)\n"
+	    "    --seconds: duration of the overload (default: 5)\n"
+	    "    --points:  output points along x and z; raise it if nothing is dropped (default: 512)\n",
+	    argv0);
+}
+
+function Options
+parse_argv(i32 argc, char *argv[])
+{
+	Options result = {
+		.policy  = BeamformerBackpressurePolicy_LatestWins,
+		.depth   = 1,
+		.seconds = 5,
+		.points  = 512,
+	};
+
+	char *argv0 = argv[0];
+	shift(argv, argc);
+
+	while (argc > 0) {
+		str8 arg = str8_from_c_str(*argv);
+		shift(argv, argc);
+
+		if (arg.length > 2 && arg.data[0] == '-' && arg.data[1] == '-' && argc) {
+			char *value = *argv;
+			if (str8_equal(arg, str8("--policy"))) {
+				result.policy = BeamformerBackpressurePolicy_Count;
+				for EachElement(overload_policy_names, it)
+					if (str8_equal(overload_policy_names[it], str8_from_c_str(value)))
+						result.policy = (BeamformerBackpressurePolicy)it;
+				if (result.policy == BeamformerBackpressurePolicy_Count) usage(argv0);
+			}
+			else if (str8_equal(arg, str8("--depth")))   result.depth   = Max(1, (u32)atoi(value));
+			else if (str8_equal(arg, str8("--seconds"))) result.seconds = Max(2, (u32)atoi(value));
+			else if (str8_equal(arg, str8("--points")))  result.points  = Max(16, (u32)atoi(value));
+			else usage(argv0);
+			shift(argv, argc);
+		} else {
+			usage(argv0);
+		}
+	}
+
+	return result;
+}
+
+function u64
+overload_dropped(BeamformerTelemetry *t)
+{
+	u64 result = 0;
+	for EachElement(t->compute.blocks, it)
+		result += t->compute.blocks[it].frames_dropped;
+	return result;
+}
+
+BASE_IMPORT void
+entry_point(i32 argc, char *argv[])
+{
+	Options options = parse_argv(argc, argv);
+	Arena  *arena   = arena_create();
+
+	BeamformerSimpleParameters *bp = push_struct(arena, BeamformerSimpleParameters);
+	rf_simulation_client_parameters(bp, options.points, 40e-3f);
+
+	u32 data_size = bp->raw_data_dimensions.x * bp->raw_data_dimensions.y * sizeof(i16);
+	i16 *data     = push_array(arena, i16, data_size / sizeof(i16));
+
+	u64 *latencies  = push_array(arena, u64, OVERLOAD_MAX_SAMPLES);
+	u64 *sample_at  = push_array(arena, u64, OVERLOAD_MAX_SAMPLES);
+	u64 *push_times = push_array(arena, u64, OVERLOAD_MAX_SAMPLES);
+
+	beamformer_set_global_timeout(1000);
+	if (!beamformer_push_simple_parameters(bp) ||
+	    !beamformer_set_backpressure_policy(options.policy, options.depth))
+	{
+		die("failed to configure beamformer: %s\n", beamformer_get_last_error_string());
+	}
+
+	BeamformerTelemetry first = {0}, now = {0};
+	if (!beamformer_read_telemetry(&first))
+		die("failed to read telemetry: %s\n", beamformer_get_last_error_string());
+
+	/* NOTE(rnp): the first frame compiles the shaders; keep it out of the measurement */
+	if (!beamformer_push_data_with_compute(data, data_size, BeamformerViewPlaneTag_XZ, 0))
+		die("failed to push data: %s\n", beamformer_get_last_error_string());
+
+	f64 timer_frequency = (f64)os_system_info()->timer_frequency;
+	u64 warmup_end      = os_timer_count() + (u64)(10 * timer_frequency);
+	for (now = first; now.compute.frames_completed == first.compute.frames_completed; cpu_yield()) {
+		if (!beamformer_read_telemetry(&now) || os_timer_count() > warmup_end)
+			die("no frame was beamformed; is the beamformer running?\n");
+	}
+	first = now;
+
+	u64 start    = os_timer_count();
+	u64 end      = start + (u64)(options.seconds * timer_frequency);
+	u32 last_id  = first.compute.last_frame_id;
+
+	u32 pushes = 0, push_failures = 0, samples = 0;
+	for (u64 time = start; time < end; time = os_timer_count()) {
+		if (!beamformer_push_data_with_compute(data, data_size, BeamformerViewPlaneTag_XZ, 0))
+			push_failures++;
+		if (pushes < OVERLOAD_MAX_SAMPLES)
+			push_times[pushes++] = os_timer_count() - time;
+
+		if (!beamformer_read_telemetry(&now))
+			die("failed to read telemetry: %s\n", beamformer_get_last_error_string());
+
+		u64 *ts = now.compute.last_frame.timestamps;
+		if (now.compute.last_frame_id != last_id && ts[BeamformerFrameTimestamp_FrameReady] &&
+		    ts[BeamformerFrameTimestamp_PushBegin] && samples < OVERLOAD_MAX_SAMPLES)
+		{
+			latencies[samples] = ts[BeamformerFrameTimestamp_FrameReady] - ts[BeamformerFrameTimestamp_PushBegin];
+			sample_at[samples] = ts[BeamformerFrameTimestamp_FrameReady];
+			samples++;
+		}
+		last_id = now.compute.last_frame_id;
+	}
+	f64 elapsed = (f64)(os_timer_count() - start) / timer_frequency;
+
+	u64 frames  = now.compute.frames_completed - first.compute.frames_completed;
+	u64 dropped = overload_dropped(&now) - overload_dropped(&first);
+	if (frames == 0 || samples < 8)
+		die("no frames were completed; is the beamformer running?\n");
+
+	f64 frame_interval = elapsed / (f64)frames;
+	f64 ms = 1e3 / timer_frequency;
+
+	printf("policy: %s, depth: %u, points: %u x %u, %.1f s\n",
+	       overload_policy_names[options.policy].data, options.depth, options.points, options.points, elapsed);
+	printf("pushed: %u (%.1f/s, %u failed) | beamformed: %llu (%.1f/s) | dropped: %llu\n",
+	       pushes, (f64)pushes / elapsed, push_failures, (unsigned long long)frames,
+	       (f64)frames / elapsed, (unsigned long long)dropped);
+	printf("push:    p50 %8.3f ms | p99 %8.3f ms | max %8.3f ms\n",
+	       (f64)rf_simulation_percentile(push_times, pushes, 0.5)  * ms,
+	       (f64)rf_simulation_percentile(push_times, pushes, 0.99) * ms,
+	       (f64)rf_simulation_percentile(push_times, pushes, 1.0)  * ms);
+
+	/* NOTE(rnp): the first half lets the queues fill; quarters of the second half are
+	 * compared for a trend */
+	u64 steady_start = start + (end - start) / 2;
+	u32 steady = 0;
+	while (steady < samples && sample_at[steady] < steady_start) steady++;
+	u32 steady_count = samples - steady;
+	if (steady_count < 8)
+		die("too few frames in the steady state; increase --seconds\n");
+
+	u32 quarter = steady_count / 4;
+	u64 early   = rf_simulation_percentile(latencies + steady,                    quarter, 0.5);
+	u64 late    = rf_simulation_percentile(latencies + steady + 3 * quarter,      steady_count - 3 * quarter, 0.5);
+	u64 maximum = rf_simulation_percentile(latencies + steady,                    steady_count, 1.0);
+	u64 p50     = rf_simulation_percentile(latencies + steady,                    steady_count, 0.5);
+	u64 p99     = rf_simulation_percentile(latencies + steady,                    steady_count, 0.99);
+
+	u32 depth = options.policy == BeamformerBackpressurePolicy_DropOldest ? options.depth : 1;
+	f64 bound = (f64)(depth + BeamformerMaxRawDataFramesInFlight + 2) * frame_interval * 1e3;
+
+	printf("latency: p50 %8.3f ms | p99 %8.3f ms | max %8.3f ms | bound %8.3f ms\n",
+	       (f64)p50 * ms, (f64)p99 * ms, (f64)maximum * ms, bound);
+	printf("trend:   %8.3f ms -> %8.3f ms\n", (f64)early * ms, (f64)late * ms);
+
+	if (options.policy != BeamformerBackpressurePolicy_Block && dropped == 0)
+		printf("warning: nothing was dropped; the beamformer kept up. increase --points\n");
+
+	b32 bounded = (f64)maximum * ms <= bound && late <= 2 * early + (u64)(frame_interval * timer_frequency);
+	printf("%s\n", bounded ? "PASS" : "FAIL: latency is not bounded");
+	fflush(stdout);
+
+	if (!bounded) os_exit(1);
+}
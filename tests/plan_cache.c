@@ -0,0 +1,165 @@
+/* See LICENSE for license details. */
+/* NOTE(rnp): plan cache check against a running beamformer. a parameter block is cycled
+ * through --configs configurations (interpolation mode, coherency weighting and output
+ * region) for --rounds rounds. every switch pushes the parameters and one frame and times
+ * the push until that frame is ready. the first round has to plan and compile each
+ * configuration; later rounds should be served from the plan cache. the switch times of the
+ * first and later rounds and the cache hits seen in the telemetry are reported. the program
+ * fails if no later switch was a cache hit */
+#define BASE_EXPORT           function
+#define BASE_IMPORT           function
+#define BEAMFORMER_LIB_EXPORT function
+#include "base_platform.h"
+#include "ogl_beamformer_lib.c"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define PLAN_CACHE_MAX_CONFIGS (6)
+
+typedef struct {
+	u32 configs;
+	u32 rounds;
+	u32 points;
+} Options;
+
+#define die(...) die_((char *)__func__, __VA_ARGS__)
+function no_return void
+die_(char *function_name, char *format, ...)
+{
+	if (function_name)
+		fprintf(stderr, "%s: ", function_name);
+
+	va_list ap;
+
+	va_start(ap, format);
+	vfprintf(stderr, format, ap);
+	va_end(ap);
+
+	fflush(stdout);
+	os_exit(1);
+}
+
+#include "cpu_platform.c"
+#include "rf_simulator.c"
+
+#define shift_n(v, c, n) v += n, c -= n
+#define shift(v, c)   shift_n(v, c, 1)
+
+function void
+usage(char *argv0)
+{
+	die("%s [--configs n] [--rounds n] [--points n]\n"
+	    "    --configs: configurations to cycle through, at most %u (default: 4)\n"
+	    "    --rounds:  times each configuration is visited (default: 5)\n"
+	    "    --points:  output points along x and z (default: 256)\n",
+	    argv0, PLAN_CACHE_MAX_CONFIGS);
+}
+
+function Options
+parse_argv(i32 argc, char *argv[])
+{
+	Options result = {.configs = 4, .rounds = 5, .points = 256};
+
+	char *argv0 = argv[0];
+	shift(argv, argc);
+
+	while (argc > 0) {
+		str8 arg = str8_from_c_str(*argv);
+		shift(argv, argc);
+
+		if (arg.length > 2 && arg.data[0] == '-' && arg.data[1] == '-' && argc) {
+			char *value = *argv;
+			if      (str8_equal(arg, str8("--configs"))) result.configs = Clamp((u32)atoi(value), 2, PLAN_CACHE_MAX_CONFIGS);
+			else if (str8_equal(arg, str8("--rounds")))  result.rounds  = Max(2, (u32)atoi(value));
+			else if (str8_equal(arg, str8("--points")))  result.points  = Max(16, (u32)atoi(value));
+			else usage(argv0);
+			shift(argv, argc);
+		} else {
+			usage(argv0);
+		}
+	}
+
+	return result;
+}
+
+/* NOTE(rnp): config selects the interpolation mode, coherency weighting and depth range;
+ * the same as toggling them from the UI */
+function void
+plan_cache_parameters(BeamformerSimpleParameters *bp, u32 points, u32 config)
+{
+	rf_simulation_client_parameters(bp, points, 40e-3f + 10e-3f * (f32)(config >> 2));
+	bp->interpolation_mode  = config & 1 ? BeamformerInterpolationMode_Cubic : BeamformerInterpolationMode_Linear;
+	bp->coherency_weighting = (config >> 1) & 1;
+}
+
+BASE_IMPORT void
+entry_point(i32 argc, char *argv[])
+{
+	Options options = parse_argv(argc, argv);
+	Arena  *arena   = arena_create();
+
+	BeamformerSimpleParameters *bp = push_struct(arena, BeamformerSimpleParameters);
+	plan_cache_parameters(bp, options.points, 0);
+	u32 data_size = bp->raw_data_dimensions.x * bp->raw_data_dimensions.y * sizeof(i16);
+	i16 *data     = push_array(arena, i16, data_size / sizeof(i16));
+
+	u64 *first_switch  = push_array(arena, u64, options.configs);
+	u64 *later_switch  = push_array(arena, u64, options.configs * options.rounds);
+	u32  later_count   = 0;
+
+	beamformer_set_global_timeout(1000);
+
+	BeamformerTelemetry first = {0}, now = {0};
+	if (!beamformer_read_telemetry(&first))
+		die("failed to read telemetry: %s\n", beamformer_get_last_error_string());
+	now = first;
+
+	f64 timer_frequency = (f64)os_system_info()->timer_frequency;
+	for (u32 round = 0; round < options.rounds; round++) {
+		for (u32 config = 0; config < options.configs; config++) {
+			plan_cache_parameters(bp, options.points, config);
+
+			u64 frames = now.compute.frames_completed;
+			u64 start  = os_timer_count();
+			if (!beamformer_push_simple_parameters(bp) ||
+			    !beamformer_push_data_with_compute(data, data_size, BeamformerViewPlaneTag_XZ, 0))
+			{
+				die("failed to push frame: %s\n", beamformer_get_last_error_string());
+			}
+
+			u64 timeout = start + (u64)(10 * timer_frequency);
+			while (now.compute.frames_completed == frames) {
+				if (!beamformer_read_telemetry(&now) || os_timer_count() > timeout)
+					die("no frame was beamformed; is the beamformer running?\n");
+				cpu_yield();
+			}
+			u64 elapsed = os_timer_count() - start;
+
+			if (round == 0) first_switch[config]         = elapsed;
+			else            later_switch[later_count++]  = elapsed;
+		}
+	}
+
+	BeamformerMemoryBudgetTable *mb = &now.compute.memory, *fmb = &first.compute.memory;
+	u64 hits   = mb->plan_cache_hits   - fmb->plan_cache_hits;
+	u64 misses = mb->plan_cache_misses - fmb->plan_cache_misses;
+
+	f64 ms = 1e3 / timer_frequency;
+	printf("configs: %u, rounds: %u, points: %u x %u\n", options.configs, options.rounds,
+	       options.points, options.points);
+	printf("switch to frame: first round p50 %8.3f ms | later rounds p50 %8.3f ms\n",
+	       (f64)rf_simulation_percentile(first_switch, options.configs, 0.5) * ms,
+	       (f64)rf_simulation_percentile(later_switch, later_count, 0.5) * ms);
+	printf("plan cache: %llu hits, %llu misses, %u cached, %0.1f / %0.1f MiB\n",
+	       (unsigned long long)hits, (unsigned long long)misses, mb->plan_cache_count,
+	       (f64)mb->used[BeamformerMemoryBudget_PlanCache] / (f64)MB(1),
+	       (f64)mb->budget[BeamformerMemoryBudget_PlanCache] / (f64)MB(1));
+
+	b32 passed = hits > 0;
+	printf("%s\n", passed ? "PASS" : "FAIL: no configuration was served from the plan cache");
+	fflush(stdout);
+
+	if (!passed) os_exit(1);
+}
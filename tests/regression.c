@@ -0,0 +1,639 @@
+/* See LICENSE for license details. */
+/* NOTE(rnp): cross validation and performance regression check. every case is beamformed
+ * by the CPU reference (beamformer_cpu.c) and, when a beamformer is running, by the GPU
+ * through the library. the outputs are compared with a tolerance and per stage times are
+ * written as JSON. when a baseline from a previous run is given any stage slower than the
+ * threshold is reported as a regression and the program exits with a failure.
+ *
+ * the GPU evaluates transcendentals at reduced precision and loads integer data as f16 so
+ * the comparison uses the relative RMS error of the whole image. Nearest interpolation may
+ * select a neighbouring sample when a delay lands on a rounding boundary; such outliers
+ * only show up in the reported maximum error.
+ *
+ * the built in synthetic cases always run; ZBP parameter files given on the command line
+ * are added as extra cases. with no beamformer running only the CPU half is recorded.
+ */
+#define BASE_EXPORT           function
+#define BASE_IMPORT           function
+#define BEAMFORMER_LIB_EXPORT function
+#include "base_platform.h"
+#include "ogl_beamformer_lib.c"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define AVERAGE_SAMPLES countof(((BeamformerComputeStatsTable *)0)->times)
+
+#define RF_TIME_SAMPLES    2048
+#define CHANNEL_COUNT      64
+#define ACQUISITION_COUNT  16
+#define SAMPLING_FREQUENCY 40e6f
+#define CENTER_FREQUENCY   5e6f
+
+global iv3 g_output_points = {{128, 1, 256}};
+
+typedef struct {
+	u32 lane_count;
+	u32 cpu_frame_count;
+	b32 cpu_only;
+
+	f32 tolerance;
+	f32 threshold;
+
+	char *baseline;
+	char *output;
+
+	char **remaining;
+	i32    remaining_count;
+} Options;
+
+typedef struct {
+	str8 case_name;
+	str8 backend;
+	str8 stage;
+	f64  ms;
+	f64  gbps;
+	f64  mvoxels;
+} PerformanceRecord;
+DA_STRUCT(PerformanceRecord, PerformanceRecord);
+
+typedef struct {
+	char                      *name;
+	BeamformerAcquisitionKind  acquisition_kind;
+	BeamformerInterpolationMode interpolation_mode;
+	b32                        demodulate;
+	b32                        hilbert;
+	b32                        coherency_weighting;
+	u32                        readi_group_count;
+} SyntheticCase;
+
+/* NOTE(rnp): name, acquisition, interpolation, demodulate, hilbert, coherency weighting, READI groups */
+read_only global SyntheticCase synthetic_cases[] = {
+	{"forces_cubic",      BeamformerAcquisitionKind_FORCES,   BeamformerInterpolationMode_Cubic,   0, 0, 0, 0},
+	{"forces_demod",      BeamformerAcquisitionKind_FORCES,   BeamformerInterpolationMode_Linear,  1, 0, 0, 0},
+	{"forces_demod_cw",   BeamformerAcquisitionKind_FORCES,   BeamformerInterpolationMode_Linear,  1, 0, 1, 0},
+	{"forces_readi",      BeamformerAcquisitionKind_FORCES,   BeamformerInterpolationMode_Linear,  1, 0, 0, 4},
+	{"hercules_cubic",    BeamformerAcquisitionKind_HERCULES, BeamformerInterpolationMode_Cubic,   0, 0, 0, 0},
+	{"hercules_demod",    BeamformerAcquisitionKind_HERCULES, BeamformerInterpolationMode_Linear,  1, 0, 0, 0},
+	{"hercules_hilbert",  BeamformerAcquisitionKind_HERCULES, BeamformerInterpolationMode_Linear,  0, 1, 0, 0},
+	{"tpw_cubic",         BeamformerAcquisitionKind_RCA_TPW,  BeamformerInterpolationMode_Cubic,   0, 0, 0, 0},
+	{"tpw_demod_nearest", BeamformerAcquisitionKind_RCA_TPW,  BeamformerInterpolationMode_Nearest, 1, 0, 0, 0},
+	{"tpw_cw",            BeamformerAcquisitionKind_RCA_TPW,  BeamformerInterpolationMode_Cubic,   0, 0, 1, 0},
+};
+
+#define die(...) die_((char *)__func__, __VA_ARGS__)
+function no_return void
+die_(char *function_name, char *format, ...)
+{
+	if (function_name)
+		fprintf(stderr, "%s: ", function_name);
+
+	va_list ap;
+
+	va_start(ap, format);
+	vfprintf(stderr, format, ap);
+	va_end(ap);
+
+	os_exit(1);
+}
+
+#include "zbp.c"
+#include "cpu_platform.c"
+
+#define shift_n(v, c, n) v += n, c -= n
+#define shift(v, c)   shift_n(v, c, 1)
+
+function void
+usage(char *argv0)
+{
+	die("%s [--baseline file] [--output file] [--threshold f] [--tolerance f] [--lanes n]\n"
+	    "    [--frames n] [--cpu-only] [parameters_file.bp ...]\n"
+	    "    --baseline:  compare stage times against a previous --output\n"
+	    "    --output:    write stage times as JSON (default: regression.json)\n"
+	    "    --threshold: relative slow down counted as a regression (default: 0.1)\n"
+	    "    --tolerance: maximum relative RMS error between CPU and GPU (default: 1e-2)\n"
+	    "    --lanes:     CPU beamformer lane count (default: logical processor count)\n"
+	    "    --frames:    CPU frames to average (GPU always averages %u)\n"
+	    "    --cpu-only:  don't try to connect to a running beamformer\n",
+	    argv0, (u32)AVERAGE_SAMPLES);
+}
+
+function Options
+parse_argv(i32 argc, char *argv[])
+{
+	Options result = {
+		.lane_count      = os_system_info()->logical_processor_count,
+		.cpu_frame_count = 4,
+		.tolerance       = 1e-2f,
+		.threshold       = 0.1f,
+		.output          = "regression.json",
+	};
+
+	char *argv0 = argv[0];
+	shift(argv, argc);
+
+	while (argc > 0) {
+		str8 arg = str8_from_c_str(*argv);
+
+		if (str8_equal(arg, str8("--cpu-only"))) {
+			shift(argv, argc);
+			result.cpu_only = 1;
+		} else if (arg.length > 2 && arg.data[0] == '-' && arg.data[1] == '-' && argc > 1) {
+			char *value = argv[1];
+			if      (str8_equal(arg, str8("--baseline")))  result.baseline        = value;
+			else if (str8_equal(arg, str8("--output")))    result.output          = value;
+			else if (str8_equal(arg, str8("--threshold"))) result.threshold       = (f32)atof(value);
+			else if (str8_equal(arg, str8("--tolerance"))) result.tolerance       = (f32)atof(value);
+			else if (str8_equal(arg, str8("--lanes")))     result.lane_count      = Max(1, (u32)atoi(value));
+			else if (str8_equal(arg, str8("--frames")))    result.cpu_frame_count = Max(1, (u32)atoi(value));
+			else usage(argv0);
+			shift_n(argv, argc, 2);
+		} else if (arg.length > 0 && arg.data[0] == '-') {
+			usage(argv0);
+		} else {
+			break;
+		}
+	}
+
+	result.remaining       = argv;
+	result.remaining_count = argc;
+
+	return result;
+}
+
+/////////////////////////////////////
+// NOTE: Case Setup
+
+function i16 *
+generate_rf_data(Arena *arena, u32 sample_count, u32 line_count)
+{
+	i16 *result = push_array(arena, i16, (u64)sample_count * line_count);
+	u32 state   = 0x2545F491u;
+	for (u32 line = 0; line < line_count; line++) {
+		u32 burst_start = 128 + (line * 53) % (sample_count / 2);
+		for (u32 i = 0; i < sample_count; i++) {
+			state = state * 1664525u + 1013904223u;
+			f32 s = (f32)((i32)(state >> 20) - 2048) / 16.0f;
+			if (i >= burst_start && i < burst_start + 64) {
+				f32 t = (f32)(i - burst_start);
+				s += 4096.0f * sin_f32(2 * PI * CENTER_FREQUENCY * t / SAMPLING_FREQUENCY)
+				           * sin_f32(PI * t / 64.0f);
+			}
+			result[(u64)line * sample_count + i] = (i16)s;
+		}
+	}
+	return result;
+}
+
+function void
+set_output_region(BeamformerSimpleParameters *bp, v2 lateral_extent, v2 axial_extent)
+{
+	iv3 points = g_output_points;
+	v3 min_coordinate = (v3){{lateral_extent.x, axial_extent.x, 0}};
+	v3 max_coordinate = (v3){{lateral_extent.y, axial_extent.y, 0}};
+	bp->das_voxel_transform = das_transform(min_coordinate, max_coordinate, &points);
+	bp->output_points.xyz   = points;
+	bp->output_points.w     = 1;
+}
+
+function void
+synthetic_parameters(BeamformerSimpleParameters *bp, SyntheticCase *c)
+{
+	bp->acquisition_kind    = c->acquisition_kind;
+	bp->sample_count        = RF_TIME_SAMPLES;
+	bp->channel_count       = CHANNEL_COUNT;
+	bp->acquisition_count   = ACQUISITION_COUNT;
+	bp->raw_data_dimensions = (uv2){{RF_TIME_SAMPLES * ACQUISITION_COUNT, CHANNEL_COUNT}};
+	bp->data_kind           = BeamformerDataKind_Int16;
+	bp->sampling_frequency  = SAMPLING_FREQUENCY;
+	bp->speed_of_sound      = 1540.0f;
+	bp->f_number            = 0.5f;
+	bp->interpolation_mode  = c->interpolation_mode;
+	bp->xdc_element_pitch   = (v2){{0.1e-3f, 0.1e-3f}};
+	bp->xdc_transform       = m4_translation((v3){0});
+	bp->decimation_rate     = 1;
+	bp->coherency_weighting = c->coherency_weighting;
+
+	/* NOTE(rnp): the transmitting elements are split into readi_group_count groups of
+	 * ACQUISITION_COUNT; the data is from the second group */
+	if (c->readi_group_count > 1) {
+		bp->readi_group_count = c->readi_group_count;
+		bp->readi_group       = 1;
+	}
+
+	bp->emission_parameters.kind           = BeamformerEmissionKind_Sine;
+	bp->emission_parameters.sine.cycles    = 2;
+	bp->emission_parameters.sine.frequency = CENTER_FREQUENCY;
+	bp->demodulation_frequency             = CENTER_FREQUENCY;
+
+	for (u32 i = 0; i < CHANNEL_COUNT; i++)
+		bp->channel_mapping[i] = (i16)i;
+
+	u8 orientation = (BeamformerRCAOrientation_Rows << 4) | BeamformerRCAOrientation_Columns;
+	bp->transmit_receive_orientation = orientation;
+	bp->single_orientation           = 1;
+	if (c->acquisition_kind == BeamformerAcquisitionKind_RCA_TPW) {
+		for (u32 i = 0; i < ACQUISITION_COUNT; i++) {
+			bp->steering_angles[i] = -15.0f + 30.0f * (f32)i / (ACQUISITION_COUNT - 1);
+			bp->focal_depths[i]    = inf32();
+			bp->transmit_receive_orientations[i] = orientation;
+		}
+	} else {
+		bp->decode_mode  = BeamformerDecodeMode_Hadamard;
+		bp->single_focus = 1;
+		bp->focal_vector = (v2){{0, inf32()}};
+	}
+
+	set_output_region(bp, (v2){{-3.2e-3f, 3.2e-3f}}, (v2){{2e-3f, 25e-3f}});
+}
+
+/* NOTE(rnp): appends a Demodulate stage (if the data is real) followed by Decode, Hilbert
+ * (if requested) and DAS. the filter is created on the GPU side as well unless running CPU
+ * only. Hilbert uses the FFT path on both sides */
+function void
+setup_pipeline(Arena *arena, BeamformerSimpleParameters *bp, BeamformerCPUPlanInfo *info,
+               b32 demodulate, b32 hilbert, b32 push_filter)
+{
+	b32 complex_data = beamformer_data_kind_complex[bp->data_kind];
+	if (demodulate && !complex_data) {
+		BeamformerFilterParameters filter = {.sampling_frequency = bp->sampling_frequency / 2};
+		BeamformerEmissionParameters *ep = &bp->emission_parameters;
+		if (ep->kind == BeamformerEmissionKind_Chirp) {
+			filter.kind                        = BeamformerFilterKind_MatchedChirp;
+			filter.matched_chirp.duration      = ep->chirp.duration;
+			filter.matched_chirp.min_frequency = ep->chirp.min_frequency - bp->demodulation_frequency;
+			filter.matched_chirp.max_frequency = ep->chirp.max_frequency - bp->demodulation_frequency;
+			filter.complex                     = 1;
+		} else {
+			filter.kind                    = BeamformerFilterKind_Kaiser;
+			filter.kaiser.beta             = 5.65f;
+			filter.kaiser.cutoff_frequency = 0.5f * bp->demodulation_frequency;
+			filter.kaiser.length           = 36;
+		}
+		if (push_filter) beamformer_create_filter(&filter, 0, 0);
+
+		info->filters[bp->compute_stages_count] = cpu_filter_from_parameters(arena, &filter);
+		bp->compute_stage_parameters[bp->compute_stages_count] = 0;
+		bp->compute_stages[bp->compute_stages_count++] = BeamformerShaderKind_Demodulate;
+	}
+	bp->compute_stages[bp->compute_stages_count++] = BeamformerShaderKind_Decode;
+	if (hilbert) {
+		bp->compute_stage_parameters[bp->compute_stages_count] = 0;
+		bp->compute_stages[bp->compute_stages_count++] = BeamformerShaderKind_Hilbert;
+	}
+	bp->compute_stages[bp->compute_stages_count++] = BeamformerShaderKind_DAS;
+
+	info->parameters  = *(BeamformerParameters *)bp;
+	info->data_kind   = bp->data_kind;
+	info->stage_count = bp->compute_stages_count;
+	for (u32 i = 0; i < bp->compute_stages_count; i++)
+		info->stages[i] = (BeamformerShaderKind)bp->compute_stages[i];
+
+	BeamformerComputeArrayParameters *ap = push_struct(arena, BeamformerComputeArrayParameters);
+	for (u32 i = 0; i < bp->acquisition_count; i++) {
+		ap->focal_vectors[i]                 = (v2){{bp->steering_angles[i], bp->focal_depths[i]}};
+		ap->sparse_elements[i]               = bp->sparse_elements[i];
+		ap->transmit_receive_orientations[i] = bp->transmit_receive_orientations[i];
+	}
+	info->array_parameters = ap;
+}
+
+/////////////////////////////////////
+// NOTE: Measurement
+
+function u64
+cpu_stage_bytes(BeamformerCPUPlan *plan, BeamformerCPUStage kind)
+{
+	BeamformerParameters *bp = &plan->parameters;
+	u64 lines  = (u64)bp->channel_count * bp->acquisition_count;
+	u64 result = 0;
+	for (u32 i = 0; i < plan->stage_count; i++) {
+		BeamformerCPUStageInfo *s = plan->stages + i;
+		if (s->kind != kind) continue;
+		switch (kind) {
+		case BeamformerCPUStage_Load:{
+			result  = lines * s->input_samples * beamformer_data_kind_byte_size[plan->data_kind];
+			result += lines * s->output_line_floats * sizeof(f32);
+		}break;
+		case BeamformerCPUStage_DAS:{
+			result = (lines * s->input_line_floats + beamformer_cpu_output_floats(plan)) * sizeof(f32);
+		}break;
+		default:{
+			result = lines * (s->input_line_floats + s->output_line_floats) * sizeof(f32);
+		}break;
+		}
+	}
+	return result;
+}
+
+function BeamformerCPUStage
+cpu_stage_from_shader(BeamformerShaderKind shader)
+{
+	BeamformerCPUStage result = BeamformerCPUStage_Count;
+	switch (shader) {
+	case BeamformerShaderKind_Decode:{     result = BeamformerCPUStage_Decode;     }break;
+	case BeamformerShaderKind_Demodulate:{ result = BeamformerCPUStage_Demodulate; }break;
+	case BeamformerShaderKind_Filter:{     result = BeamformerCPUStage_Filter;     }break;
+	case BeamformerShaderKind_Hilbert:{    result = BeamformerCPUStage_Hilbert;    }break;
+	case BeamformerShaderKind_DAS:{        result = BeamformerCPUStage_DAS;        }break;
+	default:{}break;
+	}
+	return result;
+}
+
+function void
+push_record(Arena *arena, PerformanceRecordList *records, str8 case_name, str8 backend, str8 stage,
+            f64 seconds, u64 bytes, f64 voxels)
+{
+	PerformanceRecord *r = da_push(arena, records);
+	r->case_name = case_name;
+	r->backend   = backend;
+	r->stage     = stage;
+	r->ms        = seconds * 1e3;
+	if (seconds > 0) {
+		r->gbps    = (f64)bytes / seconds * 1e-9;
+		r->mvoxels = voxels  / seconds * 1e-6;
+	}
+	printf("  %-4.*s %-18.*s %10.3f [ms] %8.2f [GB/s] %9.2f [MVoxel/s]\n",
+	       (i32)backend.length, backend.data, (i32)stage.length, stage.data,
+	       r->ms, r->gbps, r->mvoxels);
+}
+
+typedef struct {
+	f64 rms_error;
+	f64 max_error;
+} ComparisonResult;
+
+/* NOTE(rnp): errors are relative to the RMS/maximum magnitude of the reference */
+function ComparisonResult
+compare_outputs(f32 *reference, f32 *test, u64 count)
+{
+	f64 reference_sum = 0, error_sum = 0, reference_max = 0, error_max = 0;
+	for (u64 i = 0; i < count; i++) {
+		f64 r = reference[i];
+		f64 e = (f64)test[i] - r;
+		reference_sum += r * r;
+		error_sum     += e * e;
+		reference_max  = Max(reference_max, Abs(r));
+		error_max      = Max(error_max, Abs(e));
+	}
+	ComparisonResult result = {0};
+	if (reference_sum > 0) {
+		result.rms_error = sqrt_f32((f32)(error_sum / reference_sum));
+		result.max_error = error_max / reference_max;
+	}
+	return result;
+}
+
+global b32 g_gpu_available = 1;
+
+/* NOTE(rnp): records are pushed to record_arena; arena only needs to live for the case */
+function b32
+execute_case(Arena *arena, Arena *record_arena, BeamformerCPUContext *cpu, PerformanceRecordList *records,
+             str8 name, BeamformerSimpleParameters *bp, BeamformerCPUPlanInfo *info, void *data,
+             Options *options)
+{
+	b32 result = 1;
+	printf("%.*s\n", (i32)name.length, name.data);
+
+	BeamformerCPUPlan *plan = beamformer_cpu_plan(arena, info);
+	if (plan->error.length) {
+		printf("  skipped: %.*s\n", (i32)plan->error.length, plan->error.data);
+		return result;
+	}
+
+	u64 output_floats = beamformer_cpu_output_floats(plan);
+	f64 voxels        = (f64)output_floats / (plan->iq ? 2 : 1);
+	u32 data_size     = bp->raw_data_dimensions.x * bp->raw_data_dimensions.y *
+	                    beamformer_data_kind_byte_size[bp->data_kind];
+
+	f32 *reference = push_array(arena, f32, output_floats);
+	beamformer_cpu_beamform(cpu, plan, data, reference);
+
+	/////////////////////////////
+	// NOTE: CPU reference timing
+	memory_clear(cpu->stage_ticks, 0, sizeof(cpu->stage_ticks));
+	for (u32 i = 0; i < options->cpu_frame_count; i++)
+		beamformer_cpu_beamform(cpu, plan, data, reference);
+
+	f64 frequency = os_timer_frequency() * options->cpu_frame_count;
+	f64 cpu_total = 0;
+	for (u32 i = 0; i < plan->stage_count; i++) {
+		BeamformerCPUStage stage = plan->stages[i].kind;
+		f64 seconds = (f64)cpu->stage_ticks[stage] / frequency;
+		cpu_total  += seconds;
+		push_record(record_arena, records, name, str8("cpu"), beamformer_cpu_stage_names[stage], seconds,
+		            cpu_stage_bytes(plan, stage), stage == BeamformerCPUStage_DAS ? voxels : 0);
+	}
+	push_record(record_arena, records, name, str8("cpu"), str8("Total"), cpu_total, data_size, voxels);
+
+	/////////////////////////////
+	// NOTE: GPU
+	if (g_gpu_available) {
+		f32 *output = push_array(arena, f32, output_floats);
+		if (!beamformer_beamform_data(bp, data, data_size, output, 5000)) {
+			printf("  gpu unavailable: %s\n", beamformer_get_last_error_string());
+			g_gpu_available = 0;
+		} else {
+			ComparisonResult cmp = compare_outputs(reference, output, output_floats);
+			b32 pass = cmp.rms_error <= options->tolerance;
+			printf("  validation: %s (relative rms error %.3e, max error %.3e)\n",
+			       pass ? "PASS" : "FAIL", cmp.rms_error, cmp.max_error);
+			result &= pass;
+
+			for (u32 i = 0; i < AVERAGE_SAMPLES; i++)
+				beamformer_push_data_with_compute(data, data_size, 0, 0);
+
+			BeamformerComputeStatsTable stats = {0};
+			if (beamformer_compute_timings(&stats, 5000)) {
+				f64 gpu_total = 0;
+				for (u64 it = 0; it < stats.shader_count; it++) {
+					f64 seconds = 0;
+					for (u32 frame = 0; frame < countof(stats.times); frame++)
+						seconds += stats.times[frame][it];
+					seconds   /= (f64)countof(stats.times);
+					gpu_total += seconds;
+
+					BeamformerShaderKind shader = (BeamformerShaderKind)stats.shader_ids[it];
+					BeamformerCPUStage   stage  = cpu_stage_from_shader(shader);
+					u64 bytes = stage != BeamformerCPUStage_Count ? cpu_stage_bytes(plan, stage) : 0;
+					push_record(record_arena, records, name, str8("gpu"), beamformer_shader_names[shader], seconds,
+					            bytes, shader == BeamformerShaderKind_DAS ? voxels : 0);
+				}
+				push_record(record_arena, records, name, str8("gpu"), str8("Total"), gpu_total, data_size, voxels);
+			}
+		}
+	}
+
+	return result;
+}
+
+/////////////////////////////////////
+// NOTE: Baseline
+
+/* NOTE(rnp): one record per line so that the baseline can be read back with a line scanner
+ * instead of a general JSON parser */
+function void
+write_records(PerformanceRecordList *records, char *path)
+{
+	FILE *f = fopen(path, "w");
+	if (!f) die("failed to open output: %s\n", path);
+	fprintf(f, "{\n\"version\": 1,\n\"records\": [\n");
+	for (da_count i = 0; i < records->count; i++) {
+		PerformanceRecord *r = records->data + i;
+		fprintf(f, "{\"case\": \"%.*s\", \"backend\": \"%.*s\", \"stage\": \"%.*s\", "
+		        "\"ms\": %.6f, \"gbps\": %.6f, \"mvoxels\": %.6f}%s\n",
+		        (i32)r->case_name.length, r->case_name.data, (i32)r->backend.length, r->backend.data,
+		        (i32)r->stage.length, r->stage.data, r->ms, r->gbps, r->mvoxels,
+		        i + 1 < records->count ? "," : "");
+	}
+	fprintf(f, "]\n}\n");
+	fclose(f);
+}
+
+function str8
+json_string_field(str8 line, str8 key)
+{
+	str8 result = {0};
+	i64 index = str8_find_needle(line, key, 0);
+	if (index < line.length) {
+		str8 value = str8_skip(line, index + key.length);
+		i64 start  = str8_find_needle(value, str8("\""), 0);
+		value      = str8_skip(value, start + 1);
+		result     = value;
+		result.length = str8_find_needle(value, str8("\""), 0);
+	}
+	return result;
+}
+
+function f64
+json_number_field(str8 line, str8 key)
+{
+	f64 result = 0;
+	i64 index  = str8_find_needle(line, key, 0);
+	if (index < line.length)
+		result = strtod((char *)line.data + index + key.length, 0);
+	return result;
+}
+
+function b32
+compare_baseline(PerformanceRecordList *records, Options *options)
+{
+	str8 file = os_read_file_simp(options->baseline);
+
+	b32 result = 1;
+	u32 compared = 0;
+	printf("baseline: %s (threshold %.0f%%)\n", options->baseline, options->threshold * 100);
+	while (file.length > 0) {
+		i64 end   = str8_find_needle(file, str8("\n"), 0);
+		str8 line = {.data = file.data, .length = end};
+		file      = str8_skip(file, end + 1);
+
+		str8 case_name = json_string_field(line, str8("\"case\":"));
+		if (case_name.length == 0) continue;
+		str8 backend = json_string_field(line, str8("\"backend\":"));
+		str8 stage   = json_string_field(line, str8("\"stage\":"));
+		f64  ms      = json_number_field(line, str8("\"ms\":"));
+
+		for (da_count i = 0; i < records->count; i++) {
+			PerformanceRecord *r = records->data + i;
+			if (!str8_equal(r->case_name, case_name) || !str8_equal(r->backend, backend) ||
+			    !str8_equal(r->stage, stage))
+			{
+				continue;
+			}
+
+			/* NOTE(rnp): stages this short are dominated by timer noise */
+			if (ms < 0.01) break;
+
+			compared++;
+			f64 change = r->ms / ms - 1.0;
+			if (change > options->threshold) {
+				result = 0;
+				printf("  REGRESSION %.*s %.*s %.*s: %.3f -> %.3f [ms] (%+.1f%%)\n",
+				       (i32)case_name.length, case_name.data, (i32)backend.length, backend.data,
+				       (i32)stage.length, stage.data, ms, r->ms, change * 100);
+			} else if (change < -options->threshold) {
+				printf("  improved   %.*s %.*s %.*s: %.3f -> %.3f [ms] (%+.1f%%)\n",
+				       (i32)case_name.length, case_name.data, (i32)backend.length, backend.data,
+				       (i32)stage.length, stage.data, ms, r->ms, change * 100);
+			}
+			break;
+		}
+	}
+	printf("  %u stages compared: %s\n", compared, result ? "PASS" : "FAIL");
+
+	return result;
+}
+
+BASE_IMPORT void
+entry_point(i32 argc, char *argv[])
+{
+	Options options = parse_argv(argc, argv);
+
+	Arena *arena      = arena_create(.reserve_size = GB(1));
+	Arena *case_arena = arena_create(.reserve_size = GB(4));
+	g_platform_arena  = arena;
+	g_gpu_available   = !options.cpu_only;
+
+	BeamformerCPUContext *cpu = beamformer_cpu_context_create(arena, options.lane_count);
+	if (g_gpu_available) beamformer_set_global_timeout(5000);
+
+	PerformanceRecordList records = {0};
+	b32 result = 1;
+
+	i16 *synthetic_data = generate_rf_data(arena, RF_TIME_SAMPLES, CHANNEL_COUNT * ACQUISITION_COUNT);
+	for (u32 i = 0; i < countof(synthetic_cases); i++) {
+		Temp temp = temp_begin(case_arena);
+		SyntheticCase *c = synthetic_cases + i;
+
+		BeamformerSimpleParameters bp   = {0};
+		BeamformerCPUPlanInfo      info = {0};
+		synthetic_parameters(&bp, c);
+		setup_pipeline(case_arena, &bp, &info, c->demodulate, c->hilbert, g_gpu_available);
+
+		result &= execute_case(case_arena, arena, cpu, &records, str8_from_c_str(c->name), &bp, &info,
+		                       synthetic_data, &options);
+		temp_end(temp);
+	}
+
+	for (i32 i = 0; i < options.remaining_count; i++) {
+		Temp temp = temp_begin(case_arena);
+
+		Stream path = stream_alloc(case_arena, KB(4));
+		stream_append_str8(&path, str8_from_c_str(options.remaining[i]));
+		i32 path_work_index = path.widx;
+		stream_ensure_termination(&path, 0);
+
+		ZBP_Data raw_data = {0};
+		BeamformerSimpleParameters bp   = {0};
+		BeamformerCPUPlanInfo      info = {0};
+		if (!beamformer_simple_parameters_from_zbp_file(&bp, (char *)path.data, &raw_data))
+			die("failed to load parameters file: %s\n", (char *)path.data);
+
+		set_output_region(&bp, (v2){{-20e-3f, 20e-3f}}, (v2){{5e-3f, 60e-3f}});
+		bp.f_number           = 0.5f;
+		bp.interpolation_mode = BeamformerInterpolationMode_Cubic;
+		bp.decimation_rate    = 1;
+		setup_pipeline(case_arena, &bp, &info, 1, 0, g_gpu_available);
+
+		void *data = rf_data_from_zbp(&raw_data, path, path_work_index, 0);
+
+		str8 name = push_str8(arena, str8_from_c_str(options.remaining[i]));
+		result &= execute_case(case_arena, arena, cpu, &records, name, &bp, &info, data, &options);
+		temp_end(temp);
+	}
+
+	write_records(&records, options.output);
+	printf("wrote %d records to %s\n", records.count, options.output);
+
+	if (options.baseline)
+		result &= compare_baseline(&records, &options);
+
+	beamformer_cpu_context_destroy(cpu);
+
+	/* NOTE(rnp): os_exit() skips the stdio flush */
+	fflush(stdout);
+	if (!result) os_exit(1);
+}
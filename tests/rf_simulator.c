@@ -0,0 +1,435 @@
+/* See LICENSE for license details. */
+/* NOTE(rnp): point scatterer RF simulator for benchmarks. synthesizes raw channel data for
+ * a set of point scatterers using the same delay model as the DAS shader so that the
+ * beamformed image of a scatterer lands on the scatterer. amplitude spreading, element
+ * directivity and attenuation are ignored; the goal is realistic data volume and access
+ * patterns with a known answer, not a physical simulation.
+ *
+ * supported acquisitions: FORCES, HERCULES (Hadamard encoded when decode_mode is set),
+ * RCA TPW/VLS and Flash. the excitation is taken from the emission parameters (windowed
+ * sine burst or rf_chirp()) and is centered on the echo time so the beamformer's filter
+ * delay compensation lines up.
+ *
+ * output is laid out as it is uploaded to the beamformer: [channel][transmit][sample] with
+ * an identity channel mapping. work is split over lanes by channel and the noise is seeded
+ * per line so the result doesn't depend on the lane count.
+ *
+ * requires threads.c and the os thread functions (see cpu_platform.c) to be included first.
+ */
+
+#define RF_SIMULATOR_OVERSAMPLE 8
+
+typedef struct {
+	v3  position;
+	f32 amplitude;
+} RFScatterer;
+
+typedef struct {
+	BeamformerSimpleParameters *parameters;
+
+	RFScatterer *scatterers;
+	u32          scatterer_count;
+
+	/* NOTE(rnp): uniform noise in [-noise_amplitude, noise_amplitude] */
+	f32 noise_amplitude;
+	u32 seed;
+
+	u32 lane_count;
+} RFSimulationInfo;
+
+typedef struct {
+	RFSimulationInfo *info;
+
+	/* NOTE(rnp): excitation sampled RF_SIMULATOR_OVERSAMPLE times faster than the data */
+	f32 *waveform;
+	i32  waveform_length;
+	f32  waveform_center;
+
+	f32 *hadamard;
+	f32 *scratch;
+	u32  line_count;
+
+	void *output;
+} RFSimulation;
+
+typedef struct {
+	ThreadContext  thread;
+	RFSimulation  *simulation;
+} RFSimulationWorker;
+
+function void
+rf_simulation_waveform(Arena *arena, RFSimulation *s)
+{
+	BeamformerSimpleParameters   *bp = s->info->parameters;
+	BeamformerEmissionParameters *ep = &bp->emission_parameters;
+	f32 fs = bp->sampling_frequency * RF_SIMULATOR_OVERSAMPLE;
+
+	switch (ep->kind) {
+	case BeamformerEmissionKind_Sine:{
+		f32 cycles = ep->sine.cycles > 0 ? ep->sine.cycles : 2;
+		s->waveform_length = Max(1, (i32)(cycles / ep->sine.frequency * fs));
+		s->waveform        = push_array(arena, f32, s->waveform_length);
+		/* NOTE(rnp): cosine phase so that the carrier peak is on the envelope peak */
+		f32 center = (f32)s->waveform_length / 2.0f;
+		for (i32 i = 0; i < s->waveform_length; i++) {
+			f32 t = (f32)i / (f32)s->waveform_length;
+			s->waveform[i] = cos_f32(2 * PI * ep->sine.frequency * ((f32)i - center) / fs) * sin_f32(PI * t) * sin_f32(PI * t);
+		}
+	}break;
+	case BeamformerEmissionKind_Chirp:{
+		s->waveform_length = Max(1, (i32)(ep->chirp.duration * fs));
+		s->waveform = rf_chirp(arena, ep->chirp.min_frequency, ep->chirp.max_frequency, fs, s->waveform_length, 0);
+	}break;
+	InvalidDefaultCase;
+	}
+	s->waveform_center = (f32)s->waveform_length / 2.0f;
+}
+
+function void
+rf_simulation_add_pulse(RFSimulation *s, f32 *line, u32 sample_count, f32 index, f32 amplitude)
+{
+	f32 half  = s->waveform_center / RF_SIMULATOR_OVERSAMPLE;
+	i32 start = Max(0, (i32)ceil_f32(index - half));
+	i32 stop  = Min((i32)sample_count, (i32)(index + ((f32)s->waveform_length - s->waveform_center) / RF_SIMULATOR_OVERSAMPLE));
+	for (i32 k = start; k < stop; k++) {
+		f32 position = ((f32)k - index) * RF_SIMULATOR_OVERSAMPLE + s->waveform_center;
+		i32 i0 = (i32)position;
+		if (i0 >= 0 && i0 + 1 < s->waveform_length) {
+			f32 t = position - (f32)i0;
+			line[k] += amplitude * ((1 - t) * s->waveform[i0] + t * s->waveform[i0 + 1]);
+		}
+	}
+}
+
+/* NOTE(rnp): these mirror the transmit and receive models in das.glsl */
+function f32
+rf_simulation_rca_transmit_distance(v3 point, v2 focal_vector, u32 tx_rx_orientation)
+{
+	f32 result = 0;
+	u32 tx = (tx_rx_orientation >> 4) & 0x0F;
+	if (tx != BeamformerRCAOrientation_None) {
+		f32 px    = tx == BeamformerRCAOrientation_Rows ? point.y : point.x;
+		f32 angle = focal_vector.x * PI / 180.0f;
+		f32 depth = focal_vector.y;
+		if (depth == inf32() || depth == -inf32()) {
+			result = px * sin_f32(angle) + point.z * cos_f32(angle);
+		} else {
+			f32 dx = px      - depth * sin_f32(angle);
+			f32 dz = point.z - depth * cos_f32(angle);
+			result = sqrt_f32(dx * dx + dz * dz);
+		}
+	}
+	return result;
+}
+
+/* NOTE(rnp): sample index of the echo from point for the (decoded) transmit on channel */
+function f32
+rf_simulation_echo_index(BeamformerSimpleParameters *bp, v3 point, u32 transmit, u32 channel)
+{
+	v3  q    = m4_mul_v3(bp->xdc_transform, point);
+	v2  p    = bp->xdc_element_pitch;
+	f32 c    = bp->speed_of_sound;
+	f32 rx   = (f32)channel;
+	f32 tx   = (f32)transmit;
+	f32 time = 0;
+
+	b32 single_focus = bp->single_focus;
+	v2  focal_vector = single_focus ? bp->focal_vector : (v2){{bp->steering_angles[transmit], bp->focal_depths[transmit]}};
+	u32 orientation  = bp->single_orientation ? bp->transmit_receive_orientation
+	                                          : bp->transmit_receive_orientations[transmit];
+
+	switch (bp->acquisition_kind) {
+	case BeamformerAcquisitionKind_FORCES:{
+		f32 dx_tx = q.x - tx * p.x, dy_tx = q.y - p.y * (f32)bp->channel_count / 2;
+		f32 dx_rx = q.x - rx * p.x;
+		time = (sqrt_f32(dx_tx * dx_tx + dy_tx * dy_tx + q.z * q.z) + sqrt_f32(dx_rx * dx_rx + q.z * q.z)) / c;
+	}break;
+	case BeamformerAcquisitionKind_HERCULES:{
+		b32 rx_cols  = (orientation & 0x0F) == BeamformerRCAOrientation_Columns;
+		f32 rx_delta = rx_cols ? q.x - rx * p.x : q.y - rx * p.y;
+		f32 tx_delta = rx_cols ? q.y - tx * p.y : q.x - tx * p.x;
+		f32 distance = sqrt_f32(q.z * q.z + rx_delta * rx_delta + tx_delta * tx_delta);
+		time = (rf_simulation_rca_transmit_distance(point, focal_vector, orientation) + distance) / c;
+	}break;
+	case BeamformerAcquisitionKind_RCA_TPW:
+	case BeamformerAcquisitionKind_RCA_VLS:
+	case BeamformerAcquisitionKind_Flash:
+	{
+		b32 rx_rows  = (orientation & 0x0F) == BeamformerRCAOrientation_Rows;
+		f32 u        = (rx_rows ? q.y : q.x) - rx * (rx_rows ? p.y : p.x);
+		f32 distance = sqrt_f32(u * u + q.z * q.z);
+		time = (rf_simulation_rca_transmit_distance(point, focal_vector, orientation) + distance) / c;
+	}break;
+	InvalidDefaultCase;
+	}
+
+	f32 result = (time + bp->time_offset) * bp->sampling_frequency;
+	return result;
+}
+
+function void
+rf_simulate_lane(RFSimulation *s)
+{
+	BeamformerSimpleParameters *bp = s->info->parameters;
+	u32 sample_count   = bp->sample_count;
+	u32 transmit_count = bp->acquisition_count;
+	u64 line_floats    = (u64)sample_count * transmit_count;
+	f32 *scratch       = s->scratch + lane_index() * line_floats;
+
+	RangeU64 channels = lane_range(bp->channel_count);
+	for (u64 channel = channels.start; channel < channels.stop; channel++) {
+		memory_clear(scratch, 0, line_floats * sizeof(f32));
+
+		for (u32 transmit = 0; transmit < transmit_count; transmit++) {
+			for (u32 it = 0; it < s->info->scatterer_count; it++) {
+				RFScatterer *scatterer = s->info->scatterers + it;
+				f32 index = rf_simulation_echo_index(bp, scatterer->position, transmit, (u32)channel);
+				if (s->hadamard) {
+					/* NOTE(rnp): the raw data for event j is the sum of every decoded transmit
+					 * weighted by the encoding; decode() divides by the transmit count */
+					for (u32 j = 0; j < transmit_count; j++) {
+						f32 sign = s->hadamard[transmit_count * j + transmit];
+						rf_simulation_add_pulse(s, scratch + j * sample_count, sample_count, index,
+						                        sign * scatterer->amplitude);
+					}
+				} else {
+					rf_simulation_add_pulse(s, scratch + transmit * sample_count, sample_count, index,
+					                        scatterer->amplitude);
+				}
+			}
+		}
+
+		if (s->info->noise_amplitude > 0) {
+			for (u32 line = 0; line < transmit_count; line++) {
+				u32 state = s->info->seed ^ (0x9E3779B9u * (u32)(channel * transmit_count + line + 1));
+				for (u32 i = 0; i < sample_count; i++) {
+					state = state * 1664525u + 1013904223u;
+					f32 noise = ((f32)(state >> 8) / (f32)(1u << 24)) * 2.0f - 1.0f;
+					scratch[line * sample_count + i] += s->info->noise_amplitude * noise;
+				}
+			}
+		}
+
+		u64 offset = channel * line_floats;
+		switch (bp->data_kind) {
+		case BeamformerDataKind_Int16:{
+			i16 *out = (i16 *)s->output + offset;
+			for (u64 i = 0; i < line_floats; i++) {
+				f32 value = scratch[i] + (scratch[i] < 0 ? -0.5f : 0.5f);
+				out[i] = (i16)Clamp(value, -32768.0f, 32767.0f);
+			}
+		}break;
+		case BeamformerDataKind_Float32:{
+			memory_copy((f32 *)s->output + offset, scratch, line_floats * sizeof(f32));
+		}break;
+		InvalidDefaultCase;
+		}
+	}
+}
+
+function OS_THREAD_ENTRY_POINT_FN(rf_simulation_worker_entry_point)
+{
+	RFSimulationWorker *worker = user_context;
+	lane_context(&worker->thread);
+	rf_simulate_lane(worker->simulation);
+	lane_sync();
+	return 0;
+}
+
+/* NOTE(rnp): returns 0 for unsupported acquisitions or data kinds. the returned data is
+ * bp->raw_data_dimensions in size */
+function void *
+rf_simulate(Arena *arena, RFSimulationInfo *info)
+{
+	BeamformerSimpleParameters *bp = info->parameters;
+
+	b32 supported = bp->data_kind == BeamformerDataKind_Int16 || bp->data_kind == BeamformerDataKind_Float32;
+	switch (bp->acquisition_kind) {
+	case BeamformerAcquisitionKind_FORCES:
+	case BeamformerAcquisitionKind_HERCULES:
+	case BeamformerAcquisitionKind_RCA_TPW:
+	case BeamformerAcquisitionKind_RCA_VLS:
+	case BeamformerAcquisitionKind_Flash:
+	{}break;
+	default:{ supported = 0; }break;
+	}
+	if (!supported) return 0;
+
+	RFSimulation *s = push_struct(arena, RFSimulation);
+	s->info = info;
+	rf_simulation_waveform(arena, s);
+
+	u32 transmit_count = bp->acquisition_count;
+	if (bp->decode_mode == BeamformerDecodeMode_Hadamard) {
+		f16 *h = make_hadamard_transpose(arena, (i32)transmit_count, 0);
+		if (!h) return 0;
+		s->hadamard = push_array(arena, f32, transmit_count * transmit_count);
+		for (u32 i = 0; i < transmit_count * transmit_count; i++)
+			s->hadamard[i] = (f32)h[i];
+	}
+
+	u32 lane_count = Clamp(info->lane_count, 1, Max(1, bp->channel_count));
+	u64 line_floats = (u64)bp->sample_count * transmit_count;
+	s->scratch = push_array_no_zero(arena, f32, line_floats * lane_count, .align = 64);
+	s->output  = push_array_no_zero(arena, u8, line_floats * bp->channel_count *
+	                                beamformer_data_kind_byte_size[bp->data_kind], .align = 64);
+
+	RFSimulationWorker *workers = push_array(arena, RFSimulationWorker, lane_count);
+	OSBarrier barrier = os_barrier_alloc(lane_count);
+	u64 *broadcast    = push_array(arena, u64, 8);
+	for (u32 i = 0; i < lane_count; i++) {
+		LaneContext *lc = &workers[i].thread.lane_context;
+		lc->index            = i;
+		lc->count            = lane_count;
+		lc->barrier          = barrier;
+		lc->broadcast_memory = broadcast;
+		workers[i].simulation = s;
+	}
+	for (u32 i = 1; i < lane_count; i++)
+		os_create_thread("[rf simulator]", workers + i, rf_simulation_worker_entry_point);
+
+	lane_context(&workers[0].thread);
+	rf_simulate_lane(s);
+	lane_sync();
+
+	return s->output;
+}
+
+/////////////////////////////////////
+// NOTE: Setup Helpers
+
+/* NOTE(rnp): fills out an acquisition with 0.1 mm pitch, 5 MHz center frequency and 4x
+ * sampling. the transducer transform places the aperture center at the world origin */
+function void
+rf_simulation_parameters(BeamformerSimpleParameters *bp, BeamformerAcquisitionKind kind,
+                         u32 channel_count, u32 transmit_count, u32 sample_count, b32 chirp)
+{
+	bp->acquisition_kind       = kind;
+	bp->sample_count           = sample_count;
+	bp->channel_count          = channel_count;
+	bp->acquisition_count      = transmit_count;
+	bp->raw_data_dimensions    = (uv2){{sample_count * transmit_count, channel_count}};
+	bp->data_kind              = BeamformerDataKind_Int16;
+	bp->sampling_mode          = BeamformerSamplingMode_4X;
+	bp->demodulation_frequency = 5e6f;
+	bp->sampling_frequency     = 4 * bp->demodulation_frequency;
+	bp->speed_of_sound         = 1540.0f;
+	bp->xdc_element_pitch      = (v2){{0.1e-3f, 0.1e-3f}};
+	bp->xdc_transform          = m4_translation((v3){{(f32)channel_count * bp->xdc_element_pitch.x / 2,
+	                                                  (f32)channel_count * bp->xdc_element_pitch.y / 2, 0}});
+
+	if (chirp) {
+		bp->emission_parameters.kind                = BeamformerEmissionKind_Chirp;
+		bp->emission_parameters.chirp.duration      = 2e-6f;
+		bp->emission_parameters.chirp.min_frequency = 3e6f;
+		bp->emission_parameters.chirp.max_frequency = 7e6f;
+	} else {
+		bp->emission_parameters.kind           = BeamformerEmissionKind_Sine;
+		bp->emission_parameters.sine.cycles    = 2;
+		bp->emission_parameters.sine.frequency = bp->demodulation_frequency;
+	}
+
+	for (u32 i = 0; i < channel_count; i++)
+		bp->channel_mapping[i] = (i16)i;
+
+	u32 orientation = (BeamformerRCAOrientation_Rows << 4) | BeamformerRCAOrientation_Columns;
+	bp->transmit_receive_orientation = orientation;
+	bp->single_orientation           = 1;
+	bp->single_focus                 = 1;
+	bp->focal_vector                 = (v2){{0, inf32()}};
+
+	switch (kind) {
+	case BeamformerAcquisitionKind_FORCES:
+	case BeamformerAcquisitionKind_HERCULES:
+	{
+		bp->decode_mode = BeamformerDecodeMode_Hadamard;
+	}break;
+	case BeamformerAcquisitionKind_RCA_TPW:
+	case BeamformerAcquisitionKind_RCA_VLS:
+	case BeamformerAcquisitionKind_Flash:
+	{
+		bp->single_focus = 0;
+		f32 aperture = (f32)channel_count * bp->xdc_element_pitch.x;
+		for (u32 i = 0; i < transmit_count; i++) {
+			f32 t = transmit_count > 1 ? (f32)i / (f32)(transmit_count - 1) : 0.5f;
+			bp->transmit_receive_orientations[i] = (u8)orientation;
+			if (kind == BeamformerAcquisitionKind_RCA_TPW) {
+				bp->steering_angles[i] = -15.0f + 30.0f * t;
+				bp->focal_depths[i]    = inf32();
+			} else if (kind == BeamformerAcquisitionKind_RCA_VLS) {
+				/* NOTE(rnp): virtual sources behind the array spread across the aperture */
+				f32 origin = aperture * (t - 0.5f);
+				f32 depth  = -aperture;
+				bp->steering_angles[i] = atan2_f32(origin, -depth) * 180.0f / PI;
+				bp->focal_depths[i]    = -sqrt_f32(depth * depth + origin * origin);
+			} else {
+				bp->steering_angles[i] = 0;
+				bp->focal_depths[i]    = inf32();
+			}
+		}
+	}break;
+	InvalidDefaultCase;
+	}
+}
+
+/* NOTE(rnp): the acquisition shared by the client load tests (overload, multi_client,
+ * plan_cache and interactive): 128 channel, 32 transmit Hadamard FORCES with 2048 samples,
+ * beamformed by Decode -> DAS onto a points x points grid in the xz plane from 2 mm down
+ * to max_depth. the tests only override what they vary */
+function void
+rf_simulation_client_parameters(BeamformerSimpleParameters *bp, u32 points, f32 max_depth)
+{
+	zero_struct(bp);
+	rf_simulation_parameters(bp, BeamformerAcquisitionKind_FORCES, 128, 32, 2048, 0);
+	bp->f_number           = 0.5f;
+	bp->interpolation_mode = BeamformerInterpolationMode_Linear;
+	bp->decimation_rate    = 1;
+
+	iv3 output_points = {{(i32)points, 1, (i32)points}};
+	f32 half_width    = (f32)bp->channel_count * bp->xdc_element_pitch.x / 2;
+	bp->das_voxel_transform = das_transform((v3){{-half_width, 2e-3f, 0}}, (v3){{half_width, max_depth, 0}},
+	                                        &output_points);
+	bp->output_points.xyz   = output_points;
+	bp->output_points.w     = 1;
+
+	bp->compute_stages[bp->compute_stages_count++] = BeamformerShaderKind_Decode;
+	bp->compute_stages[bp->compute_stages_count++] = BeamformerShaderKind_DAS;
+}
+
+function i32
+rf_simulation_u64_compare(const void *a, const void *b)
+{
+	u64 va = *(u64 *)a, vb = *(u64 *)b;
+	return va < vb ? -1 : va > vb;
+}
+
+/* NOTE(rnp): p in [0, 1]; sorts values in place. returns 0 when there are no values */
+function u64
+rf_simulation_percentile(u64 *values, u32 count, f64 p)
+{
+	u64 result = 0;
+	if (count) {
+		qsort(values, count, sizeof(*values), rf_simulation_u64_compare);
+		result = values[Min((u32)((f64)count * p), count - 1)];
+	}
+	return result;
+}
+
+/* NOTE(rnp): count_x * count_z scatterers on a regular grid in the world xz plane */
+function RFScatterer *
+rf_simulation_scatterer_grid(Arena *arena, u32 count_x, u32 count_z, v2 lateral_extent, v2 axial_extent,
+                             f32 amplitude)
+{
+	RFScatterer *result = push_array(arena, RFScatterer, count_x * count_z);
+	for (u32 z = 0; z < count_z; z++) {
+		for (u32 x = 0; x < count_x; x++) {
+			f32 tx = count_x > 1 ? (f32)x / (f32)(count_x - 1) : 0.5f;
+			f32 tz = count_z > 1 ? (f32)z / (f32)(count_z - 1) : 0.5f;
+			RFScatterer *s = result + z * count_x + x;
+			s->position.x = lateral_extent.x + tx * (lateral_extent.y - lateral_extent.x);
+			s->position.z = axial_extent.x + tz * (axial_extent.y - axial_extent.x);
+			s->amplitude  = amplitude;
+		}
+	}
+	return result;
+}
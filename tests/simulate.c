@@ -0,0 +1,196 @@
+/* See LICENSE for license details. */
+/* NOTE(rnp): writes a synthetic point scatterer acquisition (see rf_simulator.c) as a self
+ * contained ZBP file which can be passed to throughput or regression. all inputs are
+ * deterministic so the same arguments always produce the same file */
+#define BASE_EXPORT           function
+#define BASE_IMPORT           function
+#define BEAMFORMER_LIB_EXPORT function
+#include "base_platform.h"
+#include "ogl_beamformer_lib.c"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+typedef struct {
+	BeamformerAcquisitionKind acquisition_kind;
+
+	u32 channel_count;
+	u32 transmit_count;
+	u32 sample_count;
+	u32 points_x;
+	u32 points_z;
+	u32 lane_count;
+	u32 seed;
+
+	f32 noise;
+	b32 chirp;
+	b32 float_data;
+	b32 compress;
+
+	char *output;
+} Options;
+
+#define die(...) die_((char *)__func__, __VA_ARGS__)
+function no_return void
+die_(char *function_name, char *format, ...)
+{
+	if (function_name)
+		fprintf(stderr, "%s: ", function_name);
+
+	va_list ap;
+
+	va_start(ap, format);
+	vfprintf(stderr, format, ap);
+	va_end(ap);
+
+	os_exit(1);
+}
+
+#include "zbp.c"
+#include "cpu_platform.c"
+#include "rf_simulator.c"
+
+#define shift_n(v, c, n) v += n, c -= n
+#define shift(v, c)   shift_n(v, c, 1)
+
+read_only global str8 simulation_kind_names[] = {
+	str8_comp("forces"),
+	str8_comp("hercules"),
+	str8_comp("tpw"),
+	str8_comp("vls"),
+	str8_comp("flash"),
+};
+
+read_only global BeamformerAcquisitionKind simulation_kinds[] = {
+	BeamformerAcquisitionKind_FORCES,
+	BeamformerAcquisitionKind_HERCULES,
+	BeamformerAcquisitionKind_RCA_TPW,
+	BeamformerAcquisitionKind_RCA_VLS,
+	BeamformerAcquisitionKind_Flash,
+};
+static_assert(countof(simulation_kind_names) == countof(simulation_kinds), "");
+
+function void
+usage(char *argv0)
+{
+	die("%s [--kind forces|hercules|tpw|vls|flash] [--channels n] [--transmits n] [--samples n]\n"
+	    "    [--points nx nz] [--noise f] [--seed n] [--lanes n] [--chirp] [--float] [--zstd]\n"
+	    "    [--output file.bp]\n"
+	    "    --points:    grid of point scatterers between 5 and 25 mm (default: 5 5)\n"
+	    "    --noise:     uniform noise amplitude relative to a scatterer (default: 0)\n"
+	    "    --chirp:     3-7 MHz chirp excitation instead of a 2 cycle sine\n"
+	    "    --float:     store Float32 samples instead of Int16\n"
+	    "    --zstd:      compress the stored samples\n", argv0);
+}
+
+function Options
+parse_argv(i32 argc, char *argv[])
+{
+	Options result = {
+		.acquisition_kind = BeamformerAcquisitionKind_FORCES,
+		.channel_count    = 64,
+		.transmit_count   = 64,
+		.sample_count     = 2048,
+		.points_x         = 5,
+		.points_z         = 5,
+		.lane_count       = os_system_info()->logical_processor_count,
+		.seed             = 1,
+		.output           = "simulated.bp",
+	};
+
+	char *argv0 = argv[0];
+	shift(argv, argc);
+
+	while (argc > 0) {
+		str8 arg = str8_from_c_str(*argv);
+		shift(argv, argc);
+
+		if (str8_equal(arg, str8("--chirp"))) {
+			result.chirp = 1;
+		} else if (str8_equal(arg, str8("--float"))) {
+			result.float_data = 1;
+		} else if (str8_equal(arg, str8("--zstd"))) {
+			result.compress = 1;
+		} else if (str8_equal(arg, str8("--points")) && argc > 1) {
+			result.points_x = Max(1, (u32)atoi(argv[0]));
+			result.points_z = Max(1, (u32)atoi(argv[1]));
+			shift_n(argv, argc, 2);
+		} else if (str8_equal(arg, str8("--kind")) && argc) {
+			i32 index = -1;
+			for (i32 i = 0; i < (i32)countof(simulation_kind_names) && index < 0; i++)
+				if (str8_match(simulation_kind_names[i], str8_from_c_str(*argv), StringMatchFlag_CaseInsensitive))
+					index = i;
+			if (index < 0) usage(argv0);
+			result.acquisition_kind = simulation_kinds[index];
+			shift(argv, argc);
+		} else if (arg.length > 2 && arg.data[0] == '-' && arg.data[1] == '-' && argc) {
+			char *value = *argv;
+			if      (str8_equal(arg, str8("--channels")))  result.channel_count  = (u32)atoi(value);
+			else if (str8_equal(arg, str8("--transmits"))) result.transmit_count = (u32)atoi(value);
+			else if (str8_equal(arg, str8("--samples")))   result.sample_count   = (u32)atoi(value);
+			else if (str8_equal(arg, str8("--lanes")))     result.lane_count     = Max(1, (u32)atoi(value));
+			else if (str8_equal(arg, str8("--seed")))      result.seed           = (u32)atoi(value);
+			else if (str8_equal(arg, str8("--noise")))     result.noise          = (f32)atof(value);
+			else if (str8_equal(arg, str8("--output")))    result.output         = value;
+			else usage(argv0);
+			shift(argv, argc);
+		} else {
+			usage(argv0);
+		}
+	}
+
+	if (!Between(result.channel_count,  1, BeamformerMaxChannelCount) ||
+	    !Between(result.transmit_count, 1, BeamformerMaxEmissionsCount) ||
+	    result.sample_count == 0)
+	{
+		die("channel, transmit or sample count out of range\n");
+	}
+
+	return result;
+}
+
+BASE_IMPORT void
+entry_point(i32 argc, char *argv[])
+{
+	Arena *arena     = arena_create(.reserve_size = GB(4));
+	g_platform_arena = arena;
+
+	Options options = parse_argv(argc, argv);
+
+	BeamformerSimpleParameters *bp = push_struct(arena, BeamformerSimpleParameters);
+	rf_simulation_parameters(bp, options.acquisition_kind, options.channel_count, options.transmit_count,
+	                         options.sample_count, options.chirp);
+	if (options.float_data) bp->data_kind = BeamformerDataKind_Float32;
+
+	/* NOTE(rnp): scatterers on a grid spanning most of the receive aperture */
+	f32 half_width = 0.4f * (f32)options.channel_count * bp->xdc_element_pitch.x;
+	RFSimulationInfo info = {
+		.parameters      = bp,
+		.scatterer_count = options.points_x * options.points_z,
+		.noise_amplitude = options.noise * 1024.0f,
+		.seed            = options.seed,
+		.lane_count      = options.lane_count,
+	};
+	info.scatterers = rf_simulation_scatterer_grid(arena, options.points_x, options.points_z,
+	                                               (v2){{-half_width, half_width}}, (v2){{5e-3f, 25e-3f}},
+	                                               1024.0f);
+
+	u64 start = os_timer_count();
+	void *data = rf_simulate(arena, &info);
+	f64 elapsed = (f64)(os_timer_count() - start) / (f64)os_system_info()->timer_frequency;
+	if (!data)
+		die("unsupported acquisition: %s with %u transmits\n",
+		    beamformer_acquisition_kind_strings[options.acquisition_kind].data, options.transmit_count);
+
+	if (!zbp_write_file(*arena, options.output, bp, data, options.compress))
+		die("failed to write: %s\n", options.output);
+
+	u64 bytes = (u64)bp->raw_data_dimensions.x * bp->raw_data_dimensions.y *
+	            beamformer_data_kind_byte_size[bp->data_kind];
+	printf("%s: %s %u channels x %u transmits x %u samples, %u scatterers, %.1f MB in %.3f s (%u lanes)\n",
+	       options.output, beamformer_acquisition_kind_strings[options.acquisition_kind].data,
+	       bp->channel_count, bp->acquisition_count, bp->sample_count, info.scatterer_count,
+	       (f64)bytes / (1024.0 * 1024.0), elapsed, Min(options.lane_count, bp->channel_count));
+	fflush(stdout);
+}
@@ -0,0 +1,693 @@
+/* See LICENSE for license details. */
+/* NOTE(rnp): parameter sweep benchmark. every combination of the requested axes is run
+ * against a running beamformer (or the CPU reference with --cpu) using data from the point
+ * scatterer simulator. each configuration is run warmup times untimed followed by repeats
+ * timed frames; the frame latency statistics, throughput and the per stage times are
+ * written as CSV and/or JSON with one configuration per row.
+ *
+ * GPU latency is the round trip from upload until the output is available to the library.
+ * GPU stage times are the average of the compute stats table which holds the last 32
+ * frames, so repeats is raised to at least 32 for the GPU. the same frames give the mean
+ * time spent in each step between the client push and the frame being ready (see
+ * BEAMFORMER_FRAME_TIMESTAMP_LIST); it is printed and written to the JSON as "latency".
+ *
+ * axes take comma separated lists, for example:
+ *   sweep --points 256x512,512x1024 --channels 64,128 --interpolation linear,cubic
+ */
+#define BASE_EXPORT           function
+#define BASE_IMPORT           function
+#define BEAMFORMER_LIB_EXPORT function
+#include "base_platform.h"
+#include "ogl_beamformer_lib.c"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define STATS_FRAMES    countof(((BeamformerComputeStatsTable *)0)->times)
+#define SWEEP_MAX_AXIS  16
+
+#define SWEEP_AXIS_LIST \
+	X(points,        "points")        \
+	X(channels,      "channels")      \
+	X(transmits,     "transmits")     \
+	X(data_kind,     "data-kind")     \
+	X(interpolation, "interpolation") \
+	X(filter_length, "filter-length") \
+	X(decode,        "decode")        \
+	X(coherency,     "coherency")     \
+
+typedef enum {
+	#define X(name, ...) SweepAxis_ ##name,
+	SWEEP_AXIS_LIST
+	#undef X
+	SweepAxis_Count,
+} SweepAxis;
+
+read_only global str8 sweep_axis_names[] = {
+	#define X(_n, name, ...) str8_comp(name),
+	SWEEP_AXIS_LIST
+	#undef X
+};
+
+typedef struct {
+	/* NOTE(rnp): points are packed as x << 16 | z */
+	u32 values[SWEEP_MAX_AXIS];
+	u32 count;
+} SweepValues;
+
+typedef struct {
+	SweepValues axes[SweepAxis_Count];
+
+	BeamformerAcquisitionKind acquisition_kind;
+	u32 sample_count;
+	u32 warmup;
+	u32 repeats;
+	u32 lane_count;
+	b32 cpu;
+
+	char *csv;
+	char *json;
+} Options;
+
+typedef struct {
+	str8 name;
+	f64  ms;
+	f64  p99_ms;
+} StageTime;
+
+typedef struct {
+	u32  values[SweepAxis_Count];
+	str8 skipped;
+
+	f64 mean_ms;
+	f64 median_ms;
+	f64 p99_ms;
+	f64 gbps;
+	f64 mvoxels;
+
+	StageTime stages[BeamformerMaxComputeShaderStages + 1];
+	u32       stage_count;
+
+	/* NOTE(rnp): indexed by the timestamp ending the interval; 0 is the total */
+	f64 latency_ms[BeamformerFrameTimestamp_Count];
+} SweepResult;
+
+read_only global str8 frame_interval_names[] = {
+	#define X(_k, _name, interval) str8_comp(interval),
+	BEAMFORMER_FRAME_TIMESTAMP_LIST
+	#undef X
+};
+DA_STRUCT(SweepResult, SweepResult);
+
+#define die(...) die_((char *)__func__, __VA_ARGS__)
+function no_return void
+die_(char *function_name, char *format, ...)
+{
+	if (function_name)
+		fprintf(stderr, "%s: ", function_name);
+
+	va_list ap;
+
+	va_start(ap, format);
+	vfprintf(stderr, format, ap);
+	va_end(ap);
+
+	os_exit(1);
+}
+
+#include "zbp.c"
+#include "cpu_platform.c"
+#include "rf_simulator.c"
+
+#define shift_n(v, c, n) v += n, c -= n
+#define shift(v, c)   shift_n(v, c, 1)
+
+read_only global str8 interpolation_mode_names[] = {
+	str8_comp("nearest"),
+	str8_comp("linear"),
+	str8_comp("cubic"),
+};
+
+read_only global str8 decode_mode_names[] = {
+	str8_comp("none"),
+	str8_comp("hadamard"),
+};
+
+read_only global str8 data_kind_names[] = {
+	str8_comp("int16"),
+	str8_comp("int16complex"),
+	str8_comp("float32"),
+	str8_comp("float32complex"),
+};
+
+function void
+usage(char *argv0)
+{
+	die("%s [--points XxZ,...] [--channels n,...] [--transmits n,...] [--data-kind k,...]\n"
+	    "    [--interpolation m,...] [--filter-length n,...] [--decode none|hadamard,...]\n"
+	    "    [--coherency 0|1,...] [--kind forces|hercules|tpw|vls|flash] [--samples n]\n"
+	    "    [--warmup n] [--repeats n] [--lanes n] [--cpu] [--csv file] [--json file]\n"
+	    "    --data-kind:     int16, int16complex, float32, float32complex (default: int16)\n"
+	    "    --filter-length: Demodulate filter taps, 0 to skip Demodulate (default: 36)\n"
+	    "    --cpu:           use the CPU reference beamformer instead of a running beamformer\n"
+	    "    --csv, --json:   output files (default: --csv sweep.csv)\n", argv0);
+}
+
+function i32
+option_index(str8 *names, i32 count, str8 value)
+{
+	i32 result = -1;
+	for (i32 i = 0; i < count && result < 0; i++)
+		if (str8_match(names[i], value, StringMatchFlag_CaseInsensitive))
+			result = i;
+	return result;
+}
+
+function b32
+parse_axis_value(SweepAxis axis, str8 value, u32 *out)
+{
+	b32 result = 1;
+	char buffer[64] = {0};
+	memory_copy(buffer, value.data, (u64)Min(value.length, (i64)countof(buffer) - 1));
+	switch (axis) {
+	case SweepAxis_points:{
+		i64 split = str8_find_needle(value, str8("x"), 0);
+		result    = split < value.length;
+		if (result) {
+			u32 x = (u32)atoi(buffer), z = (u32)atoi(buffer + split + 1);
+			result = Between(x, 1, U16_MAX) && Between(z, 1, U16_MAX);
+			*out   = x << 16 | z;
+		}
+	}break;
+	case SweepAxis_data_kind:{
+		i32 index = option_index((str8 *)data_kind_names, countof(data_kind_names), value);
+		result    = index >= 0;
+		*out      = (u32)index;
+	}break;
+	case SweepAxis_interpolation:{
+		i32 index = option_index((str8 *)interpolation_mode_names, countof(interpolation_mode_names), value);
+		result    = index >= 0;
+		*out      = (u32)index;
+	}break;
+	case SweepAxis_decode:{
+		i32 index = option_index((str8 *)decode_mode_names, countof(decode_mode_names), value);
+		result    = index >= 0;
+		*out      = index == 1 ? BeamformerDecodeMode_Hadamard : BeamformerDecodeMode_None;
+	}break;
+	default:{
+		*out = (u32)atoi(buffer);
+	}break;
+	}
+	return result;
+}
+
+function Options
+parse_argv(i32 argc, char *argv[])
+{
+	Options result = {
+		.acquisition_kind = BeamformerAcquisitionKind_FORCES,
+		.sample_count     = 2048,
+		.warmup           = 4,
+		.repeats          = 32,
+		.lane_count       = os_system_info()->logical_processor_count,
+	};
+
+	read_only local_persist u32 defaults[SweepAxis_Count] = {
+		[SweepAxis_points]        = 256 << 16 | 512,
+		[SweepAxis_channels]      = 64,
+		[SweepAxis_transmits]     = 64,
+		[SweepAxis_data_kind]     = BeamformerDataKind_Int16,
+		[SweepAxis_interpolation] = BeamformerInterpolationMode_Cubic,
+		[SweepAxis_filter_length] = 36,
+		[SweepAxis_decode]        = BeamformerDecodeMode_Hadamard,
+		[SweepAxis_coherency]     = 0,
+	};
+
+	char *argv0 = argv[0];
+	shift(argv, argc);
+
+	while (argc > 0) {
+		str8 arg = str8_from_c_str(*argv);
+		shift(argv, argc);
+
+		if (str8_equal(arg, str8("--cpu"))) {
+			result.cpu = 1;
+			continue;
+		}
+
+		if (arg.length <= 2 || arg.data[0] != '-' || arg.data[1] != '-' || argc == 0)
+			usage(argv0);
+
+		str8 name  = str8_skip(arg, 2);
+		str8 value = str8_from_c_str(*argv);
+		shift(argv, argc);
+
+		i32 axis = option_index((str8 *)sweep_axis_names, countof(sweep_axis_names), name);
+		if (axis >= 0) {
+			SweepValues *sv = result.axes + axis;
+			while (value.length > 0) {
+				i64 end = str8_find_needle(value, str8(","), 0);
+				str8 item = {.data = value.data, .length = end};
+				if (sv->count == SWEEP_MAX_AXIS || !parse_axis_value((SweepAxis)axis, item, sv->values + sv->count))
+					usage(argv0);
+				sv->count++;
+				value = str8_skip(value, end + 1);
+			}
+		} else if (str8_equal(name, str8("kind"))) {
+			i32 index = option_index((str8 *)beamformer_acquisition_kind_strings,
+			                         countof(beamformer_acquisition_kind_strings), value);
+			if (index < 0) usage(argv0);
+			result.acquisition_kind = (BeamformerAcquisitionKind)index;
+		} else {
+			char *v = (char *)value.data;
+			if      (str8_equal(name, str8("samples"))) result.sample_count = Max(1, (u32)atoi(v));
+			else if (str8_equal(name, str8("warmup")))  result.warmup       = (u32)atoi(v);
+			else if (str8_equal(name, str8("repeats"))) result.repeats      = Max(1, (u32)atoi(v));
+			else if (str8_equal(name, str8("lanes")))   result.lane_count   = Max(1, (u32)atoi(v));
+			else if (str8_equal(name, str8("csv")))     result.csv          = v;
+			else if (str8_equal(name, str8("json")))    result.json         = v;
+			else usage(argv0);
+		}
+	}
+
+	for (u32 axis = 0; axis < SweepAxis_Count; axis++) {
+		if (result.axes[axis].count == 0) {
+			result.axes[axis].values[0] = defaults[axis];
+			result.axes[axis].count     = 1;
+		}
+	}
+
+	if (!result.csv && !result.json) result.csv = "sweep.csv";
+	if (!result.cpu) result.repeats = Max(result.repeats, (u32)STATS_FRAMES);
+
+	return result;
+}
+
+/////////////////////////////////////
+// NOTE: Configuration Setup
+
+/* NOTE(rnp): complex kinds are the real simulation with a zero imaginary part */
+function void *
+sweep_rf_data(Arena *arena, BeamformerSimpleParameters *bp, BeamformerDataKind kind)
+{
+	b32 complex = beamformer_data_kind_complex[kind];
+	bp->data_kind = complex ? (kind == BeamformerDataKind_Int16Complex ? BeamformerDataKind_Int16
+	                                                                   : BeamformerDataKind_Float32)
+	                        : kind;
+
+	RFSimulationInfo info = {
+		.parameters      = bp,
+		.scatterer_count = 9,
+		.noise_amplitude = 16.0f,
+		.seed            = 1,
+		.lane_count      = os_system_info()->logical_processor_count,
+	};
+	f32 half_width  = 0.4f * (f32)bp->channel_count * bp->xdc_element_pitch.x;
+	info.scatterers = rf_simulation_scatterer_grid(arena, 3, 3, (v2){{-half_width, half_width}},
+	                                               (v2){{5e-3f, 25e-3f}}, 1024.0f);
+	void *result = rf_simulate(arena, &info);
+
+	if (result && complex) {
+		u64 samples = (u64)bp->raw_data_dimensions.x * bp->raw_data_dimensions.y;
+		u64 size    = beamformer_data_kind_byte_size[bp->data_kind];
+		u8 *out     = push_array(arena, u8, samples * size * 2);
+		for (u64 i = 0; i < samples; i++)
+			memory_copy(out + 2 * i * size, (u8 *)result + i * size, size);
+		result = out;
+	}
+	bp->data_kind = kind;
+
+	return result;
+}
+
+function str8
+sweep_setup(Arena *arena, BeamformerSimpleParameters *bp, BeamformerCPUPlanInfo *info, u32 *values,
+            Options *options)
+{
+	str8 result = {0};
+
+	rf_simulation_parameters(bp, options->acquisition_kind, values[SweepAxis_channels],
+	                         values[SweepAxis_transmits], options->sample_count, 0);
+	bp->decode_mode         = values[SweepAxis_decode];
+	bp->interpolation_mode  = values[SweepAxis_interpolation];
+	bp->coherency_weighting = values[SweepAxis_coherency] != 0;
+	bp->f_number            = 0.5f;
+	bp->decimation_rate     = 1;
+
+	iv3 points = {{(i32)(values[SweepAxis_points] >> 16), 1, (i32)(values[SweepAxis_points] & 0xFFFF)}};
+	f32 half_width = (f32)bp->channel_count * bp->xdc_element_pitch.x / 2;
+	bp->das_voxel_transform = das_transform((v3){{-half_width, 5e-3f, 0}}, (v3){{half_width, 25e-3f, 0}}, &points);
+	bp->output_points.xyz   = points;
+	bp->output_points.w     = 1;
+
+	BeamformerDataKind kind = (BeamformerDataKind)values[SweepAxis_data_kind];
+	b32 demodulate = values[SweepAxis_filter_length] > 0 && !beamformer_data_kind_complex[kind];
+	if (demodulate) {
+		BeamformerFilterParameters filter = {
+			.kind               = BeamformerFilterKind_Kaiser,
+			.sampling_frequency = bp->sampling_frequency / 2,
+			.kaiser = {
+				.beta             = 5.65f,
+				.cutoff_frequency = 0.5f * bp->demodulation_frequency,
+				.length           = values[SweepAxis_filter_length],
+			},
+		};
+		if (!options->cpu) beamformer_create_filter(&filter, 0, 0);
+		info->filters[bp->compute_stages_count] = cpu_filter_from_parameters(arena, &filter);
+		bp->compute_stage_parameters[bp->compute_stages_count] = 0;
+		bp->compute_stages[bp->compute_stages_count++] = BeamformerShaderKind_Demodulate;
+	}
+	bp->compute_stages[bp->compute_stages_count++] = BeamformerShaderKind_Decode;
+	bp->compute_stages[bp->compute_stages_count++] = BeamformerShaderKind_DAS;
+
+	info->data_kind   = kind;
+	info->stage_count = bp->compute_stages_count;
+	for (u32 i = 0; i < bp->compute_stages_count; i++)
+		info->stages[i] = (BeamformerShaderKind)bp->compute_stages[i];
+
+	BeamformerComputeArrayParameters *ap = push_struct(arena, BeamformerComputeArrayParameters);
+	for (u32 i = 0; i < bp->acquisition_count; i++) {
+		ap->focal_vectors[i]                 = (v2){{bp->steering_angles[i], bp->focal_depths[i]}};
+		ap->sparse_elements[i]               = bp->sparse_elements[i];
+		ap->transmit_receive_orientations[i] = bp->transmit_receive_orientations[i];
+	}
+	info->array_parameters = ap;
+
+	if (bp->decode_mode == BeamformerDecodeMode_Hadamard && !make_hadamard_transpose(arena, (i32)bp->acquisition_count, 0))
+		result = str8("invalid Hadamard order");
+
+	return result;
+}
+
+/////////////////////////////////////
+// NOTE: Measurement
+
+function void
+sort_f64(f64 *values, u32 count)
+{
+	for (u32 i = 1; i < count; i++) {
+		f64 value = values[i];
+		u32 j     = i;
+		for (; j > 0 && values[j - 1] > value; j--)
+			values[j] = values[j - 1];
+		values[j] = value;
+	}
+}
+
+function void
+sweep_latency_statistics(SweepResult *r, f64 *seconds, u32 count, u64 bytes, f64 voxels)
+{
+	f64 sum = 0;
+	for (u32 i = 0; i < count; i++) sum += seconds[i];
+	sort_f64(seconds, count);
+
+	f64 mean = sum / count;
+	r->mean_ms   = mean * 1e3;
+	r->median_ms = (count % 2 ? seconds[count / 2] : 0.5 * (seconds[count / 2 - 1] + seconds[count / 2])) * 1e3;
+	r->p99_ms    = seconds[Min(count - 1, (u32)ceil_f32(0.99f * (f32)count) - 1)] * 1e3;
+	if (mean > 0) {
+		r->gbps    = (f64)bytes / mean * 1e-9;
+		r->mvoxels = voxels / mean * 1e-6;
+	}
+}
+
+function void
+sweep_cpu(Arena *arena, BeamformerCPUContext *cpu, SweepResult *r, BeamformerSimpleParameters *bp,
+          BeamformerCPUPlanInfo *info, void *data, u64 data_size, Options *options)
+{
+	info->parameters = *(BeamformerParameters *)bp;
+	BeamformerCPUPlan *plan = beamformer_cpu_plan(arena, info);
+	if (plan->error.length) {
+		r->skipped = plan->error;
+		return;
+	}
+
+	u64 output_floats = beamformer_cpu_output_floats(plan);
+	f64 voxels        = (f64)output_floats / (plan->iq ? 2 : 1);
+	f32 *output       = push_array(arena, f32, output_floats);
+	f64 *seconds      = push_array(arena, f64, options->repeats);
+
+	for (u32 i = 0; i < options->warmup; i++)
+		beamformer_cpu_beamform(cpu, plan, data, output);
+
+	memory_clear(cpu->stage_ticks, 0, sizeof(cpu->stage_ticks));
+	f64 frequency = os_timer_frequency();
+	for (u32 i = 0; i < options->repeats; i++) {
+		u64 start = os_timer_count();
+		beamformer_cpu_beamform(cpu, plan, data, output);
+		seconds[i] = (f64)(os_timer_count() - start) / frequency;
+	}
+
+	for (u32 i = 0; i < plan->stage_count; i++) {
+		BeamformerCPUStage stage = plan->stages[i].kind;
+		StageTime *st = r->stages + r->stage_count++;
+		st->name = beamformer_cpu_stage_names[stage];
+		st->ms   = (f64)cpu->stage_ticks[stage] / (frequency * options->repeats) * 1e3;
+	}
+
+	sweep_latency_statistics(r, seconds, options->repeats, data_size, voxels);
+}
+
+function b32
+sweep_gpu(Arena *arena, SweepResult *r, BeamformerSimpleParameters *bp, void *data, u64 data_size,
+          Options *options)
+{
+	iv3 points = bp->output_points.xyz;
+	b32 iq     = 0;
+	for (u32 i = 0; i < bp->compute_stages_count; i++)
+		iq |= bp->compute_stages[i] == BeamformerShaderKind_Demodulate;
+	iq |= beamformer_data_kind_complex[bp->data_kind];
+
+	f64 voxels      = (f64)points.x * (f64)points.y * (f64)points.z;
+	u64 output_size = (u64)voxels * sizeof(f32) * (iq ? 2 : 1);
+	f32 *output     = push_array(arena, f32, output_size / sizeof(f32));
+	f64 *seconds    = push_array(arena, f64, options->repeats);
+
+	b32 result = beamformer_push_simple_parameters(bp);
+	for (u32 i = 0; result && i < options->warmup; i++) {
+		result &= beamformer_push_data_with_compute(data, (u32)data_size, 0, 0);
+		result &= beamformer_get_last_frames(output, output_size, 1);
+	}
+
+	/* NOTE(rnp): so that the stage percentiles only cover the timed frames */
+	if (result) result = beamformer_set_latency_window(options->repeats);
+
+	f64 frequency = os_timer_frequency();
+	for (u32 i = 0; result && i < options->repeats; i++) {
+		u64 start = os_timer_count();
+		result &= beamformer_push_data_with_compute(data, (u32)data_size, 0, 0);
+		result &= beamformer_get_last_frames(output, output_size, 1);
+		seconds[i] = (f64)(os_timer_count() - start) / frequency;
+	}
+
+	BeamformerComputeStatsTable stats = {0};
+	if (result) result = beamformer_compute_timings(&stats, 5000);
+
+	if (result) {
+		for (u64 it = 0; it < stats.shader_count; it++) {
+			f64 sum = 0;
+			for (u32 frame = 0; frame < STATS_FRAMES; frame++)
+				sum += stats.times[frame][it];
+			StageTime *st = r->stages + r->stage_count++;
+			BeamformerLatencySummary *ls = stats.latency[BeamformerLatencyWindow_Window] +
+			                               BeamformerLatencyHistogram_FirstStage + it;
+			st->name   = beamformer_shader_names[stats.shader_ids[it]];
+			st->ms     = sum / STATS_FRAMES * 1e3;
+			st->p99_ms = ls->percentiles[BeamformerLatencyPercentile_P99] * 1e3;
+		}
+		sweep_latency_statistics(r, seconds, options->repeats, data_size, voxels);
+
+		f64 to_ms = 1e3 / (f64)stats.timer_frequency;
+		u32 counts[BeamformerFrameTimestamp_Count] = {0};
+		for (u32 frame = 0; frame < stats.frame_timing_count; frame++) {
+			u64 *t = stats.frame_timings[frame].timestamps;
+			for (u32 it = 1; it < BeamformerFrameTimestamp_Count; it++) {
+				if (t[it] && t[it - 1]) {
+					r->latency_ms[it] += (f64)(i64)(t[it] - t[it - 1]) * to_ms;
+					counts[it]++;
+				}
+			}
+			if (t[BeamformerFrameTimestamp_PushBegin]) {
+				r->latency_ms[0] += (f64)(t[BeamformerFrameTimestamp_FrameReady] - t[BeamformerFrameTimestamp_PushBegin]) * to_ms;
+				counts[0]++;
+			}
+		}
+		for (u32 it = 0; it < BeamformerFrameTimestamp_Count; it++)
+			if (counts[it]) r->latency_ms[it] /= counts[it];
+	}
+
+	return result;
+}
+
+/////////////////////////////////////
+// NOTE: Output
+
+function void
+print_axis_value(FILE *f, SweepAxis axis, u32 value, b32 quote)
+{
+	char *q = quote ? "\"" : "";
+	switch (axis) {
+	case SweepAxis_points:{        fprintf(f, "%s%ux%u%s", q, value >> 16, value & 0xFFFF, q); }break;
+	case SweepAxis_data_kind:{     fprintf(f, "%s%s%s", q, (char *)data_kind_names[value].data, q); }break;
+	case SweepAxis_interpolation:{ fprintf(f, "%s%s%s", q, (char *)interpolation_mode_names[value].data, q); }break;
+	case SweepAxis_decode:{
+		fprintf(f, "%s%s%s", q, value == BeamformerDecodeMode_Hadamard ? "hadamard" : "none", q);
+	}break;
+	default:{ fprintf(f, "%u", value); }break;
+	}
+}
+
+function void
+write_csv(SweepResultList *results, char *path)
+{
+	FILE *f = fopen(path, "w");
+	if (!f) die("failed to open output: %s\n", path);
+
+	for (u32 axis = 0; axis < SweepAxis_Count; axis++)
+		fprintf(f, "%s,", (char *)sweep_axis_names[axis].data);
+	fprintf(f, "mean_ms,median_ms,p99_ms,gbps,mvoxels_per_s,stages,skipped\n");
+
+	for (da_count i = 0; i < results->count; i++) {
+		SweepResult *r = results->data + i;
+		for (u32 axis = 0; axis < SweepAxis_Count; axis++) {
+			print_axis_value(f, (SweepAxis)axis, r->values[axis], 0);
+			fprintf(f, ",");
+		}
+		fprintf(f, "%.6f,%.6f,%.6f,%.6f,%.6f,", r->mean_ms, r->median_ms, r->p99_ms, r->gbps, r->mvoxels);
+		/* NOTE(rnp): stages vary between configurations so they share one column */
+		for (u32 s = 0; s < r->stage_count; s++)
+			fprintf(f, "%s%.*s=%.6f", s ? ";" : "", (i32)r->stages[s].name.length,
+			        r->stages[s].name.data, r->stages[s].ms);
+		fprintf(f, ",%.*s\n", (i32)r->skipped.length, r->skipped.data);
+	}
+	fclose(f);
+}
+
+function void
+write_json(SweepResultList *results, char *path, Options *options)
+{
+	FILE *f = fopen(path, "w");
+	if (!f) die("failed to open output: %s\n", path);
+
+	fprintf(f, "{\n\"version\": 1,\n\"backend\": \"%s\",\n\"acquisition\": \"%s\",\n"
+	        "\"warmup\": %u,\n\"repeats\": %u,\n\"results\": [\n", options->cpu ? "cpu" : "gpu",
+	        (char *)beamformer_acquisition_kind_strings[options->acquisition_kind].data,
+	        options->warmup, options->repeats);
+	for (da_count i = 0; i < results->count; i++) {
+		SweepResult *r = results->data + i;
+		fprintf(f, "{");
+		for (u32 axis = 0; axis < SweepAxis_Count; axis++) {
+			fprintf(f, "\"%s\": ", (char *)sweep_axis_names[axis].data);
+			print_axis_value(f, (SweepAxis)axis, r->values[axis], 1);
+			fprintf(f, ", ");
+		}
+		if (r->skipped.length) {
+			fprintf(f, "\"skipped\": \"%.*s\"}", (i32)r->skipped.length, r->skipped.data);
+		} else {
+			fprintf(f, "\"mean_ms\": %.6f, \"median_ms\": %.6f, \"p99_ms\": %.6f, \"gbps\": %.6f, "
+			        "\"mvoxels_per_s\": %.6f, \"stages\": {", r->mean_ms, r->median_ms, r->p99_ms,
+			        r->gbps, r->mvoxels);
+			for (u32 s = 0; s < r->stage_count; s++)
+				fprintf(f, "%s\"%.*s\": %.6f", s ? ", " : "", (i32)r->stages[s].name.length,
+				        r->stages[s].name.data, r->stages[s].ms);
+			fprintf(f, "}, \"stages_p99\": {");
+			for (u32 s = 0; s < r->stage_count; s++)
+				fprintf(f, "%s\"%.*s\": %.6f", s ? ", " : "", (i32)r->stages[s].name.length,
+				        r->stages[s].name.data, r->stages[s].p99_ms);
+			fprintf(f, "}, \"latency\": {\"Total\": %.6f", r->latency_ms[0]);
+			for (u32 it = 1; it < BeamformerFrameTimestamp_Count; it++)
+				fprintf(f, ", \"%s\": %.6f", (char *)frame_interval_names[it].data, r->latency_ms[it]);
+			fprintf(f, "}}");
+		}
+		fprintf(f, "%s\n", i + 1 < results->count ? "," : "");
+	}
+	fprintf(f, "]\n}\n");
+	fclose(f);
+}
+
+BASE_IMPORT void
+entry_point(i32 argc, char *argv[])
+{
+	Options options = parse_argv(argc, argv);
+
+	Arena *arena        = arena_create(.reserve_size = GB(1));
+	Arena *config_arena = arena_create(.reserve_size = GB(8));
+	g_platform_arena    = arena;
+
+	BeamformerCPUContext *cpu = 0;
+	if (options.cpu) cpu = beamformer_cpu_context_create(arena, options.lane_count);
+	else             beamformer_set_global_timeout(5000);
+
+	u32 total = 1;
+	for (u32 axis = 0; axis < SweepAxis_Count; axis++)
+		total *= options.axes[axis].count;
+
+	printf("sweep: %u configurations on the %s, %u warmup + %u timed frames each\n", total,
+	       options.cpu ? "CPU reference" : "GPU", options.warmup, options.repeats);
+
+	SweepResultList results = {0};
+	b32 result = 1;
+	for (u32 index = 0; result && index < total; index++) {
+		Temp temp = temp_begin(config_arena);
+
+		SweepResult *r = da_push(arena, &results);
+		u32 remainder  = index;
+		for (u32 axis = 0; axis < SweepAxis_Count; axis++) {
+			SweepValues *sv = options.axes + axis;
+			r->values[axis] = sv->values[remainder % sv->count];
+			remainder      /= sv->count;
+		}
+
+		BeamformerSimpleParameters *bp   = push_struct(config_arena, BeamformerSimpleParameters);
+		BeamformerCPUPlanInfo      *info = push_struct(config_arena, BeamformerCPUPlanInfo);
+		r->skipped = sweep_setup(config_arena, bp, info, r->values, &options);
+
+		void *data = 0;
+		if (!r->skipped.length) {
+			data = sweep_rf_data(config_arena, bp, (BeamformerDataKind)r->values[SweepAxis_data_kind]);
+			if (!data) r->skipped = str8("unsupported acquisition");
+		}
+
+		if (!r->skipped.length) {
+			u64 data_size = (u64)bp->raw_data_dimensions.x * bp->raw_data_dimensions.y *
+			                beamformer_data_kind_byte_size[bp->data_kind];
+			if (options.cpu) {
+				sweep_cpu(config_arena, cpu, r, bp, info, data, data_size, &options);
+			} else if (!sweep_gpu(config_arena, r, bp, data, data_size, &options)) {
+				r->skipped = str8_from_c_str((char *)beamformer_get_last_error_string());
+				result     = 0;
+			}
+		}
+
+		for (u32 axis = 0; axis < SweepAxis_Count; axis++) {
+			printf("%s", axis ? " " : "");
+			print_axis_value(stdout, (SweepAxis)axis, r->values[axis], 0);
+		}
+		if (r->skipped.length)
+			printf(": skipped (%.*s)\n", (i32)r->skipped.length, r->skipped.data);
+		else
+			printf(": mean %.3f median %.3f p99 %.3f [ms] %.2f [GB/s] %.2f [MVoxel/s]\n",
+			       r->mean_ms, r->median_ms, r->p99_ms, r->gbps, r->mvoxels);
+
+		if (!r->skipped.length && !options.cpu) {
+			printf("  latency %.3f [ms]:", r->latency_ms[0]);
+			for (u32 it = 1; it < BeamformerFrameTimestamp_Count; it++)
+				printf(" %s %.3f", (char *)frame_interval_names[it].data, r->latency_ms[it]);
+			printf("\n");
+		}
+
+		/* NOTE(rnp): plan errors may live in the config arena */
+		r->skipped = push_str8(arena, r->skipped);
+		temp_end(temp);
+	}
+
+	if (options.csv)  write_csv(&results, options.csv);
+	if (options.json) write_json(&results, options.json, &options);
+
+	if (cpu) beamformer_cpu_context_destroy(cpu);
+
+	/* NOTE(rnp): os_exit() skips the stdio flush */
+	fflush(stdout);
+	if (!result) os_exit(1);
+}
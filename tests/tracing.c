@@ -0,0 +1,313 @@
+/* See LICENSE for license details. */
+/* NOTE(rnp): trace zone (trace.c) overhead benchmark and export check. the same small unit
+ * of work is run with and without a zone around it, on one thread and then on --threads
+ * threads at once, and the difference per iteration is reported next to the overhead
+ * trace.c measured for itself. the events are then written out both as a snapshot and through
+ * the streaming writer and the output is checked for lost or repeated events and for the
+ * shape of the JSON; exits non zero on error */
+#define BASE_EXPORT           function
+#define BASE_IMPORT           function
+#define BEAMFORMER_LIB_EXPORT function
+#include "base_platform.h"
+#include "ogl_beamformer_lib.c"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+typedef struct {
+	u32   zones;
+	u32   threads;
+	u32   work;
+	char *output;
+} Options;
+
+#define die(...) die_((char *)__func__, __VA_ARGS__)
+function no_return void
+die_(char *function_name, char *format, ...)
+{
+	if (function_name)
+		fprintf(stderr, "%s: ", function_name);
+
+	va_list ap;
+
+	va_start(ap, format);
+	vfprintf(stderr, format, ap);
+	va_end(ap);
+
+	fflush(stdout);
+	os_exit(1);
+}
+
+#include "cpu_platform.c"
+
+/* NOTE(rnp): file API the beamformer expects from the platform (see beamformer.h) */
+function OSHandle
+os_create_file(const char *path)
+{
+	FILE *f = fopen(path, "wb");
+	OSHandle result = {f ? (u64)f : OSInvalidHandleValue};
+	return result;
+}
+
+function b32
+os_append_file(OSHandle file, u8 *data, i64 length)
+{
+	b32 result = fwrite(data, 1, (u64)length, (FILE *)file.value[0]) == (u64)length;
+	return result;
+}
+
+function void
+os_release_handle(OSHandle file)
+{
+	if ValidHandle(file) fclose((FILE *)file.value[0]);
+}
+
+#include "trace.c"
+
+#define shift_n(v, c, n) v += n, c -= n
+#define shift(v, c)   shift_n(v, c, 1)
+
+typedef struct {
+	u32  zones;
+	u32  work;
+	b32  traced;
+	u32  index;
+	u64  elapsed;
+	u64  sink;
+
+	OSBarrier *barrier;
+	i32       *finished;
+} TraceBenchThread;
+
+function void
+usage(char *argv0)
+{
+	die("%s [--zones n] [--threads n] [--work n] [--output path]\n"
+	    "    --zones:   zones recorded per thread and run (default: 1000000)\n"
+	    "    --threads: threads recording at once (default: logical processors, at most 16)\n"
+	    "    --work:    LCG steps inside each zone (default: 16)\n"
+	    "    --output:  base name of the written traces (default: tracing_test)\n", argv0);
+}
+
+function Options
+parse_argv(i32 argc, char *argv[])
+{
+	Options result = {
+		.zones   = 1000000,
+		.threads = Clamp(os_system_info()->logical_processor_count, 2, 16),
+		.work    = 16,
+		.output  = "tracing_test",
+	};
+
+	char *argv0 = argv[0];
+	shift(argv, argc);
+
+	while (argc > 0) {
+		str8 arg = str8_from_c_str(*argv);
+		shift(argv, argc);
+
+		if (arg.length > 2 && arg.data[0] == '-' && arg.data[1] == '-' && argc) {
+			char *value = *argv;
+			if      (str8_equal(arg, str8("--zones")))   result.zones   = Max(1, (u32)atoi(value));
+			else if (str8_equal(arg, str8("--threads"))) result.threads = Clamp((u32)atoi(value), 1, (TraceMaxTracks - 8) / 2);
+			else if (str8_equal(arg, str8("--work")))    result.work    = (u32)atoi(value);
+			else if (str8_equal(arg, str8("--output")))  result.output  = value;
+			else usage(argv0);
+			shift(argv, argc);
+		} else {
+			usage(argv0);
+		}
+	}
+
+	return result;
+}
+
+function force_inline u64
+trace_bench_work(u64 x, u32 work)
+{
+	for (u32 i = 0; i < work; i++) x = x * 6364136223846793005ull + 1442695040888963407ull;
+	return x;
+}
+
+function OS_THREAD_ENTRY_POINT_FN(trace_bench_entry_point)
+{
+	TraceBenchThread *t = user_context;
+
+	/* NOTE(rnp): every thread takes a track for good; only register the ones that trace */
+	if (t->traced) {
+		u8 buffer[32];
+		Stream sb = {.data = buffer, .cap = countof(buffer)};
+		stream_append_str8(&sb, str8("[bench "));
+		stream_append_u64(&sb, t->index);
+		stream_append_byte(&sb, ']');
+		trace_thread_name(stream_to_str8(&sb));
+	}
+
+	if (t->barrier) os_barrier_enter(*t->barrier);
+
+	u64 x     = t->index + 1;
+	u64 start = os_timer_count();
+	if (t->traced) {
+		for (u32 i = 0; i < t->zones; i++) {
+			trace_zone_begin(str8("bench_zone"));
+			x = trace_bench_work(x, t->work);
+			trace_zone_end();
+		}
+	} else {
+		for (u32 i = 0; i < t->zones; i++)
+			x = trace_bench_work(x, t->work);
+	}
+	t->elapsed = os_timer_count() - start;
+	t->sink    = x;
+
+	if (t->finished) atomic_add_u32(t->finished, 1);
+	return 0;
+}
+
+/* NOTE(rnp): returns the mean ns per iteration over all threads */
+function f64
+trace_bench_run(Arena *arena, Options *options, u32 thread_count, b32 traced)
+{
+	Temp temp = temp_begin(arena);
+	TraceBenchThread *threads = push_array(arena, TraceBenchThread, thread_count);
+	OSBarrier barrier = os_barrier_alloc(thread_count);
+	i32 finished = 0;
+
+	for (u32 i = 0; i < thread_count; i++) {
+		threads[i] = (TraceBenchThread){
+			.zones    = options->zones,
+			.work     = options->work,
+			.traced   = traced,
+			.index    = i,
+			.barrier  = &barrier,
+			.finished = &finished,
+		};
+		os_create_thread("[bench]", threads + i, trace_bench_entry_point);
+	}
+	spin_wait(atomic_load_u32(&finished) != (i32)thread_count);
+
+	f64 result = 0;
+	for (u32 i = 0; i < thread_count; i++)
+		result += (f64)threads[i].elapsed * 1e9 / (f64)os_system_info()->timer_frequency / (f64)options->zones;
+	result /= (f64)thread_count;
+
+	temp_end(temp);
+	return result;
+}
+
+function u64
+trace_recorded_events(u64 *retained)
+{
+	u64 result = 0;
+	*retained  = 0;
+	for (u32 it = 0; it < trace_context.track_count; it++) {
+		u64 written = atomic_load_u64(&trace_context.tracks[it]->write_index);
+		result    += written;
+		*retained += Min(written, TraceEventsPerTrack - 1);
+	}
+	return result;
+}
+
+function u64
+trace_count_occurrences(str8 haystack, str8 needle)
+{
+	u64 result = 0;
+	for (i64 it = 0; it + needle.length <= haystack.length; it++)
+		result += memory_equal(haystack.data + it, needle.data, needle.length);
+	return result;
+}
+
+function b32
+trace_check_output(Arena *arena, char *path, u64 expected_events, b32 expect_tracks)
+{
+	Temp temp = temp_begin(arena);
+	str8 file = os_read_entire_file(arena, path);
+	u64  found = trace_count_occurrences(file, str8("\"ph\":\"X\""));
+	u64  names = trace_count_occurrences(file, str8("\"thread_name\""));
+
+	b32 result = file.length > 4;
+	result &= result && file.data[0] == '[' && file.data[file.length - 2] == ']' && file.data[file.length - 1] == '\n';
+	result &= found == expected_events;
+	result &= !expect_tracks || names == trace_context.track_count;
+
+	printf("%-10s %10llu events %3llu tracks %8.2f MB: %s\n", path, (unsigned long long)found,
+	       (unsigned long long)names, (f64)file.length / MB(1), result ? "ok" : "FAILED");
+	if (found != expected_events)
+		printf("    expected %llu events\n", (unsigned long long)expected_events);
+
+	temp_end(temp);
+	return result;
+}
+
+BASE_IMPORT void
+entry_point(i32 argc, char *argv[])
+{
+	Options options  = parse_argv(argc, argv);
+	Arena  *arena    = arena_create(.reserve_size = GB(1));
+	g_platform_arena = arena;
+
+	b32 ok = 1;
+	trace_thread_name(str8("[main]"));
+
+	printf("zones: %u per thread, work: %u, threads: %u, calibrated zone overhead: %0.1f ns\n",
+	       options.zones, options.work, options.threads, trace_context.zone_overhead_ns);
+
+	/* NOTE(rnp): nesting and explicit GPU style tracks */
+	{
+		trace_zone_begin(str8("outer"));
+		trace_zone_begin(str8("inner"));
+		trace_zone_end();
+		trace_zone_end();
+
+		u32 gpu  = trace_track(str8("[gpu compute]"));
+		u64 now  = os_timer_count();
+		trace_track_zone(gpu, str8("DAS"), now, now + os_system_info()->timer_frequency / 1000);
+		ok &= gpu != 0 && trace_track(str8("[gpu compute]")) == gpu;
+		ok &= trace_thread_track->write_index == 2 && trace_thread_track->events[0].name[0] == 'i';
+	}
+
+	printf("%-24s %12s %12s %12s\n", "[ns/iteration]", "untraced", "traced", "overhead");
+	f64 single_base   = trace_bench_run(arena, &options, 1, 0);
+	f64 single_traced = trace_bench_run(arena, &options, 1, 1);
+	printf("%-24s %12.2f %12.2f %12.2f\n", "single thread", single_base, single_traced, single_traced - single_base);
+
+	f64 multi_base    = trace_bench_run(arena, &options, options.threads, 0);
+	f64 multi_traced  = trace_bench_run(arena, &options, options.threads, 1);
+	printf("%-24s %12.2f %12.2f %12.2f\n", "all threads", multi_base, multi_traced, multi_traced - multi_base);
+
+	/* NOTE(rnp): nothing is recording; a snapshot must hold exactly what the tracks retain */
+	Stream sb = arena_stream(arena);
+	stream_appendf(&sb, "%s_snapshot.json", options.output);
+	char *snapshot_path = (char *)arena_stream_commit_zero(arena, &sb).data;
+
+	u64 retained = 0, recorded = trace_recorded_events(&retained);
+	TraceWriter stats = {0};
+	u64 start   = os_timer_count();
+	b32 written = trace_write(snapshot_path, &stats);
+	f64 write_ms = (f64)(os_timer_count() - start) * 1e3 / (f64)os_system_info()->timer_frequency;
+	printf("snapshot: %llu events (%llu dropped) in %0.2f ms\n", (unsigned long long)stats.events,
+	       (unsigned long long)stats.dropped, write_ms);
+	ok &= written && stats.events == retained && stats.events + stats.dropped == recorded;
+	ok &= trace_check_output(arena, snapshot_path, retained, 1);
+
+	/* NOTE(rnp): streaming while recording; every event ever recorded must either be written
+	 * or counted as dropped */
+	sb = arena_stream(arena);
+	stream_appendf(&sb, "%s_stream.json", options.output);
+	char *stream_path = (char *)arena_stream_commit_zero(arena, &sb).data;
+
+	ok &= trace_stream_begin(stream_path);
+	trace_bench_run(arena, &options, options.threads, 1);
+	ok &= trace_stream_end();
+
+	recorded = trace_recorded_events(&retained);
+	TraceWriter *sw = &trace_context.stream;
+	printf("stream:   %llu events (%llu dropped) of %llu recorded\n", (unsigned long long)sw->events,
+	       (unsigned long long)sw->dropped, (unsigned long long)recorded);
+	ok &= sw->events + sw->dropped == recorded;
+	ok &= trace_check_output(arena, stream_path, sw->events, 1);
+
+	if (!ok) die("FAILED\n");
+	printf("all checks passed\n");
+}
@@ -0,0 +1,463 @@
+/* See LICENSE for license details. */
+/* NOTE(rnp): scoped zone tracing with Chrome/Perfetto JSON export
+ *
+ * every thread which opens a zone gets its own track: a ring of events that only that
+ * thread writes. closing a zone copies the event into the ring and publishes it by bumping
+ * the track's write index so recording takes no locks and never blocks. readers copy events
+ * out and throw away any that were overwritten while being copied. GPU work is placed on
+ * separate tracks with explicit begin and end times (trace_track_zone()) once its timestamps
+ * have been moved onto the host timeline. a track must only be written by one thread.
+ *
+ * zone names are copied into the events so that they remain valid across hot reloads.
+ *
+ * the output is the JSON array form of the Chrome trace event format which both
+ * chrome://tracing and ui.perfetto.dev open. when streaming the file is appended to every
+ * TraceStreamPeriodMS; the closing ']' is optional in that format so a capture which was
+ * cut short by a crash still loads.
+ */
+
+#define TraceMaxTracks       (64)
+#define TraceEventsPerTrack  (16384)
+#define TraceMaxZoneDepth    (32)
+#define TraceNameCapacity    (47)
+#define TraceStreamPeriodMS  (250)
+#define TraceOutputChunkSize (MB(1))
+
+typedef struct {
+	u64 begin;
+	u64 end;
+	u8  name_length;
+	c8  name[TraceNameCapacity];
+} TraceEvent;
+static_assert(sizeof(TraceEvent) == 64, "TraceEvent should fill exactly one cache line");
+
+typedef struct {
+	TraceEvent events[TraceEventsPerTrack];
+	/* NOTE(rnp): count of events ever published. the slot holding the oldest of the last
+	 * TraceEventsPerTrack events is the one being written next so only the newest
+	 * TraceEventsPerTrack - 1 can be read safely */
+	u64        write_index;
+
+	/* NOTE(rnp): only accessed by the owning thread */
+	TraceEvent open[TraceMaxZoneDepth];
+	u32        depth;
+
+	/* NOTE(rnp): only accessed by the streaming thread */
+	u64        stream_index;
+	b32        stream_named;
+
+	u8         name_length;
+	c8         name[TraceNameCapacity];
+} TraceTrack;
+
+typedef struct {
+	Stream   stream;
+	OSHandle file;
+	u64      events;
+	u64      dropped;
+	b32      errors;
+} TraceWriter;
+
+typedef struct {
+	Arena      *arena;
+	i32         lock;
+	b32         initialized;
+
+	u32         track_count;
+	TraceTrack *tracks[TraceMaxTracks];
+
+	u64         start_time;
+	u64         timer_frequency;
+	/* NOTE(rnp): measured cost of one zone (begin + end) on this machine */
+	f64         zone_overhead_ns;
+
+	TraceWriter stream;
+	Arena      *stream_arena;
+	b32         streaming;
+	b32         stream_quit;
+	i32         stream_futex;
+	b32         stream_thread_active;
+} TraceContext;
+
+global TraceContext trace_context;
+thread_static TraceTrack *trace_thread_track;
+thread_static b32         trace_thread_no_track;
+
+function void
+trace_name_copy(c8 *name, u8 *name_length, str8 source)
+{
+	u8 length = (u8)Min(source.length, TraceNameCapacity);
+	memory_copy(name, source.data, length);
+	*name_length = length;
+}
+
+function force_inline void
+trace_track_begin(TraceTrack *track, str8 name)
+{
+	if (track->depth < TraceMaxZoneDepth) {
+		TraceEvent *event = track->open + track->depth;
+		trace_name_copy(event->name, &event->name_length, name);
+		event->begin = os_timer_count();
+	}
+	track->depth++;
+}
+
+function force_inline void
+trace_track_publish(TraceTrack *track, TraceEvent *event)
+{
+	u64 index = track->write_index;
+	track->events[index % TraceEventsPerTrack] = *event;
+	atomic_store_u64(&track->write_index, index + 1);
+}
+
+function force_inline void
+trace_track_end(TraceTrack *track)
+{
+	u64 end = os_timer_count();
+	if (track->depth > 0) {
+		track->depth--;
+		if (track->depth < TraceMaxZoneDepth) {
+			TraceEvent *event = track->open + track->depth;
+			event->end = end;
+			trace_track_publish(track, event);
+		}
+	}
+}
+
+function void
+trace_calibrate(Arena *arena)
+{
+	Temp temp = temp_begin(arena);
+	TraceTrack *track = push_struct(arena, TraceTrack);
+
+	u32 count = 4096;
+	u64 best  = U64_MAX;
+	for (u32 run = 0; run < 8; run++) {
+		u64 start = os_timer_count();
+		for (u32 i = 0; i < count; i++) {
+			trace_track_begin(track, str8("trace_calibrate"));
+			trace_track_end(track);
+		}
+		best = Min(best, os_timer_count() - start);
+	}
+	trace_context.zone_overhead_ns = (f64)best * 1e9 / ((f64)count * (f64)trace_context.timer_frequency);
+
+	temp_end(temp);
+}
+
+/* NOTE(rnp): must be called with the lock held */
+function void
+trace_init(void)
+{
+	if (!trace_context.initialized) {
+		trace_context.arena = arena_create(.reserve_size = TraceMaxTracks * sizeof(TraceTrack) + MB(8),
+		                                   .name = "Trace Arena");
+		trace_context.start_time      = os_timer_count();
+		trace_context.timer_frequency = os_system_info()->timer_frequency;
+		trace_calibrate(trace_context.arena);
+		trace_context.initialized = 1;
+	}
+}
+
+/* NOTE(rnp): named tracks are looked up by name; thread tracks are always new since every
+ * thread needs its own */
+function TraceTrack *
+trace_track_create(str8 name, b32 named)
+{
+	TraceTrack *result = 0;
+	DeferLoop(take_lock(&trace_context.lock, -1), release_lock(&trace_context.lock))
+	{
+		trace_init();
+		for (u32 it = 0; named && !result && it < trace_context.track_count; it++) {
+			TraceTrack *track = trace_context.tracks[it];
+			if (str8_equal(name, (str8){.data = (u8 *)track->name, .length = track->name_length}))
+				result = track;
+		}
+
+		if (!result && trace_context.track_count < TraceMaxTracks) {
+			result = push_struct(trace_context.arena, TraceTrack);
+			trace_name_copy(result->name, &result->name_length, name);
+			trace_context.tracks[trace_context.track_count] = result;
+			atomic_store_u32(&trace_context.track_count, trace_context.track_count + 1);
+		}
+	}
+	return result;
+}
+
+function TraceTrack *
+trace_current_thread_track(void)
+{
+	TraceTrack *result = trace_thread_track;
+	if (!result && !trace_thread_no_track) {
+		u8 buffer[32];
+		Stream sb = {.data = buffer, .cap = countof(buffer)};
+		stream_append_str8(&sb, str8("thread "));
+		stream_append_u64(&sb, atomic_load_u32(&trace_context.track_count));
+		result = trace_thread_track = trace_track_create(stream_to_str8(&sb), 0);
+		trace_thread_no_track = result == 0;
+	}
+	return result;
+}
+
+/////////////////////////
+// NOTE: recording API
+
+DEBUG_IMPORT void
+trace_thread_name(str8 name)
+{
+	if (trace_thread_track) {
+		DeferLoop(take_lock(&trace_context.lock, -1), release_lock(&trace_context.lock))
+			trace_name_copy(trace_thread_track->name, &trace_thread_track->name_length, name);
+	} else {
+		trace_thread_track    = trace_track_create(name, 0);
+		trace_thread_no_track = trace_thread_track == 0;
+	}
+}
+
+DEBUG_IMPORT void
+trace_zone_begin(str8 name)
+{
+	TraceTrack *track = trace_current_thread_track();
+	if (track) trace_track_begin(track, name);
+}
+
+DEBUG_IMPORT void
+trace_zone_end(void)
+{
+	TraceTrack *track = trace_thread_track;
+	if (track) trace_track_end(track);
+}
+
+/* NOTE(rnp): returns a handle to the named track, creating it if needed. 0 if none are left */
+DEBUG_IMPORT u32
+trace_track(str8 name)
+{
+	TraceTrack *track = trace_track_create(name, 1);
+	u32 result = 0;
+	for (u32 it = 0; track && !result && it < trace_context.track_count; it++)
+		if (trace_context.tracks[it] == track) result = it + 1;
+	return result;
+}
+
+/* NOTE(rnp): begin and end are os_timer_count() values */
+DEBUG_IMPORT void
+trace_track_zone(u32 track_handle, str8 name, u64 begin, u64 end)
+{
+	if Between(track_handle, 1, atomic_load_u32(&trace_context.track_count)) {
+		TraceEvent event = {.begin = begin, .end = end};
+		trace_name_copy(event.name, &event.name_length, name);
+		trace_track_publish(trace_context.tracks[track_handle - 1], &event);
+	}
+}
+
+/////////////////////////
+// NOTE: JSON output
+
+function void
+trace_writer_flush(TraceWriter *w)
+{
+	if (w->stream.widx > 0) {
+		w->errors |= w->stream.errors || !os_append_file(w->file, w->stream.data, w->stream.widx);
+		stream_reset(&w->stream, 0);
+	}
+}
+
+function void
+trace_writer_reserve(TraceWriter *w, i32 size)
+{
+	if (w->stream.cap - w->stream.widx < size)
+		trace_writer_flush(w);
+}
+
+/* NOTE(rnp): names are only ever internal string literals but quotes and control
+ * characters would still produce invalid JSON */
+function void
+trace_append_name(Stream *s, c8 *name, u8 length)
+{
+	for (u8 it = 0; it < length; it++) {
+		c8 c = name[it];
+		stream_append_byte(s, (c == '"' || c == '\\' || (u8)c < 0x20) ? '_' : (u8)c);
+	}
+}
+
+function void
+trace_append_time(Stream *s, u64 time)
+{
+	/* NOTE(rnp): microseconds since tracing started */
+	f64 us = ((f64)time - (f64)trace_context.start_time) * 1e6 / (f64)trace_context.timer_frequency;
+	stream_append_f64(s, us, 1000);
+}
+
+function void
+trace_append_event(TraceWriter *w, u32 tid, TraceEvent *event)
+{
+	trace_writer_reserve(w, 256);
+	Stream *s = &w->stream;
+	stream_append_str8(s, str8(",\n{\"name\":\""));
+	trace_append_name(s, event->name, event->name_length);
+	stream_append_str8(s, str8("\",\"ph\":\"X\",\"pid\":1,\"tid\":"));
+	stream_append_u64(s, tid);
+	stream_append_str8(s, str8(",\"ts\":"));
+	trace_append_time(s, event->begin);
+	stream_append_str8(s, str8(",\"dur\":"));
+	stream_append_f64(s, (f64)(event->end - event->begin) * 1e6 / (f64)trace_context.timer_frequency, 1000);
+	stream_append_byte(s, '}');
+	w->events++;
+}
+
+function void
+trace_append_track_name(TraceWriter *w, u32 tid, TraceTrack *track)
+{
+	trace_writer_reserve(w, 256);
+	Stream *s = &w->stream;
+	stream_append_str8(s, str8(",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":"));
+	stream_append_u64(s, tid);
+	stream_append_str8(s, str8(",\"args\":{\"name\":\""));
+	DeferLoop(take_lock(&trace_context.lock, -1), release_lock(&trace_context.lock))
+		trace_append_name(s, track->name, track->name_length);
+	stream_append_str8(s, str8("\"}}"));
+}
+
+function b32
+trace_writer_begin(TraceWriter *w, Arena *arena, char *path)
+{
+	DeferLoop(take_lock(&trace_context.lock, -1), release_lock(&trace_context.lock))
+		trace_init();
+
+	zero_struct(w);
+	w->file = os_create_file(path);
+	b32 result = ValidHandle(w->file);
+	if (result) {
+		w->stream = stream_alloc(arena, TraceOutputChunkSize);
+		Stream *s = &w->stream;
+		stream_append_str8(s, str8("[{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"ogl_beamformer\"}}"));
+		stream_append_str8(s, str8(",\n{\"name\":\"trace zone overhead: "));
+		stream_append_f64(s, trace_context.zone_overhead_ns, 10);
+		stream_append_str8(s, str8(" ns\",\"ph\":\"i\",\"s\":\"g\",\"pid\":1,\"tid\":0,\"ts\":0}"));
+	}
+	return result;
+}
+
+function b32
+trace_writer_end(TraceWriter *w)
+{
+	stream_append_str8(&w->stream, str8("\n]\n"));
+	trace_writer_flush(w);
+	os_release_handle(w->file);
+	return !w->errors;
+}
+
+/* NOTE(rnp): copies out the events in [*cursor, write_index) which are still valid and
+ * advances the cursor */
+function void
+trace_drain_track(TraceWriter *w, u32 tid, TraceTrack *track, u64 *cursor)
+{
+	u64 end   = atomic_load_u64(&track->write_index);
+	u64 start = *cursor;
+	if (end - start > TraceEventsPerTrack - 1) {
+		w->dropped += end - (TraceEventsPerTrack - 1) - start;
+		start       = end - (TraceEventsPerTrack - 1);
+	}
+
+	for (u64 it = start; it < end; it++) {
+		TraceEvent event = track->events[it % TraceEventsPerTrack];
+		/* NOTE(rnp): the owner may have wrapped around and written over the event while it
+		 * was being copied */
+		if (atomic_load_u64(&track->write_index) >= it + TraceEventsPerTrack) {
+			w->dropped++;
+		} else {
+			trace_append_event(w, tid, &event);
+		}
+	}
+	*cursor = end;
+}
+
+/* NOTE(rnp): writes everything currently held by every track */
+function b32
+trace_write(char *path, TraceWriter *out_stats)
+{
+	Arena *arena = arena_create(.reserve_size = TraceOutputChunkSize + MB(1), .name = "Trace Write Arena");
+	TraceWriter w;
+	b32 result = trace_writer_begin(&w, arena, path);
+	if (result) {
+		u32 track_count = atomic_load_u32(&trace_context.track_count);
+		for (u32 it = 0; it < track_count; it++) {
+			u64 cursor = 0;
+			trace_append_track_name(&w, it + 1, trace_context.tracks[it]);
+			trace_drain_track(&w, it + 1, trace_context.tracks[it], &cursor);
+		}
+		result = trace_writer_end(&w);
+		if (out_stats) *out_stats = w;
+	}
+	arena_destroy(arena);
+	return result;
+}
+
+function void
+trace_stream_drain(TraceWriter *w)
+{
+	u32 track_count = atomic_load_u32(&trace_context.track_count);
+	for (u32 it = 0; it < track_count; it++) {
+		TraceTrack *track = trace_context.tracks[it];
+		if (!track->stream_named) {
+			trace_append_track_name(w, it + 1, track);
+			track->stream_named = 1;
+		}
+		trace_drain_track(w, it + 1, track, &track->stream_index);
+	}
+	trace_writer_flush(w);
+}
+
+function OS_THREAD_ENTRY_POINT_FN(trace_stream_entry_point)
+{
+	TraceWriter *w = user_context;
+	trace_thread_name(str8("[trace]"));
+	while (!atomic_load_u32(&trace_context.stream_quit)) {
+		atomic_store_u32(&trace_context.stream_futex, 1);
+		if (!atomic_load_u32(&trace_context.stream_quit))
+			os_wait_on_address(&trace_context.stream_futex, 1, TraceStreamPeriodMS);
+		DeferLoop(trace_zone_begin(str8("trace_stream_drain")), trace_zone_end())
+			trace_stream_drain(w);
+	}
+	atomic_store_u32(&trace_context.stream_thread_active, 0);
+	return 0;
+}
+
+/* NOTE(rnp): continuously appends to path until trace_stream_end(); events recorded before
+ * this call which are still held by the tracks are included */
+function b32
+trace_stream_begin(char *path)
+{
+	b32 result = 0;
+	if (!trace_context.streaming) {
+		Arena *arena = arena_create(.reserve_size = TraceOutputChunkSize + MB(1), .name = "Trace Stream Arena");
+		result = trace_writer_begin(&trace_context.stream, arena, path);
+		if (result) {
+			trace_context.stream_arena         = arena;
+			trace_context.streaming            = 1;
+			trace_context.stream_quit          = 0;
+			trace_context.stream_thread_active = 1;
+			os_create_thread("[trace]", &trace_context.stream, trace_stream_entry_point);
+		} else {
+			arena_destroy(arena);
+		}
+	}
+	return result;
+}
+
+function b32
+trace_stream_end(void)
+{
+	b32 result = 0;
+	if (trace_context.streaming) {
+		atomic_store_u32(&trace_context.stream_quit, 1);
+		os_wake_all_waiters(&trace_context.stream_futex);
+		spin_wait(atomic_load_u32(&trace_context.stream_thread_active));
+
+		trace_stream_drain(&trace_context.stream);
+		result = trace_writer_end(&trace_context.stream);
+		arena_destroy(trace_context.stream_arena);
+		trace_context.streaming = 0;
+	}
+	return result;
+}
@@ -3212,6 +3212,84 @@ function UI_CUSTOM_DRAW_FUNCTION(beamformer_ui_custom_draw_compute_bar_graph)
 	}
 }
 
+function void
+ui_build_frame_latency(void)
+{
+	BeamformerFrameBacklog *bl = &beamformer_context->compute_context.backlog;
+	f64 to_ms = 1e3 / (f64)os_system_info()->timer_frequency;
+
+	/* NOTE(rnp): means are over the completed frames among the last 32 */
+	f64 means[BeamformerFrameTimestamp_Count] = {0};
+	u32 counts[BeamformerFrameTimestamp_Count] = {0};
+	f64 total_mean = 0;
+	u32 total_count = 0;
+	BeamformerFrame *latest = 0;
+
+	u64 available = Min(bl->counter, 32);
+	for (u64 id = bl->counter - available; id < bl->counter; id++) {
+		BeamformerFrame *f = bl->frames + id % countof(bl->frames);
+		u64 *t = f->timestamps;
+		if (t[BeamformerFrameTimestamp_FrameReady] == 0) continue;
+		latest = f;
+
+		u64 first = 0;
+		for (u32 it = 0; it < BeamformerFrameTimestamp_Count; it++) {
+			if (!first) first = t[it];
+			if (it > 0 && t[it] && t[it - 1]) {
+				means[it] += (f64)(i64)(t[it] - t[it - 1]) * to_ms;
+				counts[it]++;
+			}
+		}
+		total_mean += (f64)(t[BeamformerFrameTimestamp_FrameReady] - first) * to_ms;
+		total_count++;
+	}
+
+	UIFontSize(30.f)
+	UIScroll(Axis2_Count)
+	{
+		ui_top_parent()->child_layout_axis = Axis2_X;
+
+		UINode *label_column, *value_column, *unit_column;
+		UIAxisAlign(Axis2_X, Left)
+		UIChildLayoutAxis(Axis2_Y)
+		UIPrefWidth(ui_children_sum(1.0f))
+		UIPrefHeight(ui_children_sum(1.0f))
+		{
+			label_column = ui_node_from_string(0, str8("###labels"));
+			ui_padw(UI_NODE_PAD);
+			value_column = ui_node_from_string(0, str8("###values"));
+			ui_padw(UI_NODE_PAD);
+			unit_column  = ui_node_from_string(0, str8("###units"));
+		}
+
+		UIPrefWidth(ui_text_dim(1.0f, 1.0f))
+		UIPrefHeight(ui_text_dim(1.05f, 1.0f))
+		{
+			if (!latest) {
+				UIParent(label_column) ui_label(str8("No Frames"));
+			} else {
+				u64 *t = latest->timestamps;
+				u64 first = 0;
+				for (u32 it = 0; it < BeamformerFrameTimestamp_Count; it++) {
+					if (!first) first = t[it];
+					if (counts[it] == 0) continue;
+
+					f64 last = t[it] && t[it - 1] ? (f64)(i64)(t[it] - t[it - 1]) * to_ms : 0;
+					str8 name = beamformer_frame_interval_names[it];
+					UIParent(label_column) ui_labelf("%.*s:###fl_%u", (i32)name.length, name.data, it);
+					UIParent(value_column) ui_labelf("%0.3f / %0.3f###fl_%u", last, means[it] / counts[it], it);
+					UIParent(unit_column)  ui_labelf("[ms]###fl_%u", it);
+				}
+
+				f64 last = (f64)(t[BeamformerFrameTimestamp_FrameReady] - first) * to_ms;
+				UIParent(label_column) ui_label(str8("Total:###fl_total"));
+				UIParent(value_column) ui_labelf("%0.3f / %0.3f###fl_total", last, total_mean / total_count);
+				UIParent(unit_column)  ui_label(str8("[ms] (last/mean)###fl_total"));
+			}
+		}
+	}
+}
+
 function void
 ui_build_compute_stats(BeamformerComputePlan *cp, f32 broken_shader_t, BeamformerUIPanel *panel)
 {
@@ -3245,11 +3323,8 @@ ui_build_compute_stats(BeamformerComputePlan *cp, f32 broken_shader_t, Beamforme
 		{
 			for EachIndex(stages, it) {
 				v4 label_colour = FG_COLOUR;
-				if (vk_pipeline_valid(cp->vulkan_pipelines[it]) == 0 &&
-				    stats->table.shader_ids[it] != BeamformerShaderKind_Hilbert)
-				{
+				if (vk_pipeline_valid(cp->vulkan_pipelines[it]) == 0)
 					label_colour = v4_lerp(FG_COLOUR, FOCUSED_COLOUR, ease_in_out_quartic(broken_shader_t));
-				}
 
 				str8 shader = beamformer_shader_names[stats->table.shader_ids[it]];
 				i32 reloadable_index = beamformer_shader_reloadable_index_by_shader[stats->table.shader_ids[it]];
@@ -3346,12 +3421,47 @@ ui_build_compute_stats(BeamformerComputePlan *cp, f32 broken_shader_t, Beamforme
 			                                 compute_time_sum > 0.f ? 1.0f / compute_time_sum : 0.f);
 			UIParent(unit_column)  ui_label(str8("[s] (FPS)###csv_total"));
 
+			/* NOTE(rnp): achieved rates from the planner's estimates. a stage near the copy
+			 * bandwidth is memory bound; one well below it with a high GFLOP/s is compute bound */
+			f32 peak_bandwidth = beamformer_context->compute_context.peak_bandwidth;
+			for EachIndex(stages, it) {
+				f32 time = stats->average_times[it];
+				if (time <= 0.f || stats->table.stage_bytes[it] == 0) continue;
+
+				f32  bandwidth = (f32)stats->table.stage_bytes[it] / time;
+				f32  flops     = (f32)stats->table.stage_flops[it] / time;
+				str8 shader    = beamformer_shader_names[stats->table.shader_ids[it]];
+				UIParent(label_column) ui_labelf("%.*s Rate:###csr%u", (i32)shader.length, shader.data, (u32)it);
+				UIParent(value_column) ui_labelf("%0.1f (%0.0f%%) / %0.1f###csr%u", bandwidth * 1e-9f,
+				                                 peak_bandwidth > 0.f ? 100.f * bandwidth / peak_bandwidth : 0.f,
+				                                 flops * 1e-9f, (u32)it);
+				UIParent(unit_column)  ui_labelf("[GB/s] (peak) / [GFLOP/s]###csr%u", (u32)it);
+			}
+
+			if (peak_bandwidth > 0.f) {
+				UIParent(label_column) ui_label(str8("Copy Bandwidth:"));
+				UIParent(value_column) ui_labelf("%0.1f###csv_peak_bandwidth", peak_bandwidth * 1e-9f);
+				UIParent(unit_column)  ui_label(str8("[GB/s]###csv_peak_bandwidth"));
+			}
+
 			UIParent(label_column) ui_label(str8("RF Upload Delta:"));
 			UIParent(value_column) ui_labelf("%0.2e (%0.2f)###csv_upload", stats->rf_time_delta_average,
 			                                 stats->rf_time_delta_average > 0.f ? 1.0f / stats->rf_time_delta_average
 			                                                                    : 0.f);
 			UIParent(unit_column)  ui_label(str8("[s] (FPS)###csv_upload"));
 
+			for (u32 it = 0; it < BeamformerLatencyHistogram_FirstStage; it++) {
+				BeamformerLatencySummary ls = latency_histogram_summary(stats->latency + it, stats->latency_window,
+				                                                        BeamformerLatencyWindow_Window);
+				if (ls.count == 0) continue;
+				str8 name = beamformer_latency_histogram_names[it];
+				UIParent(label_column) ui_labelf("%.*s:###latency_%u", (i32)name.length, name.data, it);
+				UIParent(value_column) ui_labelf("%0.2e / %0.2e / %0.2e###latency_%u",
+				                                 ls.percentiles[BeamformerLatencyPercentile_P50],
+				                                 ls.percentiles[BeamformerLatencyPercentile_P99], ls.max, it);
+				UIParent(unit_column)  ui_labelf("[s] (p50/p99/max)###latency_%u", it);
+			}
+
 			u32 rf_size = beamformer_context->compute_context.rf_buffer.active_rf_size;
 			UIParent(label_column) ui_label(str8("Input RF Size:"));
 			UIParent(value_column) ui_labelf("%u###csv_rf_size", rf_size);
@@ -3360,6 +3470,68 @@ ui_build_compute_stats(BeamformerComputePlan *cp, f32 broken_shader_t, Beamforme
 			UIParent(label_column) ui_label(str8("DAS RF Size:"));
 			UIParent(value_column) ui_labelf("%u###csv_das_size", cp->rf_size);
 			UIParent(unit_column)  ui_label(str8("[B/F]###csv_das_size"));
+
+			BeamformerThreadPlacementLayout *tpl = beamformer_thread_placement();
+			str8 policy = beamformer_thread_placement_policy_names[tpl->policy];
+			UIParent(label_column) ui_label(str8("Thread Placement:"));
+			UIParent(value_column) ui_labelf("%.*s###placement", (i32)policy.length, policy.data);
+			if (tpl->policy == BeamformerThreadPlacementPolicy_GPULocal)
+				UIParent(unit_column) ui_labelf("[node %d]###placement", tpl->numa_node);
+			else
+				UIParent(unit_column) ui_label(str8("###placement"));
+
+			for (u32 it = 0; it < tpl->thread_count; it++) {
+				BeamformerThreadPlacement *tp = tpl->threads + it;
+				if (tp->cpu < 0 && !tp->realtime) continue;
+				UIParent(label_column) ui_labelf("%.*s:###placement_%u", (i32)tp->name.length, tp->name.data, it);
+				b32  dedicated = tp->cpu >= 0;
+				str8 unit      = dedicated ? str8("[CPU]") : str8("[CPUs]");
+				UIParent(value_column) ui_labelf("%u###placement_%u", dedicated ? (u32)tp->cpu : tp->cpu_count, it);
+				UIParent(unit_column)  ui_labelf("%.*s%s###placement_%u", (i32)unit.length, unit.data,
+				                                 tp->realtime ? " (FIFO)" : "", it);
+			}
+
+			GPUMemoryReport gmr = gpu_memory_report(ui_build_arena());
+			UIParent(label_column) ui_label(str8("GPU Memory:"));
+			UIParent(value_column) ui_labelf("%0.1f / %0.1f###gpu_memory",
+			                                 (f64)(gmr.suballocated_bytes + gmr.dedicated_bytes) / MB(1),
+			                                 (f64)(gmr.block_bytes + gmr.dedicated_bytes) / MB(1));
+			UIParent(unit_column)  ui_labelf("[MiB] (%u blocks, %u dedicated)###gpu_memory",
+			                                 gmr.block_count, gmr.dedicated_count);
+			BeamformerMemoryBudgetTable *mb = &beamformer_context->compute_context.memory_budget;
+			for EachElement(mb->budget, it) {
+				str8 name = beamformer_memory_budget_names[it];
+				UIParent(label_column) ui_labelf("  %.*s:###budget_%u", (i32)name.length, name.data, (u32)it);
+				UIParent(value_column) ui_labelf("%0.1f / %0.1f###budget_%u", (f64)mb->used[it] / MB(1),
+				                                 (f64)mb->budget[it] / MB(1), (u32)it);
+				UIParent(unit_column)  ui_labelf("[MiB]###budget_%u", (u32)it);
+			}
+
+			u64 plan_lookups = mb->plan_cache_hits + mb->plan_cache_misses;
+			UIParent(label_column) ui_label(str8("  Plan Cache Hits:"));
+			UIParent(value_column) ui_labelf("%0.1f###plan_cache", plan_lookups ? 100.0 * (f64)mb->plan_cache_hits / (f64)plan_lookups : 0.0);
+			UIParent(unit_column)  ui_labelf("[%%] (%llu / %llu, %u cached)###plan_cache", (unsigned long long)mb->plan_cache_hits,
+			                                 (unsigned long long)plan_lookups, mb->plan_cache_count);
+
+			if (gmr.pending_bytes) {
+				UIParent(label_column) ui_label(str8("Pending Free:"));
+				UIParent(value_column) ui_labelf("%0.1f###gpu_pending", (f64)gmr.pending_bytes / MB(1));
+				UIParent(unit_column)  ui_label(str8("[MiB]###gpu_pending"));
+			}
+
+			/* NOTE(rnp): largest live allocations first */
+			for (u32 it = 0; it < Min(gmr.allocation_count, 8); it++) {
+				u32 largest = it;
+				for (u32 other = it + 1; other < gmr.allocation_count; other++)
+					if (gmr.allocations[other].size > gmr.allocations[largest].size) largest = other;
+				swap(gmr.allocations[it], gmr.allocations[largest]);
+
+				GPUMemoryAllocation *a = gmr.allocations + it;
+				str8 label = a->label.length ? a->label : str8("(unlabeled)");
+				UIParent(label_column) ui_labelf("  %.*s:###gpu_alloc_%u", (i32)label.length, label.data, it);
+				UIParent(value_column) ui_labelf("%0.2f###gpu_alloc_%u", (f64)a->size / MB(1), it);
+				UIParent(unit_column)  ui_labelf("[MiB]%s###gpu_alloc_%u", a->dedicated ? " (dedicated)" : "", it);
+			}
 		}
 	}
 }
@@ -3824,6 +3996,7 @@ ui_panel_label(BeamformerUIPanel *panel)
 	InvalidDefaultCase;
 	case BeamformerPanelKind_ComputeBarGraph:{stream_append_str8(&sb, str8("Compute Bar Graph"));}break;
 	case BeamformerPanelKind_ComputeStats:{stream_append_str8(&sb, str8("Compute Stats"));}break;
+	case BeamformerPanelKind_FrameLatency:{stream_append_str8(&sb, str8("Frame Latency"));}break;
 	case BeamformerPanelKind_FrameViewLive:{stream_append_str8(&sb, str8("Frame View"));}break;
 	case BeamformerPanelKind_FrameViewXPlane:{stream_append_str8(&sb, str8("X-Plane View"));}break;
 	case BeamformerPanelKind_LiveImagingControls:{stream_append_str8(&sb, str8("Live Controls"));}break;
@@ -4238,6 +4411,8 @@ ui_build_regions(UINode *root_node, BeamformerUIPanel *tree_root)
 			ui_build_compute_stats(cp, t, panel);
 		}break;
 
+		case BeamformerPanelKind_FrameLatency:{ ui_build_frame_latency(); }break;
+
 		case BeamformerPanelKind_FrameViewXPlane:
 		{
 			BeamformerFrameView *view = panel->u.frame_view;
@@ -5,78 +5,598 @@
   #pragma GCC diagnostic ignored "-Woverride-init"
 #endif
 
-#define zero_struct(s) memory_clear((s), 0, sizeof(*(s)))
+/* NOTE(rnp): the memory functions dispatch on first use to the widest implementation the
+ * CPU supports (os_system_info()->cpu_features). lengths shorter than a vector are handled
+ * bytewise (or with a single masked access on AVX-512); longer ones store an unaligned head, run the body with
+ * the destination aligned, and finish with an overlapping unaligned tail. bodies at least
+ * MEMORY_NON_TEMPORAL_THRESHOLD long use streaming stores so that filling or copying a large
+ * buffer doesn't evict everything else from the cache */
+#define MEMORY_NON_TEMPORAL_THRESHOLD MB(4)
+
+typedef struct {
+	void *(*clear)(void *restrict, u8, u64);
+	b32   (*equal)(void *restrict, void *restrict, u64);
+	void  (*copy)(void *restrict, void *restrict, u64, b32 non_temporal);
+	str8  name;
+	u32   required_features;
+} MemoryFunctions;
+
+#if ARCH_X64
+
 function void *
-memory_clear(void *restrict p_, u8 c, u64 size)
+memory_clear_sse2(void *restrict p, u8 c, u64 n)
 {
-	u8 *p = p_;
-	while (size > 0) p[--size] = c;
+	u8 *d = p;
+	if (n < 16) {
+		for (; n; n--) *d++ = c;
+	} else {
+		__m128i v   = _mm_set1_epi8((char)c);
+		u8     *end = d + n;
+		_mm_storeu_si128((__m128i *)d, v);
+		u64 skip = 16 - ((u64)d & 15);
+		d += skip;
+		n -= skip;
+		if (n >= MEMORY_NON_TEMPORAL_THRESHOLD) {
+			for (; n >= 16; n -= 16, d += 16)
+				_mm_stream_si128((__m128i *)d, v);
+			store_fence();
+		} else {
+			for (; n >= 64; n -= 64, d += 64) {
+				_mm_store_si128((__m128i *)d + 0, v);
+				_mm_store_si128((__m128i *)d + 1, v);
+				_mm_store_si128((__m128i *)d + 2, v);
+				_mm_store_si128((__m128i *)d + 3, v);
+			}
+			for (; n >= 16; n -= 16, d += 16)
+				_mm_store_si128((__m128i *)d, v);
+		}
+		_mm_storeu_si128((__m128i *)(end - 16), v);
+	}
 	return p;
 }
 
 function b32
-memory_equal(void *restrict left, void *restrict right, u64 n)
+memory_equal_sse2(void *restrict left, void *restrict right, u64 n)
 {
 	u8 *a = left, *b = right;
 	b32 result = 1;
-	for (; result && n; n--)
-		result &= *a++ == *b++;
+	if (n < 16) {
+		for (; result && n; n--) result = *a++ == *b++;
+	} else {
+		u8 *a_tail = a + n - 16, *b_tail = b + n - 16;
+		for (; result && n >= 64; n -= 64, a += 64, b += 64) {
+			__m128i e0 = _mm_cmpeq_epi8(_mm_loadu_si128((__m128i *)a + 0), _mm_loadu_si128((__m128i *)b + 0));
+			__m128i e1 = _mm_cmpeq_epi8(_mm_loadu_si128((__m128i *)a + 1), _mm_loadu_si128((__m128i *)b + 1));
+			__m128i e2 = _mm_cmpeq_epi8(_mm_loadu_si128((__m128i *)a + 2), _mm_loadu_si128((__m128i *)b + 2));
+			__m128i e3 = _mm_cmpeq_epi8(_mm_loadu_si128((__m128i *)a + 3), _mm_loadu_si128((__m128i *)b + 3));
+			result = _mm_movemask_epi8(_mm_and_si128(_mm_and_si128(e0, e1), _mm_and_si128(e2, e3))) == 0xFFFF;
+		}
+		for (; result && n >= 16; n -= 16, a += 16, b += 16)
+			result = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((__m128i *)a), _mm_loadu_si128((__m128i *)b))) == 0xFFFF;
+		if (result)
+			result = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((__m128i *)a_tail), _mm_loadu_si128((__m128i *)b_tail))) == 0xFFFF;
+	}
 	return result;
 }
 
 function void
-memory_copy(void *restrict dest, void *restrict src, u64 n)
+memory_copy_sse2(void *restrict dest, void *restrict src, u64 n, b32 non_temporal)
+{
+	u8 *d = dest, *s = src;
+	if (n < 16) {
+		for (; n; n--) *d++ = *s++;
+	} else {
+		u8     *end  = d + n;
+		__m128i tail = _mm_loadu_si128((__m128i *)(s + n - 16));
+		_mm_storeu_si128((__m128i *)d, _mm_loadu_si128((__m128i *)s));
+		u64 skip = 16 - ((u64)d & 15);
+		d += skip;
+		s += skip;
+		n -= skip;
+		if (non_temporal) {
+			for (; n >= 16; n -= 16, d += 16, s += 16)
+				_mm_stream_si128((__m128i *)d, _mm_loadu_si128((__m128i *)s));
+			store_fence();
+		} else {
+			for (; n >= 64; n -= 64, d += 64, s += 64) {
+				__m128i v0 = _mm_loadu_si128((__m128i *)s + 0);
+				__m128i v1 = _mm_loadu_si128((__m128i *)s + 1);
+				__m128i v2 = _mm_loadu_si128((__m128i *)s + 2);
+				__m128i v3 = _mm_loadu_si128((__m128i *)s + 3);
+				_mm_store_si128((__m128i *)d + 0, v0);
+				_mm_store_si128((__m128i *)d + 1, v1);
+				_mm_store_si128((__m128i *)d + 2, v2);
+				_mm_store_si128((__m128i *)d + 3, v3);
+			}
+			for (; n >= 16; n -= 16, d += 16, s += 16)
+				_mm_store_si128((__m128i *)d, _mm_loadu_si128((__m128i *)s));
+		}
+		_mm_storeu_si128((__m128i *)(end - 16), tail);
+	}
+}
+
+function target_feature("avx2") void *
+memory_clear_avx2(void *restrict p, u8 c, u64 n)
+{
+	u8 *d = p;
+	if (n < 32) {
+		memory_clear_sse2(d, c, n);
+	} else {
+		__m256i v   = _mm256_set1_epi8((char)c);
+		u8     *end = d + n;
+		_mm256_storeu_si256((__m256i *)d, v);
+		u64 skip = 32 - ((u64)d & 31);
+		d += skip;
+		n -= skip;
+		if (n >= MEMORY_NON_TEMPORAL_THRESHOLD) {
+			for (; n >= 32; n -= 32, d += 32)
+				_mm256_stream_si256((__m256i *)d, v);
+			store_fence();
+		} else {
+			for (; n >= 128; n -= 128, d += 128) {
+				_mm256_store_si256((__m256i *)d + 0, v);
+				_mm256_store_si256((__m256i *)d + 1, v);
+				_mm256_store_si256((__m256i *)d + 2, v);
+				_mm256_store_si256((__m256i *)d + 3, v);
+			}
+			for (; n >= 32; n -= 32, d += 32)
+				_mm256_store_si256((__m256i *)d, v);
+		}
+		_mm256_storeu_si256((__m256i *)(end - 32), v);
+	}
+	return p;
+}
+
+function target_feature("avx2") b32
+memory_equal_avx2(void *restrict left, void *restrict right, u64 n)
+{
+	u8 *a = left, *b = right;
+	b32 result = 1;
+	if (n < 32) {
+		result = memory_equal_sse2(a, b, n);
+	} else {
+		u8 *a_tail = a + n - 32, *b_tail = b + n - 32;
+		for (; result && n >= 128; n -= 128, a += 128, b += 128) {
+			__m256i e0 = _mm256_cmpeq_epi8(_mm256_loadu_si256((__m256i *)a + 0), _mm256_loadu_si256((__m256i *)b + 0));
+			__m256i e1 = _mm256_cmpeq_epi8(_mm256_loadu_si256((__m256i *)a + 1), _mm256_loadu_si256((__m256i *)b + 1));
+			__m256i e2 = _mm256_cmpeq_epi8(_mm256_loadu_si256((__m256i *)a + 2), _mm256_loadu_si256((__m256i *)b + 2));
+			__m256i e3 = _mm256_cmpeq_epi8(_mm256_loadu_si256((__m256i *)a + 3), _mm256_loadu_si256((__m256i *)b + 3));
+			result = (u32)_mm256_movemask_epi8(_mm256_and_si256(_mm256_and_si256(e0, e1), _mm256_and_si256(e2, e3))) == 0xFFFFFFFFu;
+		}
+		for (; result && n >= 32; n -= 32, a += 32, b += 32)
+			result = (u32)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((__m256i *)a), _mm256_loadu_si256((__m256i *)b))) == 0xFFFFFFFFu;
+		if (result)
+			result = (u32)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((__m256i *)a_tail), _mm256_loadu_si256((__m256i *)b_tail))) == 0xFFFFFFFFu;
+	}
+	return result;
+}
+
+function target_feature("avx2") void
+memory_copy_avx2(void *restrict dest, void *restrict src, u64 n, b32 non_temporal)
 {
-	u8 *s = src, *d = dest;
-	#ifdef __AVX512BW__
-	{
-		for (; n >= 64; n -= 64, s += 64, d += 64)
-			_mm512_storeu_epi8(d, _mm512_loadu_epi8(s));
-		__mmask64 k = _cvtu64_mask64(_bzhi_u64(-1ULL, n));
+	u8 *d = dest, *s = src;
+	if (n < 32) {
+		memory_copy_sse2(d, s, n, 0);
+	} else {
+		u8     *end  = d + n;
+		__m256i tail = _mm256_loadu_si256((__m256i *)(s + n - 32));
+		_mm256_storeu_si256((__m256i *)d, _mm256_loadu_si256((__m256i *)s));
+		u64 skip = 32 - ((u64)d & 31);
+		d += skip;
+		s += skip;
+		n -= skip;
+		if (non_temporal) {
+			for (; n >= 32; n -= 32, d += 32, s += 32)
+				_mm256_stream_si256((__m256i *)d, _mm256_loadu_si256((__m256i *)s));
+			store_fence();
+		} else {
+			for (; n >= 128; n -= 128, d += 128, s += 128) {
+				__m256i v0 = _mm256_loadu_si256((__m256i *)s + 0);
+				__m256i v1 = _mm256_loadu_si256((__m256i *)s + 1);
+				__m256i v2 = _mm256_loadu_si256((__m256i *)s + 2);
+				__m256i v3 = _mm256_loadu_si256((__m256i *)s + 3);
+				_mm256_store_si256((__m256i *)d + 0, v0);
+				_mm256_store_si256((__m256i *)d + 1, v1);
+				_mm256_store_si256((__m256i *)d + 2, v2);
+				_mm256_store_si256((__m256i *)d + 3, v3);
+			}
+			for (; n >= 32; n -= 32, d += 32, s += 32)
+				_mm256_store_si256((__m256i *)d, _mm256_loadu_si256((__m256i *)s));
+		}
+		_mm256_storeu_si256((__m256i *)(end - 32), tail);
+	}
+}
+
+/* NOTE(rnp): masked accesses don't fault on the masked off bytes so anything up to a full
+ * vector is a single load/store */
+#define memory_mask_avx512(n) _cvtu64_mask64((n) >= 64 ? U64_MAX : ((1ULL << (n)) - 1))
+
+function target_feature("avx512f,avx512bw") void *
+memory_clear_avx512(void *restrict p, u8 c, u64 n)
+{
+	u8     *d = p;
+	__m512i v = _mm512_set1_epi8((char)c);
+	if (n <= 64) {
+		_mm512_mask_storeu_epi8(d, memory_mask_avx512(n), v);
+	} else {
+		u8 *end = d + n;
+		_mm512_storeu_si512(d, v);
+		u64 skip = 64 - ((u64)d & 63);
+		d += skip;
+		n -= skip;
+		if (n >= MEMORY_NON_TEMPORAL_THRESHOLD) {
+			for (; n >= 64; n -= 64, d += 64)
+				_mm512_stream_si512((__m512i *)d, v);
+			store_fence();
+		} else {
+			for (; n >= 256; n -= 256, d += 256) {
+				_mm512_store_si512(d +   0, v);
+				_mm512_store_si512(d +  64, v);
+				_mm512_store_si512(d + 128, v);
+				_mm512_store_si512(d + 192, v);
+			}
+			for (; n >= 64; n -= 64, d += 64)
+				_mm512_store_si512(d, v);
+		}
+		_mm512_storeu_si512(end - 64, v);
+	}
+	return p;
+}
+
+function target_feature("avx512f,avx512bw") b32
+memory_equal_avx512(void *restrict left, void *restrict right, u64 n)
+{
+	u8 *a = left, *b = right;
+	b32 result = 1;
+	if (n <= 64) {
+		__mmask64 k = memory_mask_avx512(n);
+		result = _mm512_cmpneq_epi8_mask(_mm512_maskz_loadu_epi8(k, a), _mm512_maskz_loadu_epi8(k, b)) == 0;
+	} else {
+		u8 *a_tail = a + n - 64, *b_tail = b + n - 64;
+		for (; result && n >= 256; n -= 256, a += 256, b += 256) {
+			u64 ne = _mm512_cmpneq_epi8_mask(_mm512_loadu_si512(a +   0), _mm512_loadu_si512(b +   0))
+			       | _mm512_cmpneq_epi8_mask(_mm512_loadu_si512(a +  64), _mm512_loadu_si512(b +  64))
+			       | _mm512_cmpneq_epi8_mask(_mm512_loadu_si512(a + 128), _mm512_loadu_si512(b + 128))
+			       | _mm512_cmpneq_epi8_mask(_mm512_loadu_si512(a + 192), _mm512_loadu_si512(b + 192));
+			result = ne == 0;
+		}
+		for (; result && n >= 64; n -= 64, a += 64, b += 64)
+			result = _mm512_cmpneq_epi8_mask(_mm512_loadu_si512(a), _mm512_loadu_si512(b)) == 0;
+		if (result)
+			result = _mm512_cmpneq_epi8_mask(_mm512_loadu_si512(a_tail), _mm512_loadu_si512(b_tail)) == 0;
+	}
+	return result;
+}
+
+function target_feature("avx512f,avx512bw") void
+memory_copy_avx512(void *restrict dest, void *restrict src, u64 n, b32 non_temporal)
+{
+	u8 *d = dest, *s = src;
+	if (n <= 64) {
+		__mmask64 k = memory_mask_avx512(n);
 		_mm512_mask_storeu_epi8(d, k, _mm512_maskz_loadu_epi8(k, s));
+	} else {
+		u8     *end  = d + n;
+		__m512i tail = _mm512_loadu_si512(s + n - 64);
+		_mm512_storeu_si512(d, _mm512_loadu_si512(s));
+		u64 skip = 64 - ((u64)d & 63);
+		d += skip;
+		s += skip;
+		n -= skip;
+		if (non_temporal) {
+			for (; n >= 64; n -= 64, d += 64, s += 64)
+				_mm512_stream_si512((__m512i *)d, _mm512_loadu_si512(s));
+			store_fence();
+		} else {
+			for (; n >= 256; n -= 256, d += 256, s += 256) {
+				__m512i v0 = _mm512_loadu_si512(s +   0);
+				__m512i v1 = _mm512_loadu_si512(s +  64);
+				__m512i v2 = _mm512_loadu_si512(s + 128);
+				__m512i v3 = _mm512_loadu_si512(s + 192);
+				_mm512_store_si512(d +   0, v0);
+				_mm512_store_si512(d +  64, v1);
+				_mm512_store_si512(d + 128, v2);
+				_mm512_store_si512(d + 192, v3);
+			}
+			for (; n >= 64; n -= 64, d += 64, s += 64)
+				_mm512_store_si512(d, _mm512_loadu_si512(s));
+		}
+		_mm512_storeu_si512(end - 64, tail);
 	}
-	#else
-		for (; n; n--) *d++ = *s++;
-	#endif
 }
 
-/* IMPORTANT: this function may fault if dest, src, and n are not multiples of 64 */
-function void
-memory_copy_non_temporal(void *restrict dest, void *restrict src, u64 n)
+#define MEMORY_FUNCTIONS_LIST \
+	X(sse2,   "SSE2",    0) \
+	X(avx2,   "AVX2",    CPUFeature_AVX2) \
+	X(avx512, "AVX-512", CPUFeature_AVX512BW)
+
+#elif ARCH_ARM64
+
+function void *
+memory_clear_neon(void *restrict p, u8 c, u64 n)
 {
-	assume(((u64)dest & 63) == 0);
-	assume(((u64)src  & 63) == 0);
-	assume(((u64)n    & 63) == 0);
-	u8 *s = src, *d = dest;
+	u8 *d = p;
+	if (n < 16) {
+		for (; n; n--) *d++ = c;
+	} else {
+		uint8x16_t v   = vdupq_n_u8(c);
+		u8        *end = d + n;
+		vst1q_u8(d, v);
+		u64 skip = 16 - ((u64)d & 15);
+		d += skip;
+		n -= skip;
+		#if !COMPILER_MSVC
+		if (n >= MEMORY_NON_TEMPORAL_THRESHOLD) {
+			u64 count = n & ~31ULL;
+			n &= 31;
+			asm volatile (
+				"1: stnp %q[v], %q[v], [%[d]]\n"
+				"subs %[c], %[c], #32\n"
+				"add  %[d], %[d], #32\n"
+				"b.ne 1b\n"
+				: [d] "+r"(d), [c] "+r"(count)
+				: [v] "w"(v)
+				: "memory", "cc"
+			);
+		}
+		#endif
+		for (; n >= 64; n -= 64, d += 64) {
+			vst1q_u8(d +  0, v);
+			vst1q_u8(d + 16, v);
+			vst1q_u8(d + 32, v);
+			vst1q_u8(d + 48, v);
+		}
+		for (; n >= 16; n -= 16, d += 16)
+			vst1q_u8(d, v);
+		vst1q_u8(end - 16, v);
+	}
+	return p;
+}
 
-	#if defined(__AVX512BW__)
-	{
-		for (; n >= 64; n -= 64, s += 64, d += 64)
-			_mm512_stream_si512((__m512i *)d, _mm512_stream_load_si512((__m512i *)s));
+function b32
+memory_equal_neon(void *restrict left, void *restrict right, u64 n)
+{
+	u8 *a = left, *b = right;
+	b32 result = 1;
+	if (n < 16) {
+		for (; result && n; n--) result = *a++ == *b++;
+	} else {
+		u8 *a_tail = a + n - 16, *b_tail = b + n - 16;
+		for (; result && n >= 64; n -= 64, a += 64, b += 64) {
+			uint8x16_t e0 = vceqq_u8(vld1q_u8(a +  0), vld1q_u8(b +  0));
+			uint8x16_t e1 = vceqq_u8(vld1q_u8(a + 16), vld1q_u8(b + 16));
+			uint8x16_t e2 = vceqq_u8(vld1q_u8(a + 32), vld1q_u8(b + 32));
+			uint8x16_t e3 = vceqq_u8(vld1q_u8(a + 48), vld1q_u8(b + 48));
+			result = vminvq_u8(vandq_u8(vandq_u8(e0, e1), vandq_u8(e2, e3))) == 0xFF;
+		}
+		for (; result && n >= 16; n -= 16, a += 16, b += 16)
+			result = vminvq_u8(vceqq_u8(vld1q_u8(a), vld1q_u8(b))) == 0xFF;
+		if (result)
+			result = vminvq_u8(vceqq_u8(vld1q_u8(a_tail), vld1q_u8(b_tail))) == 0xFF;
 	}
-	#elif defined(__AVX2__)
-	{
-		for (; n >= 32; n -= 32, s += 32, d += 32)
-			_mm256_stream_si256((__m256i *)d, _mm256_stream_load_si256((__m256i *)s));
+	return result;
+}
+
+function void
+memory_copy_neon(void *restrict dest, void *restrict src, u64 n, b32 non_temporal)
+{
+	u8 *d = dest, *s = src;
+	if (n < 16) {
+		for (; n; n--) *d++ = *s++;
+	} else {
+		u8        *end  = d + n;
+		uint8x16_t tail = vld1q_u8(s + n - 16);
+		vst1q_u8(d, vld1q_u8(s));
+		u64 skip = 16 - ((u64)d & 15);
+		d += skip;
+		s += skip;
+		n -= skip;
+		#if !COMPILER_MSVC
+		if (non_temporal && n >= 32) {
+			u64 count = n & ~31ULL;
+			n &= 31;
+			asm volatile (
+				"1: ldp  q0, q1, [%[s]]\n"
+				"subs %[c], %[c], #32\n"
+				"add  %[s], %[s], #32\n"
+				"stnp q0, q1, [%[d]]\n"
+				"add  %[d], %[d], #32\n"
+				"b.ne 1b\n"
+				: [d] "+r"(d), [s] "+r"(s), [c] "+r"(count)
+				:: "memory", "cc", "v0", "v1"
+			);
+		}
+		#endif
+		for (; n >= 64; n -= 64, d += 64, s += 64) {
+			uint8x16_t v0 = vld1q_u8(s +  0);
+			uint8x16_t v1 = vld1q_u8(s + 16);
+			uint8x16_t v2 = vld1q_u8(s + 32);
+			uint8x16_t v3 = vld1q_u8(s + 48);
+			vst1q_u8(d +  0, v0);
+			vst1q_u8(d + 16, v1);
+			vst1q_u8(d + 32, v2);
+			vst1q_u8(d + 48, v3);
+		}
+		for (; n >= 16; n -= 16, d += 16, s += 16)
+			vst1q_u8(d, vld1q_u8(s));
+		vst1q_u8(end - 16, tail);
 	}
-	#elif ARCH_ARM64 && !COMPILER_MSVC
-	{
+}
+
+#if !COMPILER_MSVC
+/* NOTE(rnp): SVE is written directly in assembly so that no compiler support beyond the
+ * assembler is needed. predicated loads and stores cover the head and tail so there is a
+ * single loop for every length. all of the loops are the canonical whilelo/incb form */
+function void *
+memory_clear_sve(void *restrict p, u8 c, u64 n)
+{
+	u64 i = 0;
+	if (n >= MEMORY_NON_TEMPORAL_THRESHOLD) {
 		asm volatile (
-			"cbz  %2, 2f\n"
-			"1: ldnp q0, q1, [%1]\n"
-			"subs %2, %2, #32\n"
-			"add  %1, %1, #32\n"
-			"stnp q0, q1, [%0]\n"
-			"add  %0, %0, #32\n"
-			"b.ne 1b\n"
-			"2:"
-			:  "+r"(d), "+r"(s), "+r"(n)
-			:: "memory", "v0", "v1"
+			".arch_extension sve\n"
+			"mov     z0.b, %w[c]\n"
+			"whilelo p0.b, %[i], %[n]\n"
+			"1: stnt1b {z0.b}, p0, [%[p], %[i]]\n"
+			"incb    %[i]\n"
+			"whilelo p0.b, %[i], %[n]\n"
+			"b.first 1b\n"
+			: [i] "+r"(i)
+			: [p] "r"(p), [c] "r"((u32)c), [n] "r"(n)
+			: "memory", "cc", "v0", "p0"
+		);
+	} else {
+		asm volatile (
+			".arch_extension sve\n"
+			"mov     z0.b, %w[c]\n"
+			"whilelo p0.b, %[i], %[n]\n"
+			"b.none  2f\n"
+			"1: st1b {z0.b}, p0, [%[p], %[i]]\n"
+			"incb    %[i]\n"
+			"whilelo p0.b, %[i], %[n]\n"
+			"b.first 1b\n"
+			"2:\n"
+			: [i] "+r"(i)
+			: [p] "r"(p), [c] "r"((u32)c), [n] "r"(n)
+			: "memory", "cc", "v0", "p0"
 		);
 	}
-	#else
-		memory_copy(d, s, n);
-	#endif
+	return p;
+}
+
+function b32
+memory_equal_sve(void *restrict left, void *restrict right, u64 n)
+{
+	u64 i = 0;
+	u32 result = 1;
+	asm volatile (
+		".arch_extension sve\n"
+		"whilelo p0.b, %[i], %[n]\n"
+		"b.none  2f\n"
+		"1: ld1b {z0.b}, p0/z, [%[a], %[i]]\n"
+		"ld1b    {z1.b}, p0/z, [%[b], %[i]]\n"
+		"cmpne   p1.b, p0/z, z0.b, z1.b\n"
+		"b.any   3f\n"
+		"incb    %[i]\n"
+		"whilelo p0.b, %[i], %[n]\n"
+		"b.first 1b\n"
+		"b       2f\n"
+		"3: mov  %w[r], #0\n"
+		"2:\n"
+		: [i] "+r"(i), [r] "+r"(result)
+		: [a] "r"(left), [b] "r"(right), [n] "r"(n)
+		: "memory", "cc", "v0", "v1", "p0", "p1"
+	);
+	return result;
+}
+
+function void
+memory_copy_sve(void *restrict dest, void *restrict src, u64 n, b32 non_temporal)
+{
+	u64 i = 0;
+	if (non_temporal) {
+		asm volatile (
+			".arch_extension sve\n"
+			"whilelo p0.b, %[i], %[n]\n"
+			"b.none  2f\n"
+			"1: ld1b {z0.b}, p0/z, [%[s], %[i]]\n"
+			"stnt1b  {z0.b}, p0, [%[d], %[i]]\n"
+			"incb    %[i]\n"
+			"whilelo p0.b, %[i], %[n]\n"
+			"b.first 1b\n"
+			"2:\n"
+			: [i] "+r"(i)
+			: [d] "r"(dest), [s] "r"(src), [n] "r"(n)
+			: "memory", "cc", "v0", "p0"
+		);
+	} else {
+		asm volatile (
+			".arch_extension sve\n"
+			"whilelo p0.b, %[i], %[n]\n"
+			"b.none  2f\n"
+			"1: ld1b {z0.b}, p0/z, [%[s], %[i]]\n"
+			"st1b    {z0.b}, p0, [%[d], %[i]]\n"
+			"incb    %[i]\n"
+			"whilelo p0.b, %[i], %[n]\n"
+			"b.first 1b\n"
+			"2:\n"
+			: [i] "+r"(i)
+			: [d] "r"(dest), [s] "r"(src), [n] "r"(n)
+			: "memory", "cc", "v0", "p0"
+		);
+	}
+}
+
+#define MEMORY_FUNCTIONS_LIST \
+	X(neon, "NEON", 0) \
+	X(sve,  "SVE",  CPUFeature_SVE)
+
+#else
+
+#define MEMORY_FUNCTIONS_LIST \
+	X(neon, "NEON", 0)
+
+#endif /* !COMPILER_MSVC */
+
+#endif /* ARCH_ARM64 */
+
+/* NOTE(rnp): ordered by preference; not read_only since it holds relocated pointers */
+global MemoryFunctions memory_function_table[] = {
+	#define X(suffix, name, features) {memory_clear_ ##suffix, memory_equal_ ##suffix, memory_copy_ ##suffix, str8_comp(name), features},
+	MEMORY_FUNCTIONS_LIST
+	#undef X
+};
+
+global MemoryFunctions *memory_functions;
+
+function MemoryFunctions *
+memory_functions_for_features(u32 cpu_features)
+{
+	MemoryFunctions *result = memory_function_table;
+	for EachElement(memory_function_table, it) {
+		u32 required = memory_function_table[it].required_features;
+		if ((cpu_features & required) == required)
+			result = memory_function_table + it;
+	}
+	return result;
+}
+
+/* NOTE(rnp): racing threads resolve to the same table entry so the unsynchronized store is fine */
+function force_inline MemoryFunctions *
+memory_functions_get(void)
+{
+	MemoryFunctions *result = memory_functions;
+	if unlikely(!result) {
+		result = memory_functions_for_features(os_system_info()->cpu_features);
+		memory_functions = result;
+	}
+	return result;
+}
+
+#define zero_struct(s) memory_clear((s), 0, sizeof(*(s)))
+function void *
+memory_clear(void *restrict p, u8 c, u64 size)
+{
+	return memory_functions_get()->clear(p, c, size);
+}
+
+function b32
+memory_equal(void *restrict left, void *restrict right, u64 n)
+{
+	return memory_functions_get()->equal(left, right, n);
+}
+
+function void
+memory_copy(void *restrict dest, void *restrict src, u64 n)
+{
+	memory_functions_get()->copy(dest, src, n, n >= MEMORY_NON_TEMPORAL_THRESHOLD);
+}
+
+/* NOTE(rnp): always uses streaming stores; for large copies into memory which won't be read
+ * back by the CPU soon (e.g. upload buffers) */
+function void
+memory_copy_non_temporal(void *restrict dest, void *restrict src, u64 n)
+{
+	memory_functions_get()->copy(dest, src, n, 1);
 }
 
 function void
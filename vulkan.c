@@ -6,6 +6,7 @@
 
 #include "beamformer_internal.h"
 #include "vulkan.h"
+#include "buddy.c"
 #include "external/glslang/glslang/Include/glslang_c_interface.h"
 
 #define ForceSingleQueue (0)
@@ -16,7 +17,18 @@
 #define ValidVulkanHandle(h) ((h).value[0] != 0)
 
 #define MaxCommandBuffersInFlight  (3)
-#define MaxCommandBufferTimestamps (1024)
+
+/* NOTE(rnp): buffers up to half a block are suballocated from pooled memory blocks. this
+ * keeps resizes cheap and the number of device allocations well below the driver's
+ * maxMemoryAllocationCount. the device block size scales with the heap size */
+#define VulkanMemoryMinBlockSize   MB(16)
+#define VulkanMemoryMaxBlockSize   MB(256)
+#define VulkanMemoryBARBlockSize   MB(64)
+#define VulkanMemoryLabelLength    (48)
+
+/* NOTE(rnp): profile zone queries are created in blocks of this many zones as a command
+ * buffer first needs them. blocks are kept for the next use of the same command buffer */
+#define VulkanProfileBlockZones    (256)
 
 typedef enum {
 	VulkanQueueKind_Graphics,
@@ -32,7 +44,22 @@ typedef enum {
 	VulkanMemoryKind_Count,
 } VulkanMemoryKind;
 
+typedef struct VulkanMemoryBlock VulkanMemoryBlock;
+struct VulkanMemoryBlock {
+	BuddyAllocator     allocator;
+	VkDeviceMemory     memory;
+	u8 *               host_pointer;
+	VulkanMemoryBlock *next;
+};
+
 typedef struct {
+	VulkanMemoryBlock *blocks;
+	u64                block_size;
+	u32                block_count;
+} VulkanMemoryPool;
+
+typedef struct VulkanBuffer VulkanBuffer;
+struct VulkanBuffer {
 	VkDeviceMemory    memory;
 	VkBuffer          buffer;
 	u64               memory_size;
@@ -43,7 +70,20 @@ typedef struct {
 
 	// NOTE: only used when the buffer is backing a VulkanRenderModel.
 	VkIndexType       index_type;
-} VulkanBuffer;
+
+	// NOTE(rnp): set when the buffer was suballocated; memory is then owned by the block
+	VulkanMemoryBlock *block;
+	u64                memory_offset;
+
+	// NOTE(rnp): timeline values that must be reached before a released buffer is destroyed
+	u64                release_wait_values[GPUTimeline_Count];
+
+	// NOTE(rnp): live or pending release list
+	VulkanBuffer      *prev, *next;
+
+	u8                 label_length;
+	u8                 label[VulkanMemoryLabelLength];
+};
 
 typedef struct {
 	VkDeviceMemory    memory;
@@ -70,6 +110,33 @@ typedef struct {
 	u64 in_flight_wait_values[VulkanQueueKind_Count];
 } VulkanCommandBuffer;
 
+typedef struct {
+	str8 label;
+	u32  parent;
+	u32  depth;
+	u32  tag;
+	b32  statistics;
+} VulkanProfileZone;
+
+typedef struct VulkanProfileBlock VulkanProfileBlock;
+struct VulkanProfileBlock {
+	VulkanProfileBlock *next;
+	/* NOTE(rnp): begin and end timestamp of each zone */
+	VkQueryPool         timestamps;
+	/* NOTE(rnp): one query per zone; only created when pipeline statistics are supported */
+	VkQueryPool         statistics;
+	VulkanProfileZone   zones[VulkanProfileBlockZones];
+};
+
+typedef struct {
+	VulkanProfileBlock *blocks;
+	u32                 zone_count;
+	u32                 depth;
+	u32                 open_zone;
+	/* NOTE(rnp): zone owning the active pipeline statistics query */
+	u32                 statistics_zone;
+} VulkanProfileState;
+
 typedef enum {
 	VulkanEntityKind_Buffer,
 	VulkanEntityKind_CommandBuffer,
@@ -112,11 +179,11 @@ typedef alignas(64) struct {
 	VulkanPipeline *bound_pipeline;
 
 	u64             last_submission_values[MaxCommandBuffersInFlight];
-	u64             timestamp_counts[MaxCommandBuffersInFlight];
 
 	VkCommandPool   handle;
-	VkQueryPool     query_pool;
 	VkCommandBuffer buffers[MaxCommandBuffersInFlight];
+
+	VulkanProfileState profiles[MaxCommandBuffersInFlight];
 } VulkanCommandPool;
 
 typedef struct {
@@ -164,6 +231,19 @@ typedef struct {
 	VulkanEntity     *entity_freelist;
 	Arena            *entity_arena;
 	i32               entity_lock;
+
+	struct {
+		i32                lock;
+		VulkanMemoryPool   pools[VulkanMemoryKind_Count];
+		VulkanMemoryBlock *block_freelist;
+
+		VulkanBuffer      *live_first,    *live_last;
+		VulkanBuffer      *pending_first, *pending_last;
+
+		u64                dedicated_bytes;
+		u64                pending_bytes;
+		u32                dedicated_count;
+	} memory;
 } VulkanContext;
 
 read_only global const char *vk_required_instance_extensions[] = {
@@ -174,11 +254,14 @@ read_only global const char *vk_required_instance_extensions[] = {
 	X("VK_KHR_external_memory_win32") \
 	X("VK_KHR_external_semaphore_win32") \
 
+/* NOTE(rnp): clock behind os_timer_count() */
+#define VK_HOST_TIME_DOMAIN VK_TIME_DOMAIN_QUERY_PERFORMANCE_COUNTER_EXT
 #else
 #define VK_OS_REQUIRED_DEVICE_EXTENSIONS_LIST \
 	X("VK_KHR_external_memory_fd") \
 	X("VK_KHR_external_semaphore_fd") \
 
+#define VK_HOST_TIME_DOMAIN VK_TIME_DOMAIN_CLOCK_MONOTONIC_EXT
 #endif
 
 #define VK_REQUIRED_DEVICE_EXTENSIONS_LIST \
@@ -196,7 +279,9 @@ read_only global str8 vk_required_device_extensions[] = {VK_REQUIRED_DEVICE_EXTE
 #undef X
 
 #define VK_OPTIONAL_DEVICE_EXTENSIONS_LIST \
+	X(VK_EXT, calibrated_timestamps) \
 	X(VK_KHR, cooperative_matrix) \
+	X(VK_EXT, pci_bus_info) \
 
 #define X(p, s, ...) str8_comp(#p "_" #s),
 read_only global str8 vk_optional_device_extensions[] = {VK_OPTIONAL_DEVICE_EXTENSIONS_LIST};
@@ -947,6 +1032,135 @@ vk_allocate_memory(VkDeviceMemory *memory, u64 size, VulkanMemoryKind kind, VkMe
 	return result;
 }
 
+function VulkanMemoryBlock *
+vk_memory_block_create(VulkanMemoryKind kind)
+{
+	VulkanContext     *vk     = vulkan_context;
+	VulkanMemoryPool  *pool   = vk->memory.pools + kind;
+	VulkanMemoryBlock *result = SLLPopFreelist(vk->memory.block_freelist);
+	if (!result) {
+		DeferLoop(take_lock(&vk->arena_lock, -1), release_lock(&vk->arena_lock))
+		{
+			result = push_struct(vk->arena, VulkanMemoryBlock);
+			result->allocator.longest = push_array(vk->arena, u8, buddy_tree_size(VulkanMemoryMaxBlockSize));
+		}
+	}
+
+	VkDeviceMemory memory;
+	if (vk_allocate_memory(&memory, pool->block_size, kind, VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT, 0, 0)) {
+		vk_label_object(DEVICE_MEMORY, memory, str8("MemoryBlock"), str8("Memory"));
+		u8 *tree = result->allocator.longest;
+		zero_struct(result);
+		buddy_init(&result->allocator, tree, pool->block_size);
+		result->memory = memory;
+		if (kind == VulkanMemoryKind_BAR)
+			vkMapMemory(vk->device, memory, 0, pool->block_size, 0, (void **)&result->host_pointer);
+
+		SLLStackPush(pool->blocks, result, next);
+		pool->block_count++;
+	} else {
+		SLLStackPush(vk->memory.block_freelist, result, next);
+		result = 0;
+	}
+	return result;
+}
+
+/* NOTE(rnp): memory.lock must be held */
+function b32
+vk_memory_suballocate(VulkanBuffer *vb, u64 size, u64 alignment)
+{
+	VulkanMemoryPool *pool = vulkan_context->memory.pools + vb->memory_kind;
+
+	b32 result = 0;
+	for (VulkanMemoryBlock *block = pool->blocks; !result && block; block = block->next) {
+		u64 offset = buddy_allocate(&block->allocator, size, alignment);
+		if (offset != BuddyInvalidOffset) {
+			vb->block         = block;
+			vb->memory_offset = offset;
+			result            = 1;
+		}
+	}
+
+	if (!result) {
+		VulkanMemoryBlock *block = vk_memory_block_create(vb->memory_kind);
+		u64 offset = block ? buddy_allocate(&block->allocator, size, alignment) : BuddyInvalidOffset;
+		if (offset != BuddyInvalidOffset) {
+			vb->block         = block;
+			vb->memory_offset = offset;
+			result            = 1;
+		}
+	}
+
+	if (result) {
+		vb->memory = vb->block->memory;
+		if (vb->block->host_pointer)
+			vb->host_pointer = vb->block->host_pointer + vb->memory_offset;
+	}
+
+	return result;
+}
+
+/* NOTE(rnp): memory.lock must be held */
+function void
+vk_memory_release(VulkanBuffer *vb)
+{
+	VulkanContext *vk = vulkan_context;
+	if (vb->block) {
+		VulkanMemoryPool  *pool  = vk->memory.pools + vb->memory_kind;
+		VulkanMemoryBlock *block = vb->block;
+		buddy_free(&block->allocator, vb->memory_offset);
+
+		/* NOTE(rnp): keep one empty block around so that resizes don't hit the driver */
+		if (buddy_empty(&block->allocator) && pool->block_count > 1) {
+			for (VulkanMemoryBlock **it = &pool->blocks; *it; it = &(*it)->next) {
+				if (*it == block) {
+					*it = block->next;
+					break;
+				}
+			}
+			pool->block_count--;
+
+			if (block->host_pointer) vkUnmapMemory(vk->device, block->memory);
+			vk_release_memory(block->memory, pool->block_size);
+			SLLStackPush(vk->memory.block_freelist, block, next);
+		}
+	} else {
+		if (vb->host_pointer)
+			vkUnmapMemory(vk->device, vb->memory);
+		vk_release_memory(vb->memory, vb->memory_kind != VulkanMemoryKind_Host ? vb->memory_size : 0);
+		vk->memory.dedicated_bytes -= vb->memory_size;
+		vk->memory.dedicated_count--;
+	}
+}
+
+/* NOTE(rnp): destroys released buffers whose last use on every timeline has completed.
+ * when wait is set this blocks until all of them can be destroyed */
+function void
+vk_memory_collect(b32 wait)
+{
+	VulkanContext *vk = vulkan_context;
+	DeferLoop(take_lock(&vk->memory.lock, -1), release_lock(&vk->memory.lock))
+	{
+		VulkanBuffer *next = 0;
+		for (VulkanBuffer *vb = vk->memory.pending_first; vb; vb = next) {
+			next = vb->next;
+
+			b32 complete = 1;
+			for (u32 timeline = 0; complete && timeline < GPUTimeline_Count; timeline++)
+				complete &= gpu_host_wait_timeline(timeline, vb->release_wait_values[timeline], wait ? -1ULL : 0);
+
+			if (complete) {
+				DLLRemove(0, vk->memory.pending_first, vk->memory.pending_last, vb, next, prev);
+				vk->memory.pending_bytes -= vb->memory_size;
+
+				if (vb->buffer) vkDestroyBuffer(vk->device, vb->buffer, 0);
+				vk_memory_release(vb);
+				vk_entity_release((VulkanEntity *)((u8 *)vb - offsetof(VulkanEntity, as)));
+			}
+		}
+	}
+}
+
 function u32
 vk_index_size(VkIndexType type)
 {
@@ -1037,22 +1251,52 @@ vk_buffer_allocate_common(VulkanBuffer *vb, VulkanBufferAllocateInfo *ai)
 	b32 host_read_write = (ai->flags & VulkanUsageFlag_HostReadWrite) != 0;
 	vb->memory_kind = host_read_write ? VulkanMemoryKind_BAR : VulkanMemoryKind_Device;
 
+	/* NOTE(rnp): exported memory is handed to other APIs as a whole so it always gets its
+	 * own allocation */
+	b32 suballocate = !ai->export && size <= vk->memory.pools[vb->memory_kind].block_size / 2;
+
 	b32 result = 0;
-	// TODO(rnp): this may fail if the allocation is too big for the BAR size
-	// it needs to handled properly
-	if (vk_allocate_memory(&vb->memory, size, vb->memory_kind, VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT, &dedicated_allocate_info, ai->export)) {
-		result  = 1;
-		ai->gpu_buffer->size = size;
-		vb->memory_size = size;
+	for (u32 attempt = 0; !result && attempt < 2; attempt++) {
+		/* NOTE(rnp): the first attempt only reclaims memory the GPU is already done with.
+		 * if that fails wait for everything that was released and try again */
+		vk_memory_collect(attempt > 0);
 
-		vb->index_type = ai->index_type;
+		DeferLoop(take_lock(&vk->memory.lock, -1), release_lock(&vk->memory.lock))
+		{
+			if (suballocate)
+				result = vk_memory_suballocate(vb, size, memory_requirements.alignment);
+
+			// TODO(rnp): this may fail if the allocation is too big for the BAR size
+			// it needs to handled properly
+			if (!result && vk_allocate_memory(&vb->memory, size, vb->memory_kind, VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT,
+			                                  &dedicated_allocate_info, ai->export))
+			{
+				result = 1;
+				vk->memory.dedicated_bytes += size;
+				vk->memory.dedicated_count++;
+
+				vk_label_object(DEVICE_MEMORY, vb->memory, ai->label, str8("Memory"));
+
+				if (host_read_write)
+					vkMapMemory(vk->device, vb->memory, 0, size, 0, &vb->host_pointer);
+			}
 
-		vk_label_object(DEVICE_MEMORY, vb->memory, ai->label, str8("Memory"));
+			if (result) {
+				vb->memory_size  = size;
+				vb->label_length = (u8)Min(ai->label.length, VulkanMemoryLabelLength);
+				memory_copy(vb->label, ai->label.data, vb->label_length);
+				DLLInsertLast(0, vk->memory.live_first, vk->memory.live_last, vb, next, prev);
+			}
+		}
+
+		if (!vk->memory.pending_first) break;
+	}
 
-		if (host_read_write)
-			vkMapMemory(vk->device, vb->memory, 0, size, 0, &vb->host_pointer);
+	if (result) {
+		ai->gpu_buffer->size = size;
+		vb->index_type = ai->index_type;
 
-		vkBindBufferMemory(vk->device, vb->buffer, vb->memory, 0);
+		vkBindBufferMemory(vk->device, vb->buffer, vb->memory, vb->memory_offset);
 		VkBufferDeviceAddressInfo buffer_device_address_info = {
 			.sType  = VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO,
 			.buffer = vb->buffer,
@@ -1290,6 +1534,8 @@ vk_load_physical_device(Arena *arena, Stream *err)
 				#undef X
 				fatal(stream_to_str8(err));
 			}
+
+			vk->gpu_info.pipeline_statistics = df.features.pipelineStatisticsQuery;
 		}
 
 		{
@@ -1370,6 +1616,35 @@ vk_load_physical_device(Arena *arena, Stream *err)
 		}
 	}
 
+	if (vulkan_config.optional.pci_bus_info) {
+		VkPhysicalDeviceProperties2             pdp = {.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2};
+		VkPhysicalDevicePCIBusInfoPropertiesEXT pci = {.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PCI_BUS_INFO_PROPERTIES_EXT};
+		pdp.pNext = &pci;
+		vkGetPhysicalDeviceProperties2(vk->physical_device, &pdp);
+
+		vk->gpu_info.pci_bus_info = 1;
+		vk->gpu_info.pci_domain   = pci.pciDomain;
+		vk->gpu_info.pci_bus      = pci.pciBus;
+		vk->gpu_info.pci_device   = pci.pciDevice;
+		vk->gpu_info.pci_function = pci.pciFunction;
+	}
+
+	/* NOTE(rnp): timestamps can only be correlated with the host clock if the driver
+	 * supports sampling the device domain together with the domain os_timer_count() uses */
+	if (vulkan_config.optional.calibrated_timestamps && vkGetPhysicalDeviceCalibrateableTimeDomainsEXT) {
+		u32 domain_count = 0;
+		vkGetPhysicalDeviceCalibrateableTimeDomainsEXT(vk->physical_device, &domain_count, 0);
+		VkTimeDomainEXT *domains = push_array(arena, VkTimeDomainEXT, domain_count);
+		vkGetPhysicalDeviceCalibrateableTimeDomainsEXT(vk->physical_device, &domain_count, domains);
+
+		b32 device = 0, host = 0;
+		for EachIndex(domain_count, it) {
+			device |= domains[it] == VK_TIME_DOMAIN_DEVICE_EXT;
+			host   |= domains[it] == VK_HOST_TIME_DOMAIN;
+		}
+		vk->gpu_info.calibrated_timestamps = device && host;
+	}
+
 	VkPhysicalDeviceMemoryProperties2 mp = {.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2};
 	vkGetPhysicalDeviceMemoryProperties2(vk->physical_device, &mp);
 
@@ -1450,6 +1725,13 @@ vk_load_physical_device(Arena *arena, Stream *err)
 	vk->gpu_info.subgroup_size             = v11p.subgroupSize;
 	vk->gpu_info.max_compute_shared_memory_size = dp.properties.limits.maxComputeSharedMemorySize;
 
+	{
+		u64 block_size = round_down_power_of_two(Min(vk->gpu_info.gpu_heap_size / 32, VulkanMemoryMaxBlockSize));
+		block_size     = Max(block_size, VulkanMemoryMinBlockSize);
+		vk->memory.pools[VulkanMemoryKind_Device].block_size = block_size;
+		vk->memory.pools[VulkanMemoryKind_BAR].block_size    = Min(block_size, VulkanMemoryBARBlockSize);
+	}
+
 	temp_end(scratch);
 	// IMPORTANT(rnp): memory must only be pushed at the end of the function
 	vk->gpu_info.name = push_str8(vk->arena, str8_from_c_str(dp.properties.deviceName));
@@ -1723,6 +2005,7 @@ vk_load_queues(Arena *arena, Stream *err)
 			#define X(name, ...) .name = 1,
 			VK_REQUIRED_PHYSICAL_FEATURES
 			#undef X
+			.pipelineStatisticsQuery = vk->gpu_info.pipeline_statistics,
 		},
 	};
 	device_create_info.pNext = &device_features;
@@ -1741,7 +2024,10 @@ vk_load_queues(Arena *arena, Stream *err)
 	}
 
 	vk->queues[VulkanQueueKind_Graphics]->pipeline_stage_flags |= VK_PIPELINE_STAGE_2_ALL_GRAPHICS_BIT;
-	vk->queues[VulkanQueueKind_Compute]->pipeline_stage_flags  |= VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
+	/* NOTE(rnp): copies and clears are recorded on the compute timeline too; they must be
+	 * covered by gpu_command_pipeline_barrier() */
+	vk->queues[VulkanQueueKind_Compute]->pipeline_stage_flags  |= VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT|
+	                                                              VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT;
 
 	for EachElement(vk->command_pools, it) {
 		VulkanCommandPool *vcp = vk->command_pools[it];
@@ -1761,13 +2047,6 @@ vk_load_queues(Arena *arena, Stream *err)
 			.commandBufferCount = countof(vcp->buffers),
 		};
 		vkAllocateCommandBuffers(vk->device, &command_buffer_allocate_info, vcp->buffers);
-
-		VkQueryPoolCreateInfo query_pool_create_info = {
-			.sType      = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
-			.queryType  = VK_QUERY_TYPE_TIMESTAMP,
-			.queryCount = MaxCommandBuffersInFlight * MaxCommandBufferTimestamps,
-		};
-		vkCreateQueryPool(vk->device, &query_pool_create_info, 0, &vcp->query_pool);
 	}
 }
 
@@ -1956,20 +2235,58 @@ gpu_info(void)
 	return &vulkan_context->gpu_info;
 }
 
+/* NOTE(rnp): snapshot of pooled and dedicated memory use with every live buffer by label */
+DEBUG_IMPORT GPUMemoryReport
+gpu_memory_report(Arena *arena)
+{
+	VulkanContext  *vk     = vulkan_context;
+	GPUMemoryReport result = {0};
+	DeferLoop(take_lock(&vk->memory.lock, -1), release_lock(&vk->memory.lock))
+	{
+		for EachElement(vk->memory.pools, it) {
+			VulkanMemoryPool *pool = vk->memory.pools + it;
+			result.block_count += pool->block_count;
+			result.block_bytes += pool->block_count * pool->block_size;
+			for (VulkanMemoryBlock *block = pool->blocks; block; block = block->next)
+				result.suballocated_bytes += block->allocator.used;
+		}
+		result.dedicated_bytes = vk->memory.dedicated_bytes;
+		result.dedicated_count = vk->memory.dedicated_count;
+		result.pending_bytes   = vk->memory.pending_bytes;
+
+		for (VulkanBuffer *vb = vk->memory.live_first; vb; vb = vb->next)
+			result.allocation_count++;
+
+		result.allocations = push_array(arena, GPUMemoryAllocation, result.allocation_count);
+		u32 index = 0;
+		for (VulkanBuffer *vb = vk->memory.live_first; vb; vb = vb->next, index++) {
+			GPUMemoryAllocation *a = result.allocations + index;
+			a->label     = push_str8(arena, (str8){.data = vb->label, .length = vb->label_length});
+			a->size      = vb->memory_size;
+			a->dedicated = vb->block == 0;
+		}
+	}
+	return result;
+}
+
+/* NOTE(rnp): the GPU may still be using the buffer so destruction is deferred until every
+ * timeline reaches the value it had when the buffer was released */
 function void
 vk_vulkan_buffer_release(VulkanBuffer *vb)
 {
 	VulkanContext *vk = vulkan_context;
-	VulkanEntity  *e  = (VulkanEntity *)((u8 *)vb - offsetof(VulkanEntity, as));
-	// TODO(rnp): this happens implicitly, probably just delete this if block
-	if (vb->host_pointer)
-		vkUnmapMemory(vk->device, vb->memory);
+	for EachElement(vb->release_wait_values, it)
+		vb->release_wait_values[it] = atomic_load_u64(&vk->queues[it]->timeline_semaphore.value);
 
-	if (vb->buffer)
-		vkDestroyBuffer(vk->device, vb->buffer, 0);
+	DeferLoop(take_lock(&vk->memory.lock, -1), release_lock(&vk->memory.lock))
+	{
+		DLLRemove(0, vk->memory.live_first, vk->memory.live_last, vb, next, prev);
+		vb->next = vb->prev = 0;
+		DLLInsertLast(0, vk->memory.pending_first, vk->memory.pending_last, vb, next, prev);
+		vk->memory.pending_bytes += vb->memory_size;
+	}
 
-	vk_release_memory(vb->memory, vb->memory_kind != VulkanMemoryKind_Host ? vb->memory_size : 0);
-	vk_entity_release(e);
+	vk_memory_collect(0);
 }
 
 DEBUG_IMPORT void
@@ -2062,7 +2379,7 @@ vk_buffer_buffer_copy(VulkanBuffer *destination, VulkanBuffer *source, u64 desti
 					VkMappedMemoryRange mrs[1] = {{
 						.sType  = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE,
 						.memory = source->memory,
-						.offset = source_offset - (source_offset % nca_size),
+						.offset = source->memory_offset + source_offset - (source_offset % nca_size),
 						.size   = gpu_round_up_to_sync_size(size, nca_size),
 					}};
 					vkInvalidateMappedMemoryRanges(vk->device, countof(mrs), mrs);
@@ -2098,7 +2415,7 @@ vk_buffer_buffer_copy(VulkanBuffer *destination, VulkanBuffer *source, u64 desti
 				VkMappedMemoryRange mrs[1] = {{
 					.sType  = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE,
 					.memory = destination->memory,
-					.offset = destination_offset - (destination_offset % nca_size),
+					.offset = destination->memory_offset + destination_offset - (destination_offset % nca_size),
 					.size   = gpu_round_up_to_sync_size(size, nca_size),
 				}};
 				vkFlushMappedMemoryRanges(vk->device, countof(mrs), mrs);
@@ -2376,15 +2693,16 @@ gpu_host_signal_timeline(GPUTimeline timeline)
 }
 
 DEBUG_IMPORT VulkanHandle
-vk_pipeline(VulkanPipelineCreateInfo *infos, u32 count, u32 push_constants_size)
+vk_pipeline(Arena *arena, VulkanPipelineCreateInfo *infos, u32 count, u32 push_constants_size)
 {
 	assert(Between(count, 1, 2));
 	assert(count == 2 || infos[0].kind == VulkanShaderKind_Compute);
 
+	/* NOTE(rnp): nothing here touches shared state outside of the entity lock so pipelines
+	 * can be built from multiple threads as long as each passes its own arena */
 	VulkanHandle result = {0};
 	Temp scratch;
-	DeferLoop(take_lock(&vulkan_context->arena_lock, -1), release_lock(&vulkan_context->arena_lock))
-	DeferLoop(scratch = temp_begin(vulkan_context->arena), temp_end(scratch))
+	DeferLoop(scratch = temp_begin(arena), temp_end(scratch))
 	{
 		VulkanEntity *e = vk_entity_allocate(VulkanEntityKind_Pipeline);
 		result = (VulkanHandle){(u64)e};
@@ -2486,7 +2804,11 @@ gpu_command_list_begin(GPUTimeline timeline)
 		b32 wait_result = gpu_host_wait_timeline(timeline, vcp->last_submission_values[index], -1ULL);
 		assert(wait_result);
 
-		vcp->timestamp_counts[index] = 0;
+		VulkanProfileState *ps = vcp->profiles + index;
+		ps->zone_count      = 0;
+		ps->depth           = 0;
+		ps->open_zone       = GPUProfileZoneNone;
+		ps->statistics_zone = GPUProfileZoneNone;
 
 		VkCommandBufferBeginInfo buffer_begin_info = {
 			.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
@@ -2494,8 +2816,6 @@ gpu_command_list_begin(GPUTimeline timeline)
 		};
 
 		vkBeginCommandBuffer(vcp->buffers[index], &buffer_begin_info);
-		vkCmdResetQueryPool(vcp->buffers[index], vcp->query_pool, index * MaxCommandBufferTimestamps,
-		                    MaxCommandBufferTimestamps);
 	}
 	return result;
 }
@@ -2599,27 +2919,134 @@ gpu_command_push_constants(GPUCommandList command, u32 offset, u32 size, void *v
 	}
 }
 
+function VkPipelineStageFlags2
+vk_timestamp_stage(GPUTimeline timeline)
+{
+	read_only local_persist VkPipelineStageFlags2 stage_lut[GPUTimeline_Count] = {
+		[GPUTimeline_Graphics] = VK_PIPELINE_STAGE_2_ALL_GRAPHICS_BIT,
+		/* NOTE(rnp): all commands so that zones around copies and clears are timed too */
+		[GPUTimeline_Compute]  = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+		[GPUTimeline_Transfer] = -1,
+	};
+
+	VkPipelineStageFlags2 result = stage_lut[timeline];
+	assert(result != (VkPipelineStageFlags2)-1);
+	return result;
+}
+
+function VulkanProfileBlock *
+vk_profile_block_create(void)
+{
+	VulkanContext      *vk     = vulkan_context;
+	VulkanProfileBlock *result = 0;
+	DeferLoop(take_lock(&vk->arena_lock, -1), release_lock(&vk->arena_lock))
+	{
+		result = push_struct(vk->arena, VulkanProfileBlock);
+	}
+
+	VkQueryPoolCreateInfo timestamps_create_info = {
+		.sType      = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+		.queryType  = VK_QUERY_TYPE_TIMESTAMP,
+		.queryCount = 2 * VulkanProfileBlockZones,
+	};
+	vkCreateQueryPool(vk->device, &timestamps_create_info, 0, &result->timestamps);
+
+	if (vk->gpu_info.pipeline_statistics) {
+		VkQueryPoolCreateInfo statistics_create_info = {
+			.sType              = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+			.queryType          = VK_QUERY_TYPE_PIPELINE_STATISTICS,
+			.queryCount         = VulkanProfileBlockZones,
+			.pipelineStatistics = VK_QUERY_PIPELINE_STATISTIC_COMPUTE_SHADER_INVOCATIONS_BIT,
+		};
+		vkCreateQueryPool(vk->device, &statistics_create_info, 0, &result->statistics);
+	}
+	return result;
+}
+
+/* NOTE(rnp): returns the block holding zone, growing the chain if necessary */
+function VulkanProfileBlock *
+vk_profile_block(VulkanProfileState *ps, u32 zone)
+{
+	VulkanProfileBlock  *result = 0;
+	VulkanProfileBlock **link   = &ps->blocks;
+	for (u32 it = 0; it <= zone / VulkanProfileBlockZones; it++) {
+		if (!*link) *link = vk_profile_block_create();
+		result = *link;
+		link   = &result->next;
+	}
+	return result;
+}
+
+/* NOTE(rnp): zones nest; each one records a timestamp when it is opened and when it is
+ * closed. queries are reset as their block is first used so zones must not be opened inside
+ * of rendering. the label must stay valid until the zones are read back */
 DEBUG_IMPORT void
-gpu_command_timestamp(GPUCommandList command)
+gpu_profile_zone_begin_tagged(GPUCommandList command, str8 label, GPUProfileZoneFlags flags, u32 tag)
 {
 	if (command.value) {
 		VulkanContext       *vk  = vulkan_context;
 		VulkanCommandBuffer *vcb = vk_entity_data(command.value, VulkanEntityKind_CommandBuffer);
-		VulkanCommandPool   *vcp = vk->command_pools[vcb->timeline];
+		VulkanProfileState  *ps  = vk->command_pools[vcb->timeline]->profiles + vcb->buffer_index;
+		VkCommandBuffer      cmd = vk_command_buffer(command);
+
+		u32 zone = ps->zone_count++;
+		u32 slot = zone % VulkanProfileBlockZones;
+		VulkanProfileBlock *block = vk_profile_block(ps, zone);
+		if (slot == 0) {
+			vkCmdResetQueryPool(cmd, block->timestamps, 0, 2 * VulkanProfileBlockZones);
+			if (block->statistics) vkCmdResetQueryPool(cmd, block->statistics, 0, VulkanProfileBlockZones);
+		}
 
-		read_only local_persist VkPipelineStageFlags2 stage_lut[GPUTimeline_Count] = {
-			[GPUTimeline_Graphics] = VK_PIPELINE_STAGE_2_ALL_GRAPHICS_BIT,
-			[GPUTimeline_Compute]  = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
-			[GPUTimeline_Transfer] = -1,
-		};
+		VulkanProfileZone *vpz = block->zones + slot;
+		vpz->label  = label;
+		vpz->parent = ps->open_zone;
+		vpz->depth  = ps->depth++;
+		vpz->tag    = tag;
+		ps->open_zone = zone;
+
+		/* NOTE(rnp): only one pipeline statistics query may be active in a command buffer;
+		 * requests from zones nested inside of one which has it are ignored */
+		vpz->statistics = (flags & GPUProfileZoneFlag_PipelineStatistics) && block->statistics &&
+		                  ps->statistics_zone == GPUProfileZoneNone;
+
+		vkCmdWriteTimestamp2(cmd, vk_timestamp_stage(vcb->timeline), block->timestamps, 2 * slot);
+		if (vpz->statistics) {
+			ps->statistics_zone = zone;
+			vkCmdBeginQuery(cmd, block->statistics, slot, 0);
+		}
+	}
+}
+
+DEBUG_IMPORT void
+gpu_profile_zone_begin(GPUCommandList command, str8 label, GPUProfileZoneFlags flags)
+{
+	gpu_profile_zone_begin_tagged(command, label, flags, GPUProfileZoneNone);
+}
 
-		VkPipelineStageFlags2 stage = stage_lut[vcb->timeline];
-		assert(stage != (VkPipelineStageFlags2)-1);
+DEBUG_IMPORT void
+gpu_profile_zone_end(GPUCommandList command)
+{
+	if (command.value) {
+		VulkanContext       *vk  = vulkan_context;
+		VulkanCommandBuffer *vcb = vk_entity_data(command.value, VulkanEntityKind_CommandBuffer);
+		VulkanProfileState  *ps  = vk->command_pools[vcb->timeline]->profiles + vcb->buffer_index;
+		VkCommandBuffer      cmd = vk_command_buffer(command);
+
+		assert(ps->open_zone != GPUProfileZoneNone);
+		if (ps->open_zone != GPUProfileZoneNone) {
+			u32 zone = ps->open_zone;
+			u32 slot = zone % VulkanProfileBlockZones;
+			VulkanProfileBlock *block = vk_profile_block(ps, zone);
+			VulkanProfileZone  *vpz   = block->zones + slot;
+
+			if (vpz->statistics) {
+				vkCmdEndQuery(cmd, block->statistics, slot);
+				ps->statistics_zone = GPUProfileZoneNone;
+			}
+			vkCmdWriteTimestamp2(cmd, vk_timestamp_stage(vcb->timeline), block->timestamps, 2 * slot + 1);
 
-		if (vcp->timestamp_counts[vcb->buffer_index] < MaxCommandBufferTimestamps) {
-			u64 query_index = vcp->timestamp_counts[vcb->buffer_index]++;
-			vkCmdWriteTimestamp2(vk_command_buffer(command), stage, vcp->query_pool,
-			                     vcb->buffer_index * MaxCommandBufferTimestamps + query_index);
+			ps->open_zone = vpz->parent;
+			ps->depth--;
 		}
 	}
 }
@@ -2647,6 +3074,12 @@ gpu_command_list_end(GPUCommandList command, VulkanHandle wait_semaphore, Vulkan
 		VulkanQueue         *vq  = vk->queues[vcb->timeline];
 		VulkanSemaphore     *vs  = &vq->timeline_semaphore;
 
+		/* NOTE(rnp): an unfinished zone would never have its end timestamp written */
+		VulkanProfileState *ps = vcp->profiles + vcb->buffer_index;
+		assert(ps->open_zone == GPUProfileZoneNone);
+		while (ps->open_zone != GPUProfileZoneNone)
+			gpu_profile_zone_end(command);
+
 		vkEndCommandBuffer(vcp->buffers[vcb->buffer_index]);
 
 		DeferLoop(take_lock(&vq->lock, -1), release_lock(&vq->lock)) {
@@ -2902,24 +3335,93 @@ gpu_command_copy_buffer(GPUCommandList command, GPUBuffer *restrict destination,
 	}
 }
 
-DEBUG_IMPORT u64 *
-gpu_read_timestamps(GPUTimeline timeline, u64 *count, Arena *arena)
+/* NOTE(rnp): samples the device timestamp counter and os_timer_count() at (nearly) the same
+ * instant. returns 0 when VK_EXT_calibrated_timestamps is not usable */
+DEBUG_IMPORT b32
+gpu_timestamp_calibration(u64 *gpu_ticks, u64 *host_ticks)
 {
-	u64 *result = 0;
+	b32 result = 0;
+	VulkanContext *vk = vulkan_context;
+	if (vk->gpu_info.calibrated_timestamps && vkGetCalibratedTimestampsEXT) {
+		VkCalibratedTimestampInfoEXT infos[2] = {
+			{.sType = VK_STRUCTURE_TYPE_CALIBRATED_TIMESTAMP_INFO_EXT, .timeDomain = VK_TIME_DOMAIN_DEVICE_EXT},
+			{.sType = VK_STRUCTURE_TYPE_CALIBRATED_TIMESTAMP_INFO_EXT, .timeDomain = VK_HOST_TIME_DOMAIN},
+		};
+		u64 values[2], max_deviation;
+		result = vkGetCalibratedTimestampsEXT(vk->device, countof(infos), infos, values, &max_deviation) == VK_SUCCESS;
+		if (result) {
+			*gpu_ticks  = values[0];
+			*host_ticks = values[1];
+		}
+	}
+	return result;
+}
+
+/* NOTE(rnp): zones are returned in the order they were opened */
+DEBUG_IMPORT GPUProfileZone *
+gpu_read_profile_zones(GPUTimeline timeline, u32 *count, Arena *arena)
+{
+	GPUProfileZone *result = 0;
+	*count = 0;
 	if Between(timeline, 0, GPUTimeline_Count - 1) {
 		VulkanContext     *vk  = vulkan_context;
 		VulkanCommandPool *vcp = vk->command_pools[timeline];
 		DeferLoop(take_lock(&vcp->lock, -1), release_lock(&vcp->lock))
 		{
 			u32 index = (vcp->next_command_buffer_index - 1) % MaxCommandBuffersInFlight;
-			*count = vcp->timestamp_counts[index];
-			if (*count > 0) {
-				result = push_array(arena, u64, *count);
+			VulkanProfileState *ps = vcp->profiles + index;
+			if (ps->zone_count > 0) {
 				gpu_host_wait_timeline(timeline, vcp->last_submission_values[index], -1ULL);
 
-				vkGetQueryPoolResults(vk->device, vcp->query_pool, index * MaxCommandBufferTimestamps, *count,
-				                      *count * sizeof(u64), result, 8, VK_QUERY_RESULT_WAIT_BIT);
+				*count = ps->zone_count;
+				result = push_array(arena, GPUProfileZone, ps->zone_count);
+
+				u64 *ticks = push_array(arena, u64, 2 * VulkanProfileBlockZones);
+				u32  zone  = 0;
+				VkQueryResultFlags flags = VK_QUERY_RESULT_64_BIT|VK_QUERY_RESULT_WAIT_BIT;
+				for (VulkanProfileBlock *block = ps->blocks; zone < ps->zone_count; block = block->next) {
+					u32 block_zones = Min(ps->zone_count - zone, VulkanProfileBlockZones);
+					vkGetQueryPoolResults(vk->device, block->timestamps, 0, 2 * block_zones,
+					                      2 * block_zones * sizeof(u64), ticks, sizeof(u64), flags);
+
+					for (u32 it = 0; it < block_zones; it++, zone++) {
+						VulkanProfileZone *vpz = block->zones + it;
+						GPUProfileZone    *z   = result + zone;
+						z->label  = vpz->label;
+						z->parent = vpz->parent;
+						z->depth  = vpz->depth;
+						z->tag    = vpz->tag;
+						z->begin  = ticks[2 * it + 0];
+						z->end    = ticks[2 * it + 1];
+						if (vpz->statistics) {
+							vkGetQueryPoolResults(vk->device, block->statistics, it, 1, sizeof(u64),
+							                      &z->invocations, sizeof(u64), flags);
+						}
+					}
+				}
+			}
+		}
+	}
+	return result;
+}
+
+/* NOTE(rnp): one summary per tag in [0, tag_count); zones with other tags are skipped. the
+ * label and depth are those of the first zone with the tag */
+DEBUG_IMPORT GPUProfileZoneSummary *
+gpu_profile_zones_by_tag(GPUProfileZone *zones, u32 count, u32 tag_count, Arena *arena)
+{
+	GPUProfileZoneSummary *result = push_array(arena, GPUProfileZoneSummary, tag_count);
+	for (u32 it = 0; it < count; it++) {
+		GPUProfileZone *z = zones + it;
+		if (z->tag < tag_count) {
+			GPUProfileZoneSummary *s = result + z->tag;
+			if (s->count == 0) {
+				s->label = z->label;
+				s->depth = z->depth;
 			}
+			s->count       += 1;
+			s->ticks       += z->end - z->begin;
+			s->invocations += z->invocations;
 		}
 	}
 	return result;
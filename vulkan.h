@@ -130,10 +130,12 @@ typedef enum {
 	VK_STRUCTURE_TYPE_SEMAPHORE_GET_FD_INFO_KHR                                        = 1000079001,
 	VK_STRUCTURE_TYPE_MEMORY_DEDICATED_ALLOCATE_INFO                                   = 1000127001,
 	VK_STRUCTURE_TYPE_DEBUG_UTILS_OBJECT_NAME_INFO_EXT                                 = 1000128000,
+	VK_STRUCTURE_TYPE_CALIBRATED_TIMESTAMP_INFO_EXT                                    = 1000184000,
 	VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO                                       = 1000207002,
 	VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO                                   = 1000207003,
 	VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO                                              = 1000207004,
 	VK_STRUCTURE_TYPE_SEMAPHORE_SIGNAL_INFO                                            = 1000207005,
+	VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PCI_BUS_INFO_PROPERTIES_EXT                      = 1000212000,
 	VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO                                       = 1000244001,
 	VK_STRUCTURE_TYPE_VALIDATION_FEATURES_EXT                                          = 1000247000,
 	VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_ROBUSTNESS_2_FEATURES_KHR                        = 1000286000,
@@ -2044,6 +2046,15 @@ typedef struct {
 	VkDeviceSize            maxMemoryAllocationSize;
 } VkPhysicalDeviceVulkan11Properties;
 
+typedef struct {
+	VkStructureType sType;
+	void *          pNext;
+	uint32_t        pciDomain;
+	uint32_t        pciBus;
+	uint32_t        pciDevice;
+	uint32_t        pciFunction;
+} VkPhysicalDevicePCIBusInfoPropertiesEXT;
+
 typedef struct {
 	uint32_t                         apiVersion;
 	uint32_t                         driverVersion;
@@ -3043,6 +3054,20 @@ typedef struct {
 	VkBool32        cooperativeMatrixRobustBufferAccess;
 } VkPhysicalDeviceCooperativeMatrixFeaturesKHR;
 
+typedef enum {
+	VK_TIME_DOMAIN_DEVICE_EXT                    = 0,
+	VK_TIME_DOMAIN_CLOCK_MONOTONIC_EXT           = 1,
+	VK_TIME_DOMAIN_CLOCK_MONOTONIC_RAW_EXT       = 2,
+	VK_TIME_DOMAIN_QUERY_PERFORMANCE_COUNTER_EXT = 3,
+	VK_TIME_DOMAIN_MAX_ENUM_EXT                  = 0x7FFFFFFF
+} VkTimeDomainEXT;
+
+typedef struct {
+	VkStructureType sType;
+	const void *    pNext;
+	VkTimeDomainEXT timeDomain;
+} VkCalibratedTimestampInfoEXT;
+
 typedef enum {
 	VK_VALIDATION_FEATURE_ENABLE_GPU_ASSISTED_EXT                      = 0,
 	VK_VALIDATION_FEATURE_ENABLE_GPU_ASSISTED_RESERVE_BINDING_SLOT_EXT = 1,
@@ -3097,6 +3122,7 @@ typedef struct {
 	X(vkEnumerateDeviceExtensionProperties,     VkResult, (VkPhysicalDevice physicalDevice, const char *pLayerName, uint32_t *pPropertyCount, VkExtensionProperties *pProperties)) \
 	X(vkEnumeratePhysicalDevices,               VkResult, (VkInstance instance, uint32_t *pPhysicalDeviceCount, VkPhysicalDevice *pPhysicalDevices)) \
 	X(vkGetDeviceProcAddr,                      void *,   (VkDevice device, const char *pName)) \
+	X(vkGetPhysicalDeviceCalibrateableTimeDomainsEXT,    VkResult, (VkPhysicalDevice physicalDevice, uint32_t *pTimeDomainCount, VkTimeDomainEXT *pTimeDomains)) \
 	X(vkGetPhysicalDeviceCooperativeMatrixPropertiesKHR, VkResult, (VkPhysicalDevice physicalDevice, uint32_t *pPropertyCount, VkCooperativeMatrixPropertiesKHR *pProperties)) \
 	X(vkGetPhysicalDeviceFeatures2,             void,     (VkPhysicalDevice physicalDevice, VkPhysicalDeviceFeatures2 *pFeatures)) \
 	X(vkGetPhysicalDeviceFormatProperties2,     void,     (VkPhysicalDevice physicalDevice, VkFormat format, VkFormatProperties2 *pFormatProperties)) \
@@ -3134,6 +3160,7 @@ typedef struct {
 	X(vkGetBufferDeviceAddress,        VkDeviceAddress, (VkDevice device, const VkBufferDeviceAddressInfo *pInfo)) \
 	X(vkGetBufferMemoryRequirements,   void,     (VkDevice device, VkBuffer buffer, VkMemoryRequirements *pMemoryRequirements)) \
 	X(vkGetDeviceQueue,                void,     (VkDevice device, uint32_t queueFamilyIndex, uint32_t queueIndex, VkQueue *pQueue)) \
+	X(vkGetCalibratedTimestampsEXT,    VkResult, (VkDevice device, uint32_t timestampCount, const VkCalibratedTimestampInfoEXT *pTimestampInfos, uint64_t *pTimestamps, uint64_t *pMaxDeviation)) \
 	X(vkGetImageMemoryRequirements,    void,     (VkDevice device, VkImage image, VkMemoryRequirements *pMemoryRequirements)) \
 	X(vkGetMemoryFdKHR,                VkResult, (VkDevice device, const VkMemoryGetFdInfoKHR *pGetFdInfo, int *pFd)) \
 	X(vkGetMemoryWin32HandleKHR,       VkResult, (VkDevice device, const VkMemoryGetWin32HandleInfoKHR *pGetWin32HandleInfo, void **pHandle)) \
@@ -3148,6 +3175,7 @@ typedef struct {
 	X(vkUpdateDescriptorSets,          void,     (VkDevice device, uint32_t descriptorWriteCount, const VkWriteDescriptorSet *pDescriptorWrites, uint32_t descriptorCopyCount, const VkCopyDescriptorSet *pDescriptorCopies)) \
 	X(vkWaitSemaphores,                VkResult, (VkDevice device, const VkSemaphoreWaitInfo *pWaitInfo, uint64_t timeout)) \
 	X(vkBeginCommandBuffer,            VkResult, (VkCommandBuffer commandBuffer, const VkCommandBufferBeginInfo *pBeginInfo)) \
+	X(vkCmdBeginQuery,                 void,     (VkCommandBuffer commandBuffer, VkQueryPool queryPool, uint32_t query, VkQueryControlFlags flags)) \
 	X(vkCmdBeginRendering,             void,     (VkCommandBuffer commandBuffer, const VkRenderingInfo *pRenderingInfo)) \
 	X(vkCmdBindDescriptorSets,         void,     (VkCommandBuffer commandBuffer, VkPipelineBindPoint pipelineBindPoint, VkPipelineLayout layout, uint32_t firstSet, uint32_t descriptorSetCount, const VkDescriptorSet *pDescriptorSets, uint32_t dynamicOffsetCount, const uint32_t *pDynamicOffsets)) \
 	X(vkCmdBindIndexBuffer2,           void,     (VkCommandBuffer commandBuffer, VkBuffer buffer, VkDeviceSize offset, VkDeviceSize size, VkIndexType indexType)) \
@@ -3155,6 +3183,7 @@ typedef struct {
 	X(vkCmdCopyBuffer2,                void,     (VkCommandBuffer commandBuffer, const VkCopyBufferInfo2 *pCopyBufferInfo)) \
 	X(vkCmdDispatch,                   void,     (VkCommandBuffer commandBuffer, uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ)) \
 	X(vkCmdDrawIndexed,                void,     (VkCommandBuffer commandBuffer, uint32_t indexCount, uint32_t instanceCount, uint32_t firstIndex, int32_t vertexOffset, uint32_t firstInstance)) \
+	X(vkCmdEndQuery,                   void,     (VkCommandBuffer commandBuffer, VkQueryPool queryPool, uint32_t query)) \
 	X(vkCmdEndRendering,               void,     (VkCommandBuffer commandBuffer)) \
 	X(vkCmdFillBuffer,                 void,     (VkCommandBuffer commandBuffer, VkBuffer dstBuffer, VkDeviceSize dstOffset, VkDeviceSize size, uint32_t data)) \
 	X(vkCmdPipelineBarrier2,           void,     (VkCommandBuffer commandBuffer, const VkDependencyInfo *pDependencyInfo)) \